@@ -0,0 +1,276 @@
+// Time single-region CoordinateIndexReader::query_region() lookups on one .cdx.
+//
+// Build with -DGFAIDX_BUILD_BENCHMARKS=ON, then run it on the coordinate index
+// of an indexed graph:
+//
+//   gfaidx_coordinate_lookup_bench graph.gfa.gz.cdx [--queries N] [--width BP]
+//
+// Each query is a --width interval at a random position of a random track.
+// The queries are answered by the previous ifstream-seek binary search, kept
+// here as the reference, and by the mmap reader, both with the file in the
+// page cache (warm) and after asking the kernel to drop it (cold). Cold
+// lookups open a fresh reader per query, since a live mapping keeps its pages
+// cached. Both implementations must return the same slices and node ranks.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "coordinates/coordinate_index.h"
+#include "paths/p_path_coordinates.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using gfaidx::coordinates::CoordinateIndexReader;
+using gfaidx::coordinates::CoordinateQueryResult;
+using gfaidx::coordinates::CoordinateTrackInfo;
+using gfaidx::coordinates::CoordinateTrackSlice;
+
+struct Query {
+    std::string reference_name;
+    std::string sequence_name;
+    std::uint64_t begin{};
+    std::uint64_t end{};
+};
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Ask the kernel to evict the file from the page cache. This only affects
+// pages no process has mapped, and is best effort.
+void drop_page_cache(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) throw std::runtime_error("Failed to open " + path);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+// The ifstream reader query_region() replaced: one seek and one 16-byte read
+// per binary-search probe, then one read of the matching entry range.
+class ReferenceLookup {
+public:
+    ReferenceLookup(const std::string& path, const std::vector<CoordinateTrackInfo>& tracks)
+        : in_(path, std::ios::binary), tracks_(tracks) {
+        if (!in_) throw std::runtime_error("Failed to open " + path);
+        // Header: magic[8], version, reserved, node_count, track_count,
+        // entry_count, track_table_offset, entry_table_offset, ...
+        char header[72];
+        in_.read(header, sizeof(header));
+        if (!in_) throw std::runtime_error("Failed to read coordinate index header");
+        std::memcpy(&entry_table_offset_, header + 48, sizeof(entry_table_offset_));
+    }
+
+    CoordinateQueryResult query(const Query& query) {
+        CoordinateQueryResult result;
+        for (const auto& track : tracks_) {
+            if (track.reference_name != query.reference_name || !matches(track, query)) continue;
+            if (track.entry_count == 0 || query.end <= track.sequence_start ||
+                query.begin >= track.sequence_end) {
+                continue;
+            }
+            std::uint64_t low = 0;
+            std::uint64_t high = track.entry_count;
+            while (low < high) {
+                const auto mid = low + (high - low) / 2;
+                const auto step_end = mid + 1 < track.entry_count
+                    ? read_start(track.entry_begin + mid + 1)
+                    : track.sequence_end;
+                if (step_end <= query.begin) low = mid + 1;
+                else high = mid;
+            }
+            if (low >= track.entry_count) continue;
+            std::uint64_t search_low = low;
+            std::uint64_t search_high = track.entry_count;
+            while (search_low < search_high) {
+                const auto mid = search_low + (search_high - search_low) / 2;
+                if (read_start(track.entry_begin + mid) < query.end) search_low = mid + 1;
+                else search_high = mid;
+            }
+            if (search_low == low) continue;
+
+            std::vector<char> range((search_low - low) * 16);
+            seek(track.entry_begin + low);
+            in_.read(range.data(), static_cast<std::streamsize>(range.size()));
+            if (!in_) throw std::runtime_error("Failed to read coordinate entry range");
+            for (std::size_t i = 0; i < range.size(); i += 16) {
+                std::uint32_t rank = 0;
+                std::memcpy(&rank, range.data() + i + 8, sizeof(rank));
+                result.node_ranks.push_back(rank);
+            }
+            result.slices.push_back(CoordinateTrackSlice{track, low, search_low - low});
+        }
+        std::sort(result.node_ranks.begin(), result.node_ranks.end());
+        result.node_ranks.erase(std::unique(result.node_ranks.begin(), result.node_ranks.end()),
+                                result.node_ranks.end());
+        return result;
+    }
+
+private:
+    static bool matches(const CoordinateTrackInfo& track, const Query& query) {
+        if (track.sequence_name == query.sequence_name) return true;
+        return track.source_type == 'P' &&
+               gfaidx::paths::parse_p_path_coordinate_name(track.sequence_name)
+                       .coordinate_name == query.sequence_name;
+    }
+
+    void seek(std::uint64_t entry_index) {
+        in_.clear();
+        in_.seekg(static_cast<std::streamoff>(entry_table_offset_ + entry_index * 16),
+                  std::ios::beg);
+    }
+
+    std::uint64_t read_start(std::uint64_t entry_index) {
+        std::uint64_t start = 0;
+        seek(entry_index);
+        in_.read(reinterpret_cast<char*>(&start), sizeof(start));
+        if (!in_) throw std::runtime_error("Failed to read coordinate index entry");
+        return start;
+    }
+
+    std::ifstream in_;
+    const std::vector<CoordinateTrackInfo>& tracks_;
+    std::uint64_t entry_table_offset_{};
+};
+
+bool same_result(const CoordinateQueryResult& lhs, const CoordinateQueryResult& rhs) {
+    return lhs.node_ranks == rhs.node_ranks &&
+           std::equal(lhs.slices.begin(), lhs.slices.end(), rhs.slices.begin(), rhs.slices.end(),
+                      [](const CoordinateTrackSlice& a, const CoordinateTrackSlice& b) {
+                          return a.track.entry_begin == b.track.entry_begin &&
+                                 a.start_step == b.start_step && a.step_count == b.step_count;
+                      });
+}
+
+// Print the mean, median, and 99th percentile latency of one query set.
+void report(const std::string& label, std::vector<double> seconds) {
+    std::sort(seconds.begin(), seconds.end());
+    double total = 0.0;
+    for (const auto value : seconds) total += value;
+    const auto percentile = [&](double fraction) {
+        return seconds[std::min(seconds.size() - 1,
+                                static_cast<std::size_t>(fraction * seconds.size()))];
+    };
+    std::cout << "  " << std::left << std::setw(22) << label << std::right << std::fixed
+              << std::setprecision(1) << "mean " << std::setw(9)
+              << total / seconds.size() * 1e6 << " us  p50 " << std::setw(9)
+              << percentile(0.5) * 1e6 << " us  p99 " << std::setw(9)
+              << percentile(0.99) * 1e6 << " us" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string input;
+    unsigned query_count = 1000;
+    std::uint64_t width = 10000;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--queries" && i + 1 < argc) {
+                query_count = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else if (arg == "--width" && i + 1 < argc) {
+                width = std::stoull(argv[++i]);
+            } else {
+                input = arg;
+            }
+        }
+        if (input.empty() || query_count == 0 || width == 0) {
+            std::cerr << "Usage: " << argv[0] << " <index.cdx> [--queries N] [--width BP]"
+                      << std::endl;
+            return 1;
+        }
+
+        std::vector<CoordinateTrackInfo> tracks;
+        {
+            CoordinateIndexReader index(input);
+            for (const auto& track : index.tracks()) {
+                if (track.entry_count != 0) tracks.push_back(track);
+            }
+        }
+        if (tracks.empty()) throw std::runtime_error("Coordinate index has no entries");
+
+        std::mt19937_64 rng(42);
+        std::vector<Query> queries;
+        std::uint64_t largest_track = 0;
+        for (const auto& track : tracks) largest_track = std::max(largest_track, track.entry_count);
+        for (unsigned q = 0; q < query_count; ++q) {
+            const auto& track = tracks[rng() % tracks.size()];
+            const auto begin =
+                track.sequence_start + rng() % (track.sequence_end - track.sequence_start);
+            queries.push_back(Query{track.reference_name, track.sequence_name, begin, begin + width});
+        }
+
+        std::cout << input << std::endl;
+        std::cout << "  tracks / largest:      " << tracks.size() << " / " << largest_track
+                  << " entries" << std::endl;
+        std::cout << "  queries:               " << queries.size() << " x " << width << " bp"
+                  << std::endl;
+
+        std::vector<CoordinateQueryResult> expected(queries.size());
+        std::vector<double> seconds(queries.size());
+        const auto check = [&](std::size_t q, const CoordinateQueryResult& result) {
+            if (!same_result(result, expected[q])) {
+                throw std::runtime_error("query_region disagrees with the reference");
+            }
+        };
+
+        for (const bool cold : {false, true}) {
+            const std::string cache = cold ? "cold" : "warm";
+            {
+                ReferenceLookup warm_reference(input, tracks);
+                for (std::size_t q = 0; q < queries.size(); ++q) {
+                    if (cold) {
+                        drop_page_cache(input);
+                        ReferenceLookup reference(input, tracks);
+                        const auto start = Clock::now();
+                        const auto result = reference.query(queries[q]);
+                        seconds[q] = seconds_since(start);
+                        check(q, result);
+                    } else {
+                        const auto start = Clock::now();
+                        expected[q] = warm_reference.query(queries[q]);
+                        seconds[q] = seconds_since(start);
+                    }
+                }
+            }
+            report("ifstream, " + cache, seconds);
+
+            std::unique_ptr<CoordinateIndexReader> warm_index;
+            if (!cold) warm_index = std::make_unique<CoordinateIndexReader>(input);
+            for (std::size_t q = 0; q < queries.size(); ++q) {
+                std::unique_ptr<CoordinateIndexReader> cold_index;
+                if (cold) {
+                    drop_page_cache(input);
+                    cold_index = std::make_unique<CoordinateIndexReader>(input);
+                }
+                const auto& index = cold ? *cold_index : *warm_index;
+                const auto start = Clock::now();
+                const auto result = index.query_region(queries[q].reference_name,
+                                                       queries[q].sequence_name,
+                                                       queries[q].begin,
+                                                       queries[q].end);
+                seconds[q] = seconds_since(start);
+                check(q, result);
+            }
+            report("mmap + fence, " + cache, seconds);
+        }
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
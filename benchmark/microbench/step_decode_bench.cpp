@@ -0,0 +1,186 @@
+// Time .pdx step decoding on one or more path indexes.
+//
+// Build with -DGFAIDX_BUILD_BENCHMARKS=ON, then compare a shared-run index
+// against one built with `gfaidx index_paths --flat_steps` from the same graph:
+//
+//   gfaidx_step_decode_bench shared.pdx flat.pdx [--repeat N] [--random N]
+//
+// For each index this reports full-path read_steps() and for_each_step()
+// throughput, random single-step access latency, node posting decode
+// throughput through for_each_node_posting(), and path-range posting scans through for_each_node_posting_in_paths().
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "paths/path_index.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void print_rate(const std::string& label,
+                std::uint64_t items,
+                double seconds,
+                const std::string& unit = "steps") {
+    const double rate = seconds > 0.0 ? static_cast<double>(items) / seconds / 1e6 : 0.0;
+    std::cout << "  " << std::left << std::setw(22) << label
+              << std::right << std::setw(10) << std::fixed << std::setprecision(3) << seconds << " s  "
+              << std::setw(10) << std::setprecision(1) << rate << " M " << unit << "/s" << std::endl;
+}
+
+void bench_index(const std::string& pdx_path, unsigned repeat, std::uint64_t random_reads) {
+    const auto open_start = Clock::now();
+    gfaidx::paths::PathIndexReader index(pdx_path);
+    const double open_seconds = seconds_since(open_start);
+
+    std::cout << pdx_path << std::endl;
+    std::cout << "  file bytes:            " << std::filesystem::file_size(pdx_path) << std::endl;
+    std::cout << "  paths / steps:         " << index.path_count() << " / "
+              << index.total_step_count() << std::endl;
+    std::cout << "  open:                  " << std::fixed << std::setprecision(6)
+              << open_seconds << " s" << std::endl;
+
+    // Fold every decoded step into a checksum so neither loop can be elided,
+    // and so both layouts can be checked to decode the same steps.
+    std::uint64_t checksum = 0;
+    std::uint64_t steps = 0;
+    auto start = Clock::now();
+    for (unsigned r = 0; r < repeat; ++r) {
+        for (std::uint32_t path_id = 0; path_id < index.path_count(); ++path_id) {
+            const auto decoded = index.read_steps(path_id);
+            for (const auto& step : decoded) {
+                checksum = checksum * 31 + step.node_id * 2 + step.is_reverse;
+            }
+            steps += decoded.size();
+        }
+    }
+    print_rate("read_steps", steps, seconds_since(start));
+
+    steps = 0;
+    start = Clock::now();
+    for (unsigned r = 0; r < repeat; ++r) {
+        for (std::uint32_t path_id = 0; path_id < index.path_count(); ++path_id) {
+            index.for_each_step(path_id, 0, std::numeric_limits<std::uint64_t>::max(),
+                [&](const gfaidx::paths::StepRecord& step, std::uint64_t) {
+                    checksum = checksum * 31 + step.node_id * 2 + step.is_reverse;
+                    ++steps;
+                });
+        }
+    }
+    print_rate("for_each_step", steps, seconds_since(start));
+
+    std::vector<std::uint32_t> nonempty_paths;
+    for (std::uint32_t path_id = 0; path_id < index.path_count(); ++path_id) {
+        if (index.get_path_info(path_id).step_count != 0) nonempty_paths.push_back(path_id);
+    }
+    if (!nonempty_paths.empty() && random_reads != 0) {
+        std::mt19937_64 rng(42);
+        start = Clock::now();
+        for (std::uint64_t i = 0; i < random_reads; ++i) {
+            const auto path_id = nonempty_paths[rng() % nonempty_paths.size()];
+            const auto step_count = index.get_path_info(path_id).step_count;
+            index.for_each_step(path_id, rng() % step_count, 1,
+                [&](const gfaidx::paths::StepRecord& step, std::uint64_t rank) {
+                    checksum += step.node_id + rank;
+                });
+        }
+        const double seconds = seconds_since(start);
+        std::cout << "  random single step:    " << std::setprecision(1)
+                  << seconds * 1e9 / static_cast<double>(random_reads) << " ns/lookup" << std::endl;
+    }
+
+    // Walk every node's postings through the visitor API. Postings are summed
+    // rather than chained into the checksum so the fold does not hide decode
+    // cost.
+    std::uint64_t postings = 0;
+    std::uint64_t posting_sum = 0;
+    start = Clock::now();
+    for (unsigned r = 0; r < repeat; ++r) {
+        for (std::uint32_t node_id = 0; node_id < index.node_count(); ++node_id) {
+            index.for_each_node_posting(node_id, [&](std::uint32_t path_id, std::uint32_t step_rank) {
+                posting_sum += path_id ^ step_rank;
+                ++postings;
+            });
+        }
+    }
+    print_rate("for_each_node_posting", postings, seconds_since(start), "postings");
+
+    // Restrict every node to a window of 5% of the paths, once by filtering a
+    // full decode and once through the skip-table scan; both must agree.
+    const std::uint32_t path_begin = index.path_count() / 2;
+    const std::uint32_t path_end = path_begin + std::max<std::uint32_t>(1, index.path_count() / 20);
+    std::uint64_t filtered_sum = 0;
+    std::uint64_t ranged_sum = 0;
+    postings = 0;
+    start = Clock::now();
+    for (unsigned r = 0; r < repeat; ++r) {
+        for (std::uint32_t node_id = 0; node_id < index.node_count(); ++node_id) {
+            index.for_each_node_posting(node_id, [&](std::uint32_t path_id, std::uint32_t step_rank) {
+                if (path_id < path_begin || path_id >= path_end) return;
+                filtered_sum += path_id ^ step_rank;
+                ++postings;
+            });
+        }
+    }
+    print_rate("filtered full decode", postings, seconds_since(start), "postings");
+
+    postings = 0;
+    start = Clock::now();
+    for (unsigned r = 0; r < repeat; ++r) {
+        for (std::uint32_t node_id = 0; node_id < index.node_count(); ++node_id) {
+            index.for_each_node_posting_in_paths(node_id, path_begin, path_end,
+                [&](std::uint32_t path_id, std::uint32_t step_rank) {
+                    ranged_sum += path_id ^ step_rank;
+                    ++postings;
+                });
+        }
+    }
+    print_rate("posting path range", postings, seconds_since(start), "postings");
+    if (ranged_sum != filtered_sum) {
+        throw std::runtime_error("Path-range posting scan disagrees with the full decode");
+    }
+    std::cout << "  checksum:              " << checksum << std::endl;
+    std::cout << "  posting sum:           " << posting_sum << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> inputs;
+    unsigned repeat = 3;
+    std::uint64_t random_reads = 1000000;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--repeat" && i + 1 < argc) {
+                repeat = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else if (arg == "--random" && i + 1 < argc) {
+                random_reads = std::stoull(argv[++i]);
+            } else {
+                inputs.push_back(arg);
+            }
+        }
+        if (inputs.empty()) {
+            std::cerr << "Usage: " << argv[0] << " <index.pdx> [more.pdx ...] [--repeat N] [--random N]"
+                      << std::endl;
+            return 1;
+        }
+        for (const auto& input : inputs) bench_index(input, repeat, random_reads);
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+// Time find_subpaths_for_node_ids() on one path index.
+//
+// Build with -DGFAIDX_BUILD_BENCHMARKS=ON, then run it on the .pdx of an
+// indexed graph:
+//
+//   gfaidx_subpath_discovery_bench graph.gfa.gz.pdx [--nodes N] [--queries N] [--threads N]
+//
+// Each query selects the distinct nodes of a window of N steps on a random
+// path, like a BFS or region selection around that path. The queries are
+// answered by the previous hash-map implementation, kept here as the
+// reference, and by find_subpaths_for_node_ids() with one and with --threads
+// workers. All three must return the same runs.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "paths/path_index.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using gfaidx::paths::PathIndexReader;
+using gfaidx::paths::SubpathRun;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// The hash-map implementation find_subpaths_for_node_ids() replaced.
+std::vector<SubpathRun> reference_find_subpaths(const PathIndexReader& index,
+                                                const std::vector<std::uint32_t>& node_ids) {
+    std::unordered_set<std::uint32_t> unique_nodes(node_ids.begin(), node_ids.end());
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> path_to_steps;
+    for (const auto node_id : unique_nodes) {
+        index.for_each_node_posting(node_id, [&](std::uint32_t path_id, std::uint32_t step_rank) {
+            path_to_steps[path_id].push_back(step_rank);
+        });
+    }
+
+    std::vector<std::pair<std::uint32_t, std::vector<std::uint32_t>>> grouped(
+        path_to_steps.begin(), path_to_steps.end());
+    std::sort(grouped.begin(), grouped.end(),
+              [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+    std::vector<SubpathRun> runs;
+    for (auto& [path_id, ranks] : grouped) {
+        std::sort(ranks.begin(), ranks.end());
+        std::uint64_t start = ranks.front();
+        std::uint64_t prev = ranks.front();
+        for (std::size_t i = 1; i <= ranks.size(); ++i) {
+            if (i < ranks.size() && ranks[i] == prev + 1) {
+                prev = ranks[i];
+                continue;
+            }
+            if (prev > start) runs.push_back(SubpathRun{path_id, start, prev - start + 1});
+            if (i < ranks.size()) start = prev = ranks[i];
+        }
+    }
+    return runs;
+}
+
+bool same_runs(const std::vector<SubpathRun>& lhs, const std::vector<SubpathRun>& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                      [](const SubpathRun& a, const SubpathRun& b) {
+                          return a.path_id == b.path_id && a.start_step == b.start_step &&
+                                 a.step_count == b.step_count;
+                      });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string input;
+    std::uint64_t window_steps = 10000;
+    unsigned queries = 20;
+    unsigned threads = 4;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--nodes" && i + 1 < argc) {
+                window_steps = std::stoull(argv[++i]);
+            } else if (arg == "--queries" && i + 1 < argc) {
+                queries = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else if (arg == "--threads" && i + 1 < argc) {
+                threads = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else {
+                input = arg;
+            }
+        }
+        if (input.empty()) {
+            std::cerr << "Usage: " << argv[0]
+                      << " <index.pdx> [--nodes N] [--queries N] [--threads N]" << std::endl;
+            return 1;
+        }
+
+        PathIndexReader index(input);
+        std::vector<std::uint32_t> nonempty_paths;
+        for (std::uint32_t path_id = 0; path_id < index.path_count(); ++path_id) {
+            if (index.get_path_info(path_id).step_count != 0) nonempty_paths.push_back(path_id);
+        }
+        if (nonempty_paths.empty()) throw std::runtime_error("Path index has no steps");
+
+        std::mt19937_64 rng(42);
+        std::vector<std::vector<std::uint32_t>> node_sets;
+        for (unsigned q = 0; q < queries; ++q) {
+            const auto path_id = nonempty_paths[rng() % nonempty_paths.size()];
+            const auto step_count = index.get_path_info(path_id).step_count;
+            const auto start = rng() % step_count;
+            std::vector<std::uint32_t> nodes;
+            index.for_each_step(path_id, start, window_steps,
+                [&](const gfaidx::paths::StepRecord& step, std::uint64_t) {
+                    nodes.push_back(step.node_id);
+                });
+            std::sort(nodes.begin(), nodes.end());
+            nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+            node_sets.push_back(std::move(nodes));
+        }
+
+        std::vector<std::vector<SubpathRun>> expected(node_sets.size());
+        auto start = Clock::now();
+        for (std::size_t q = 0; q < node_sets.size(); ++q) {
+            expected[q] = reference_find_subpaths(index, node_sets[q]);
+        }
+        const double reference_seconds = seconds_since(start);
+
+        std::uint64_t total_nodes = 0;
+        std::uint64_t total_runs = 0;
+        for (std::size_t q = 0; q < node_sets.size(); ++q) {
+            total_nodes += node_sets[q].size();
+            total_runs += expected[q].size();
+        }
+        std::cout << input << std::endl;
+        std::cout << "  queries:               " << node_sets.size() << " ("
+                  << total_nodes << " nodes, " << total_runs << " runs)" << std::endl;
+
+        const auto report = [&](const std::string& label, double seconds) {
+            std::cout << "  " << std::left << std::setw(22) << label << std::right
+                      << std::setw(10) << std::fixed << std::setprecision(3) << seconds << " s  "
+                      << std::setw(8) << std::setprecision(2) << reference_seconds / seconds
+                      << "x" << std::endl;
+        };
+        report("hash map reference", reference_seconds);
+
+        for (const unsigned worker_count : {1u, threads}) {
+            start = Clock::now();
+            for (std::size_t q = 0; q < node_sets.size(); ++q) {
+                const auto runs = gfaidx::paths::find_subpaths_for_node_ids(
+                    index, node_sets[q], worker_count);
+                if (!same_runs(runs, expected[q])) {
+                    throw std::runtime_error("find_subpaths_for_node_ids disagrees with the reference");
+                }
+            }
+            report("flat buffer, " + std::to_string(worker_count) + " thread(s)",
+                   seconds_since(start));
+        }
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
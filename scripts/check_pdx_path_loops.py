@@ -19,14 +19,16 @@ from typing import BinaryIO, Iterator
 
 
 MAGIC = b"GFPATH1\x00"
-SUPPORTED_VERSION = 4
-NODE_MASK = 0x7FFFFFFF
-REVERSE_BIT = 0x80000000
+SUPPORTED_VERSION = 11
 
-HEADER_STRUCT = struct.Struct("<8sIIQQQQQQQQQQ")
-PATH_RECORD_STRUCT = struct.Struct("<c7x" + "Q" * 13 + "qq")
+STEP_BLOCK_SIZE = 128
+STEP_DATA_PADDING = 8
+
+HEADER_STRUCT = struct.Struct("<8sIIQQQQQQQQQQQQQQ")
+PATH_RECORD_STRUCT = struct.Struct("<c7x" + "Q" * 13 + "qqQQ")
 NODE_RECORD_STRUCT = struct.Struct("<QQQQ")
-STEP_STRUCT = struct.Struct("<I")
+STEP_BLOCK_STRUCT = struct.Struct("<QIB3x")
+STEP_PHRASE_STRUCT = struct.Struct("<QQ")
 
 
 @dataclass
@@ -40,6 +42,17 @@ class Header:
     posting_table_offset: int
     strings_offset: int
     strings_size: int
+    step_block_count: int
+    step_phrase_count: int
+    literal_step_count: int
+
+    @property
+    def step_phrase_offset(self) -> int:
+        return self.step_table_offset + self.step_block_count * STEP_BLOCK_STRUCT.size
+
+    @property
+    def step_data_offset(self) -> int:
+        return self.step_phrase_offset + self.step_phrase_count * STEP_PHRASE_STRUCT.size
 
 
 @dataclass
@@ -49,6 +62,8 @@ class PathRecord:
     name: str
     step_begin: int
     step_count: int
+    step_phrase_begin: int
+    step_phrase_count: int
 
 
 def read_exact_at(handle: BinaryIO, offset: int, size: int) -> bytes:
@@ -63,7 +78,7 @@ def read_exact_at(handle: BinaryIO, offset: int, size: int) -> bytes:
 
 
 def read_header(handle: BinaryIO) -> Header:
-    """Read and validate the current version-4 PDX header."""
+    """Read and validate the current version-7 PDX header."""
     values = HEADER_STRUCT.unpack(read_exact_at(handle, 0, HEADER_STRUCT.size))
     if values[0] != MAGIC:
         raise RuntimeError("Invalid .pdx magic")
@@ -80,14 +95,15 @@ def read_header(handle: BinaryIO) -> Header:
         posting_table_offset=values[10],
         strings_offset=values[11],
         strings_size=values[12],
+        step_block_count=values[13],
+        step_phrase_count=values[14],
+        literal_step_count=values[15],
     )
     if header.path_table_offset + header.path_count * PATH_RECORD_STRUCT.size > (
         header.node_table_offset
     ):
         raise RuntimeError("The .pdx path table is truncated or overlaps the node table")
-    if header.step_table_offset + header.step_count * STEP_STRUCT.size > (
-        header.posting_table_offset
-    ):
+    if header.step_data_offset + STEP_DATA_PADDING > header.posting_table_offset:
         raise RuntimeError("The .pdx step table is truncated or overlaps the posting table")
     return header
 
@@ -122,11 +138,15 @@ def find_path(handle: BinaryIO, header: Header, requested_name: str) -> PathReco
             name=name,
             step_begin=values[3],
             step_count=values[4],
+            step_phrase_begin=values[16],
+            step_phrase_count=values[17],
         )
         if record.step_begin > header.step_count or record.step_count > (
             header.step_count - record.step_begin
         ):
             raise RuntimeError("The selected path steps are outside the .pdx step table")
+        if record.step_phrase_begin + record.step_phrase_count > header.step_phrase_count:
+            raise RuntimeError("The selected path phrases are outside the .pdx phrase table")
         matches.append(record)
 
     if not matches:
@@ -140,30 +160,69 @@ def find_path(handle: BinaryIO, header: Header, requested_name: str) -> PathReco
     return matches[0]
 
 
+def decode_literal_block(
+    handle: BinaryIO, header: Header, block: int
+) -> tuple[list[int], int]:
+    """Decode one bitpacked literal block into packed step words."""
+    if block >= header.step_block_count:
+        raise RuntimeError(f"Literal block {block} is outside the .pdx block directory")
+    data_offset, base, width = STEP_BLOCK_STRUCT.unpack(
+        read_exact_at(
+            handle,
+            header.step_table_offset + block * STEP_BLOCK_STRUCT.size,
+            STEP_BLOCK_STRUCT.size,
+        )
+    )
+    count = min(STEP_BLOCK_SIZE, header.literal_step_count - block * STEP_BLOCK_SIZE)
+    packed = int.from_bytes(
+        read_exact_at(
+            handle, header.step_data_offset + data_offset, (count * width + 7) // 8
+        ),
+        "little",
+    )
+    mask = (1 << width) - 1
+    return [(packed >> (i * width)) & mask for i in range(count)], base
+
+
 def iter_path_steps(
     handle: BinaryIO,
     header: Header,
     path: PathRecord,
-    chunk_steps: int = 1 << 20,
 ) -> Iterator[tuple[int, int, bool]]:
-    """Stream packed steps as (zero-based step, node rank, is_reverse)."""
-    remaining = path.step_count
+    """Decode path phrases as (zero-based step, node rank, is_reverse)."""
+    phrases = read_exact_at(
+        handle,
+        header.step_phrase_offset + path.step_phrase_begin * STEP_PHRASE_STRUCT.size,
+        path.step_phrase_count * STEP_PHRASE_STRUCT.size,
+    )
     step_rank = 0
-    byte_offset = header.step_table_offset + path.step_begin * STEP_STRUCT.size
-
-    while remaining:
-        take = min(remaining, chunk_steps)
-        raw = read_exact_at(handle, byte_offset, take * STEP_STRUCT.size)
-        for (packed,) in STEP_STRUCT.iter_unpack(raw):
-            node_rank = packed & NODE_MASK
+    cached_block = -1
+    values: list[int] = []
+    base = 0
+
+    for literal_begin, step_end in STEP_PHRASE_STRUCT.iter_unpack(phrases):
+        if step_end <= step_rank or step_end > path.step_count:
+            raise RuntimeError("A .pdx step phrase is out of order")
+        literal = literal_begin
+        while step_rank < step_end:
+            if literal >= header.literal_step_count:
+                raise RuntimeError("A .pdx step phrase is outside the literal steps")
+            block = literal // STEP_BLOCK_SIZE
+            if block != cached_block:
+                values, base = decode_literal_block(handle, header, block)
+                cached_block = block
+            value = values[literal % STEP_BLOCK_SIZE]
+            node_rank = base + (value >> 1)
             if node_rank >= header.node_count:
                 raise RuntimeError(
                     f"Step {step_rank} has node rank {node_rank} outside the node table"
                 )
-            yield step_rank, node_rank, bool(packed & REVERSE_BIT)
+            yield step_rank, node_rank, bool(value & 1)
             step_rank += 1
-        remaining -= take
-        byte_offset += take * STEP_STRUCT.size
+            literal += 1
+
+    if step_rank != path.step_count:
+        raise RuntimeError("The .pdx step phrases do not cover the whole path")
 
 
 def read_node_name(handle: BinaryIO, header: Header, node_rank: int) -> str:
@@ -255,7 +314,7 @@ def check_path(
 
 def main() -> int:
     parser = argparse.ArgumentParser(
-        description="Check whether one path in a version-4 .pdx revisits nodes"
+        description="Check whether one path in a version-7 .pdx revisits nodes"
     )
     parser.add_argument("pdx", help="input path index")
     parser.add_argument(
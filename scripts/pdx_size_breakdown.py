@@ -16,13 +16,15 @@ import struct
 from dataclasses import dataclass
 
 
-HEADER_STRUCT = struct.Struct("<8sIIQQQQQQQQQQ")
+HEADER_STRUCT = struct.Struct("<8sIIQQQQQQQQQQQQQQ")
 HEADER_SIZE = HEADER_STRUCT.size
 MAGIC = b"GFPATH1\x00"
 
-PATH_RECORD_SIZE = 128
+PATH_RECORD_SIZE = 144
 NODE_RECORD_SIZE = 32
-STEP_RECORD_SIZE = 4
+STEP_BLOCK_RECORD_SIZE = 16
+STEP_BLOCK_SIZE = 128
+STEP_PHRASE_RECORD_SIZE = 16
 
 
 @dataclass
@@ -40,6 +42,10 @@ class Header:
     posting_table_offset: int
     strings_offset: int
     strings_size: int
+    step_block_count: int
+    step_phrase_count: int
+    literal_step_count: int
+    path_layout_hash: int
 
 
 def format_bytes(value: int) -> str:
@@ -69,7 +75,7 @@ def read_header(path: str) -> Header:
     header = Header(*HEADER_STRUCT.unpack(raw))
     if header.magic != MAGIC:
         raise RuntimeError("Invalid .pdx magic")
-    if header.version != 4:
+    if header.version != 11:
         raise RuntimeError(f"Unsupported .pdx version: {header.version}")
     return header
 
@@ -86,8 +92,15 @@ def main() -> int:
     path_table_size = header.node_table_offset - header.path_table_offset
     node_table_size = header.step_table_offset - header.node_table_offset
     step_table_size = header.posting_table_offset - header.step_table_offset
+    step_directory_size = header.step_block_count * STEP_BLOCK_RECORD_SIZE
+    step_phrase_size = header.step_phrase_count * STEP_PHRASE_RECORD_SIZE
+    step_data_size = step_table_size - step_directory_size - step_phrase_size
     posting_table_size = header.strings_offset - header.posting_table_offset
     strings_size = header.strings_size
+    names_offset = (header.strings_offset + strings_size + 7) & ~7
+    namespace_offset = names_offset + header.path_count * 16
+    namespace_table_size = file_size - namespace_offset
+    path_name_table_size = namespace_offset - header.strings_offset - strings_size
 
     accounted = (
         header_size
@@ -96,6 +109,8 @@ def main() -> int:
         + step_table_size
         + posting_table_size
         + strings_size
+        + path_name_table_size
+        + namespace_table_size
     )
     trailing = file_size - accounted
 
@@ -104,15 +119,19 @@ def main() -> int:
     print(f"Format version: {header.version}")
     print()
     print("Counts")
-    print(f"  paths:    {header.path_count}")
-    print(f"  nodes:    {header.node_count}")
-    print(f"  steps:    {header.step_count}")
-    print(f"  postings: {header.posting_count}")
+    print(f"  paths:         {header.path_count}")
+    print(f"  nodes:         {header.node_count}")
+    print(f"  steps:         {header.step_count}")
+    print(f"  postings:      {header.posting_count}")
+    print(f"  literal steps: {header.literal_step_count}")
+    print(f"  step blocks:   {header.step_block_count}")
+    print(f"  step phrases:  {header.step_phrase_count}")
     print()
     print("Record sizes")
     print(f"  path record:    {PATH_RECORD_SIZE} B")
     print(f"  node record:    {NODE_RECORD_SIZE} B")
-    print(f"  step record:    {STEP_RECORD_SIZE} B")
+    print(f"  step block:     {STEP_BLOCK_RECORD_SIZE} B directory entry per {STEP_BLOCK_SIZE} literal steps")
+    print(f"  step phrase:    {STEP_PHRASE_RECORD_SIZE} B")
     print("  posting record: compressed per-node blocks")
     print()
     print("Section offsets")
@@ -122,22 +141,31 @@ def main() -> int:
     print(f"  step table:     {header.step_table_offset}")
     print(f"  posting table:  {header.posting_table_offset}")
     print(f"  strings:        {header.strings_offset}")
+    print(f"  path names:     {names_offset}")
+    print(f"  namespaces:     {namespace_offset}")
     print()
     print("Section sizes")
     print(f"  header:         {format_bytes(header_size):>12}  {pct(header_size, file_size):>8}")
     print(f"  path table:     {format_bytes(path_table_size):>12}  {pct(path_table_size, file_size):>8}")
     print(f"  node table:     {format_bytes(node_table_size):>12}  {pct(node_table_size, file_size):>8}")
     print(f"  step table:     {format_bytes(step_table_size):>12}  {pct(step_table_size, file_size):>8}")
+    print(f"    directory:    {format_bytes(step_directory_size):>12}  {pct(step_directory_size, file_size):>8}")
+    print(f"    phrases:      {format_bytes(step_phrase_size):>12}  {pct(step_phrase_size, file_size):>8}")
+    print(f"    packed data:  {format_bytes(step_data_size):>12}  {pct(step_data_size, file_size):>8}")
     print(f"  posting table:  {format_bytes(posting_table_size):>12}  {pct(posting_table_size, file_size):>8}")
     print(f"  strings:        {format_bytes(strings_size):>12}  {pct(strings_size, file_size):>8}")
+    print(f"  path names:     {format_bytes(path_name_table_size):>12}  {pct(path_name_table_size, file_size):>8}")
+    print(f"  namespaces:     {format_bytes(namespace_table_size):>12}  {pct(namespace_table_size, file_size):>8}")
     if trailing != 0:
         label = "unaccounted" if trailing > 0 else "over-accounted"
         print(f"  {label}:     {format_bytes(abs(trailing)):>12}  {pct(abs(trailing), file_size):>8}")
     print()
     print("Derived totals")
     print(f"  accounted:      {format_bytes(accounted)}")
+    if header.step_count:
+        print(f"  step bits/step: {8.0 * step_table_size / header.step_count:.2f}")
     print(f"  step+posting:   {format_bytes(step_table_size + posting_table_size)}")
-    print(f"  metadata-ish:   {format_bytes(header_size + path_table_size + node_table_size + strings_size)}")
+    print(f"  metadata-ish:   {format_bytes(header_size + path_table_size + node_table_size + strings_size + path_name_table_size + namespace_table_size)}")
     return 0
 
 
@@ -1,13 +1,15 @@
 #!/usr/bin/env python3
-"""Estimate .pdx step-table savings from bit-packing node id + orientation.
+"""Compare the .pdx step table against simpler encodings.
 
 Usage:
     python3 scripts/pdx_step_bitpack_estimate.py graph.pdx
 
-The current .pdx step table stores one 32-bit word per step: 31 bits for the
-rank-aligned node id and 1 orientation bit. This script only reads the .pdx
-header and estimates how much smaller the step table and whole file would be if
-each step used the minimum fixed bit width required by this graph.
+The .pdx step table stores each path as 16-byte phrases over one shared
+literal step stream. The literal stream is split into blocks of up to 128
+steps, each bitpacked against its smallest node id, with a 16-byte directory
+entry per block. This script only reads the .pdx header. It compares the
+actual step table with fixed 32-bit step words and with one global fixed bit
+width per step, both without any sharing between paths.
 """
 
 from __future__ import annotations
@@ -19,11 +21,13 @@ import struct
 from dataclasses import dataclass
 
 
-HEADER_STRUCT = struct.Struct("<8sIIQQQQQQQQQQ")
+HEADER_STRUCT = struct.Struct("<8sIIQQQQQQQQQQQQQQ")
 HEADER_SIZE = HEADER_STRUCT.size
 MAGIC = b"GFPATH1\x00"
-SUPPORTED_VERSION = 4
-CURRENT_STEP_BITS = 32
+SUPPORTED_VERSION = 11
+RAW_STEP_BITS = 32
+STEP_BLOCK_RECORD_SIZE = 16
+STEP_PHRASE_RECORD_SIZE = 16
 
 
 @dataclass
@@ -41,6 +45,10 @@ class Header:
     posting_table_offset: int
     strings_offset: int
     strings_size: int
+    step_block_count: int
+    step_phrase_count: int
+    literal_step_count: int
+    path_layout_hash: int
 
 
 def format_bytes(value: int) -> str:
@@ -102,7 +110,7 @@ def main() -> int:
         "--align",
         type=int,
         default=8,
-        help="byte alignment for the packed step table estimate [default: 8]",
+        help="byte alignment for the global fixed-width estimate [default: 8]",
     )
     args = parser.parse_args()
 
@@ -112,45 +120,47 @@ def main() -> int:
     file_size = os.path.getsize(args.pdx)
     header = read_header(args.pdx)
     current_step_bytes = header.posting_table_offset - header.step_table_offset
-    expected_step_bytes = header.step_count * (CURRENT_STEP_BITS // 8)
-    other_file_bytes = file_size - current_step_bytes
+    directory_bytes = header.step_block_count * STEP_BLOCK_RECORD_SIZE
+    phrase_bytes = header.step_phrase_count * STEP_PHRASE_RECORD_SIZE
+    raw_step_bytes = header.step_count * (RAW_STEP_BITS // 8)
 
     node_bits = bits_for_node_ids(header.node_count)
     bits_per_step = node_bits + 1  # One extra bit stores orientation.
-    estimated_step_bytes = packed_bytes(header.step_count, bits_per_step, args.align)
-    saved_step_bytes = current_step_bytes - estimated_step_bytes
-    estimated_file_size = other_file_bytes + estimated_step_bytes
-    saved_file_bytes = file_size - estimated_file_size
+    global_step_bytes = packed_bytes(header.step_count, bits_per_step, args.align)
 
     print(f"File: {args.pdx}")
     print(f"File size: {format_bytes(file_size)}")
     print(f"Format version: {header.version}")
     print()
     print("Counts")
-    print(f"  nodes: {header.node_count}")
-    print(f"  steps: {header.step_count}")
+    print(f"  nodes:         {header.node_count}")
+    print(f"  steps:         {header.step_count}")
+    print(f"  literal steps: {header.literal_step_count}")
+    print(f"  step blocks:   {header.step_block_count}")
+    print(f"  step phrases:  {header.step_phrase_count}")
     print()
     print("Current step table")
-    print(f"  current bits/step:      {CURRENT_STEP_BITS}")
-    print(f"  current step bytes:     {format_bytes(current_step_bytes)}")
-    if current_step_bytes != expected_step_bytes:
-        print(f"  expected 4B * steps:    {format_bytes(expected_step_bytes)}")
+    print(f"  directory bytes:        {format_bytes(directory_bytes)}")
+    print(f"  phrase bytes:           {format_bytes(phrase_bytes)}")
+    print(f"  packed data bytes:      {format_bytes(current_step_bytes - directory_bytes - phrase_bytes)}")
+    print(f"  total step bytes:       {format_bytes(current_step_bytes)}")
+    if header.step_count:
+        print(f"  bits/step:              {8.0 * current_step_bytes / header.step_count:.2f}")
     print()
-    print("Bit-packed estimate")
+    print("Fixed 32-bit step words")
+    print(f"  step bytes:             {format_bytes(raw_step_bytes)}")
+    print(f"  saved by current:       {format_bytes(raw_step_bytes - current_step_bytes)}  {pct(raw_step_bytes - current_step_bytes, raw_step_bytes)}")
+    print()
+    print("Global fixed-width estimate")
     print(f"  node id bits:           {node_bits}")
     print(f"  orientation bits:       1")
-    print(f"  estimated bits/step:    {bits_per_step}")
+    print(f"  bits/step:              {bits_per_step}")
     print(f"  alignment:              {args.align} B")
-    print(f"  estimated step bytes:   {format_bytes(estimated_step_bytes)}")
-    print(f"  step table saved:       {format_bytes(saved_step_bytes)}  {pct(saved_step_bytes, current_step_bytes)}")
-    print()
-    print("Whole-file estimate")
-    print(f"  estimated file size:    {format_bytes(estimated_file_size)}")
-    print(f"  file bytes saved:       {format_bytes(saved_file_bytes)}  {pct(saved_file_bytes, file_size)}")
+    print(f"  step bytes:             {format_bytes(global_step_bytes)}")
+    print(f"  saved by current:       {format_bytes(global_step_bytes - current_step_bytes)}  {pct(global_step_bytes - current_step_bytes, global_step_bytes)}")
     print()
     print("Notes")
-    print("  This is a fixed-width bit-packing estimate for the step table only.")
-    print("  It does not change the posting table or add any offset/index overhead.")
+    print("  Negative savings mean the simpler encoding would be smaller for this file.")
     return 0
 
 
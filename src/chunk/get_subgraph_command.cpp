@@ -9,12 +9,12 @@
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
-#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -29,6 +29,7 @@
 #include "utils/debug_trace.h"
 #include "utils/Timer.h"
 #include "utils/cli_helpers.h"
+#include "utils/parallel_tasks.h"
 
 namespace gfaidx::chunk {
 namespace {
@@ -551,14 +552,13 @@ std::vector<SubpathFormattingJob> build_subpath_formatting_jobs(
     return jobs;
 }
 
-// One slot holds one completed job until the main thread writes that exact
-// job number. A ring with one slot per worker bounds large record buffers.
+// One slot holds one completed job until its job number is written. A ring
+// with one slot per worker bounds large record buffers.
 struct FormattedSubpathSlot {
     std::size_t sequence{std::numeric_limits<std::size_t>::max()};
     bool ready{false};
     std::string line;
     std::vector<std::string> warnings;
-    std::exception_ptr error;
 };
 
 // Format one run without touching the shared output stream. Warnings are
@@ -610,12 +610,11 @@ void format_subpath_record(
         run.step_count, subpath_name);
 }
 
-// Use persistent worker-local readers for independent seeks into the packed
-// step table. All workers share the immutable selected-name lookup, which has
-// no file stream or mutable cache state.
+// All workers share the mmap-backed path index and the immutable selected-name
+// lookup; neither has a file stream or mutable cache state.
 std::uint64_t emit_subpaths_in_parallel(
     std::ostream& out,
-    const std::string& path_index_path,
+    const paths::PathIndexReader& step_index,
     const paths::SelectedNodeNameLookup& node_name_lookup,
     const std::vector<paths::SubpathRun>& runs,
     const paths::WalkCoordState& walk_coord_state,
@@ -633,142 +632,80 @@ std::uint64_t emit_subpaths_in_parallel(
         std::to_string(runs.size()) + " records)");
 
     std::vector<FormattedSubpathSlot> slots(worker_count);
-    std::vector<std::thread> workers;
-    workers.reserve(worker_count);
     std::mutex state_mutex;
-    std::condition_variable work_available;
-    std::condition_variable result_available;
-    std::size_t next_job = 0;
+    std::condition_variable window_open;
     std::size_t next_output = 0;
+    bool writing = false;
     bool stop = false;
-    std::exception_ptr startup_error;
 
-    // This cleanup path is used for normal completion, formatting errors, and
-    // output failures, so no joinable std::thread can escape the function.
-    const auto stop_and_join = [&]() {
+    // Jobs are claimed in order, and a job waits until its slot leaves the
+    // ring window, so the job at next_output is never the one waiting. The
+    // worker that stores the next job to write becomes the writer and drains
+    // every ready slot in order; the others go back to formatting.
+    const auto format_job = [&](std::size_t sequence) {
         {
-            std::lock_guard<std::mutex> lock(state_mutex);
-            stop = true;
-        }
-        work_available.notify_all();
-        result_available.notify_all();
-        for (auto& worker : workers) {
-            if (worker.joinable()) worker.join();
-        }
-    };
-
-    try {
-        for (std::size_t worker_number = 0;
-             worker_number < worker_count; ++worker_number) {
-            workers.emplace_back([&]() {
-                try {
-                    // An independent file stream is required because seekg and
-                    // read mutate stream state even through const reader APIs.
-                    paths::PathIndexReader step_index(path_index_path);
-                    // Short-record jobs reuse this scratch string; long-record
-                    // jobs hand its allocation directly to the output slot.
-                    std::string record_buffer;
-                    while (true) {
-                        std::size_t sequence = 0;
-                        {
-                            std::unique_lock<std::mutex> lock(state_mutex);
-                            work_available.wait(lock, [&]() {
-                                return stop || next_job >= jobs.size() ||
-                                       next_job < next_output + slots.size();
-                            });
-                            if (stop || next_job >= jobs.size()) return;
-                            sequence = next_job++;
-                        }
-
-                        FormattedSubpathSlot result;
-                        result.sequence = sequence;
-                        try {
-                            const auto& job = jobs[sequence];
-                            for (std::size_t run_index = job.begin_run;
-                                 run_index < job.end_run; ++run_index) {
-                                format_subpath_record(
-                                    record_buffer, step_index,
-                                    node_name_lookup, runs[run_index],
-                                    walk_coord_state, with_walk_coordinates,
-                                    result.warnings);
-                                if (result.line.empty()) {
-                                    result.line.swap(record_buffer);
-                                } else {
-                                    result.line.append(record_buffer);
-                                }
-                            }
-                        } catch (...) {
-                            result.error = std::current_exception();
-                        }
-
-                        {
-                            std::lock_guard<std::mutex> lock(state_mutex);
-                            if (stop) return;
-                            auto& slot = slots[sequence % slots.size()];
-                            slot = std::move(result);
-                            slot.ready = true;
-                            if (slot.error) {
-                                result_available.notify_one();
-                                return;
-                            }
-                        }
-                        result_available.notify_one();
-                    }
-                } catch (...) {
-                    // Reader construction failures have no sequence number;
-                    // wake the writer immediately and preserve the exception.
-                    {
-                        std::lock_guard<std::mutex> lock(state_mutex);
-                        if (!startup_error) startup_error = std::current_exception();
-                        stop = true;
-                    }
-                    work_available.notify_all();
-                    result_available.notify_all();
-                }
+            std::unique_lock<std::mutex> lock(state_mutex);
+            window_open.wait(lock, [&]() {
+                return stop || sequence < next_output + slots.size();
             });
+            if (stop) return;
         }
 
-        while (next_output < jobs.size()) {
-            FormattedSubpathSlot* slot = nullptr;
-            {
-                std::unique_lock<std::mutex> lock(state_mutex);
-                result_available.wait(lock, [&]() {
-                    const auto& candidate = slots[next_output % slots.size()];
-                    return startup_error ||
-                           (candidate.ready &&
-                            candidate.sequence == next_output);
-                });
-                if (startup_error) std::rethrow_exception(startup_error);
-                slot = &slots[next_output % slots.size()];
+        // Short records reuse this scratch string; the first record hands its
+        // allocation directly to the output slot.
+        FormattedSubpathSlot result;
+        result.sequence = sequence;
+        std::string record_buffer;
+        const auto& job = jobs[sequence];
+        for (std::size_t run_index = job.begin_run; run_index < job.end_run; ++run_index) {
+            format_subpath_record(record_buffer, step_index, node_name_lookup,
+                                  runs[run_index], walk_coord_state,
+                                  with_walk_coordinates, result.warnings);
+            if (result.line.empty()) {
+                result.line.swap(record_buffer);
+            } else {
+                result.line.append(record_buffer);
             }
+        }
 
-            // The ring window prevents this slot from being reused until
-            // next_output advances, so it is safe to write without the mutex.
-            if (slot->error) std::rethrow_exception(slot->error);
-            for (const auto& warning : slot->warnings) {
-                warn_get_subgraph(warning);
-            }
-            out.write(slot->line.data(),
-                      static_cast<std::streamsize>(slot->line.size()));
+        std::unique_lock<std::mutex> lock(state_mutex);
+        if (stop) return;
+        slots[sequence % slots.size()] = std::move(result);
+        slots[sequence % slots.size()].ready = true;
+        if (writing) return;
+        writing = true;
+        while (true) {
+            auto& slot = slots[next_output % slots.size()];
+            if (!slot.ready || slot.sequence != next_output) break;
+            // The ring window keeps this slot from being reused until
+            // next_output advances, so it is written without the mutex.
+            lock.unlock();
+            for (const auto& warning : slot.warnings) warn_get_subgraph(warning);
+            out.write(slot.line.data(), static_cast<std::streamsize>(slot.line.size()));
             if (!out) {
-                throw std::runtime_error(
-                    "Failed while writing parallel P/W record");
+                throw std::runtime_error("Failed while writing parallel P/W record");
             }
+            lock.lock();
+            slot = FormattedSubpathSlot{};
+            ++next_output;
+            window_open.notify_all();
+        }
+        writing = false;
+    };
 
+    utils::run_parallel_tasks(jobs.size(), worker_count, [&](std::size_t sequence) {
+        try {
+            format_job(sequence);
+        } catch (...) {
+            // Wake every job waiting for the window so the pool can stop.
             {
                 std::lock_guard<std::mutex> lock(state_mutex);
-                *slot = FormattedSubpathSlot{};
-                ++next_output;
+                stop = true;
             }
-            // Exactly one new job enters the bounded window per consumed slot.
-            work_available.notify_one();
+            window_open.notify_all();
+            throw;
         }
-    } catch (...) {
-        stop_and_join();
-        throw;
-    }
-
-    stop_and_join();
+    });
     return static_cast<std::uint64_t>(runs.size());
 }
 
@@ -776,7 +713,6 @@ std::uint64_t emit_subpaths_in_parallel(
 // .pdx exists. This keeps graph extraction and path extraction in one command.
 std::uint64_t emit_subpaths_if_available(std::ostream& out,
                                          const paths::PathIndexReader& index,
-                                         const std::string& path_index_path,
                                          const std::vector<std::uint32_t>& node_ids,
                                          const std::vector<std::string>& node_names,
                                          const std::vector<paths::SubpathRun>* selected_path_runs,
@@ -794,7 +730,7 @@ std::uint64_t emit_subpaths_if_available(std::ostream& out,
     const std::vector<paths::SubpathRun>* runs = selected_path_runs;
     if (runs == nullptr) {
         discovered_runs =
-            paths::find_subpaths_for_node_ids(index, node_ids);
+            paths::find_subpaths_for_node_ids(index, node_ids, threads);
         runs = &discovered_runs;
     } else {
         info_get_subgraph(
@@ -855,7 +791,7 @@ std::uint64_t emit_subpaths_if_available(std::ostream& out,
 
     if (threads > 1 && runs->size() > 1) {
         const auto emitted = emit_subpaths_in_parallel(
-            out, path_index_path, node_name_lookup, *runs, walk_coord_state,
+            out, index, node_name_lookup, *runs, walk_coord_state,
             with_walk_coordinates, threads);
         info_get_subgraph("P/W coordinate calculation and output finished in " +
                           elapsed_seconds(output_timer));
@@ -888,8 +824,12 @@ std::uint64_t emit_subpaths_if_available(std::ostream& out,
 // Write an already selected node set by replaying only its communities and the
 // shared-edge member. BFS and posting-based coordinate selection both finish
 // here, keeping graph/path output behavior identical between selection modes.
+// Records go to out_stream when it is set; otherwise output_gfa is created only
+// once a non-empty selection exists.
 int materialize_selected_subgraph(
     const SubgraphExtractionOptions& options,
+    const std::string& output_gfa,
+    std::ostream* out_stream,
     const std::vector<CommunitySpan>& spans,
     const ResolvedIndexPaths& index_paths,
     const indexer::NodeHashIndex& node_index,
@@ -931,15 +871,19 @@ int materialize_selected_subgraph(
         node_set.emplace(node_name);
     }
 
-    std::ofstream out(options.output_gfa);
-    if (!out) {
-        throw std::runtime_error("Failed to open output GFA file for writing: " +
-                                 options.output_gfa);
+    std::ofstream output_file;
+    if (out_stream == nullptr) {
+        output_file.open(output_gfa);
+        if (!output_file) {
+            throw std::runtime_error("Failed to open output GFA file for writing: " +
+                                     output_gfa);
+        }
     }
+    std::ostream& out = out_stream != nullptr ? *out_stream : output_file;
 
     Timer graph_materialization_timer;
     info_get_subgraph("Starting subgraph materialization into " +
-                      options.output_gfa);
+                      output_gfa);
     emit_header_if_present(out, options.input_gz, spans);
     EmissionStats total_stats{};
     for (const auto community_id : materialization_communities) {
@@ -981,7 +925,6 @@ int materialize_selected_subgraph(
             subpath_count = emit_subpaths_if_available(
                 out,
                 preserved_paths->path_index,
-                index_paths.pdx_path,
                 *path_node_ranks,
                 node_names,
                 &preserved_paths->path_runs,
@@ -998,7 +941,6 @@ int materialize_selected_subgraph(
             subpath_count = emit_subpaths_if_available(
                 out,
                 path_index,
-                index_paths.pdx_path,
                 *path_node_ranks,
                 node_names,
                 nullptr,
@@ -1014,7 +956,7 @@ int materialize_selected_subgraph(
     }
 
     info_get_subgraph("Finished writing extracted subgraph to " +
-                      options.output_gfa);
+                      output_gfa);
     return 0;
 }
 
@@ -1063,7 +1005,7 @@ void configure_get_subgraph_parser(argparse::ArgumentParser& parser) {
     parser.add_argument("--threads")
       .default_value(std::string("1"))
       .nargs(1)
-      .help("number of ordered P/W formatting workers (default: 1)");
+      .help("number of posting decode and ordered P/W formatting workers (default: 1)");
 
     parser.add_argument("--no_paths").default_value(false)
       .implicit_value(true)
@@ -1078,22 +1020,52 @@ void configure_get_subgraph_parser(argparse::ArgumentParser& parser) {
       .help("enable temporary cross-file tracing for get_subgraph debugging");
 }
 
-int extract_subgraph_from_seeds(const SubgraphExtractionOptions& options,
-                                const std::vector<std::string>& seed_nodes) {
+// Everything one graph's extractions share: the resolved companion files, the
+// community spans, the mmap-backed .ndx, and the BFS adjacency with its
+// shared-edge cache. The neighborhood keeps references to the members before
+// it and is created by the first BFS.
+struct SubgraphExtractionSession::State {
+    State(SubgraphExtractionOptions extraction_options,
+          bool require_pdx,
+          bool keep_communities)
+        : options(std::move(extraction_options)),
+          index_paths(resolve_index_paths(options.input_gz,
+                                          options.idx_path,
+                                          options.ndx_path,
+                                          options.pdx_path,
+                                          options.include_paths || require_pdx,
+                                          options.with_walk_coordinates || require_pdx)),
+          spans(load_all_community_spans_tsv(index_paths.idx_path)),
+          node_index(index_paths.ndx_path),
+          shared_chunk_id(spans.size() >= 2 ? static_cast<std::uint32_t>(spans.size() - 1)
+                                            : std::numeric_limits<std::uint32_t>::max()),
+          keep_loaded_communities(keep_communities) {}
+
+    SubgraphExtractionOptions options;
+    ResolvedIndexPaths index_paths;
+    std::vector<CommunitySpan> spans;
+    indexer::NodeHashIndex node_index;
+    std::uint32_t shared_chunk_id;
+    bool keep_loaded_communities;
+    std::unique_ptr<NeighborhoodState> neighborhood;
+};
+
+namespace {
+
+// Validate the options before any index is opened so argument errors are
+// reported ahead of missing-file errors.
+SubgraphExtractionOptions validated_session_options(SubgraphExtractionOptions options,
+                                                    bool require_pdx) {
     if (!file_exists(options.input_gz.c_str())) {
         throw std::runtime_error("Input file does not exist: " + options.input_gz);
     }
-    if (seed_nodes.empty()) {
-        throw std::runtime_error("At least one seed node is required for subgraph extraction");
-    }
-    if (options.max_nodes == 0) {
-        throw std::runtime_error("--max_nodes must be greater than zero");
-    }
     if (options.threads == 0 || options.threads > kMaxExtractionThreads) {
         throw std::runtime_error("--threads must be between 1 and " +
                                  std::to_string(kMaxExtractionThreads));
     }
     if (options.with_walk_coordinates && !options.include_paths) {
+        // Keep the shared library-facing extraction entry points consistent
+        // even when callers bypass the CLI's --with_coords validation.
         throw std::runtime_error(
             "--with_coords requires path output; remove --no_paths");
     }
@@ -1102,17 +1074,26 @@ int extract_subgraph_from_seeds(const SubgraphExtractionOptions& options,
     // translation units can participate in the same debug run.
     if (options.debug_trace) {
         ::setenv("GFAIDX_DEBUG_SUBGRAPH", "1", 1);
-        debug::log_subgraph_trace("Enabled temporary get_subgraph trace logging");
+        debug::log_subgraph_trace(require_pdx
+                                      ? "Enabled temporary exact-subgraph trace logging"
+                                      : "Enabled temporary get_subgraph trace logging");
     }
+    return options;
+}
+
+}  // namespace
 
-    const auto index_paths = resolve_index_paths(options.input_gz,
-                                                 options.idx_path,
-                                                 options.ndx_path,
-                                                 options.pdx_path,
-                                                 options.include_paths,
-                                                 options.with_walk_coordinates);
-    const auto spans = load_all_community_spans_tsv(index_paths.idx_path);
-    if (spans.empty()) {
+SubgraphExtractionSession::SubgraphExtractionSession(SubgraphExtractionOptions options,
+                                                     bool require_pdx,
+                                                     bool keep_loaded_communities)
+    : state_(std::make_unique<State>(validated_session_options(std::move(options), require_pdx),
+                                     require_pdx,
+                                     keep_loaded_communities)) {
+    if (require_pdx && !state_->index_paths.has_pdx) {
+        throw std::runtime_error(
+            "Exact rank-based subgraph extraction requires a companion .pdx");
+    }
+    if (state_->spans.empty()) {
         throw std::runtime_error("The .idx file does not contain any community spans");
     }
 
@@ -1120,15 +1101,30 @@ int extract_subgraph_from_seeds(const SubgraphExtractionOptions& options,
     // confirms which index set was paired with the input gzip.
     if (debug::subgraph_trace_enabled()) {
         std::ostringstream oss;
-        oss << "Resolved index paths idx=" << index_paths.idx_path
-            << " ndx=" << index_paths.ndx_path
-            << " pdx=" << index_paths.pdx_path
-            << " has_pdx=" << index_paths.has_pdx
-            << " spans=" << spans.size();
+        oss << "Resolved index paths idx=" << state_->index_paths.idx_path
+            << " ndx=" << state_->index_paths.ndx_path
+            << " pdx=" << state_->index_paths.pdx_path
+            << " has_pdx=" << state_->index_paths.has_pdx
+            << " spans=" << state_->spans.size();
         gfaidx::debug::log_subgraph_trace(oss.str());
     }
+}
+
+SubgraphExtractionSession::~SubgraphExtractionSession() = default;
+
+int SubgraphExtractionSession::extract_from_seeds(const std::vector<std::string>& seed_nodes,
+                                                  const std::string& output_gfa,
+                                                  std::ostream* out) {
+    const auto& options = state_->options;
+    const auto& spans = state_->spans;
+    auto& node_index = state_->node_index;
+    if (seed_nodes.empty()) {
+        throw std::runtime_error("At least one seed node is required for subgraph extraction");
+    }
+    if (options.max_nodes == 0) {
+        throw std::runtime_error("--max_nodes must be greater than zero");
+    }
 
-    indexer::NodeHashIndex node_index(index_paths.ndx_path);
     std::vector<std::string> unique_seeds = seed_nodes;
     std::sort(unique_seeds.begin(), unique_seeds.end());
     unique_seeds.erase(std::unique(unique_seeds.begin(), unique_seeds.end()), unique_seeds.end());
@@ -1148,108 +1144,68 @@ int extract_subgraph_from_seeds(const SubgraphExtractionOptions& options,
         seed_communities.push_back(community_id);
     }
 
-    std::vector<std::string> node_names;
-    std::vector<std::uint32_t> materialization_communities;
-    std::size_t loaded_community_count = 0;
-    {
-        // Scope the potentially large string adjacency and shared-edge cache
-        // to BFS so they are released before materialization and path work.
-        const std::uint32_t shared_chunk_id =
-            spans.size() >= 2 ? static_cast<std::uint32_t>(spans.size() - 1)
-                              : std::numeric_limits<std::uint32_t>::max();
-        NeighborhoodState state(options.input_gz, spans, node_index, shared_chunk_id);
-        for (std::size_t i = 0; i < unique_seeds.size(); ++i) {
-            state.node_community_cache.emplace(unique_seeds[i], seed_communities[i]);
-        }
+    if (state_->neighborhood == nullptr) {
+        state_->neighborhood = std::make_unique<NeighborhoodState>(
+            options.input_gz, spans, node_index, state_->shared_chunk_id);
+    }
+    auto& state = *state_->neighborhood;
+    for (std::size_t i = 0; i < unique_seeds.size(); ++i) {
+        state.node_community_cache.emplace(unique_seeds[i], seed_communities[i]);
+    }
 
-        info_get_subgraph("Starting multi-source BFS from " +
-                          std::to_string(unique_seeds.size()) +
-                          " seed nodes with max_nodes=" +
-                          std::to_string(options.max_nodes));
-        node_names = bfs_collect_node_names(state, unique_seeds, options.max_nodes);
-        loaded_community_count = state.touched_communities.size();
-
-        // The last admitted node may never be expanded, so independently
-        // collect every selected node's community for final S/L replay.
-        std::unordered_set<std::uint32_t> community_set;
-        community_set.reserve(node_names.size());
-        for (const auto& node_name : node_names) {
-            const std::uint32_t community_id =
-                resolve_node_community(state, node_name, "selected node materialization");
-            if (community_id >= spans.size() || community_id == shared_chunk_id) {
-                throw std::runtime_error("Selected node resolved to an invalid community: " +
-                                         node_name);
-            }
-            community_set.insert(community_id);
+    info_get_subgraph("Starting multi-source BFS from " +
+                      std::to_string(unique_seeds.size()) +
+                      " seed nodes with max_nodes=" +
+                      std::to_string(options.max_nodes));
+    std::vector<std::string> node_names =
+        bfs_collect_node_names(state, unique_seeds, options.max_nodes);
+
+    // The last admitted node may never be expanded, so independently
+    // collect every selected node's community for final S/L replay.
+    std::unordered_set<std::uint32_t> community_set;
+    community_set.reserve(node_names.size());
+    for (const auto& node_name : node_names) {
+        const std::uint32_t community_id =
+            resolve_node_community(state, node_name, "selected node materialization");
+        if (community_id >= spans.size() || community_id == state_->shared_chunk_id) {
+            throw std::runtime_error("Selected node resolved to an invalid community: " +
+                                     node_name);
         }
-        materialization_communities.assign(community_set.begin(), community_set.end());
+        community_set.insert(community_id);
     }
+    std::vector<std::uint32_t> materialization_communities(community_set.begin(),
+                                                           community_set.end());
 
     info_get_subgraph("BFS finished with " + std::to_string(node_names.size()) +
-                      " nodes across " + std::to_string(loaded_community_count) +
+                      " nodes across " + std::to_string(state.touched_communities.size()) +
                       " loaded communities");
+    // Release the potentially large string adjacency and shared-edge cache
+    // before materialization and path work unless later extractions reuse them.
+    if (!state_->keep_loaded_communities) state_->neighborhood.reset();
     return materialize_selected_subgraph(options,
+                                         output_gfa,
+                                         out,
                                          spans,
-                                         index_paths,
+                                         state_->index_paths,
                                          node_index,
                                          std::move(node_names),
                                          std::move(materialization_communities),
                                          nullptr);
 }
 
-int extract_subgraph_from_node_ranks(
-    const SubgraphExtractionOptions& options,
+int SubgraphExtractionSession::extract_from_node_ranks(
     const std::vector<std::uint32_t>& node_ranks,
     const std::vector<paths::SubpathRun>& selected_path_runs,
-    const paths::PathIndexReader& path_index) {
-
-    if (!file_exists(options.input_gz.c_str())) {
-        throw std::runtime_error("Input file does not exist: " +
-                                 options.input_gz);
-    }
+    const paths::PathIndexReader& path_index,
+    const std::string& output_gfa,
+    std::ostream* out) {
+    const auto& spans = state_->spans;
+    const auto& node_index = state_->node_index;
     if (node_ranks.empty()) {
         throw std::runtime_error(
             "At least one node rank is required for exact subgraph extraction");
     }
-    if (options.threads == 0 || options.threads > kMaxExtractionThreads) {
-        throw std::runtime_error("--threads must be between 1 and " +
-                                 std::to_string(kMaxExtractionThreads));
-    }
-    if (options.with_walk_coordinates && !options.include_paths) {
-        // Keep the shared library-facing extraction entry points consistent
-        // even when callers bypass the CLI's --with_coords validation.
-        throw std::runtime_error(
-            "--with_coords requires path output; remove --no_paths");
-    }
-
-    // Export the same trace flag used by BFS so cross-index diagnostics remain
-    // available for exact path-supported materialization.
-    if (options.debug_trace) {
-        ::setenv("GFAIDX_DEBUG_SUBGRAPH", "1", 1);
-        debug::log_subgraph_trace(
-            "Enabled temporary exact-subgraph trace logging");
-    }
 
-    // Exact rank materialization always needs .pdx for rank-to-name conversion,
-    // even when --no_paths suppresses P/W records in the output.
-    const auto index_paths = resolve_index_paths(options.input_gz,
-                                                 options.idx_path,
-                                                 options.ndx_path,
-                                                 options.pdx_path,
-                                                 true,
-                                                 true);
-    if (!index_paths.has_pdx) {
-        throw std::runtime_error(
-            "Exact rank-based subgraph extraction requires a companion .pdx");
-    }
-
-    const auto spans = load_all_community_spans_tsv(index_paths.idx_path);
-    if (spans.empty()) {
-        throw std::runtime_error(
-            "The .idx file does not contain any community spans");
-    }
-
-    indexer::NodeHashIndex node_index(index_paths.ndx_path);
     std::vector<std::uint32_t> unique_node_ranks = node_ranks;
     std::sort(unique_node_ranks.begin(), unique_node_ranks.end());
     unique_node_ranks.erase(
@@ -1260,9 +1216,6 @@ int extract_subgraph_from_node_ranks(
     node_names.reserve(unique_node_ranks.size());
     std::vector<std::uint32_t> materialization_communities;
     std::vector<std::uint8_t> seen_communities(spans.size(), 0);
-    const std::uint32_t shared_chunk_id =
-        spans.size() >= 2 ? static_cast<std::uint32_t>(spans.size() - 1)
-                          : std::numeric_limits<std::uint32_t>::max();
 
     if (path_index.node_count() != node_index.size()) {
         throw std::runtime_error(
@@ -1278,7 +1231,7 @@ int extract_subgraph_from_node_ranks(
         const auto community_id =
             node_index.community_id_by_rank(node_rank);
         if (community_id >= spans.size() ||
-            community_id == shared_chunk_id) {
+            community_id == state_->shared_chunk_id) {
             throw std::runtime_error(
                 "Selected node rank resolved to an invalid community");
         }
@@ -1298,15 +1251,35 @@ int extract_subgraph_from_node_ranks(
         unique_node_ranks,
         selected_path_runs,
         path_index};
-    return materialize_selected_subgraph(options,
+    return materialize_selected_subgraph(state_->options,
+                                         output_gfa,
+                                         out,
                                          spans,
-                                         index_paths,
+                                         state_->index_paths,
                                          node_index,
                                          std::move(node_names),
                                          std::move(materialization_communities),
                                          &preserved_paths);
 }
 
+int extract_subgraph_from_seeds(const SubgraphExtractionOptions& options,
+                                const std::vector<std::string>& seed_nodes) {
+    SubgraphExtractionSession session(options, false, false);
+    return session.extract_from_seeds(seed_nodes, options.output_gfa);
+}
+
+int extract_subgraph_from_node_ranks(
+    const SubgraphExtractionOptions& options,
+    const std::vector<std::uint32_t>& node_ranks,
+    const std::vector<paths::SubpathRun>& selected_path_runs,
+    const paths::PathIndexReader& path_index) {
+    // Exact rank materialization always needs .pdx for rank-to-name conversion,
+    // even when --no_paths suppresses P/W records in the output.
+    SubgraphExtractionSession session(options, true, false);
+    return session.extract_from_node_ranks(
+        node_ranks, selected_path_runs, path_index, options.output_gfa);
+}
+
 int run_get_subgraph(const argparse::ArgumentParser& program) {
     try {
         SubgraphExtractionOptions options;
@@ -2,6 +2,8 @@
 #define GFAIDX_GET_SUBGRAPH_COMMAND_H
 
 #include <cstdint>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -33,6 +35,39 @@ struct SubgraphExtractionOptions {
     bool debug_trace{false};
 };
 
+// Keep one graph's companion indexes, community spans and BFS adjacency open
+// across several extractions, such as the regions of a get_region BED batch.
+// With keep_loaded_communities, every community and the shared-edge cache a
+// BFS loads stay in memory for the following extractions. require_pdx is set
+// for exact rank extraction, which needs .pdx for rank-to-name conversion even
+// when P/W output is disabled.
+class SubgraphExtractionSession {
+public:
+    SubgraphExtractionSession(SubgraphExtractionOptions options,
+                              bool require_pdx,
+                              bool keep_loaded_communities);
+    ~SubgraphExtractionSession();
+
+    SubgraphExtractionSession(const SubgraphExtractionSession&) = delete;
+    SubgraphExtractionSession& operator=(const SubgraphExtractionSession&) = delete;
+
+    // Both extractions create output_gfa once a selection exists, or append
+    // to out when it is set; output_gfa then only names progress messages.
+    // options.output_gfa is not used by a session.
+    int extract_from_seeds(const std::vector<std::string>& seed_nodes,
+                           const std::string& output_gfa,
+                           std::ostream* out = nullptr);
+    int extract_from_node_ranks(const std::vector<std::uint32_t>& node_ranks,
+                                const std::vector<paths::SubpathRun>& selected_path_runs,
+                                const paths::PathIndexReader& path_index,
+                                const std::string& output_gfa,
+                                std::ostream* out = nullptr);
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
 // Configure the get_subgraph CLI for BFS neighborhood extraction from an
 // indexed graph.
 void configure_get_subgraph_parser(argparse::ArgumentParser& parser);
@@ -3,34 +3,48 @@
 #include <algorithm>
 #include <cctype>
 #include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <memory>
 #include <optional>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "chunk/chunk_reader.h"
 #include "chunk/get_subgraph_command.h"
 #include "coordinates/coordinate_index.h"
+#include "coordinates/haplotype_projection.h"
 #include "coordinates/path_coordinate_query.h"
 #include "coordinates/path_haplotype_query.h"
+#include "coordinates/path_liftover.h"
 #include "fs/fs_helpers.h"
 #include "indexer/node_length_index.h"
+#include "paths/node_positions.h"
 #include "paths/p_path_coordinates.h"
+#include "paths/path_coordinate_checkpoints.h"
 #include "paths/path_index.h"
+#include "paths/path_step_offsets.h"
 #include "utils/Timer.h"
 #include "utils/cli_helpers.h"
 
 namespace gfaidx::coordinates {
 namespace {
 
+constexpr std::uint64_t kMinCoordinateEntryMemoryBytes = 64ULL * 1024ULL;
+
 struct ParsedRegion {
     std::string sequence;
     std::uint64_t begin{};
     std::uint64_t end{};
+    // BED name column; empty for the command-line region and unnamed records.
+    std::string name;
 };
 
 std::string coordinate_walk_key(const CoordinateTrackInfo& track) {
@@ -58,16 +72,6 @@ struct CoordinateTrackLookup {
     std::size_t track_index{};
 };
 
-std::string_view coordinate_sequence_name(const CoordinateTrackInfo& track) {
-    // Keep the raw P name in .cdx for exact .pdx identity, but present and query
-    // its terminal :start-end suffix as one fragment of the base namespace.
-    if (track.source_type == 'P') {
-        return paths::parse_p_path_coordinate_name(track.sequence_name)
-            .coordinate_name;
-    }
-    return track.sequence_name;
-}
-
 bool coordinate_track_uses_current_p_semantics(
     const CoordinateTrackInfo& track) {
     if (track.source_type != 'P') return true;
@@ -150,7 +154,7 @@ void write_available_coordinate_paths(
                 out << track.source_type << '\t'
                     << track.reference_name << '\t'
                     << track.haplotype << '\t'
-                    << coordinate_sequence_name(track) << '\t'
+                    << track.coordinate_name << '\t'
                     << track.sequence_start << '\t'
                     << track.sequence_end << '\t'
                     << track.entry_count << "\tcdx\n";
@@ -209,7 +213,7 @@ void write_available_coordinate_paths(
             out << track.source_type << '\t'
                 << track.reference_name << '\t'
                 << track.haplotype << '\t'
-                << coordinate_sequence_name(track) << '\t'
+                << track.coordinate_name << '\t'
                 << track.sequence_start << '\t'
                 << track.sequence_end << '\t'
                 << track.entry_count << '\t'
@@ -273,12 +277,9 @@ std::uint32_t parse_max_nodes(const std::string& value) {
                                    true);
 }
 
-std::optional<std::uint64_t> parse_haplotype_gap_bases(
-    const std::string& value) {
-    // An empty parser default distinguishes an omitted flag from an explicit
-    // zero, which means that only directly adjacent anchor occurrences join.
-    if (value.empty()) return std::nullopt;
-
+// Parse a base count given as a bare number or with a case-insensitive bp,
+// kb, mb, or gb suffix.
+std::uint64_t parse_base_count(const std::string& value, const std::string& option_name) {
     std::string normalized = value;
     std::transform(normalized.begin(), normalized.end(), normalized.begin(),
                    [](const unsigned char ch) {
@@ -304,14 +305,22 @@ std::optional<std::uint64_t> parse_haplotype_gap_bases(
 
     const auto amount = utils::parse_u64_strict(
         normalized.substr(0, normalized.size() - suffix_size),
-        "--haplotype_gap",
+        option_name,
         true);
     if (amount > std::numeric_limits<std::uint64_t>::max() / multiplier) {
-        throw std::runtime_error("--haplotype_gap is too large");
+        throw std::runtime_error(option_name + " is too large");
     }
     return amount * multiplier;
 }
 
+std::optional<std::uint64_t> parse_haplotype_gap_bases(
+    const std::string& value) {
+    // An empty parser default distinguishes an omitted flag from an explicit
+    // zero, which means that only directly adjacent anchor occurrences join.
+    if (value.empty()) return std::nullopt;
+    return parse_base_count(value, "--haplotype_gap");
+}
+
 ParsedRegion parse_region(const std::string& region) {
     // Region strings use the same 0-based, half-open coordinates stored by W
     // records: sequence:start-end.
@@ -336,6 +345,401 @@ ParsedRegion parse_region(const std::string& region) {
     return out;
 }
 
+// Read the first three or four columns of a BED file. Browser, track, comment
+// and blank lines are skipped; BED coordinates are already 0-based half-open.
+std::vector<ParsedRegion> read_regions_bed(const std::string& bed_path) {
+    std::ifstream in(bed_path);
+    if (!in) {
+        throw std::runtime_error("Failed to open regions BED file: " + bed_path);
+    }
+
+    std::vector<ParsedRegion> regions;
+    std::string line;
+    std::uint64_t line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#' || line.rfind("track", 0) == 0 ||
+            line.rfind("browser", 0) == 0) {
+            continue;
+        }
+
+        std::vector<std::string_view> fields;
+        std::string_view rest(line);
+        while (fields.size() < 4) {
+            const auto tab = rest.find('\t');
+            fields.push_back(rest.substr(0, tab));
+            if (tab == std::string_view::npos) break;
+            rest.remove_prefix(tab + 1);
+        }
+        const auto context = bed_path + " line " + std::to_string(line_number);
+        if (fields.size() < 3 || fields[0].empty()) {
+            throw std::runtime_error(context + " needs tab-separated chrom, start and end");
+        }
+
+        ParsedRegion region;
+        region.sequence = std::string(fields[0]);
+        region.begin = utils::parse_u64_strict(fields[1], context + " start");
+        region.end = utils::parse_u64_strict(fields[2], context + " end");
+        if (region.end <= region.begin) {
+            throw std::runtime_error(context + ": end must be greater than start");
+        }
+        if (fields.size() == 4) region.name = std::string(fields[3]);
+        regions.push_back(std::move(region));
+    }
+    return regions;
+}
+
+std::string region_label(const ParsedRegion& region) {
+    if (!region.name.empty()) return region.name;
+    return region.sequence + ":" + std::to_string(region.begin) + "-" +
+           std::to_string(region.end);
+}
+
+// Per-region file name inside a --split_regions directory. The BED record
+// number keeps repeated names apart; other characters that are unsafe in file
+// names become underscores.
+std::string region_file_name(std::size_t record, const ParsedRegion& region) {
+    std::string label = region_label(region);
+    for (auto& ch : label) {
+        const auto c = static_cast<unsigned char>(ch);
+        if (!std::isalnum(c) && ch != '.' && ch != '-' && ch != '_') ch = '_';
+    }
+    return std::to_string(record + 1) + "." + label + ".gfa";
+}
+
+// Stream every community member whose nodes the region selects, in community
+// id order, and return how many were written. The ids come from the .cdx
+// community runs alone, so no node rank is resolved and no BFS is run. Edges
+// between two communities are kept in the shared member and are not written.
+std::size_t write_region_communities(const CoordinateIndexReader& coordinate_index,
+                                     const std::vector<CommunitySpan>& spans,
+                                     const std::string& input_gz,
+                                     const std::string& reference,
+                                     const ParsedRegion& region,
+                                     std::ostream& out) {
+    const auto communities = coordinate_index.query_region_communities(
+        reference, region.sequence, region.begin, region.end);
+    if (communities.empty()) {
+        throw std::runtime_error("No coordinate-indexed nodes overlap the requested region");
+    }
+    const auto shared_chunk_id = spans.size() >= 2
+        ? static_cast<std::uint32_t>(spans.size() - 1)
+        : std::numeric_limits<std::uint32_t>::max();
+    for (const auto community_id : communities) {
+        if (community_id >= spans.size() || community_id == shared_chunk_id) {
+            throw std::runtime_error(".cdx community " + std::to_string(community_id) +
+                                     " is not a community of the .idx; rebuild the .cdx "
+                                     "against the same .ndx");
+        }
+    }
+    for (const auto community_id : communities) {
+        stream_community_lines_from_gz_range(
+            input_gz, spans[community_id].gz_offset, spans[community_id].gz_size,
+            [&](const std::string& line) -> bool {
+                out << line << '\n';
+                return true;
+            });
+    }
+    if (!out) throw std::runtime_error("Failed while writing region communities");
+    return communities.size();
+}
+
+// get_region --communities_only. The output layout matches the default mode:
+// one GFA file, or with a BED batch a #region-tagged stream or a directory of
+// per-region files, and a failed batch region is skipped with a warning.
+int run_region_communities(const std::string& input_gz,
+                           const std::string& cdx_path,
+                           std::string idx_path,
+                           const std::string& reference,
+                           const std::vector<ParsedRegion>& regions,
+                           bool batch,
+                           bool split_regions,
+                           const std::string& output_gfa) {
+    if (!file_exists(input_gz.c_str())) {
+        throw std::runtime_error("Input file does not exist: " + input_gz);
+    }
+    if (!file_exists(cdx_path.c_str())) {
+        throw std::runtime_error("--communities_only requires a coordinate index: " + cdx_path +
+                                 ". Build it with: gfaidx index_coordinates");
+    }
+    if (idx_path.empty()) idx_path = utils::companion_path(input_gz, ".idx");
+    if (!file_exists(idx_path.c_str())) {
+        throw std::runtime_error("Chunk index does not exist: " + idx_path);
+    }
+    const CoordinateIndexReader coordinate_index(cdx_path);
+    const auto spans = load_all_community_spans_tsv(idx_path);
+
+    const auto open_output = [](const std::string& path, std::ofstream& out) {
+        out.open(path);
+        if (!out) throw std::runtime_error("Failed to open output GFA file for writing: " + path);
+    };
+    if (!batch) {
+        std::ofstream out;
+        open_output(output_gfa, out);
+        const auto written = write_region_communities(
+            coordinate_index, spans, input_gz, reference, regions[0], out);
+        std::cout << get_time() << ": Wrote " << written << " communities to " << output_gfa
+                  << std::endl;
+        return 0;
+    }
+
+    std::ofstream stream;
+    if (split_regions) {
+        std::filesystem::create_directories(output_gfa);
+    } else {
+        open_output(output_gfa, stream);
+    }
+    std::size_t written = 0;
+    for (std::size_t i = 0; i < regions.size(); ++i) {
+        const auto& region = regions[i];
+        const auto label = region_label(region);
+        const auto region_path = split_regions
+            ? (std::filesystem::path(output_gfa) / region_file_name(i, region)).string()
+            : std::string();
+        std::ostringstream buffer;
+        try {
+            if (split_regions) {
+                std::ofstream out;
+                open_output(region_path, out);
+                write_region_communities(coordinate_index, spans, input_gz, reference, region, out);
+            } else {
+                write_region_communities(coordinate_index, spans, input_gz, reference, region,
+                                         buffer);
+            }
+        } catch (const std::exception& err) {
+            if (split_regions) remove_path_if_exists(region_path);
+            std::cerr << get_time() << ": Warning: skipped region " << label << ": "
+                      << err.what() << std::endl;
+            continue;
+        }
+        if (!split_regions) {
+            stream << "#region\t" << label << '\t' << region.sequence << ':' << region.begin
+                   << '-' << region.end << '\n' << buffer.str();
+            if (!stream) throw std::runtime_error("Failed while writing " + output_gfa);
+        }
+        ++written;
+    }
+    std::cout << get_time() << ": Wrote " << written << " of " << regions.size()
+              << " regions to " << output_gfa << std::endl;
+    return 0;
+}
+
+// Answers the P/W fallback for regions .cdx cannot resolve. The .lnx and .pcx
+// readers are opened by the first region that needs them and then reused.
+class OnTheFlyPathLookup {
+public:
+    OnTheFlyPathLookup(const paths::PathIndexReader& path_index,
+                       std::string length_index_path,
+                       std::string checkpoint_index_path)
+        : path_index_(path_index),
+          length_index_path_(std::move(length_index_path)),
+          checkpoint_index_path_(std::move(checkpoint_index_path)) {}
+
+    PathCoordinateQueryResult query(std::string_view reference_name,
+                                    std::string_view sequence_name,
+                                    std::uint64_t begin,
+                                    std::uint64_t end) {
+        if (end <= begin) {
+            throw std::runtime_error("Coordinate query end must be greater than start");
+        }
+        if (length_index_path_.empty()) {
+            throw std::runtime_error("On-the-fly path coordinate lookup requires a .lnx node length index");
+        }
+        if (lengths_ == nullptr) {
+            auto lengths = std::make_unique<indexer::NodeLengthIndexReader>(length_index_path_);
+            if (lengths->node_count() != path_index_.node_count()) {
+                throw std::runtime_error(".lnx and .pdx node counts differ; rebuild them against the same .ndx");
+            }
+            lengths_ = std::move(lengths);
+            if (!checkpoint_index_path_.empty()) {
+                checkpoints_ = open_on_the_fly_checkpoints(checkpoint_index_path_,
+                                                           path_index_,
+                                                           lengths_->node_count());
+            }
+        }
+        return query_path_coordinates_on_the_fly(path_index_,
+                                                 *lengths_,
+                                                 checkpoints_.get(),
+                                                 reference_name,
+                                                 sequence_name,
+                                                 begin,
+                                                 end);
+    }
+
+private:
+    const paths::PathIndexReader& path_index_;
+    std::string length_index_path_;
+    std::string checkpoint_index_path_;
+    std::unique_ptr<indexer::NodeLengthIndexReader> lengths_;
+    std::unique_ptr<paths::PathCoordinateCheckpointIndexReader> checkpoints_;
+};
+
+// Readers and extraction state shared by every region of one get_region run.
+struct RegionExtractionContext {
+    RegionExtractionContext(const paths::PathIndexReader& path_index,
+                            OnTheFlyPathLookup& on_the_fly)
+        : path_index(path_index), on_the_fly(on_the_fly) {}
+
+    const paths::PathIndexReader& path_index;
+    OnTheFlyPathLookup& on_the_fly;
+    chunk::SubgraphExtractionOptions options;
+    std::string reference;
+    bool all_haplotypes{false};
+    PathHaplotypeQueryOptions haplotype_options;
+    // Optional .hpx for --all_haplotypes, validated against this .cdx.
+    const CoordinateIndexReader* coordinate_index{nullptr};
+    const HaplotypeProjectionReader* projection{nullptr};
+    // Created by the first extraction unless a batch opened it up front.
+    std::unique_ptr<chunk::SubgraphExtractionSession> session;
+};
+
+// Select one region's seeds from its .cdx answer, or through the on-the-fly
+// P/W lookup when .cdx has none, and extract its subgraph. coordinate_query is
+// null when no .cdx exists or its lookup failed with coordinate_query_error.
+int extract_region(RegionExtractionContext& context,
+                   const ParsedRegion& region,
+                   const CoordinateQueryResult* coordinate_query,
+                   std::string coordinate_query_error,
+                   const std::string& output_gfa,
+                   std::ostream* out) {
+    const auto& path_index = context.path_index;
+    std::vector<std::uint32_t> ranks;
+    std::vector<paths::SubpathRun> exact_reference_path_runs;
+    bool used_coordinate_index = false;
+    bool coordinate_index_returned_empty = false;
+    if (coordinate_query != nullptr) {
+        try {
+            std::vector<paths::SubpathRun> query_reference_runs;
+            if (context.all_haplotypes) {
+                query_reference_runs =
+                    resolve_coordinate_path_runs(path_index, *coordinate_query);
+            }
+
+            // Publish the query state only after P/W-to-PDX validation has
+            // also succeeded, so a mismatched sidecar cannot leave a
+            // partially usable rank result behind.
+            ranks = coordinate_query->node_ranks;
+            exact_reference_path_runs = std::move(query_reference_runs);
+            used_coordinate_index = !ranks.empty();
+            coordinate_index_returned_empty = ranks.empty();
+        } catch (const std::exception& err) {
+            coordinate_query_error = err.what();
+        }
+    }
+
+    if (ranks.empty()) {
+        try {
+            auto fallback = context.on_the_fly.query(context.reference,
+                                                     region.sequence,
+                                                     region.begin,
+                                                     region.end);
+            ranks = std::move(fallback.node_ranks);
+            exact_reference_path_runs = std::move(fallback.reference_path_runs);
+            std::cout << "On-the-fly path coordinate query selected "
+                      << ranks.size() << " seed nodes from "
+                      << fallback.matched_path_count << " indexed P/W records" << std::endl;
+        } catch (const std::exception& err) {
+            if (coordinate_index_returned_empty) {
+                throw std::runtime_error("No reference nodes overlap the requested coordinate interval");
+            }
+            if (!coordinate_query_error.empty()) {
+                throw std::runtime_error(std::string(err.what()) +
+                                         "; .cdx lookup also failed: " +
+                                         coordinate_query_error);
+            }
+            throw;
+        }
+    }
+
+    if (used_coordinate_index) {
+        std::cout << get_time() << ": Coordinate query selected " << ranks.size()
+                  << " reference seed nodes" << std::endl;
+    }
+
+    // Both selection modes share the same index overrides and output
+    // controls. Only the node-selection strategy changes below.
+    if (context.session == nullptr) {
+        context.session = std::make_unique<chunk::SubgraphExtractionSession>(
+            context.options, context.all_haplotypes, false);
+    }
+
+    if (context.all_haplotypes) {
+        // Use .pdx postings as an inverted index from reference anchors to
+        // their path occurrences. The coordinate source stays exact;
+        // optional gap clustering splits distant non-reference repeats.
+        // A .hpx replaces the postings of the windows the .cdx slices cover.
+        auto query_options = context.haplotype_options;
+        HaplotypeProjection projection;
+        if (context.projection != nullptr && used_coordinate_index &&
+            !query_options.max_gap_bases.has_value()) {
+            projection = context.projection->project(*context.coordinate_index,
+                                                     coordinate_query->slices);
+            query_options.projection = &projection;
+        }
+        const auto selection =
+            query_path_haplotype_nodes(path_index,
+                                       ranks,
+                                       exact_reference_path_runs,
+                                       query_options);
+        std::cerr << get_time()
+                  << ": All-haplotype phases: postings="
+                  << std::fixed << std::setprecision(3)
+                  << selection.posting_seconds
+                  << "s, selected_steps="
+                  << selection.selected_step_seconds
+                  << "s, rank_materialization="
+                  << selection.node_rank_materialization_seconds
+                  << "s" << std::endl;
+        std::cout << get_time() << ": All-haplotype path selection read "
+                  << selection.posting_count << " postings across "
+                  << selection.matched_path_count << " P/W records and selected "
+                  << selection.node_ranks.size() << " unique nodes from "
+                  << selection.selected_path_step_count << " path steps"
+                  << std::endl;
+        if (query_options.projection != nullptr) {
+            std::cout << get_time() << ": Haplotype projection supplied "
+                      << selection.projected_bound_count << " path bounds from "
+                      << selection.projected_window_count << " windows; postings were read for "
+                      << projection.posting_node_ranks.size() << " boundary nodes" << std::endl;
+        }
+        // Local-mode diagnostics are useful even if a future coordinate
+        // source cannot identify an exact P/W run for separate reporting.
+        if (query_options.max_gap_bases.has_value()) {
+            std::cout << get_time()
+                      << ": Local all-haplotype interval resolution used a "
+                      << *query_options.max_gap_bases
+                      << " bp maximum gap and emitted "
+                      << selection.local_non_reference_run_count
+                      << " non-reference interval(s); "
+                      << selection.local_split_path_count
+                      << " path(s) were split, while "
+                      << selection.exact_reference_path_count
+                      << " coordinate path(s) remained exact" << std::endl;
+        } else if (selection.exact_reference_path_count > 0) {
+            std::cout << get_time() << ": All-haplotype interval resolution preserved "
+                      << selection.exact_reference_path_count
+                      << " exact coordinate path(s); other paths retained "
+                      << "their minimum/maximum anchor bounds" << std::endl;
+        }
+        return context.session->extract_from_node_ranks(
+            selection.node_ranks,
+            selection.path_runs,
+            path_index,
+            output_gfa,
+            out);
+    }
+
+    // BFS still uses original node-name strings. Convert only the reference
+    // seed ranks selected by the coordinate query.
+    std::vector<std::string> seed_nodes;
+    seed_nodes.reserve(ranks.size());
+    for (const auto rank : ranks) {
+        seed_nodes.emplace_back(path_index.get_node_name(rank));
+    }
+    return context.session->extract_from_seeds(seed_nodes, output_gfa, out);
+}
+
 Reader::Options parse_reader_options(const argparse::ArgumentParser& program) {
     Reader::Options options;
     const auto value = program.get<std::string>("progress_every");
@@ -349,6 +753,81 @@ Reader::Options parse_reader_options(const argparse::ArgumentParser& program) {
     return options;
 }
 
+// One reference step of a get_depth region, at its namespace coordinate.
+struct DepthStep {
+    std::uint32_t path_id{};
+    std::uint64_t start{};
+    std::uint32_t node_id{};
+    std::uint32_t length{};
+};
+
+// Depth of the reference bases of one get_depth bin.
+struct DepthBin {
+    std::uint64_t covered_bases{};
+    std::uint64_t depth_bases{};
+    std::uint64_t min_depth{std::numeric_limits<std::uint64_t>::max()};
+    std::uint64_t max_depth{};
+};
+
+// Write one row per bin and coordinate namespace. Bins are aligned to
+// multiples of bin_size and clipped to the region; each reference base counts
+// with the depth of the node it belongs to.
+void write_depth_bins(std::ostream& out,
+                      const PathCoordinateNames& names,
+                      const std::vector<DepthStep>& steps,
+                      const std::vector<std::uint64_t>& step_depths,
+                      const ParsedRegion& region,
+                      std::uint64_t bin_size) {
+    const auto first_bin = region.begin / bin_size;
+    const auto bin_count = static_cast<std::size_t>((region.end - 1) / bin_size - first_bin + 1);
+    std::vector<std::string_view> namespaces;
+    std::vector<std::vector<DepthBin>> bins;
+    std::uint32_t last_path = std::numeric_limits<std::uint32_t>::max();
+    std::size_t slot = 0;
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        const auto& step = steps[i];
+        if (step.path_id != last_path) {
+            last_path = step.path_id;
+            const auto name = names.namespace_name(step.path_id);
+            slot = static_cast<std::size_t>(
+                std::find(namespaces.begin(), namespaces.end(), name) - namespaces.begin());
+            if (slot == namespaces.size()) {
+                namespaces.push_back(name);
+                bins.emplace_back(bin_count);
+            }
+        }
+        const auto depth = step_depths[i];
+        const auto end = std::min(step.start + step.length, region.end);
+        for (auto pos = std::max(step.start, region.begin); pos < end;) {
+            const auto bin = pos / bin_size;
+            const auto bin_end = std::min(end, (bin + 1) * bin_size);
+            auto& entry = bins[slot][static_cast<std::size_t>(bin - first_bin)];
+            entry.covered_bases += bin_end - pos;
+            entry.depth_bases += (bin_end - pos) * depth;
+            entry.min_depth = std::min(entry.min_depth, depth);
+            entry.max_depth = std::max(entry.max_depth, depth);
+            pos = bin_end;
+        }
+    }
+
+    out << std::fixed << std::setprecision(3);
+    for (std::size_t n = 0; n < namespaces.size(); ++n) {
+        for (std::size_t b = 0; b < bin_count; ++b) {
+            const auto bin = first_bin + b;
+            const auto& entry = bins[n][b];
+            out << namespaces[n] << '\t' << std::max(region.begin, bin * bin_size) << '\t'
+                << std::min(region.end, (bin + 1) * bin_size) << '\t' << entry.covered_bases;
+            if (entry.covered_bases == 0) {
+                out << "\t*\t*\t*\n";
+                continue;
+            }
+            out << '\t'
+                << static_cast<double>(entry.depth_bases) / static_cast<double>(entry.covered_bases)
+                << '\t' << entry.min_depth << '\t' << entry.max_depth << '\n';
+        }
+    }
+}
+
 }  // namespace
 
 void configure_index_coordinates_parser(argparse::ArgumentParser& parser) {
@@ -366,7 +845,7 @@ void configure_index_coordinates_parser(argparse::ArgumentParser& parser) {
     parser.add_argument("--pdx")
       .default_value(std::string(""))
       .nargs(1)
-      .help("optional path index to source selected P/W records or fallback reference W records; defaults to <in_gfa>.pdx when present");
+      .help("optional path index to source selected P/W records and reference W records; defaults to <in_gfa>.pdx when present");
 
     parser.add_argument("--reference")
       .default_value(std::string(""))
@@ -378,6 +857,21 @@ void configure_index_coordinates_parser(argparse::ArgumentParser& parser) {
       .nargs(1)
       .help("optional file produced by get_path --print_path_names; selected P paths and W walks are indexed from the .pdx");
 
+    parser.add_argument("--lnx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("node length index aligned to the .ndx; supplies segment lengths instead of the S lines; defaults to <in_gfa>.lnx when present");
+
+    parser.add_argument("--tmp_dir")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("temporary directory base for the entry scratch file and sorted rGFA runs (default: output directory)");
+
+    parser.add_argument("--max_memory")
+      .default_value(std::string("128M"))
+      .nargs(1)
+      .help("memory for buffered SR:i:0 segments before they spill to sorted runs on disk, with an optional K/M/G suffix (default: 128M)");
+
     parser.add_argument("--progress_every")
       .default_value(std::string("1000000"))
       .nargs(1)
@@ -389,8 +883,10 @@ int run_index_coordinates(const argparse::ArgumentParser& program) {
     const auto output_index = program.get<std::string>("out_index");
     auto node_index = program.get<std::string>("ndx");
     auto path_index = program.get<std::string>("pdx");
+    auto length_index = program.get<std::string>("lnx");
     const auto reference = program.get<std::string>("reference");
     const auto path_names_file = program.get<std::string>("path_names_file");
+    const auto tmp_dir = program.get<std::string>("tmp_dir");
 
     if (!file_exists(input_gfa.c_str())) {
         std::cerr << "Input GFA does not exist: " << input_gfa << std::endl;
@@ -404,6 +900,10 @@ int run_index_coordinates(const argparse::ArgumentParser& program) {
         const auto inferred = utils::companion_path(input_gfa, ".pdx");
         if (file_exists(inferred.c_str())) path_index = inferred;
     }
+    if (length_index.empty()) {
+        const auto inferred = utils::companion_path(input_gfa, ".lnx");
+        if (file_exists(inferred.c_str())) length_index = inferred;
+    }
     if (node_index.empty() || !file_exists(node_index.c_str())) {
         std::cerr << "Provide an existing --ndx aligned to the input GFA" << std::endl;
         return 1;
@@ -412,6 +912,10 @@ int run_index_coordinates(const argparse::ArgumentParser& program) {
         std::cerr << "Path index does not exist: " << path_index << std::endl;
         return 1;
     }
+    if (!length_index.empty() && !file_exists(length_index.c_str())) {
+        std::cerr << "Node length index does not exist: " << length_index << std::endl;
+        return 1;
+    }
     if (!path_names_file.empty() && !file_exists(path_names_file.c_str())) {
         std::cerr << "Path/walk names file does not exist: " << path_names_file << std::endl;
         return 1;
@@ -430,6 +934,12 @@ int run_index_coordinates(const argparse::ArgumentParser& program) {
     }
 
     try {
+        const auto entry_memory = utils::parse_byte_size_strict(
+            program.get<std::string>("max_memory"), "--max_memory");
+        if (entry_memory < kMinCoordinateEntryMemoryBytes) {
+            throw std::runtime_error("--max_memory must be at least 64K");
+        }
+
         Timer timer;
         std::cout << "Building coordinate index " << output_index << std::endl;
         build_coordinate_index(input_gfa,
@@ -438,7 +948,10 @@ int run_index_coordinates(const argparse::ArgumentParser& program) {
                                reference,
                                parse_reader_options(program),
                                path_index,
-                               path_names_file);
+                               path_names_file,
+                               length_index,
+                               tmp_dir,
+                               entry_memory);
 
         // Reopen the completed file to validate its header and report exactly
         // what was published without retaining builder-only vectors in memory.
@@ -455,6 +968,71 @@ int run_index_coordinates(const argparse::ArgumentParser& program) {
     return 0;
 }
 
+void configure_index_haplotype_projection_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("in_gz")
+      .help("indexed GFA graph used to infer companion .cdx and .pdx files");
+
+    parser.add_argument("out_index")
+      .default_value(std::string(""))
+      .nargs(argparse::nargs_pattern::optional)
+      .help("output haplotype projection index; defaults to <in_gz>.hpx");
+
+    parser.add_argument("--cdx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("coordinate index whose tracks are cut into windows; defaults to <in_gz>.cdx");
+
+    parser.add_argument("--pdx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("path index whose postings are projected; defaults to <in_gz>.pdx");
+
+    parser.add_argument("--window")
+      .default_value(std::string("10kb"))
+      .nargs(1)
+      .help("reference bases per projection window, with an optional bp/kb/mb suffix (default: 10kb)");
+}
+
+int run_index_haplotype_projection(const argparse::ArgumentParser& program) {
+    try {
+        const auto input_gz = program.get<std::string>("in_gz");
+        auto output_index = program.get<std::string>("out_index");
+        auto cdx_path = program.get<std::string>("cdx");
+        auto pdx_path = program.get<std::string>("pdx");
+        if (output_index.empty()) output_index = utils::companion_path(input_gz, ".hpx");
+        if (cdx_path.empty()) cdx_path = utils::companion_path(input_gz, ".cdx");
+        if (pdx_path.empty()) pdx_path = utils::companion_path(input_gz, ".pdx");
+
+        if (!file_exists(cdx_path.c_str())) {
+            throw std::runtime_error("Coordinate index does not exist: " + cdx_path);
+        }
+        if (!file_exists(pdx_path.c_str())) {
+            throw std::runtime_error("Path index does not exist: " + pdx_path);
+        }
+        const auto window_bases = parse_base_count(program.get<std::string>("window"),
+                                                   "--window");
+        if (window_bases == 0) {
+            throw std::runtime_error("--window must be greater than zero");
+        }
+
+        Timer timer;
+        std::cout << "Building haplotype projection " << output_index << " from " << cdx_path
+                  << " and " << pdx_path << std::endl;
+        build_haplotype_projection_index(cdx_path, pdx_path, output_index, window_bases);
+
+        // Reopen the completed sidecar to validate its header and report what
+        // was published.
+        HaplotypeProjectionReader projection(output_index);
+        std::cout << "Indexed " << projection.window_count() << " windows of "
+                  << projection.window_bases() << " bp with " << projection.bound_count()
+                  << " path bounds in " << timer.elapsed() << " seconds" << std::endl;
+        return 0;
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
+
 void configure_get_region_parser(argparse::ArgumentParser& parser) {
     parser.add_argument("in_gz")
       .help("input indexed multi-member GFA gzip");
@@ -469,6 +1047,15 @@ void configure_get_region_parser(argparse::ArgumentParser& parser) {
       .nargs(argparse::nargs_pattern::optional)
       .help("output extracted GFA subgraph");
 
+    parser.add_argument("--regions_bed")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("extract every interval of a BED file instead of one region, sharing the opened indexes; writes one #region-tagged GFA stream to the output");
+
+    parser.add_argument("--split_regions").default_value(false)
+      .implicit_value(true)
+      .help("with --regions_bed, treat the output as a directory and write each region to <record>.<name>.gfa");
+
     parser.add_argument("--reference")
       .default_value(std::string(""))
       .nargs(1)
@@ -502,7 +1089,12 @@ void configure_get_region_parser(argparse::ArgumentParser& parser) {
     parser.add_argument("--pcx")
       .default_value(std::string(""))
       .nargs(1)
-      .help("path coordinate checkpoints for faster coordinate-bearing path output; defaults to <in_gz>.pcx when present");
+      .help("path coordinate checkpoints for faster on-the-fly coordinate lookup and coordinate-bearing path output; defaults to <in_gz>.pcx when present");
+
+    parser.add_argument("--hpx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("haplotype projection used by --all_haplotypes without --haplotype_gap; defaults to <in_gz>.hpx when present");
 
     parser.add_argument("--max_nodes")
       .default_value(std::string("10000"))
@@ -523,6 +1115,14 @@ void configure_get_region_parser(argparse::ArgumentParser& parser) {
       .nargs(1)
       .help("optional maximum unanchored gap for local --all_haplotypes runs; accepts bases or bp/kb/mb/gb suffixes");
 
+    parser.add_argument("--communities_only").default_value(false)
+      .implicit_value(true)
+      .help("write the whole communities overlapping the region, found from the .cdx community runs without BFS or .pdx");
+
+    parser.add_argument("--whole_communities").default_value(false)
+      .implicit_value(true)
+      .help("alias for --communities_only");
+
     parser.add_argument("--no_paths").default_value(false)
       .implicit_value(true)
       .help("skip P/W subpath output; .pdx is still required to resolve coordinate ranks");
@@ -565,14 +1165,17 @@ int run_get_region(const argparse::ArgumentParser& program) {
         auto pdx_path = program.get<std::string>("pdx");
         auto lnx_path = program.get<std::string>("lnx");
         auto pcx_path = program.get<std::string>("pcx");
+        auto hpx_path = program.get<std::string>("hpx");
         const bool lnx_explicit = !lnx_path.empty();
         const bool pcx_explicit = !pcx_path.empty();
+        const bool hpx_explicit = !hpx_path.empty();
         if (cdx_path.empty()) {
             cdx_path = utils::resolve_sidecar_path(input_gz, cdx_path, ".cdx", true);
         }
         if (pdx_path.empty()) pdx_path = utils::companion_path(input_gz, ".pdx");
         if (lnx_path.empty()) lnx_path = utils::companion_path(input_gz, ".lnx");
         if (pcx_path.empty()) pcx_path = utils::companion_path(input_gz, ".pcx");
+        if (hpx_path.empty()) hpx_path = utils::companion_path(input_gz, ".hpx");
         if (list_coordinates) {
             const bool has_pdx = file_exists(pdx_path.c_str());
             const bool has_cdx = file_exists(cdx_path.c_str());
@@ -625,14 +1228,50 @@ int run_get_region(const argparse::ArgumentParser& program) {
         }
 
         const auto region_arg = program.get<std::string>("region");
-        const auto output_gfa = program.get<std::string>("out_gfa");
-        if (region_arg.empty() || output_gfa.empty()) {
+        const auto regions_bed = program.get<std::string>("regions_bed");
+        const bool split_regions = program.get<bool>("split_regions");
+        auto output_gfa = program.get<std::string>("out_gfa");
+        if (!regions_bed.empty()) {
+            // Without a region argument, argparse binds the output to the
+            // first optional positional.
+            if (output_gfa.empty()) {
+                output_gfa = region_arg;
+            } else if (!region_arg.empty()) {
+                throw std::runtime_error(
+                    "--regions_bed replaces the <sequence:start-end> argument");
+            }
+            if (output_gfa.empty()) {
+                throw std::runtime_error(
+                    "get_region --regions_bed requires an output: a tagged GFA "
+                    "stream, or a directory with --split_regions");
+            }
+        } else if (split_regions) {
+            throw std::runtime_error("--split_regions requires --regions_bed");
+        } else if (region_arg.empty() || output_gfa.empty()) {
             throw std::runtime_error(
                 "get_region requires <sequence:start-end> and <out_gfa> "
                 "unless --list_coordinates or --print_path_names is used");
         }
 
-        const auto region = parse_region(region_arg);
+        std::vector<ParsedRegion> regions;
+        if (!regions_bed.empty()) {
+            regions = read_regions_bed(regions_bed);
+            if (regions.empty()) {
+                throw std::runtime_error("Regions BED file contains no regions: " + regions_bed);
+            }
+        } else {
+            regions.push_back(parse_region(region_arg));
+        }
+        if (program.get<bool>("communities_only") || program.get<bool>("whole_communities")) {
+            if (all_haplotypes || with_coords) {
+                throw std::runtime_error(
+                    "--communities_only writes whole communities; remove --all_haplotypes "
+                    "and --with_coords");
+            }
+            return run_region_communities(input_gz, cdx_path, program.get<std::string>("idx"),
+                                          reference, regions, !regions_bed.empty(),
+                                          split_regions, output_gfa);
+        }
         if (!file_exists(pdx_path.c_str())) {
             throw std::runtime_error(
                 "Path index required for rank-to-node-name conversion does "
@@ -643,9 +1282,12 @@ int run_get_region(const argparse::ArgumentParser& program) {
         if (with_coords && lnx_explicit && !file_exists(lnx_path.c_str())) {
             throw std::runtime_error("Node length index does not exist: " + lnx_path);
         }
-        if (with_coords && pcx_explicit && !file_exists(pcx_path.c_str())) {
+        if (pcx_explicit && !file_exists(pcx_path.c_str())) {
             throw std::runtime_error("Path checkpoint index does not exist: " + pcx_path);
         }
+        if (hpx_explicit && !file_exists(hpx_path.c_str())) {
+            throw std::runtime_error("Haplotype projection index does not exist: " + hpx_path);
+        }
 
         paths::PathIndexReader path_index(pdx_path);
         if (!file_exists(cdx_path.c_str()) &&
@@ -660,163 +1302,340 @@ int run_get_region(const argparse::ArgumentParser& program) {
                 "get_region " + input_gz + " --list_coordinates");
         }
 
-        std::vector<std::uint32_t> ranks;
-        std::vector<paths::SubpathRun> exact_reference_path_runs;
-        bool used_coordinate_index = false;
-        bool coordinate_index_returned_empty = false;
-        std::string coordinate_index_error;
+        std::unique_ptr<CoordinateIndexReader> coordinate_index_reader;
         if (file_exists(cdx_path.c_str())) {
-            CoordinateIndexReader coordinate_index(cdx_path);
-            if (coordinate_index.node_count() != path_index.node_count()) {
+            coordinate_index_reader = std::make_unique<CoordinateIndexReader>(cdx_path);
+            if (coordinate_index_reader->node_count() != path_index.node_count()) {
                 throw std::runtime_error(".cdx and .pdx node counts differ; rebuild them against the same .ndx");
             }
+        }
+        // Each region is resolved against .cdx just before it is extracted, so
+        // a batch holds one region's seeds at a time. Returns null when no .cdx
+        // exists or its lookup failed, with the failure left in error.
+        CoordinateQueryResult coordinate_result;
+        const auto resolve_region = [&](const ParsedRegion& region,
+                                        std::string& error) -> const CoordinateQueryResult* {
+            if (coordinate_index_reader == nullptr) return nullptr;
             try {
-                auto query = coordinate_index.query_region(reference,
-                                                            region.sequence,
-                                                            region.begin,
-                                                            region.end);
-                std::vector<paths::SubpathRun> query_reference_runs;
-                if (all_haplotypes) {
-                    query_reference_runs =
-                        resolve_coordinate_path_runs(path_index, query);
-                }
+                coordinate_result = coordinate_index_reader->query_region(
+                    reference, region.sequence, region.begin, region.end);
+            } catch (const std::exception& err) {
+                error = err.what();
+                return nullptr;
+            }
+            return &coordinate_result;
+        };
+
+        // Empty means "fall back to the old S-line scan" or "use bounded
+        // path-prefix scans" inside the shared subgraph extractor. Explicit
+        // missing --lnx and --pcx files are rejected above.
+        const auto available_lnx_path =
+            file_exists(lnx_path.c_str()) ? lnx_path : std::string{};
+        const auto available_pcx_path =
+            file_exists(pcx_path.c_str()) ? pcx_path : std::string{};
+        OnTheFlyPathLookup on_the_fly(path_index, available_lnx_path, available_pcx_path);
+
+        RegionExtractionContext context(path_index, on_the_fly);
+        context.options.input_gz = input_gz;
+        context.options.idx_path = program.get<std::string>("idx");
+        context.options.ndx_path = program.get<std::string>("ndx");
+        context.options.pdx_path = pdx_path;
+        context.options.lnx_path = available_lnx_path;
+        context.options.pcx_path = available_pcx_path;
+        context.options.max_nodes = parse_max_nodes(program.get<std::string>("max_nodes"));
+        context.options.threads = utils::parse_u32_strict(
+            program.get<std::string>("threads"),
+            "--threads",
+            1,
+            chunk::kMaxExtractionThreads);
+        context.options.include_paths = !no_paths;
+        context.options.with_walk_coordinates = with_coords;
+        context.options.debug_trace = program.get<bool>("debug_trace");
+        context.reference = reference;
+        context.all_haplotypes = all_haplotypes;
+
+        // Omitted gap limits preserve the original min/max implementation
+        // without constructing a length reader or local-anchor bitset.
+        std::unique_ptr<indexer::NodeLengthIndexReader> gap_node_lengths;
+        if (all_haplotypes && haplotype_gap_bases.has_value()) {
+            gap_node_lengths =
+                std::make_unique<indexer::NodeLengthIndexReader>(lnx_path);
+            context.haplotype_options.max_gap_bases = haplotype_gap_bases;
+            context.haplotype_options.node_lengths = gap_node_lengths.get();
+        }
 
-                // Publish the query state only after P/W-to-PDX validation has
-                // also succeeded, so a mismatched sidecar cannot leave a
-                // partially usable rank result behind.
-                ranks = std::move(query.node_ranks);
-                exact_reference_path_runs = std::move(query_reference_runs);
-                used_coordinate_index = !ranks.empty();
-                coordinate_index_returned_empty = ranks.empty();
+        // The projection only replaces postings of the min/max mode; a stale
+        // or mismatched .hpx is skipped like a stale .pcx.
+        std::unique_ptr<HaplotypeProjectionReader> projection;
+        if (all_haplotypes && !haplotype_gap_bases.has_value() &&
+            coordinate_index_reader != nullptr && file_exists(hpx_path.c_str())) {
+            try {
+                projection = std::make_unique<HaplotypeProjectionReader>(hpx_path);
+                projection->validate_against(*coordinate_index_reader, path_index);
+                context.coordinate_index = coordinate_index_reader.get();
+                context.projection = projection.get();
             } catch (const std::exception& err) {
-                coordinate_index_error = err.what();
+                projection.reset();
+                std::cerr << "Warning: could not use haplotype projection index '" << hpx_path
+                          << "' (" << err.what() << "), falling back to .pdx postings"
+                          << std::endl;
             }
         }
 
-        if (ranks.empty()) {
+        if (regions_bed.empty()) {
+            std::string coordinate_query_error;
+            const auto* coordinate_query = resolve_region(regions[0], coordinate_query_error);
+            return extract_region(context, regions[0], coordinate_query,
+                                  std::move(coordinate_query_error), output_gfa, nullptr);
+        }
+
+        // A failed region is reported and skipped, so one unresolvable
+        // interval does not discard the rest of a large batch. Stream records
+        // are buffered per region to keep failed regions out of the output.
+        std::ofstream stream;
+        if (split_regions) {
+            std::filesystem::create_directories(output_gfa);
+        } else {
+            stream.open(output_gfa);
+            if (!stream) {
+                throw std::runtime_error("Failed to open output GFA file for writing: " +
+                                         output_gfa);
+            }
+        }
+        // Open the graph indexes once, before the loop, so a missing index
+        // fails the batch instead of every region.
+        context.session = std::make_unique<chunk::SubgraphExtractionSession>(
+            context.options, all_haplotypes, true);
+        std::size_t written = 0;
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            const auto& region = regions[i];
+            const auto label = region_label(region);
+            std::cout << get_time() << ": Region " << (i + 1) << "/" << regions.size()
+                      << " " << label << std::endl;
+            std::string coordinate_query_error;
+            const auto* coordinate_query = resolve_region(region, coordinate_query_error);
+            std::ostringstream buffer;
             try {
-                const auto fallback = query_path_coordinates_on_the_fly(path_index,
-                                                                        file_exists(lnx_path.c_str()) ? lnx_path : std::string{},
-                                                                        reference,
-                                                                        region.sequence,
-                                                                        region.begin,
-                                                                        region.end);
-                ranks = fallback.node_ranks;
-                exact_reference_path_runs = fallback.reference_path_runs;
-                std::cout << "On-the-fly path coordinate query selected "
-                          << ranks.size() << " seed nodes from "
-                          << fallback.matched_path_count << " indexed P/W records" << std::endl;
+                if (split_regions) {
+                    const auto region_path =
+                        (std::filesystem::path(output_gfa) / region_file_name(i, region)).string();
+                    extract_region(context, region, coordinate_query,
+                                   std::move(coordinate_query_error), region_path, nullptr);
+                } else {
+                    extract_region(context, region, coordinate_query,
+                                   std::move(coordinate_query_error), "region " + label, &buffer);
+                }
             } catch (const std::exception& err) {
-                if (coordinate_index_returned_empty) {
-                    throw std::runtime_error("No reference nodes overlap the requested coordinate interval");
+                std::cerr << get_time() << ": Warning: skipped region " << label << ": "
+                          << err.what() << std::endl;
+                continue;
+            }
+            if (!split_regions) {
+                stream << "#region\t" << label << '\t' << region.sequence << ':'
+                       << region.begin << '-' << region.end << '\n' << buffer.str();
+                if (!stream) {
+                    throw std::runtime_error("Failed while writing " + output_gfa);
                 }
-                if (!coordinate_index_error.empty()) {
+            }
+            ++written;
+        }
+        std::cout << get_time() << ": Wrote " << written << " of " << regions.size()
+                  << " regions to " << output_gfa << std::endl;
+        return 0;
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
+
+void configure_get_depth_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("in_gz")
+      .help("indexed GFA graph used to infer companion .cdx, .pdx, .lnx and .pcx files");
+
+    parser.add_argument("region")
+      .help("0-based half-open reference interval in sequence:start-end form");
+
+    parser.add_argument("--reference")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("reference sample name; may be omitted when the sequence is unambiguous");
+
+    parser.add_argument("--bin_size")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("write base-weighted depth per bin of this many bases instead of per node; accepts bases or bp/kb/mb/gb suffixes");
+
+    parser.add_argument("--distinct_paths").default_value(false)
+      .implicit_value(true)
+      .help("count the P/W records visiting a node instead of its visits");
+
+    parser.add_argument("--cdx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("coordinate index; defaults to <in_gz>.cdx when present");
+
+    parser.add_argument("--pdx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("path index override; defaults to <in_gz>.pdx");
+
+    parser.add_argument("--lnx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("node length index override; defaults to <in_gz>.lnx");
+
+    parser.add_argument("--pcx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("path coordinate checkpoints for the reference step offsets; defaults to <in_gz>.pcx when present");
+
+    parser.add_argument("--threads")
+      .default_value(std::string("1"))
+      .nargs(1)
+      .help("number of posting decode workers for --distinct_paths (default: 1)");
+
+    parser.add_argument("--no_header").default_value(false)
+      .implicit_value(true)
+      .help("omit the TSV header");
+}
+
+int run_get_depth(const argparse::ArgumentParser& program) {
+    try {
+        const auto input_gz = program.get<std::string>("in_gz");
+        const auto reference = program.get<std::string>("reference");
+        const auto region = parse_region(program.get<std::string>("region"));
+        const bool distinct_paths = program.get<bool>("distinct_paths");
+        const auto bin_arg = program.get<std::string>("bin_size");
+        const auto bin_size = bin_arg.empty() ? 0 : parse_base_count(bin_arg, "--bin_size");
+        if (!bin_arg.empty() && bin_size == 0) {
+            throw std::runtime_error("--bin_size must be greater than zero");
+        }
+        const auto threads = utils::parse_u32_strict(program.get<std::string>("threads"),
+                                                     "--threads",
+                                                     1,
+                                                     chunk::kMaxExtractionThreads);
+
+        auto cdx_path = program.get<std::string>("cdx");
+        auto pdx_path = program.get<std::string>("pdx");
+        auto lnx_path = program.get<std::string>("lnx");
+        auto pcx_path = program.get<std::string>("pcx");
+        const bool cdx_explicit = !cdx_path.empty();
+        const bool pcx_explicit = !pcx_path.empty();
+        if (cdx_path.empty()) {
+            cdx_path = utils::resolve_sidecar_path(input_gz, cdx_path, ".cdx", true);
+        }
+        if (pdx_path.empty()) pdx_path = utils::companion_path(input_gz, ".pdx");
+        if (lnx_path.empty()) lnx_path = utils::companion_path(input_gz, ".lnx");
+        if (pcx_path.empty()) pcx_path = utils::companion_path(input_gz, ".pcx");
+        if (!file_exists(pdx_path.c_str())) {
+            throw std::runtime_error("Path index does not exist: " + pdx_path);
+        }
+        if (!file_exists(lnx_path.c_str())) {
+            throw std::runtime_error("Node length index does not exist: " + lnx_path);
+        }
+        if (cdx_explicit && !file_exists(cdx_path.c_str())) {
+            throw std::runtime_error("Coordinate index does not exist: " + cdx_path);
+        }
+        if (pcx_explicit && !file_exists(pcx_path.c_str())) {
+            throw std::runtime_error("Path checkpoint index does not exist: " + pcx_path);
+        }
+
+        Timer timer;
+        const paths::PathIndexReader path_index(pdx_path);
+        const indexer::NodeLengthIndexReader lengths(lnx_path);
+        if (lengths.node_count() != path_index.node_count()) {
+            throw std::runtime_error(".lnx and .pdx node counts differ; rebuild them against the same .ndx");
+        }
+        std::unique_ptr<paths::PathCoordinateCheckpointIndexReader> checkpoints;
+        if (file_exists(pcx_path.c_str())) {
+            checkpoints = open_on_the_fly_checkpoints(pcx_path, path_index, lengths.node_count());
+        }
+
+        // The reference steps come from the .cdx slices when they name P/W
+        // records, otherwise from the same on-the-fly lookup get_region uses.
+        std::vector<paths::SubpathRun> runs;
+        std::string coordinate_query_error;
+        if (file_exists(cdx_path.c_str())) {
+            try {
+                const CoordinateIndexReader coordinate_index(cdx_path);
+                if (coordinate_index.node_count() != path_index.node_count()) {
+                    throw std::runtime_error(".cdx and .pdx node counts differ; rebuild them against the same .ndx");
+                }
+                runs = resolve_coordinate_path_runs(
+                    path_index,
+                    coordinate_index.query_region(reference, region.sequence, region.begin,
+                                                  region.end));
+            } catch (const std::exception& err) {
+                coordinate_query_error = err.what();
+            }
+        }
+        if (runs.empty()) {
+            try {
+                runs = query_path_coordinates_on_the_fly(path_index, lengths, checkpoints.get(),
+                                                         reference, region.sequence,
+                                                         region.begin, region.end)
+                           .reference_path_runs;
+            } catch (const std::exception& err) {
+                if (!coordinate_query_error.empty()) {
                     throw std::runtime_error(std::string(err.what()) +
                                              "; .cdx lookup also failed: " +
-                                             coordinate_index_error);
+                                             coordinate_query_error);
                 }
                 throw;
             }
         }
+        if (runs.empty()) {
+            throw std::runtime_error("No P/W reference steps overlap the requested coordinate interval");
+        }
 
-        if (used_coordinate_index) {
-            std::cout << get_time() << ": Coordinate query selected " << ranks.size()
-                      << " reference seed nodes" << std::endl;
-        }
-
-        // Both selection modes share the same index overrides and output
-        // controls. Only the node-selection strategy changes below.
-        chunk::SubgraphExtractionOptions options;
-        options.input_gz = input_gz;
-        options.output_gfa = output_gfa;
-        options.idx_path = program.get<std::string>("idx");
-        options.ndx_path = program.get<std::string>("ndx");
-        options.pdx_path = pdx_path;
-        // Empty means "fall back to the old S-line scan" inside the shared
-        // subgraph extractor. Explicit missing --lnx is rejected above.
-        options.lnx_path = file_exists(lnx_path.c_str()) ? lnx_path : std::string{};
-        // Missing inferred .pcx files preserve compatibility with existing
-        // indexes by using the previous bounded path-prefix scan.
-        options.pcx_path = file_exists(pcx_path.c_str()) ? pcx_path : std::string{};
-        options.max_nodes = parse_max_nodes(program.get<std::string>("max_nodes"));
-        options.threads = utils::parse_u32_strict(
-            program.get<std::string>("threads"),
-            "--threads",
-            1,
-            chunk::kMaxExtractionThreads);
-        options.include_paths = !no_paths;
-        options.with_walk_coordinates = with_coords;
-        options.debug_trace = program.get<bool>("debug_trace");
-
-        if (all_haplotypes) {
-            // Omitted gap limits preserve the original min/max implementation
-            // without constructing a length reader or local-anchor bitset.
-            PathHaplotypeQueryOptions query_options;
-            std::unique_ptr<indexer::NodeLengthIndexReader> gap_node_lengths;
-            if (haplotype_gap_bases.has_value()) {
-                gap_node_lengths =
-                    std::make_unique<indexer::NodeLengthIndexReader>(lnx_path);
-                query_options.max_gap_bases = haplotype_gap_bases;
-                query_options.node_lengths = gap_node_lengths.get();
+        const PathCoordinateNames names(path_index);
+        paths::PathStepOffsets offsets(path_index, lengths, checkpoints.get());
+        std::vector<DepthStep> steps;
+        for (const auto& run : runs) {
+            const auto base = names.coordinate_base(run.path_id);
+            for (std::uint64_t i = 0; i < run.step_count; ++i) {
+                const auto step = offsets.step_position(run.path_id, run.start_step + i);
+                steps.push_back(DepthStep{run.path_id, base + step.offset, step.node_id, step.length});
             }
+        }
 
-            // Use .pdx postings as an inverted index from reference anchors to
-            // their path occurrences. The coordinate source stays exact;
-            // optional gap clustering splits distant non-reference repeats.
-            const auto selection =
-                query_path_haplotype_nodes(path_index,
-                                           ranks,
-                                           exact_reference_path_runs,
-                                           query_options);
-            std::cerr << get_time()
-                      << ": All-haplotype phases: postings="
-                      << std::fixed << std::setprecision(3)
-                      << selection.posting_seconds
-                      << "s, selected_steps="
-                      << selection.selected_step_seconds
-                      << "s, rank_materialization="
-                      << selection.node_rank_materialization_seconds
-                      << "s" << std::endl;
-            std::cout << get_time() << ": All-haplotype path selection read "
-                      << selection.posting_count << " postings across "
-                      << selection.matched_path_count << " P/W records and selected "
-                      << selection.node_ranks.size() << " unique nodes from "
-                      << selection.selected_path_step_count << " path steps"
-                      << std::endl;
-            // Local-mode diagnostics are useful even if a future coordinate
-            // source cannot identify an exact P/W run for separate reporting.
-            if (haplotype_gap_bases.has_value()) {
-                std::cout << get_time()
-                          << ": Local all-haplotype interval resolution used a "
-                          << *haplotype_gap_bases
-                          << " bp maximum gap and emitted "
-                          << selection.local_non_reference_run_count
-                          << " non-reference interval(s); "
-                          << selection.local_split_path_count
-                          << " path(s) were split, while "
-                          << selection.exact_reference_path_count
-                          << " coordinate path(s) remained exact" << std::endl;
-            } else if (selection.exact_reference_path_count > 0) {
-                std::cout << get_time() << ": All-haplotype interval resolution preserved "
-                          << selection.exact_reference_path_count
-                          << " exact coordinate path(s); other paths retained "
-                          << "their minimum/maximum anchor bounds" << std::endl;
-            }
-            return chunk::extract_subgraph_from_node_ranks(
-                options,
-                selection.node_ranks,
-                selection.path_runs,
-                path_index);
+        // Depth is read once per distinct node, never from formatted records.
+        std::vector<std::uint32_t> node_ids;
+        node_ids.reserve(steps.size());
+        for (const auto& step : steps) node_ids.push_back(step.node_id);
+        std::sort(node_ids.begin(), node_ids.end());
+        node_ids.erase(std::unique(node_ids.begin(), node_ids.end()), node_ids.end());
+        const auto node_depths =
+            paths::count_node_visits(path_index, node_ids, distinct_paths, threads);
+        std::vector<std::uint64_t> step_depths;
+        step_depths.reserve(steps.size());
+        for (const auto& step : steps) {
+            const auto it = std::lower_bound(node_ids.begin(), node_ids.end(), step.node_id);
+            step_depths.push_back(node_depths[static_cast<std::size_t>(it - node_ids.begin())]);
         }
 
-        // BFS still uses original node-name strings. Convert only the reference
-        // seed ranks selected by the coordinate query.
-        std::vector<std::string> seed_nodes;
-        seed_nodes.reserve(ranks.size());
-        for (const auto rank : ranks) {
-            seed_nodes.emplace_back(path_index.get_node_name(rank));
+        auto& out = std::cout;
+        if (bin_size != 0) {
+            if (!program.get<bool>("no_header")) {
+                out << "path\tbin_start\tbin_end\tcovered_bases\tmean_depth\tmin_depth\tmax_depth\n";
+            }
+            write_depth_bins(out, names, steps, step_depths, region, bin_size);
+        } else {
+            if (!program.get<bool>("no_header")) out << "path\tstart\tend\tnode\tdepth\n";
+            for (std::size_t i = 0; i < steps.size(); ++i) {
+                const auto& step = steps[i];
+                out << names.namespace_name(step.path_id) << '\t' << step.start << '\t'
+                    << step.start + step.length << '\t' << path_index.get_node_name(step.node_id)
+                    << '\t' << step_depths[i] << '\n';
+            }
         }
-        return chunk::extract_subgraph_from_seeds(options, seed_nodes);
+        out.flush();
+        if (!out) throw std::runtime_error("Failed while writing depth output");
+
+        std::cerr << get_time() << ": Depth of " << steps.size() << " reference steps over "
+                  << node_ids.size() << " nodes from " << runs.size() << " P/W records in "
+                  << timer.elapsed() << " seconds" << std::endl;
+        return 0;
     } catch (const std::exception& err) {
         std::cerr << err.what() << std::endl;
         return 1;
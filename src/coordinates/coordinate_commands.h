@@ -9,10 +9,18 @@ namespace gfaidx::coordinates {
 void configure_index_coordinates_parser(argparse::ArgumentParser& parser);
 int run_index_coordinates(const argparse::ArgumentParser& program);
 
+// Configure and execute .hpx construction for --all_haplotypes queries.
+void configure_index_haplotype_projection_parser(argparse::ArgumentParser& parser);
+int run_index_haplotype_projection(const argparse::ArgumentParser& program);
+
 // Configure and execute coordinate-seeded graph extraction.
 void configure_get_region_parser(argparse::ArgumentParser& parser);
 int run_get_region(const argparse::ArgumentParser& program);
 
+// Configure and execute per-node and per-bin path depth over a region.
+void configure_get_depth_parser(argparse::ArgumentParser& parser);
+int run_get_depth(const argparse::ArgumentParser& program);
+
 }  // namespace gfaidx::coordinates
 
 #endif  // GFAIDX_COORDINATE_COMMANDS_H
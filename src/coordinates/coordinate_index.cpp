@@ -2,23 +2,36 @@
 
 #include <algorithm>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <iostream>
 #include <limits>
+#include <memory>
+#include <queue>
 #include <stdexcept>
+#include <unordered_map>
 #include <utility>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "fs/fs_helpers.h"
 #include "indexer/node_hash_index.h"
+#include "indexer/node_length_index.h"
 #include "paths/p_path_coordinates.h"
 #include "paths/path_index.h"
+#include "utils/Timer.h"
 
 namespace gfaidx::coordinates {
 namespace {
 
-// The standalone file contains a fixed header, a small track table, one
-// fixed-width entry table, and a trailing string blob for track names.
+// The standalone file contains a fixed header, a small track table, the
+// sequence directory, one fixed-width entry table, the community runs of each
+// track, and a trailing string blob for track names.
 constexpr char kCoordinateIndexMagic[8] = {'G', 'F', 'C', 'O', 'O', 'R', 'D', '1'};
-constexpr std::uint32_t kCoordinateIndexVersion = 1;
+constexpr std::uint32_t kCoordinateIndexVersion = 3;
 constexpr std::uint64_t kMissingLength = std::numeric_limits<std::uint64_t>::max();
 
 struct CoordinateIndexHeaderDisk {
@@ -32,11 +45,20 @@ struct CoordinateIndexHeaderDisk {
     std::uint64_t entry_table_offset{};
     std::uint64_t strings_offset{};
     std::uint64_t strings_size{};
+    std::uint64_t key_count{};
+    std::uint64_t fragment_count{};
+    std::uint64_t key_table_offset{};
+    std::uint64_t fragment_table_offset{};
+    std::uint64_t community_run_count{};
+    std::uint64_t community_run_table_offset{};
 };
 
 struct CoordinateTrackDisk {
     char source_type{};
-    char reserved[7]{};
+    char reserved[3]{};
+    // Length of the queryable sequence name, a prefix of the raw sequence
+    // name: P paths drop their terminal :start-end suffix.
+    std::uint32_t coordinate_length{};
     std::uint64_t reference_offset{};
     std::uint64_t reference_length{};
     std::uint64_t sequence_offset{};
@@ -46,6 +68,8 @@ struct CoordinateTrackDisk {
     std::uint64_t sequence_end{};
     std::uint64_t entry_begin{};
     std::uint64_t entry_count{};
+    std::uint64_t community_run_begin{};
+    std::uint64_t community_run_count{};
 };
 
 struct CoordinateEntryDisk {
@@ -54,29 +78,289 @@ struct CoordinateEntryDisk {
     std::uint32_t reserved{};
 };
 
-static_assert(sizeof(CoordinateIndexHeaderDisk) == 72,
-              "Unexpected coordinate-index header size");
-static_assert(sizeof(CoordinateTrackDisk) == 80,
-              "Unexpected coordinate-index track size");
-static_assert(sizeof(CoordinateEntryDisk) == 16,
-              "Unexpected coordinate-index entry size");
+// Sequence directory. Keys are sorted by (sequence, reference) name, so the
+// references that define one sequence are adjacent. Each key owns a run of
+// fragments sorted by sequence_start, and max_end is the largest
+// sequence_end up to and including that fragment, which bounds the backward
+// scan for fragments overlapping a query when haplotypes overlap.
+struct CoordinateKeyDisk {
+    std::uint64_t sequence_offset{};
+    std::uint64_t sequence_length{};
+    std::uint64_t reference_offset{};
+    std::uint64_t reference_length{};
+    std::uint64_t fragment_begin{};
+    std::uint64_t fragment_count{};
+};
 
-struct BuildEntry {
+struct CoordinateFragmentDisk {
+    std::uint64_t sequence_start{};
+    std::uint64_t sequence_end{};
+    std::uint64_t max_end{};
+    std::uint32_t track_id{};
+    std::uint32_t reserved{};
+};
+
+// Consecutive entries of one track whose nodes share a community collapse
+// into one run starting at the first of them; a run ends where the next one
+// starts, and a track's last run at its sequence_end.
+struct CoordinateCommunityRunDisk {
     std::uint64_t start{};
-    std::uint64_t end{};
-    std::uint32_t node_rank{};
+    std::uint32_t community_id{};
+    std::uint32_t reserved{};
 };
 
+static_assert(sizeof(CoordinateIndexHeaderDisk) == 120,
+              "Unexpected coordinate-index header size");
+static_assert(sizeof(CoordinateTrackDisk) == 96,
+              "Unexpected coordinate-index track size");
+static_assert(sizeof(CoordinateEntryDisk) == 16,
+              "Unexpected coordinate-index entry size");
+static_assert(sizeof(CoordinateKeyDisk) == 48,
+              "Unexpected coordinate-index directory key size");
+static_assert(sizeof(CoordinateFragmentDisk) == 32,
+              "Unexpected coordinate-index directory fragment size");
+static_assert(sizeof(CoordinateCommunityRunDisk) == 16,
+              "Unexpected coordinate-index community run size");
+
+// Tracks from .pdx decode their entries from this path again when the output
+// is written; every other track owns a range of the build's EntryStore.
+constexpr std::uint32_t kNoPathId = std::numeric_limits<std::uint32_t>::max();
+
+// Track metadata only: entries are never held in memory while building.
 struct BuildTrack {
     char source_type{};
     std::string reference_name;
     std::string sequence_name;
+    // Prefix of sequence_name that queries use; set once all tracks exist.
+    std::size_t coordinate_length{};
     std::uint64_t haplotype{};
     std::uint64_t sequence_start{};
     std::uint64_t sequence_end{};
-    std::vector<BuildEntry> entries;
+    std::uint64_t entry_count{};
+    std::uint64_t stored_begin{};
+    std::uint32_t path_id{kNoPathId};
+    // Stored GFA W entries carry only node ranks, because S lines may follow
+    // the W line; their starts are accumulated when the output is written.
+    bool derive_starts{false};
+};
+
+// Segment lengths by .ndx rank. A matching .lnx is mapped when one is
+// available, so no per-node table is allocated; otherwise the lengths of the
+// scanned S lines are kept in a uint32 table, the width .lnx stores.
+class NodeLengths {
+public:
+    NodeLengths(std::uint64_t node_count, const std::string& length_index_path)
+        : node_count_(node_count) {
+        if (!length_index_path.empty()) {
+            mapped_ = std::make_unique<indexer::NodeLengthIndexReader>(length_index_path);
+            if (mapped_->node_count() != node_count) {
+                throw std::runtime_error(".lnx and .ndx node counts differ; rebuild them together");
+            }
+        } else {
+            collected_.assign(static_cast<std::size_t>(node_count), kMissingLength32);
+        }
+    }
+
+    [[nodiscard]] bool mapped() const { return mapped_ != nullptr; }
+    [[nodiscard]] std::uint64_t size() const { return node_count_; }
+
+    void set(std::uint32_t rank, std::uint64_t length, const std::string& segment_name) {
+        if (length == kMissingLength) return;
+        if (length >= kMissingLength32) {
+            throw std::runtime_error("Segment length exceeds uint32_t range for segment '" +
+                                     segment_name + "'");
+        }
+        collected_[rank] = static_cast<std::uint32_t>(length);
+    }
+
+    // kMissingLength for ranks outside the table and segments without length.
+    [[nodiscard]] std::uint64_t get(std::uint32_t rank) const {
+        if (rank >= node_count_) return kMissingLength;
+        if (mapped_) return mapped_->length(rank);
+        const auto length = collected_[rank];
+        return length == kMissingLength32 ? kMissingLength : length;
+    }
+
+private:
+    static constexpr std::uint32_t kMissingLength32 = std::numeric_limits<std::uint32_t>::max();
+
+    std::uint64_t node_count_{};
+    std::unique_ptr<indexer::NodeLengthIndexReader> mapped_;
+    std::vector<std::uint32_t> collected_;
 };
 
+// Scratch copy of the entry table. Each track appends one contiguous range
+// while the input is read, and the output copies the ranges back in final
+// track order.
+class EntryStore {
+public:
+    static constexpr std::size_t kBlockEntries = 4096;
+
+    explicit EntryStore(std::string path)
+        : path_(std::move(path)), out_(path_, std::ios::binary | std::ios::trunc) {
+        if (!out_) throw std::runtime_error("Failed to open coordinate entry scratch file: " + path_);
+        buffer_.reserve(kBlockEntries);
+    }
+
+    [[nodiscard]] std::uint64_t size() const { return size_; }
+
+    void append(std::uint64_t start, std::uint32_t node_rank) {
+        buffer_.push_back(CoordinateEntryDisk{start, node_rank, 0});
+        ++size_;
+        if (buffer_.size() == kBlockEntries) flush();
+    }
+
+    // Stop appending and reopen the file for read().
+    void finish() {
+        flush();
+        out_.close();
+        if (!out_) throw std::runtime_error("Failed to write coordinate entry scratch file: " + path_);
+        in_.open(path_, std::ios::binary);
+        if (!in_) throw std::runtime_error("Failed to reopen coordinate entry scratch file: " + path_);
+    }
+
+    void read(std::uint64_t begin, std::size_t count, std::vector<CoordinateEntryDisk>& entries) {
+        entries.resize(count);
+        in_.clear();
+        in_.seekg(static_cast<std::streamoff>(begin * sizeof(CoordinateEntryDisk)), std::ios::beg);
+        in_.read(reinterpret_cast<char*>(entries.data()),
+                 static_cast<std::streamsize>(count * sizeof(CoordinateEntryDisk)));
+        if (!in_) throw std::runtime_error("Failed to read coordinate entry scratch file: " + path_);
+    }
+
+private:
+    void flush() {
+        if (buffer_.empty()) return;
+        out_.write(reinterpret_cast<const char*>(buffer_.data()),
+                   static_cast<std::streamsize>(buffer_.size() * sizeof(CoordinateEntryDisk)));
+        if (!out_) throw std::runtime_error("Failed to write coordinate entry scratch file: " + path_);
+        buffer_.clear();
+    }
+
+    std::string path_;
+    std::ofstream out_;
+    std::ifstream in_;
+    std::vector<CoordinateEntryDisk> buffer_;
+    std::uint64_t size_{};
+};
+
+// One SR:i:0 segment: its SO offset, the id of its SN sequence in order of
+// first appearance, and its rank. Lengths are looked up by rank when the
+// sorted records are split into fragments.
+struct RgfaEntryRecord {
+    std::uint64_t start{};
+    std::uint32_t sequence_id{};
+    std::uint32_t node_rank{};
+};
+
+static_assert(sizeof(RgfaEntryRecord) == 16, "Unexpected rGFA entry record size");
+
+bool rgfa_entry_less(const RgfaEntryRecord& lhs, const RgfaEntryRecord& rhs) {
+    if (lhs.sequence_id != rhs.sequence_id) return lhs.sequence_id < rhs.sequence_id;
+    if (lhs.start != rhs.start) return lhs.start < rhs.start;
+    return lhs.node_rank < rhs.node_rank;
+}
+
+// Sorts the SR:i:0 records of an rGFA in bounded memory. A full buffer is
+// sorted and spilled as a run file, and the runs are k-way merged at the end;
+// when every record fits in the buffer nothing is written.
+class RgfaEntrySorter {
+public:
+    RgfaEntrySorter(std::string temp_dir, std::size_t max_records)
+        : temp_dir_(std::move(temp_dir)), max_records_(std::max<std::size_t>(max_records, 1)) {}
+
+    [[nodiscard]] std::uint64_t size() const { return size_; }
+    [[nodiscard]] std::size_t run_count() const { return run_paths_.size(); }
+
+    void add(const RgfaEntryRecord& record) {
+        if (buffer_.size() == max_records_) spill();
+        if (buffer_.size() == buffer_.capacity()) {
+            // Grow by doubling, but never past the budget.
+            buffer_.reserve(std::min(max_records_, std::max<std::size_t>(1024, buffer_.size() * 2)));
+        }
+        buffer_.push_back(record);
+        ++size_;
+    }
+
+    // Visit every record once, in rgfa_entry_less order.
+    template <typename Visitor>
+    void for_each_sorted(Visitor&& visitor);
+
+private:
+    static constexpr std::size_t kRunBlockRecords = 4096;
+
+    // Sequential reader over one spilled run.
+    struct RunCursor {
+        explicit RunCursor(const std::string& path) : in(path, std::ios::binary) {
+            if (!in) throw std::runtime_error("Failed to open rGFA entry run: " + path);
+        }
+
+        bool advance() {
+            if (next == block.size()) {
+                block.resize(kRunBlockRecords);
+                in.read(reinterpret_cast<char*>(block.data()),
+                        static_cast<std::streamsize>(block.size() * sizeof(RgfaEntryRecord)));
+                block.resize(static_cast<std::size_t>(in.gcount()) / sizeof(RgfaEntryRecord));
+                next = 0;
+                if (block.empty()) return false;
+            }
+            current = block[next++];
+            return true;
+        }
+
+        std::ifstream in;
+        std::vector<RgfaEntryRecord> block;
+        std::size_t next{0};
+        RgfaEntryRecord current{};
+    };
+
+    void spill() {
+        std::sort(buffer_.begin(), buffer_.end(), rgfa_entry_less);
+        const auto path = temp_dir_ + "/rgfa_run_" + std::to_string(run_paths_.size()) + ".bin";
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(buffer_.data()),
+                  static_cast<std::streamsize>(buffer_.size() * sizeof(RgfaEntryRecord)));
+        out.close();
+        if (!out) throw std::runtime_error("Failed to write rGFA entry run: " + path);
+        run_paths_.push_back(path);
+        buffer_.clear();
+    }
+
+    std::string temp_dir_;
+    std::size_t max_records_{};
+    std::uint64_t size_{};
+    std::vector<RgfaEntryRecord> buffer_;
+    std::vector<std::string> run_paths_;
+};
+
+template <typename Visitor>
+void RgfaEntrySorter::for_each_sorted(Visitor&& visitor) {
+    if (run_paths_.empty()) {
+        std::sort(buffer_.begin(), buffer_.end(), rgfa_entry_less);
+        for (const auto& record : buffer_) visitor(record);
+        return;
+    }
+    if (!buffer_.empty()) spill();
+    std::vector<RgfaEntryRecord>().swap(buffer_);
+
+    std::vector<RunCursor> cursors;
+    cursors.reserve(run_paths_.size());
+    for (const auto& path : run_paths_) cursors.emplace_back(path);
+    const auto later = [&](std::size_t lhs, std::size_t rhs) {
+        return rgfa_entry_less(cursors[rhs].current, cursors[lhs].current);
+    };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(later)> heap(later);
+    for (std::size_t i = 0; i < cursors.size(); ++i) {
+        if (cursors[i].advance()) heap.push(i);
+    }
+    while (!heap.empty()) {
+        const auto i = heap.top();
+        heap.pop();
+        visitor(cursors[i].current);
+        if (cursors[i].advance()) heap.push(i);
+    }
+}
+
 struct ParsedSegment {
     std::string name;
     std::uint64_t length{};
@@ -295,62 +579,104 @@ void validate_explicit_reference_before_full_scan(const std::string& input_gfa,
     }
 }
 
-void append_reference_walks_from_path_index(const std::string& path_index_path,
+bool path_index_has_any_reference_walk(const paths::PathIndexReader& path_index,
+                                       const std::vector<std::string>& references) {
+    if (references.empty()) return false;
+    for (std::uint32_t path_id = 0; path_id < path_index.path_count(); ++path_id) {
+        const auto info = path_index.get_path_info(path_id);
+        if (info.record_type == 'W' && vector_contains(references, info.sample_id)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Pass each step of a .pdx path to emit(start, node_rank), accumulating
+// coordinates from the supplied start, and return the end coordinate. The
+// step table is already rank-aligned to .ndx, so only segment lengths are
+// needed.
+template <typename Emit>
+std::uint64_t walk_indexed_steps(const paths::PathIndexReader& path_index,
+                                 std::uint32_t path_id,
+                                 std::string_view path_name,
+                                 std::uint64_t coordinate,
+                                 const NodeLengths& node_lengths,
+                                 Emit&& emit) {
+    path_index.for_each_step(
+        path_id, 0, std::numeric_limits<std::uint64_t>::max(),
+        [&](const paths::StepRecord& step, std::uint64_t) {
+            const auto length = node_lengths.get(step.node_id);
+            if (length == kMissingLength) {
+                throw std::runtime_error("Missing segment length for coordinate path step in .pdx path: " +
+                                         std::string(path_name));
+            }
+            if (length > std::numeric_limits<std::uint64_t>::max() - coordinate) {
+                throw std::runtime_error("Coordinate overflow in .pdx path: " +
+                                         std::string(path_name));
+            }
+            emit(coordinate, step.node_id);
+            coordinate += length;
+        });
+    return coordinate;
+}
+
+// Sum a .pdx path's segment lengths without emitting entries; the entries
+// themselves are decoded again while the output is written.
+std::uint64_t indexed_path_end(const paths::PathIndexReader& path_index,
+                               std::uint32_t path_id,
+                               std::string_view path_name,
+                               std::uint64_t coordinate,
+                               const NodeLengths& node_lengths) {
+    return walk_indexed_steps(path_index, path_id, path_name, coordinate, node_lengths,
+                              [](std::uint64_t, std::uint32_t) {});
+}
+
+BuildTrack indexed_walk_track(const paths::PathIndexReader& path_index,
+                              const paths::PathInfo& info,
+                              const NodeLengths& node_lengths,
+                              const std::string& role) {
+    if (info.seq_start < 0 || info.seq_end < 0) {
+        throw std::runtime_error(role + " W path in .pdx is missing SeqStart/SeqEnd: " +
+                                 std::string(info.name));
+    }
+    if (info.seq_end < info.seq_start) {
+        throw std::runtime_error(role + " W path in .pdx has SeqEnd before SeqStart: " +
+                                 std::string(info.name));
+    }
+
+    BuildTrack track;
+    track.source_type = 'W';
+    track.reference_name = std::string(info.sample_id);
+    track.sequence_name = std::string(info.seq_id);
+    track.haplotype = info.hap_index;
+    track.sequence_start = static_cast<std::uint64_t>(info.seq_start);
+    track.sequence_end = static_cast<std::uint64_t>(info.seq_end);
+    track.entry_count = info.step_count;
+    track.path_id = info.path_id;
+    if (indexed_path_end(path_index, info.path_id, info.name, track.sequence_start,
+                         node_lengths) != track.sequence_end) {
+        throw std::runtime_error(role + " W span in .pdx is inconsistent with segment lengths: " +
+                                 std::string(info.name));
+    }
+    return track;
+}
+
+void append_reference_walks_from_path_index(const paths::PathIndexReader& path_index,
                                             const std::vector<std::string>& selected_references,
-                                            const std::vector<std::uint64_t>& node_lengths,
+                                            const NodeLengths& node_lengths,
                                             std::vector<BuildTrack>& tracks) {
-    if (path_index_path.empty() || selected_references.empty()) return;
-
-    paths::PathIndexReader path_index(path_index_path);
+    if (selected_references.empty()) return;
     if (path_index.node_count() != node_lengths.size()) {
         throw std::runtime_error(".pdx and .ndx node counts differ; rebuild them together");
     }
 
-    // Reuse the rank-aligned .pdx step table when the GFA being indexed no
-    // longer carries original W records, as in the chunked multi-member output.
+    // Reuse the rank-aligned .pdx step table instead of parsing W lines, which
+    // also covers the chunked multi-member output that no longer carries them.
     for (std::uint32_t path_id = 0; path_id < path_index.path_count(); ++path_id) {
         const auto info = path_index.get_path_info(path_id);
         if (info.record_type != 'W') continue;
         if (!vector_contains(selected_references, info.sample_id)) continue;
-        if (info.seq_start < 0 || info.seq_end < 0) {
-            throw std::runtime_error("Reference W path in .pdx is missing SeqStart/SeqEnd: " +
-                                     std::string(info.name));
-        }
-        if (info.seq_end < info.seq_start) {
-            throw std::runtime_error("Reference W path in .pdx has SeqEnd before SeqStart: " +
-                                     std::string(info.name));
-        }
-
-        BuildTrack track;
-        track.source_type = 'W';
-        track.reference_name = std::string(info.sample_id);
-        track.sequence_name = std::string(info.seq_id);
-        track.haplotype = info.hap_index;
-        track.sequence_start = static_cast<std::uint64_t>(info.seq_start);
-        track.sequence_end = static_cast<std::uint64_t>(info.seq_end);
-
-        const auto steps = path_index.read_steps(path_id);
-        track.entries.reserve(steps.size());
-        std::uint64_t coordinate = track.sequence_start;
-        for (const auto& step : steps) {
-            if (step.node_id >= node_lengths.size() ||
-                node_lengths[step.node_id] == kMissingLength) {
-                throw std::runtime_error("Missing segment length for reference W step in .pdx path: " +
-                                         std::string(info.name));
-            }
-            const auto length = node_lengths[step.node_id];
-            if (length > std::numeric_limits<std::uint64_t>::max() - coordinate) {
-                throw std::runtime_error("Reference W coordinate overflow in .pdx path: " +
-                                         std::string(info.name));
-            }
-            track.entries.push_back(BuildEntry{coordinate, coordinate + length, step.node_id});
-            coordinate += length;
-        }
-        if (coordinate != track.sequence_end) {
-            throw std::runtime_error("Reference W span in .pdx is inconsistent with segment lengths: " +
-                                     std::string(info.name));
-        }
-        tracks.push_back(std::move(track));
+        tracks.push_back(indexed_walk_track(path_index, info, node_lengths, "Reference"));
     }
 }
 
@@ -440,46 +766,17 @@ std::vector<std::uint32_t> load_requested_coordinate_path_ids(
     return path_ids;
 }
 
-std::uint64_t append_entries_from_indexed_steps(const paths::PathIndexReader& path_index,
-                                                std::uint32_t path_id,
-                                                std::string_view path_name,
-                                                std::uint64_t coordinate,
-                                                const std::vector<std::uint64_t>& node_lengths,
-                                                std::vector<BuildEntry>& entries) {
-    // The .pdx step table is already rank-aligned to .ndx, so coordinate tracks
-    // only need the segment lengths collected from S lines in the indexed GFA.
-    const auto steps = path_index.read_steps(path_id);
-    entries.reserve(entries.size() + steps.size());
-    for (const auto& step : steps) {
-        if (step.node_id >= node_lengths.size() ||
-            node_lengths[step.node_id] == kMissingLength) {
-            throw std::runtime_error("Missing segment length for coordinate path step in .pdx path: " +
-                                     std::string(path_name));
-        }
-        const auto length = node_lengths[step.node_id];
-        if (length > std::numeric_limits<std::uint64_t>::max() - coordinate) {
-            throw std::runtime_error("Coordinate overflow in .pdx path: " +
-                                     std::string(path_name));
-        }
-        entries.push_back(BuildEntry{coordinate, coordinate + length, step.node_id});
-        coordinate += length;
-    }
-    return coordinate;
-}
-
 bool p_path_has_no_overlaps(std::string_view overlap_field) {
     // Coordinate indexing of P lines assumes path coordinates advance by node
     // length. A real overlap/CIGAR field would make those coordinates ambiguous.
     return overlap_field.empty() || overlap_field == "*";
 }
 
-void append_selected_paths_from_path_index(const std::string& path_index_path,
+void append_selected_paths_from_path_index(const paths::PathIndexReader& path_index,
                                            const std::vector<std::uint32_t>& selected_path_ids,
-                                           const std::vector<std::uint64_t>& node_lengths,
+                                           const NodeLengths& node_lengths,
                                            std::vector<BuildTrack>& tracks) {
     if (selected_path_ids.empty()) return;
-
-    paths::PathIndexReader path_index(path_index_path);
     if (path_index.node_count() != node_lengths.size()) {
         throw std::runtime_error(".pdx and .ndx node counts differ; rebuild them together");
     }
@@ -490,34 +787,7 @@ void append_selected_paths_from_path_index(const std::string& path_index_path,
     for (const auto path_id : selected_path_ids) {
         const auto info = path_index.get_path_info(path_id);
         if (info.record_type == 'W') {
-            if (info.seq_start < 0 || info.seq_end < 0) {
-                throw std::runtime_error("Selected W path in .pdx is missing SeqStart/SeqEnd: " +
-                                         std::string(info.name));
-            }
-            if (info.seq_end < info.seq_start) {
-                throw std::runtime_error("Selected W path in .pdx has SeqEnd before SeqStart: " +
-                                         std::string(info.name));
-            }
-
-            BuildTrack track;
-            track.source_type = 'W';
-            track.reference_name = std::string(info.sample_id);
-            track.sequence_name = std::string(info.seq_id);
-            track.haplotype = info.hap_index;
-            track.sequence_start = static_cast<std::uint64_t>(info.seq_start);
-            track.sequence_end = static_cast<std::uint64_t>(info.seq_end);
-
-            const auto coordinate = append_entries_from_indexed_steps(path_index,
-                                                                      path_id,
-                                                                      info.name,
-                                                                      track.sequence_start,
-                                                                      node_lengths,
-                                                                      track.entries);
-            if (coordinate != track.sequence_end) {
-                throw std::runtime_error("Selected W span in .pdx is inconsistent with segment lengths: " +
-                                         std::string(info.name));
-            }
-            tracks.push_back(std::move(track));
+            tracks.push_back(indexed_walk_track(path_index, info, node_lengths, "Selected"));
         } else if (info.record_type == 'P') {
             if (!p_path_has_no_overlaps(info.overlap_field)) {
                 throw std::runtime_error("Cannot coordinate-index P path '" +
@@ -532,12 +802,13 @@ void append_selected_paths_from_path_index(const std::string& path_index_path,
             const auto parsed =
                 paths::parse_p_path_coordinate_name(info.name);
             track.sequence_start = parsed.start;
-            track.sequence_end = append_entries_from_indexed_steps(path_index,
-                                                                   path_id,
-                                                                   info.name,
-                                                                   track.sequence_start,
-                                                                   node_lengths,
-                                                                   track.entries);
+            track.sequence_end = indexed_path_end(path_index,
+                                                  path_id,
+                                                  info.name,
+                                                  track.sequence_start,
+                                                  node_lengths);
+            track.entry_count = info.step_count;
+            track.path_id = path_id;
             if (parsed.has_coordinates &&
                 track.sequence_end != parsed.end) {
                 throw std::runtime_error(
@@ -565,6 +836,108 @@ void write_vector(std::ofstream& out, const std::vector<T>& values) {
               static_cast<std::streamsize>(values.size() * sizeof(T)));
 }
 
+// Copy the entries of every track, in final track order, to the output, and
+// collapse them into community runs in the same pass. The runs go to a
+// scratch file at runs_path, each track record gets its run range, and the
+// total number of runs is returned.
+std::uint64_t write_track_entries(std::ofstream& out,
+                                  const std::vector<BuildTrack>& tracks,
+                                  EntryStore& store,
+                                  const paths::PathIndexReader* path_index,
+                                  const NodeLengths& node_lengths,
+                                  const indexer::NodeHashIndex& node_index,
+                                  const std::string& runs_path,
+                                  std::vector<CoordinateTrackDisk>& track_records) {
+    std::vector<CoordinateEntryDisk> block;
+    block.reserve(EntryStore::kBlockEntries);
+    const auto flush = [&]() {
+        write_vector(out, block);
+        block.clear();
+    };
+
+    std::ofstream runs_out(runs_path, std::ios::binary | std::ios::trunc);
+    if (!runs_out) throw std::runtime_error("Failed to open community run scratch file: " + runs_path);
+    std::vector<CoordinateCommunityRunDisk> runs;
+    runs.reserve(EntryStore::kBlockEntries);
+    std::uint64_t run_count = 0;
+    const auto push_run = [&](const CoordinateCommunityRunDisk& run) {
+        runs.push_back(run);
+        ++run_count;
+        if (runs.size() == EntryStore::kBlockEntries) {
+            write_vector(runs_out, runs);
+            runs.clear();
+        }
+    };
+    // The open run of the current track is only written once an entry of
+    // another community, or the end of the track, closes it.
+    CoordinateCommunityRunDisk open_run{};
+    bool has_open_run = false;
+    const auto add_run_entry = [&](std::uint64_t start, std::uint32_t node_rank) {
+        const auto community_id = node_index.community_id_by_rank(node_rank);
+        if (has_open_run && open_run.community_id == community_id) return;
+        if (has_open_run) push_run(open_run);
+        open_run = CoordinateCommunityRunDisk{start, community_id, 0};
+        has_open_run = true;
+    };
+    const auto close_track_runs = [&](std::size_t track_id) {
+        if (has_open_run) push_run(open_run);
+        has_open_run = false;
+        track_records[track_id].community_run_count =
+            run_count - track_records[track_id].community_run_begin;
+    };
+
+    for (std::size_t t = 0; t < tracks.size(); ++t) {
+        const auto& track = tracks[t];
+        track_records[t].community_run_begin = run_count;
+        if (track.path_id != kNoPathId) {
+            walk_indexed_steps(*path_index, track.path_id, track.sequence_name,
+                               track.sequence_start, node_lengths,
+                               [&](std::uint64_t start, std::uint32_t node_rank) {
+                                   block.push_back(CoordinateEntryDisk{start, node_rank, 0});
+                                   add_run_entry(start, node_rank);
+                                   if (block.size() == EntryStore::kBlockEntries) flush();
+                               });
+            flush();
+            close_track_runs(t);
+            continue;
+        }
+
+        std::uint64_t coordinate = track.sequence_start;
+        for (std::uint64_t done = 0; done < track.entry_count;) {
+            const auto count = static_cast<std::size_t>(
+                std::min<std::uint64_t>(EntryStore::kBlockEntries, track.entry_count - done));
+            store.read(track.stored_begin + done, count, block);
+            if (track.derive_starts) {
+                for (auto& entry : block) {
+                    const auto length = node_lengths.get(entry.node_rank);
+                    if (length == kMissingLength) {
+                        throw std::runtime_error("Missing segment length for a node of reference W walk " +
+                                                 track.reference_name + ":" + track.sequence_name);
+                    }
+                    if (length > std::numeric_limits<std::uint64_t>::max() - coordinate) {
+                        throw std::runtime_error("Reference W coordinate overflow");
+                    }
+                    entry.start = coordinate;
+                    coordinate += length;
+                }
+            }
+            for (const auto& entry : block) add_run_entry(entry.start, entry.node_rank);
+            flush();
+            done += count;
+        }
+        if (track.derive_starts && coordinate != track.sequence_end) {
+            throw std::runtime_error("Reference W span for " + track.reference_name + ":" +
+                                     track.sequence_name + " is inconsistent with segment lengths");
+        }
+        close_track_runs(t);
+    }
+
+    write_vector(runs_out, runs);
+    runs_out.close();
+    if (!runs_out) throw std::runtime_error("Failed to write community run scratch file: " + runs_path);
+    return run_count;
+}
+
 }  // namespace
 
 bool build_coordinate_index(const std::string& input_gfa,
@@ -573,7 +946,10 @@ bool build_coordinate_index(const std::string& input_gfa,
                             const std::string& reference_filter,
                             const Reader::Options& reader_options,
                             const std::string& path_index_path,
-                            const std::string& path_names_file) {
+                            const std::string& path_names_file,
+                            const std::string& node_length_index_path,
+                            const std::string& tmp_base_dir,
+                            std::uint64_t entry_memory_bytes) {
     if (!path_names_file.empty() && !reference_filter.empty()) {
         throw std::runtime_error("Use either a path/walk names file or a reference filter, not both");
     }
@@ -581,12 +957,14 @@ bool build_coordinate_index(const std::string& input_gfa,
         throw std::runtime_error("Path/walk coordinate selection requires a .pdx path index");
     }
 
+    std::unique_ptr<paths::PathIndexReader> path_index;
+    if (!path_index_path.empty()) path_index = std::make_unique<paths::PathIndexReader>(path_index_path);
+
     std::vector<std::uint32_t> selected_path_ids;
     if (!path_names_file.empty()) {
         // Validate the user-selected P/W names before scanning the potentially
-        // large GFA body. The node lengths are still collected later from S lines.
-        paths::PathIndexReader path_index(path_index_path);
-        selected_path_ids = load_requested_coordinate_path_ids(path_names_file, path_index);
+        // large GFA body.
+        selected_path_ids = load_requested_coordinate_path_ids(path_names_file, *path_index);
     } else {
         validate_explicit_reference_before_full_scan(input_gfa,
                                                      path_index_path,
@@ -595,100 +973,64 @@ bool build_coordinate_index(const std::string& input_gfa,
     }
 
     indexer::NodeHashIndex node_index(node_index_path);
-    std::vector<std::uint64_t> node_lengths(static_cast<std::size_t>(node_index.size()),
-                                            kMissingLength);
-    std::vector<std::string> reference_samples;
-    std::vector<BuildTrack> rgfa_tracks;
-
-    // Pass 1 records segment lengths by stable .ndx rank and collects SR:i:0
-    // coordinates as a fallback for rGFA files without reference W records.
-    Reader first_pass(reader_options);
-    if (!first_pass.open(input_gfa)) {
-        throw std::runtime_error("Could not open GFA for coordinate indexing: " + input_gfa);
-    }
-    std::string_view line;
-    while (first_pass.read_line(line)) {
-        if (line.empty()) continue;
-        if (line[0] == 'H') {
-            const auto parsed = parse_reference_samples(line);
-            reference_samples.insert(reference_samples.end(), parsed.begin(), parsed.end());
-            continue;
-        }
-        if (line[0] != 'S') continue;
-
-        const auto segment = parse_segment(line);
-        std::uint32_t rank = 0;
-        if (!node_index.lookup_rank(segment.name, rank)) {
-            throw std::runtime_error("Segment '" + segment.name +
-                                     "' is missing from the supplied .ndx");
-        }
-        node_lengths[rank] = segment.length;
+    NodeLengths node_lengths(node_index.size(), node_length_index_path);
 
-        if (!segment.has_rgfa_coordinates || segment.stable_rank != 0) continue;
-        if (segment.length == kMissingLength) {
-            throw std::runtime_error("SR:i:0 segment '" + segment.name +
-                                     "' has neither sequence nor LN:i length");
-        }
-        auto track_it = std::find_if(
-            rgfa_tracks.begin(), rgfa_tracks.end(),
-            [&](const BuildTrack& track) {
-                return track.sequence_name == segment.stable_sequence;
-            });
-        if (track_it == rgfa_tracks.end()) {
-            BuildTrack track;
-            track.source_type = 'S';
-            track.sequence_name = segment.stable_sequence;
-            track.haplotype = 0;
-            rgfa_tracks.push_back(std::move(track));
-            track_it = std::prev(rgfa_tracks.end());
-        }
-        if (segment.length > std::numeric_limits<std::uint64_t>::max() -
-                                 segment.stable_offset) {
-            throw std::runtime_error("rGFA coordinate overflow for segment '" +
-                                     segment.name + "'");
-        }
-        track_it->entries.push_back(BuildEntry{
-            segment.stable_offset,
-            segment.stable_offset + segment.length,
-            rank,
-        });
-    }
-
-    std::sort(reference_samples.begin(), reference_samples.end());
-    reference_samples.erase(std::unique(reference_samples.begin(), reference_samples.end()),
-                            reference_samples.end());
-    if (!reference_filter.empty() && !reference_samples.empty() &&
-        !vector_contains(reference_samples, reference_filter)) {
-        throw std::runtime_error("Reference sample '" + reference_filter +
-                                 "' is not listed by an H-line RS:Z tag");
+    std::string tmp_base = tmp_base_dir;
+    if (tmp_base.empty()) {
+        const auto parent = std::filesystem::path(output_index).parent_path();
+        tmp_base = parent.empty() ? std::string("") : parent.string();
     }
+    const std::string tmp_dir = create_temp_dir(tmp_base,
+                                                "gfaidx_coordinates_tmp_",
+                                                "latest_coordinates",
+                                                false);
+    const auto cleanup_tmp = [&]() {
+        std::error_code ec;
+        std::filesystem::remove_all(tmp_dir, ec);
+    };
 
-    std::vector<std::string> selected_references;
-    if (!reference_filter.empty()) {
-        selected_references.push_back(reference_filter);
-    } else {
-        selected_references = reference_samples;
-    }
+    try {
+        EntryStore store(tmp_dir + "/entries.bin");
+        RgfaEntrySorter rgfa_entries(
+            tmp_dir, static_cast<std::size_t>(entry_memory_bytes / sizeof(RgfaEntryRecord)));
+        std::unordered_map<std::string, std::uint32_t> rgfa_sequence_ids;
+        std::vector<std::string> rgfa_sequences;
+        std::vector<std::string> reference_samples;
+        std::vector<BuildTrack> tracks;
+
+        // What the body has to supply is settled once the header block is
+        // read: reference W tracks come from .pdx when it holds any for the
+        // selected samples, and SR:i:0 segments are only a fallback for graphs
+        // without reference W tracks.
+        bool header_done = false;
+        bool late_references = false;
+        bool collect_walks = false;
+        bool collect_rgfa = false;
+        std::vector<std::string> walk_references;
+        const auto selected_references_from = [&](std::vector<std::string> samples) {
+            if (!reference_filter.empty()) return std::vector<std::string>{reference_filter};
+            std::sort(samples.begin(), samples.end());
+            samples.erase(std::unique(samples.begin(), samples.end()), samples.end());
+            return samples;
+        };
+        const auto finish_header = [&]() {
+            header_done = true;
+            if (!selected_path_ids.empty()) return;
+            walk_references = selected_references_from(reference_samples);
+            const bool walks_from_path_index =
+                path_index && path_index_has_any_reference_walk(*path_index, walk_references);
+            collect_walks = !walks_from_path_index && !walk_references.empty();
+            collect_rgfa = !walks_from_path_index;
+        };
 
-    std::vector<BuildTrack> tracks;
-    if (!selected_path_ids.empty()) {
-        append_selected_paths_from_path_index(path_index_path,
-                                              selected_path_ids,
-                                              node_lengths,
-                                              tracks);
-    } else if (!selected_references.empty()) {
-        // Pass 2 parses only W records belonging to selected reference samples;
+        // Parse only W records belonging to selected reference samples;
         // non-reference haplotype walks never enter the coordinate index.
-        Reader second_pass(reader_options);
-        if (!second_pass.open(input_gfa)) {
-            throw std::runtime_error("Could not reopen GFA for W-line indexing: " + input_gfa);
-        }
-        while (second_pass.read_line(line)) {
-            if (line.empty() || line[0] != 'W') continue;
+        const auto collect_walk = [&](std::string_view line,
+                                      const std::vector<std::string>& references) {
             // Check the sample field before strict W parsing so unrelated
             // haplotype records with '*' coordinates are safely ignored.
             const auto fields = split_tab_fields(line);
-            if (fields.size() < 2 || !vector_contains(selected_references, fields[1])) continue;
+            if (fields.size() < 2 || !vector_contains(references, fields[1])) return;
             const auto walk = parse_walk(line);
 
             BuildTrack track;
@@ -698,8 +1040,9 @@ bool build_coordinate_index(const std::string& input_gfa,
             track.haplotype = walk.haplotype;
             track.sequence_start = walk.sequence_start;
             track.sequence_end = walk.sequence_end;
+            track.stored_begin = store.size();
+            track.derive_starts = true;
 
-            std::uint64_t coordinate = walk.sequence_start;
             for (std::size_t pos = 0; pos < walk.walk.size();) {
                 const char orientation = walk.walk[pos];
                 if (orientation != '>' && orientation != '<') {
@@ -717,304 +1060,635 @@ bool build_coordinate_index(const std::string& input_gfa,
                                              std::string(node_name) +
                                              "' is missing from the supplied .ndx");
                 }
-                if (rank >= node_lengths.size() || node_lengths[rank] == kMissingLength) {
-                    throw std::runtime_error("Missing segment length for reference W node '" +
-                                             std::string(node_name) + "'");
-                }
-                const auto length = node_lengths[rank];
-                if (length > std::numeric_limits<std::uint64_t>::max() - coordinate) {
-                    throw std::runtime_error("Reference W coordinate overflow");
-                }
-                track.entries.push_back(BuildEntry{coordinate, coordinate + length, rank});
-                coordinate += length;
+                store.append(0, rank);
+                ++track.entry_count;
                 pos = end;
             }
+            tracks.push_back(std::move(track));
+        };
 
-            if (coordinate != walk.sequence_end) {
-                throw std::runtime_error("Reference W span for " + walk.sample + ":" +
-                                         walk.sequence + " is inconsistent with segment lengths");
+        // The single pass over the GFA records segment lengths by stable .ndx
+        // rank unless a .lnx supplies them, collects SR:i:0 coordinates, and
+        // parses reference W lines. It stops after the header block when the
+        // .lnx and .pdx already provide everything.
+        Reader reader(reader_options);
+        if (!reader.open(input_gfa)) {
+            throw std::runtime_error("Could not open GFA for coordinate indexing: " + input_gfa);
+        }
+        std::string_view line;
+        while (reader.read_line(line)) {
+            if (line.empty()) continue;
+            if (line[0] == 'H') {
+                const auto parsed = parse_reference_samples(line);
+                if (header_done && !parsed.empty()) late_references = true;
+                reference_samples.insert(reference_samples.end(), parsed.begin(), parsed.end());
+                continue;
             }
-            tracks.push_back(std::move(track));
+            if (!header_done) {
+                finish_header();
+                if (node_lengths.mapped() && !collect_walks && !collect_rgfa) break;
+            }
+            if (line[0] == 'W') {
+                if (collect_walks) collect_walk(line, walk_references);
+                continue;
+            }
+            if (line[0] != 'S') continue;
+            if (node_lengths.mapped() && !collect_rgfa) continue;
+
+            const auto segment = parse_segment(line);
+            const bool rgfa_entry = collect_rgfa && segment.has_rgfa_coordinates &&
+                                    segment.stable_rank == 0;
+            if (node_lengths.mapped() && !rgfa_entry) continue;
+            std::uint32_t rank = 0;
+            if (!node_index.lookup_rank(segment.name, rank)) {
+                throw std::runtime_error("Segment '" + segment.name +
+                                         "' is missing from the supplied .ndx");
+            }
+            if (!node_lengths.mapped()) node_lengths.set(rank, segment.length, segment.name);
+            if (!rgfa_entry) continue;
+
+            if (segment.length == kMissingLength) {
+                throw std::runtime_error("SR:i:0 segment '" + segment.name +
+                                         "' has neither sequence nor LN:i length");
+            }
+            if (segment.length > std::numeric_limits<std::uint64_t>::max() -
+                                     segment.stable_offset) {
+                throw std::runtime_error("rGFA coordinate overflow for segment '" +
+                                         segment.name + "'");
+            }
+            const auto inserted = rgfa_sequence_ids.emplace(
+                segment.stable_sequence, static_cast<std::uint32_t>(rgfa_sequences.size()));
+            if (inserted.second) rgfa_sequences.push_back(segment.stable_sequence);
+            rgfa_entries.add(RgfaEntryRecord{segment.stable_offset, inserted.first->second, rank});
         }
-    }
+        reader.close();
+        if (!header_done) finish_header();
 
-    if (tracks.empty() && selected_path_ids.empty()) {
-        append_reference_walks_from_path_index(path_index_path,
-                                               selected_references,
-                                               node_lengths,
-                                               tracks);
-    }
+        const auto selected_references = selected_references_from(reference_samples);
+        if (!reference_filter.empty() && !reference_samples.empty() &&
+            !vector_contains(reference_samples, reference_filter)) {
+            throw std::runtime_error("Reference sample '" + reference_filter +
+                                     "' is not listed by an H-line RS:Z tag");
+        }
 
-    if (tracks.empty() && !reference_filter.empty()) {
-        throw std::runtime_error("No W records were found in the GFA or .pdx for reference sample '" +
-                                 reference_filter + "'");
-    }
+        if (!selected_path_ids.empty()) {
+            append_selected_paths_from_path_index(*path_index,
+                                                  selected_path_ids,
+                                                  node_lengths,
+                                                  tracks);
+        } else {
+            if (late_references && selected_references != walk_references) {
+                // An RS:Z header line after the first record widened the
+                // reference set, so select the reference W records again.
+                tracks.clear();
+                if (!(path_index && path_index_has_any_reference_walk(*path_index,
+                                                                      selected_references))) {
+                    Reader walk_reader(reader_options);
+                    if (!walk_reader.open(input_gfa)) {
+                        throw std::runtime_error("Could not reopen GFA for W-line indexing: " +
+                                                 input_gfa);
+                    }
+                    while (walk_reader.read_line(line)) {
+                        if (!line.empty() && line[0] == 'W') collect_walk(line, selected_references);
+                    }
+                }
+            }
+            if (tracks.empty() && path_index) {
+                append_reference_walks_from_path_index(*path_index,
+                                                       selected_references,
+                                                       node_lengths,
+                                                       tracks);
+            }
+        }
 
-    if (tracks.empty()) {
-        // Convert sorted SR:i:0 entries into continuous fragments. Splitting at
-        // gaps lets the compact entry format derive each end from the next start
-        // without incorrectly assigning uncovered coordinates to a node.
-        for (auto& rgfa_track : rgfa_tracks) {
-            auto& entries = rgfa_track.entries;
-            std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
-                if (lhs.start != rhs.start) return lhs.start < rhs.start;
-                return lhs.node_rank < rhs.node_rank;
-            });
-            if (entries.empty()) continue;
+        if (tracks.empty() && !reference_filter.empty()) {
+            throw std::runtime_error("No W records were found in the GFA or .pdx for reference sample '" +
+                                     reference_filter + "'");
+        }
 
+        if (tracks.empty()) {
+            // Convert sorted SR:i:0 entries into continuous fragments. Splitting
+            // at gaps lets the compact entry format derive each end from the
+            // next start without incorrectly assigning uncovered coordinates
+            // to a node.
+            if (rgfa_entries.run_count() != 0) {
+                std::cout << get_time() << ": Merging " << rgfa_entries.run_count()
+                          << " sorted runs of " << rgfa_entries.size()
+                          << " SR:i:0 segments" << std::endl;
+            }
+            bool open = false;
             BuildTrack fragment;
-            fragment.source_type = 'S';
-            fragment.sequence_name = rgfa_track.sequence_name;
-            fragment.haplotype = 0;
-            fragment.sequence_start = entries.front().start;
-            fragment.sequence_end = entries.front().end;
-            fragment.entries.push_back(entries.front());
-
-            for (std::size_t i = 1; i < entries.size(); ++i) {
-                if (entries[i].start < fragment.sequence_end) {
+            std::uint32_t sequence_id = 0;
+            rgfa_entries.for_each_sorted([&](const RgfaEntryRecord& record) {
+                const auto length = node_lengths.get(record.node_rank);
+                if (length == kMissingLength) {
+                    throw std::runtime_error("Missing segment length for SR:i:0 segment on stable sequence '" +
+                                             rgfa_sequences[record.sequence_id] + "'");
+                }
+                if (open && record.sequence_id == sequence_id &&
+                    record.start < fragment.sequence_end) {
                     throw std::runtime_error("Overlapping SR:i:0 segments on stable sequence '" +
-                                             rgfa_track.sequence_name + "'");
+                                             fragment.sequence_name + "'");
                 }
-                if (entries[i].start != fragment.sequence_end) {
-                    tracks.push_back(std::move(fragment));
+                if (!open || record.sequence_id != sequence_id ||
+                    record.start != fragment.sequence_end) {
+                    if (open) tracks.push_back(std::move(fragment));
                     fragment = BuildTrack{};
                     fragment.source_type = 'S';
-                    fragment.sequence_name = rgfa_track.sequence_name;
+                    fragment.sequence_name = rgfa_sequences[record.sequence_id];
                     fragment.haplotype = 0;
-                    fragment.sequence_start = entries[i].start;
+                    fragment.sequence_start = record.start;
+                    fragment.stored_begin = store.size();
+                    sequence_id = record.sequence_id;
+                    open = true;
                 }
-                fragment.entries.push_back(entries[i]);
-                fragment.sequence_end = entries[i].end;
-            }
-            tracks.push_back(std::move(fragment));
+                store.append(record.start, record.node_rank);
+                ++fragment.entry_count;
+                fragment.sequence_end = record.start + length;
+            });
+            if (open) tracks.push_back(std::move(fragment));
         }
-    }
+        store.finish();
 
-    if (tracks.empty()) {
-        throw std::runtime_error("No reference W records or SR:i:0 segments were available to index");
-    }
-
-    // Sorting metadata makes queries deterministic and keeps fragments for the
-    // same reference sequence adjacent without requiring a lookup map on disk.
-    const auto coordinate_sequence_name = [](const BuildTrack& track) {
-        return track.source_type == 'P'
-            ? paths::parse_p_path_coordinate_name(track.sequence_name)
-                  .coordinate_name
-            : std::string_view(track.sequence_name);
-    };
-    std::sort(tracks.begin(), tracks.end(), [&](const auto& lhs, const auto& rhs) {
-        if (lhs.reference_name != rhs.reference_name) {
-            return lhs.reference_name < rhs.reference_name;
+        if (tracks.empty()) {
+            throw std::runtime_error("No reference W records or SR:i:0 segments were available to index");
         }
-        const auto lhs_sequence = coordinate_sequence_name(lhs);
-        const auto rhs_sequence = coordinate_sequence_name(rhs);
-        if (lhs_sequence != rhs_sequence) {
-            return lhs_sequence < rhs_sequence;
+
+        // Parse P coordinate suffixes once here; the reader gets the queryable
+        // name from the stored prefix length instead of reparsing per query.
+        for (auto& track : tracks) {
+            track.coordinate_length = track.source_type == 'P'
+                ? paths::parse_p_path_coordinate_name(track.sequence_name).coordinate_name.size()
+                : track.sequence_name.size();
         }
-        if (lhs.haplotype != rhs.haplotype) return lhs.haplotype < rhs.haplotype;
-        if (lhs.sequence_start != rhs.sequence_start) {
-            return lhs.sequence_start < rhs.sequence_start;
+        const auto coordinate_sequence_name = [](const BuildTrack& track) {
+            return std::string_view(track.sequence_name).substr(0, track.coordinate_length);
+        };
+
+        // Sorting metadata makes queries deterministic and keeps fragments for the
+        // same reference sequence adjacent.
+        std::sort(tracks.begin(), tracks.end(), [&](const auto& lhs, const auto& rhs) {
+            if (lhs.reference_name != rhs.reference_name) {
+                return lhs.reference_name < rhs.reference_name;
+            }
+            const auto lhs_sequence = coordinate_sequence_name(lhs);
+            const auto rhs_sequence = coordinate_sequence_name(rhs);
+            if (lhs_sequence != rhs_sequence) {
+                return lhs_sequence < rhs_sequence;
+            }
+            if (lhs.haplotype != rhs.haplotype) return lhs.haplotype < rhs.haplotype;
+            if (lhs.sequence_start != rhs.sequence_start) {
+                return lhs.sequence_start < rhs.sequence_start;
+            }
+            return lhs.sequence_name < rhs.sequence_name;
+        });
+
+        // The GFA W specification requires fragments for one sample/haplotype/
+        // sequence to be non-overlapping; enforce that invariant before binary data
+        // is published so one coordinate never resolves through ambiguous fragments.
+        for (std::size_t i = 1; i < tracks.size(); ++i) {
+            const auto& previous = tracks[i - 1];
+            const auto& current = tracks[i];
+            if (previous.reference_name == current.reference_name &&
+                coordinate_sequence_name(previous) ==
+                    coordinate_sequence_name(current) &&
+                previous.haplotype == current.haplotype &&
+                current.sequence_start < previous.sequence_end) {
+                throw std::runtime_error("Overlapping reference-coordinate track fragments for '" +
+                                         current.reference_name + ":" +
+                                         std::string(coordinate_sequence_name(current)) +
+                                         "'");
+            }
         }
-        return lhs.sequence_name < rhs.sequence_name;
-    });
-
-    // The GFA W specification requires fragments for one sample/haplotype/
-    // sequence to be non-overlapping; enforce that invariant before binary data
-    // is published so one coordinate never resolves through ambiguous fragments.
-    for (std::size_t i = 1; i < tracks.size(); ++i) {
-        const auto& previous = tracks[i - 1];
-        const auto& current = tracks[i];
-        if (previous.reference_name == current.reference_name &&
-            coordinate_sequence_name(previous) ==
-                coordinate_sequence_name(current) &&
-            previous.haplotype == current.haplotype &&
-            current.sequence_start < previous.sequence_end) {
-            throw std::runtime_error("Overlapping reference-coordinate track fragments for '" +
-                                     current.reference_name + ":" +
-                                     std::string(coordinate_sequence_name(current)) +
-                                     "'");
+
+        if (tracks.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("Coordinate track count exceeds uint32_t range");
         }
-    }
 
-    std::vector<CoordinateTrackDisk> track_records;
-    std::vector<CoordinateEntryDisk> entry_records;
-    std::string strings;
-    track_records.reserve(tracks.size());
-    for (const auto& track : tracks) {
-        CoordinateTrackDisk record{};
-        record.source_type = track.source_type;
-        record.reference_offset = append_string(strings, track.reference_name);
-        record.reference_length = track.reference_name.size();
-        record.sequence_offset = append_string(strings, track.sequence_name);
-        record.sequence_length = track.sequence_name.size();
-        record.haplotype = track.haplotype;
-        record.sequence_start = track.sequence_start;
-        record.sequence_end = track.sequence_end;
-        record.entry_begin = entry_records.size();
-        record.entry_count = track.entries.size();
-        track_records.push_back(record);
-
-        for (const auto& entry : track.entries) {
-            entry_records.push_back(CoordinateEntryDisk{entry.start, entry.node_rank, 0});
+        std::vector<CoordinateTrackDisk> track_records;
+        std::uint64_t entry_count = 0;
+        std::string strings;
+        track_records.reserve(tracks.size());
+        for (const auto& track : tracks) {
+            CoordinateTrackDisk record{};
+            record.source_type = track.source_type;
+            record.coordinate_length = static_cast<std::uint32_t>(track.coordinate_length);
+            record.reference_offset = append_string(strings, track.reference_name);
+            record.reference_length = track.reference_name.size();
+            record.sequence_offset = append_string(strings, track.sequence_name);
+            record.sequence_length = track.sequence_name.size();
+            record.haplotype = track.haplotype;
+            record.sequence_start = track.sequence_start;
+            record.sequence_end = track.sequence_end;
+            record.entry_begin = entry_count;
+            record.entry_count = track.entry_count;
+            track_records.push_back(record);
+            entry_count += track.entry_count;
         }
-    }
 
-    CoordinateIndexHeaderDisk header{};
-    std::memcpy(header.magic, kCoordinateIndexMagic, sizeof(header.magic));
-    header.version = kCoordinateIndexVersion;
-    header.node_count = node_index.size();
-    header.track_count = track_records.size();
-    header.entry_count = entry_records.size();
-    header.track_table_offset = sizeof(CoordinateIndexHeaderDisk);
-    header.entry_table_offset = header.track_table_offset +
-                                track_records.size() * sizeof(CoordinateTrackDisk);
-    header.strings_offset = header.entry_table_offset +
-                            entry_records.size() * sizeof(CoordinateEntryDisk);
-    header.strings_size = strings.size();
-
-    // Stage and atomically publish the complete sidecar so interrupted builds
-    // cannot leave a truncated coordinate index at the requested path.
-    const auto staged_output = make_temp_output_path(output_index);
-    try {
-        std::ofstream out(staged_output, std::ios::binary | std::ios::trunc);
-        if (!out) {
-            throw std::runtime_error("Failed to open coordinate index output: " + staged_output);
+        // A suffixed P track is queryable by its coordinate namespace and by its
+        // raw name, so it is listed under both keys.
+        struct DirectoryItem {
+            std::string_view sequence;
+            std::uint64_t sequence_offset{};
+            std::uint32_t track_id{};
+        };
+        std::vector<DirectoryItem> directory_items;
+        directory_items.reserve(tracks.size());
+        for (std::uint32_t track_id = 0; track_id < tracks.size(); ++track_id) {
+            const auto& record = track_records[track_id];
+            directory_items.push_back(DirectoryItem{
+                coordinate_sequence_name(tracks[track_id]), record.sequence_offset, track_id});
+            if (tracks[track_id].coordinate_length != tracks[track_id].sequence_name.size()) {
+                directory_items.push_back(DirectoryItem{
+                    tracks[track_id].sequence_name, record.sequence_offset, track_id});
+            }
         }
-        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
-        write_vector(out, track_records);
-        write_vector(out, entry_records);
-        if (!strings.empty()) out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
-        out.close();
-        if (!out) {
-            throw std::runtime_error("Failed while writing coordinate index: " + output_index);
+        std::sort(directory_items.begin(), directory_items.end(),
+                  [&](const DirectoryItem& lhs, const DirectoryItem& rhs) {
+                      if (lhs.sequence != rhs.sequence) return lhs.sequence < rhs.sequence;
+                      const auto& lhs_track = tracks[lhs.track_id];
+                      const auto& rhs_track = tracks[rhs.track_id];
+                      if (lhs_track.reference_name != rhs_track.reference_name) {
+                          return lhs_track.reference_name < rhs_track.reference_name;
+                      }
+                      if (lhs_track.sequence_start != rhs_track.sequence_start) {
+                          return lhs_track.sequence_start < rhs_track.sequence_start;
+                      }
+                      return lhs.track_id < rhs.track_id;
+                  });
+
+        std::vector<CoordinateKeyDisk> key_records;
+        std::vector<CoordinateFragmentDisk> fragment_records;
+        fragment_records.reserve(directory_items.size());
+        for (std::size_t i = 0; i < directory_items.size(); ++i) {
+            const auto& item = directory_items[i];
+            const auto& track = tracks[item.track_id];
+            const auto& record = track_records[item.track_id];
+            const bool new_key = key_records.empty() ||
+                item.sequence != directory_items[i - 1].sequence ||
+                track.reference_name != tracks[directory_items[i - 1].track_id].reference_name;
+            if (new_key) {
+                CoordinateKeyDisk key{};
+                key.sequence_offset = item.sequence_offset;
+                key.sequence_length = item.sequence.size();
+                key.reference_offset = record.reference_offset;
+                key.reference_length = record.reference_length;
+                key.fragment_begin = fragment_records.size();
+                key_records.push_back(key);
+            }
+            auto& key = key_records.back();
+            const auto max_end = key.fragment_count == 0
+                ? track.sequence_end
+                : std::max(fragment_records.back().max_end, track.sequence_end);
+            fragment_records.push_back(CoordinateFragmentDisk{
+                track.sequence_start, track.sequence_end, max_end, item.track_id, 0});
+            ++key.fragment_count;
+        }
+
+        CoordinateIndexHeaderDisk header{};
+        std::memcpy(header.magic, kCoordinateIndexMagic, sizeof(header.magic));
+        header.version = kCoordinateIndexVersion;
+        header.node_count = node_index.size();
+        header.track_count = track_records.size();
+        header.entry_count = entry_count;
+        header.key_count = key_records.size();
+        header.fragment_count = fragment_records.size();
+        header.track_table_offset = sizeof(CoordinateIndexHeaderDisk);
+        header.key_table_offset = header.track_table_offset +
+                                  track_records.size() * sizeof(CoordinateTrackDisk);
+        header.fragment_table_offset = header.key_table_offset +
+                                       key_records.size() * sizeof(CoordinateKeyDisk);
+        header.entry_table_offset = header.fragment_table_offset +
+                                    fragment_records.size() * sizeof(CoordinateFragmentDisk);
+        header.community_run_table_offset = header.entry_table_offset +
+                                            entry_count * sizeof(CoordinateEntryDisk);
+        header.strings_size = strings.size();
+
+        // Stage and atomically publish the complete sidecar so interrupted builds
+        // cannot leave a truncated coordinate index at the requested path.
+        const auto staged_output = make_temp_output_path(output_index);
+        try {
+            std::ofstream out(staged_output, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                throw std::runtime_error("Failed to open coordinate index output: " + staged_output);
+            }
+            // The run counts are only known once the entries are written, so
+            // the header and track table are written again at the end.
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            write_vector(out, track_records);
+            write_vector(out, key_records);
+            write_vector(out, fragment_records);
+            const auto runs_path = tmp_dir + "/community_runs.bin";
+            header.community_run_count = write_track_entries(
+                out, tracks, store, path_index.get(), node_lengths, node_index, runs_path,
+                track_records);
+            header.strings_offset = header.community_run_table_offset +
+                                    header.community_run_count * sizeof(CoordinateCommunityRunDisk);
+            {
+                std::ifstream runs_in(runs_path, std::ios::binary);
+                if (!runs_in) {
+                    throw std::runtime_error("Failed to reopen community run scratch file: " +
+                                             runs_path);
+                }
+                if (header.community_run_count != 0) out << runs_in.rdbuf();
+            }
+            std::filesystem::remove(runs_path);
+            if (!strings.empty()) out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+            out.seekp(0);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            write_vector(out, track_records);
+            out.close();
+            if (!out) {
+                throw std::runtime_error("Failed while writing coordinate index: " + output_index);
+            }
+            rename_path_or_throw(staged_output, output_index);
+        } catch (...) {
+            remove_path_if_exists(staged_output);
+            throw;
         }
-        rename_path_or_throw(staged_output, output_index);
     } catch (...) {
-        remove_path_if_exists(staged_output);
+        cleanup_tmp();
         throw;
     }
+    cleanup_tmp();
     return true;
 }
 
-CoordinateIndexReader::CoordinateIndexReader(const std::string& index_path)
-    : index_path_(index_path), in_(index_path, std::ios::binary) {
-    if (!in_) throw std::runtime_error("Failed to open coordinate index: " + index_path);
-
-    CoordinateIndexHeaderDisk header{};
-    in_.read(reinterpret_cast<char*>(&header), sizeof(header));
-    if (!in_) throw std::runtime_error("Failed to read coordinate index header: " + index_path);
-    if (std::memcmp(header.magic, kCoordinateIndexMagic, sizeof(header.magic)) != 0) {
-        throw std::runtime_error("Invalid coordinate index magic: " + index_path);
+void CoordinateIndexReader::close_mapping() {
+    if (mapping_) {
+        munmap(mapping_, file_size_);
+        mapping_ = nullptr;
     }
-    if (header.version != kCoordinateIndexVersion) {
-        throw std::runtime_error("Unsupported coordinate index version: " +
-                                 std::to_string(header.version));
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
     }
+    entries_ = nullptr;
+    keys_ = nullptr;
+    fragments_ = nullptr;
+    strings_ = std::string_view();
+    file_size_ = 0;
+}
 
-    in_.seekg(0, std::ios::end);
-    const auto file_size = static_cast<std::uint64_t>(in_.tellg());
-    const bool track_size_overflow =
-        header.track_count > std::numeric_limits<std::uint64_t>::max() /
-                                 sizeof(CoordinateTrackDisk);
-    const bool entry_size_overflow =
-        header.entry_count > std::numeric_limits<std::uint64_t>::max() /
-                                 sizeof(CoordinateEntryDisk);
-    if (track_size_overflow || entry_size_overflow) {
-        throw std::runtime_error("Coordinate index section size overflows uint64");
+CoordinateIndexReader::CoordinateIndexReader(const std::string& index_path)
+    : index_path_(index_path) {
+    static_assert(sizeof(CoordinateEntryView) == sizeof(CoordinateEntryDisk),
+                  "Mapped coordinate entries must match the on-disk entry table");
+    static_assert(sizeof(CoordinateKeyView) == sizeof(CoordinateKeyDisk),
+                  "Mapped directory keys must match the on-disk key table");
+    static_assert(sizeof(CoordinateFragmentView) == sizeof(CoordinateFragmentDisk),
+                  "Mapped directory fragments must match the on-disk fragment table");
+    static_assert(sizeof(CoordinateCommunityRunView) == sizeof(CoordinateCommunityRunDisk),
+                  "Mapped community runs must match the on-disk run table");
+    fd_ = ::open(index_path.c_str(), O_RDONLY);
+    if (fd_ == -1) throw std::runtime_error("Failed to open coordinate index: " + index_path);
+
+    struct stat st{};
+    if (fstat(fd_, &st) == -1) {
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Failed to stat coordinate index: " + index_path);
     }
-    const auto track_bytes = header.track_count * sizeof(CoordinateTrackDisk);
-    const auto entry_bytes = header.entry_count * sizeof(CoordinateEntryDisk);
-    const bool track_offset_overflow =
-        track_bytes > std::numeric_limits<std::uint64_t>::max() - header.track_table_offset;
-    const bool entry_offset_overflow =
-        entry_bytes > std::numeric_limits<std::uint64_t>::max() - header.entry_table_offset;
-    if (track_offset_overflow || entry_offset_overflow ||
-        header.track_table_offset != sizeof(CoordinateIndexHeaderDisk) ||
-        header.entry_table_offset != header.track_table_offset + track_bytes ||
-        header.strings_offset != header.entry_table_offset + entry_bytes ||
-        header.strings_size > file_size ||
-        header.strings_offset > file_size - header.strings_size ||
-        header.strings_offset + header.strings_size != file_size) {
-        throw std::runtime_error("Coordinate index section offsets are invalid");
+    file_size_ = static_cast<std::size_t>(st.st_size);
+    if (file_size_ < sizeof(CoordinateIndexHeaderDisk)) {
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Failed to read coordinate index header: " + index_path);
     }
 
-    node_count_ = header.node_count;
-    entry_count_ = header.entry_count;
-    entry_table_offset_ = header.entry_table_offset;
-
-    std::vector<CoordinateTrackDisk> disk_tracks(static_cast<std::size_t>(header.track_count));
-    in_.seekg(static_cast<std::streamoff>(header.track_table_offset), std::ios::beg);
-    if (!disk_tracks.empty()) {
-        in_.read(reinterpret_cast<char*>(disk_tracks.data()),
-                 static_cast<std::streamsize>(disk_tracks.size() * sizeof(CoordinateTrackDisk)));
+    mapping_ = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("mmap failed for coordinate index: " + index_path);
     }
-    std::string strings(static_cast<std::size_t>(header.strings_size), '\0');
-    in_.seekg(static_cast<std::streamoff>(header.strings_offset), std::ios::beg);
-    if (!strings.empty()) in_.read(strings.data(), static_cast<std::streamsize>(strings.size()));
-    if (!in_) throw std::runtime_error("Failed to read coordinate index metadata");
-
-    tracks_.reserve(disk_tracks.size());
-    for (const auto& record : disk_tracks) {
-        if (record.reference_offset > strings.size() ||
-            record.reference_length > strings.size() - record.reference_offset ||
-            record.sequence_offset > strings.size() ||
-            record.sequence_length > strings.size() - record.sequence_offset ||
-            record.entry_begin > entry_count_ ||
-            record.entry_count > entry_count_ - record.entry_begin ||
-            record.sequence_end < record.sequence_start ||
-            (record.source_type != 'W' &&
-             record.source_type != 'P' &&
-             record.source_type != 'S')) {
-            throw std::runtime_error("Coordinate index track metadata is invalid");
+
+    try {
+        const auto* bytes = static_cast<const char*>(mapping_);
+        CoordinateIndexHeaderDisk header{};
+        std::memcpy(&header, bytes, sizeof(header));
+        if (std::memcmp(header.magic, kCoordinateIndexMagic, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("Invalid coordinate index magic: " + index_path);
         }
-        tracks_.push_back(CoordinateTrackInfo{
-            record.source_type,
-            strings.substr(static_cast<std::size_t>(record.reference_offset),
-                           static_cast<std::size_t>(record.reference_length)),
-            strings.substr(static_cast<std::size_t>(record.sequence_offset),
-                           static_cast<std::size_t>(record.sequence_length)),
-            record.haplotype,
-            record.sequence_start,
-            record.sequence_end,
-            record.entry_begin,
-            record.entry_count,
-        });
+        if (header.version != kCoordinateIndexVersion) {
+            throw std::runtime_error("Unsupported coordinate index version: " +
+                                     std::to_string(header.version) +
+                                     "; rebuild it with gfaidx index_coordinates");
+        }
+
+        // Check each section size and then the contiguous layout
+        // header, tracks, keys, fragments, entries, community runs, strings.
+        const auto file_size = static_cast<std::uint64_t>(file_size_);
+        const auto max_u64 = std::numeric_limits<std::uint64_t>::max();
+        if (header.track_count > max_u64 / sizeof(CoordinateTrackDisk) ||
+            header.key_count > max_u64 / sizeof(CoordinateKeyDisk) ||
+            header.fragment_count > max_u64 / sizeof(CoordinateFragmentDisk) ||
+            header.entry_count > max_u64 / sizeof(CoordinateEntryDisk) ||
+            header.community_run_count > max_u64 / sizeof(CoordinateCommunityRunDisk)) {
+            throw std::runtime_error("Coordinate index section size overflows uint64");
+        }
+        const std::uint64_t section_offsets[] = {
+            header.track_table_offset,
+            header.key_table_offset,
+            header.fragment_table_offset,
+            header.entry_table_offset,
+            header.community_run_table_offset,
+            header.strings_offset,
+        };
+        const std::uint64_t section_bytes[] = {
+            header.track_count * sizeof(CoordinateTrackDisk),
+            header.key_count * sizeof(CoordinateKeyDisk),
+            header.fragment_count * sizeof(CoordinateFragmentDisk),
+            header.entry_count * sizeof(CoordinateEntryDisk),
+            header.community_run_count * sizeof(CoordinateCommunityRunDisk),
+            header.strings_size,
+        };
+        std::uint64_t expected_offset = sizeof(CoordinateIndexHeaderDisk);
+        for (std::size_t i = 0; i < std::size(section_offsets); ++i) {
+            if (section_offsets[i] != expected_offset ||
+                section_bytes[i] > file_size ||
+                expected_offset > file_size - section_bytes[i]) {
+                throw std::runtime_error("Coordinate index section offsets are invalid");
+            }
+            expected_offset += section_bytes[i];
+        }
+        if (expected_offset != file_size) {
+            throw std::runtime_error("Coordinate index section offsets are invalid");
+        }
+
+        node_count_ = header.node_count;
+        entry_count_ = header.entry_count;
+        key_count_ = header.key_count;
+        entries_ = reinterpret_cast<const CoordinateEntryView*>(bytes + header.entry_table_offset);
+        keys_ = reinterpret_cast<const CoordinateKeyView*>(bytes + header.key_table_offset);
+        fragments_ = reinterpret_cast<const CoordinateFragmentView*>(
+            bytes + header.fragment_table_offset);
+        community_runs_ = reinterpret_cast<const CoordinateCommunityRunView*>(
+            bytes + header.community_run_table_offset);
+        strings_ = std::string_view(bytes + header.strings_offset,
+                                    static_cast<std::size_t>(header.strings_size));
+        const auto strings = strings_;
+        tracks_.reserve(static_cast<std::size_t>(header.track_count));
+        for (std::uint64_t i = 0; i < header.track_count; ++i) {
+            CoordinateTrackDisk record{};
+            std::memcpy(&record,
+                        bytes + header.track_table_offset + i * sizeof(CoordinateTrackDisk),
+                        sizeof(record));
+            if (record.reference_offset > strings.size() ||
+                record.reference_length > strings.size() - record.reference_offset ||
+                record.sequence_offset > strings.size() ||
+                record.sequence_length > strings.size() - record.sequence_offset ||
+                record.coordinate_length > record.sequence_length ||
+                record.entry_begin > entry_count_ ||
+                record.entry_count > entry_count_ - record.entry_begin ||
+                record.sequence_end < record.sequence_start ||
+                record.community_run_begin > header.community_run_count ||
+                record.community_run_count > header.community_run_count - record.community_run_begin ||
+                (record.entry_count == 0) != (record.community_run_count == 0) ||
+                (record.source_type != 'W' &&
+                 record.source_type != 'P' &&
+                 record.source_type != 'S')) {
+                throw std::runtime_error("Coordinate index track metadata is invalid");
+            }
+            tracks_.push_back(CoordinateTrackInfo{
+                record.source_type,
+                std::string(strings.substr(static_cast<std::size_t>(record.reference_offset),
+                                           static_cast<std::size_t>(record.reference_length))),
+                std::string(strings.substr(static_cast<std::size_t>(record.sequence_offset),
+                                           static_cast<std::size_t>(record.sequence_length))),
+                std::string(strings.substr(static_cast<std::size_t>(record.sequence_offset),
+                                           record.coordinate_length)),
+                record.haplotype,
+                record.sequence_start,
+                record.sequence_end,
+                record.entry_begin,
+                record.entry_count,
+                record.community_run_begin,
+                record.community_run_count,
+            });
+        }
+
+        for (std::uint64_t i = 0; i < header.key_count; ++i) {
+            const auto& key = keys_[i];
+            if (key.sequence_offset > strings.size() ||
+                key.sequence_length > strings.size() - key.sequence_offset ||
+                key.reference_offset > strings.size() ||
+                key.reference_length > strings.size() - key.reference_offset ||
+                key.fragment_begin > header.fragment_count ||
+                key.fragment_count > header.fragment_count - key.fragment_begin) {
+                throw std::runtime_error("Coordinate index directory is invalid");
+            }
+        }
+        for (std::uint64_t i = 0; i < header.fragment_count; ++i) {
+            if (fragments_[i].track_id >= header.track_count) {
+                throw std::runtime_error("Coordinate index directory is invalid");
+            }
+        }
+    } catch (...) {
+        close_mapping();
+        throw;
     }
 }
 
-CoordinateIndexReader::CoordinateEntry CoordinateIndexReader::read_entry(
-    std::uint64_t entry_index) const {
-    if (entry_index >= entry_count_) {
-        throw std::runtime_error("Coordinate entry index is out of range");
+CoordinateIndexReader::~CoordinateIndexReader() {
+    close_mapping();
+}
+
+std::uint64_t CoordinateIndexReader::fence_start(std::size_t track_index,
+                                                 std::uint64_t fence) const {
+    return entries_[tracks_[track_index].entry_begin + fence * kFenceStride].start;
+}
+
+std::uint64_t CoordinateIndexReader::partition_entries(std::size_t track_index,
+                                                       std::uint64_t value,
+                                                       bool inclusive) const {
+    const auto& track = tracks_[track_index];
+    const auto before = [&](std::uint64_t start) {
+        return inclusive ? start < value : start <= value;
+    };
+
+    // Locate the fence block holding the partition point, then search only
+    // that block's entries in the mapping.
+    std::uint64_t low = 0;
+    std::uint64_t high = (track.entry_count + kFenceStride - 1) / kFenceStride;
+    while (low < high) {
+        const auto mid = low + (high - low) / 2;
+        if (before(fence_start(track_index, mid))) low = mid + 1;
+        else high = mid;
     }
-    CoordinateEntryDisk disk{};
-    in_.clear();
-    in_.seekg(static_cast<std::streamoff>(entry_table_offset_ +
-                                         entry_index * sizeof(CoordinateEntryDisk)),
-              std::ios::beg);
-    in_.read(reinterpret_cast<char*>(&disk), sizeof(disk));
-    if (!in_) throw std::runtime_error("Failed to read coordinate index entry");
-    return CoordinateEntry{disk.start, disk.node_rank};
+    if (low == 0) return 0;
+
+    const auto block_begin = (low - 1) * kFenceStride;
+    const auto block_end = std::min(low * kFenceStride, track.entry_count);
+    const auto* first = entries_ + track.entry_begin + block_begin;
+    const auto* last = entries_ + track.entry_begin + block_end;
+    const auto* found = std::partition_point(
+        first, last, [&](const CoordinateEntryView& entry) { return before(entry.start); });
+    return block_begin + static_cast<std::uint64_t>(found - first);
 }
 
-void CoordinateIndexReader::read_entries(std::uint64_t entry_index,
-                                          std::uint64_t count,
-                                          std::vector<CoordinateEntry>& out) const {
-    if (entry_index > entry_count_ || count > entry_count_ - entry_index) {
-        throw std::runtime_error("Coordinate entry range is out of bounds");
+const CoordinateIndexReader::CoordinateKeyView& CoordinateIndexReader::find_key(
+    std::string_view reference_name,
+    std::string_view sequence_name) const {
+    // Directory keys are sorted by sequence and then reference, so the keys
+    // of one sequence are adjacent and the reference is a second search.
+    const auto* keys_end = keys_ + key_count_;
+    const auto* sequence_first = std::lower_bound(
+        keys_, keys_end, sequence_name,
+        [&](const CoordinateKeyView& lhs, std::string_view rhs) {
+            return key_sequence(lhs) < rhs;
+        });
+    const auto* sequence_last = std::upper_bound(
+        sequence_first, keys_end, sequence_name,
+        [&](std::string_view lhs, const CoordinateKeyView& rhs) {
+            return lhs < key_sequence(rhs);
+        });
+
+    // When the caller omits a reference, accept exactly one reference namespace
+    // for the requested sequence and reject ambiguous multi-reference queries.
+    const CoordinateKeyView* key = nullptr;
+    if (reference_name.empty()) {
+        if (sequence_last - sequence_first > 1) {
+            throw std::runtime_error("Coordinate sequence '" +
+                                     std::string(sequence_name) +
+                                     "' exists in multiple references; provide --reference");
+        }
+        if (sequence_first != sequence_last) key = sequence_first;
+    } else {
+        const auto* found = std::lower_bound(
+            sequence_first, sequence_last, reference_name,
+            [&](const CoordinateKeyView& lhs, std::string_view rhs) {
+                return key_reference(lhs) < rhs;
+            });
+        if (found != sequence_last && key_reference(*found) == reference_name) {
+            key = found;
+        }
     }
-    std::vector<CoordinateEntryDisk> disk(static_cast<std::size_t>(count));
-    in_.clear();
-    in_.seekg(static_cast<std::streamoff>(entry_table_offset_ +
-                                         entry_index * sizeof(CoordinateEntryDisk)),
-              std::ios::beg);
-    if (!disk.empty()) {
-        in_.read(reinterpret_cast<char*>(disk.data()),
-                 static_cast<std::streamsize>(disk.size() * sizeof(CoordinateEntryDisk)));
+    if (key == nullptr) {
+        throw std::runtime_error("Coordinate track was not found for reference '" +
+                                 std::string(reference_name) + "' sequence '" +
+                                 std::string(sequence_name) + "'");
+    }
+    return *key;
+}
+
+void CoordinateIndexReader::find_overlapping_tracks(const CoordinateKeyView& key,
+                                                    std::uint64_t begin,
+                                                    std::uint64_t end,
+                                                    std::vector<std::uint32_t>& track_ids) const {
+    // Fragments are sorted by start; walk back from the last one starting
+    // before end until no earlier fragment can reach past begin.
+    const auto* fragments_begin = fragments_ + key.fragment_begin;
+    const auto* fragment = std::partition_point(
+        fragments_begin, fragments_begin + key.fragment_count,
+        [&](const CoordinateFragmentView& candidate) { return candidate.sequence_start < end; });
+    while (fragment != fragments_begin) {
+        --fragment;
+        if (fragment->max_end <= begin) break;
+        if (fragment->sequence_end > begin) track_ids.push_back(fragment->track_id);
     }
-    if (!in_) throw std::runtime_error("Failed to read coordinate index entry range");
-    out.reserve(out.size() + disk.size());
-    for (const auto& entry : disk) out.push_back(CoordinateEntry{entry.start, entry.node_rank});
 }
 
 CoordinateQueryResult CoordinateIndexReader::query_region(
@@ -1026,103 +1700,40 @@ CoordinateQueryResult CoordinateIndexReader::query_region(
         throw std::runtime_error("Coordinate query end must be greater than start");
     }
 
-    const auto track_matches_sequence =
-        [&](const CoordinateTrackInfo& track) {
-            if (track.sequence_name == sequence_name) return true;
-            return track.source_type == 'P' &&
-                   paths::parse_p_path_coordinate_name(track.sequence_name)
-                           .coordinate_name == sequence_name;
-        };
-
-    // When the caller omits a reference, accept exactly one reference namespace
-    // for the requested sequence and reject ambiguous multi-reference queries.
-    std::string inferred_reference;
-    bool have_inferred_reference = false;
-    if (reference_name.empty()) {
-        for (const auto& track : tracks_) {
-            if (!track_matches_sequence(track)) continue;
-            if (!have_inferred_reference) {
-                inferred_reference = track.reference_name;
-                have_inferred_reference = true;
-            } else if (track.reference_name != inferred_reference) {
-                throw std::runtime_error("Coordinate sequence '" +
-                                         std::string(sequence_name) +
-                                         "' exists in multiple references; provide --reference");
-            }
-        }
-        reference_name = inferred_reference;
-    }
+    // Report the overlapping fragments in track-table order.
+    std::vector<std::uint32_t> track_ids;
+    find_overlapping_tracks(find_key(reference_name, sequence_name), begin, end, track_ids);
+    std::sort(track_ids.begin(), track_ids.end());
 
     CoordinateQueryResult result;
-    bool found_track = false;
-    for (const auto& track : tracks_) {
-        if (track.reference_name != reference_name ||
-            !track_matches_sequence(track)) {
-            continue;
-        }
-        found_track = true;
-        if (track.source_type == 'P') {
-            const auto parsed =
-                paths::parse_p_path_coordinate_name(track.sequence_name);
-            if (parsed.has_coordinates &&
-                (track.sequence_start != parsed.start ||
-                 track.sequence_end != parsed.end)) {
-                throw std::runtime_error(
-                    "Coordinate track for P path '" + track.sequence_name +
-                    "' uses obsolete path-local coordinates; rebuild the .cdx");
-            }
-        }
+    for (const auto track_index : track_ids) {
+        const auto& track = tracks_[track_index];
         if (track.entry_count == 0 || end <= track.sequence_start || begin >= track.sequence_end) {
             continue;
         }
 
-        // Binary-search the first step whose derived end coordinate is greater
-        // than begin. Within one track fragment, the next start is the current
-        // step's end; the final step ends at track.sequence_end.
-        std::uint64_t low = 0;
-        std::uint64_t high = track.entry_count;
-        while (low < high) {
-            const auto mid = low + (high - low) / 2;
-            const auto step_end = mid + 1 < track.entry_count
-                ? read_entry(track.entry_begin + mid + 1).start
-                : track.sequence_end;
-            if (step_end <= begin) low = mid + 1;
-            else high = mid;
-        }
-        if (low >= track.entry_count) continue;
-
-        // Find the exclusive step bound by start coordinate, then read the
-        // matching entries in one contiguous disk operation.
-        std::uint64_t range_high = low;
-        std::uint64_t search_low = low;
-        std::uint64_t search_high = track.entry_count;
-        while (search_low < search_high) {
-            const auto mid = search_low + (search_high - search_low) / 2;
-            if (read_entry(track.entry_begin + mid).start < end) search_low = mid + 1;
-            else search_high = mid;
-        }
-        range_high = search_low;
-
-        std::vector<CoordinateEntry> matching;
-        read_entries(track.entry_begin + low, range_high - low, matching);
-        if (matching.empty()) continue;
+        // The first overlapping step is the first whose end coordinate is
+        // greater than begin. Within one track fragment, a step ends where
+        // the next one starts and the final step ends at track.sequence_end,
+        // so it is the step before the first start greater than begin.
+        const auto low =
+            std::max<std::uint64_t>(partition_entries(track_index, begin, false), 1) - 1;
+        // Overlapping steps run up to the first start at or past end.
+        const auto range_high =
+            std::max(partition_entries(track_index, end, true), low);
+        if (range_high == low) continue;
 
         CoordinateTrackSlice slice;
         slice.track = track;
         slice.start_step = low;
-        slice.step_count = matching.size();
-        for (const auto& entry : matching) {
-            result.node_ranks.push_back(entry.node_rank);
+        slice.step_count = range_high - low;
+        const auto* entry = entries_ + track.entry_begin + low;
+        for (std::uint64_t i = low; i < range_high; ++i, ++entry) {
+            result.node_ranks.push_back(entry->node_rank);
         }
         result.slices.push_back(std::move(slice));
     }
 
-    if (!found_track) {
-        throw std::runtime_error("Coordinate track was not found for reference '" +
-                                 std::string(reference_name) + "' sequence '" +
-                                 std::string(sequence_name) + "'");
-    }
-
     // Keep ordered occurrences in slices, but collapse the graph seed vector.
     // The two views prevent BFS from doing duplicate work while allowing the
     // all-haplotype selector to distinguish repeated path occurrences.
@@ -1133,6 +1744,42 @@ CoordinateQueryResult CoordinateIndexReader::query_region(
     return result;
 }
 
+std::vector<std::uint32_t> CoordinateIndexReader::query_region_communities(
+    std::string_view reference_name,
+    std::string_view sequence_name,
+    std::uint64_t begin,
+    std::uint64_t end) const {
+    if (end <= begin) {
+        throw std::runtime_error("Coordinate query end must be greater than start");
+    }
+
+    std::vector<std::uint32_t> track_ids;
+    find_overlapping_tracks(find_key(reference_name, sequence_name), begin, end, track_ids);
+
+    std::vector<std::uint32_t> communities;
+    for (const auto track_index : track_ids) {
+        const auto& track = tracks_[track_index];
+        if (track.community_run_count == 0 || end <= track.sequence_start ||
+            begin >= track.sequence_end) {
+            continue;
+        }
+
+        // A run starts at its first entry, so the runs of query_region()'s
+        // entry range are the last run starting at or before begin and every
+        // later run starting before end.
+        const auto* first = community_runs_ + track.community_run_begin;
+        const auto* last = first + track.community_run_count;
+        const auto* run = std::partition_point(
+            first, last, [&](const CoordinateCommunityRunView& r) { return r.start <= begin; });
+        if (run != first) --run;
+        for (; run != last && run->start < end; ++run) communities.push_back(run->community_id);
+    }
+
+    std::sort(communities.begin(), communities.end());
+    communities.erase(std::unique(communities.begin(), communities.end()), communities.end());
+    return communities;
+}
+
 std::vector<std::uint32_t> CoordinateIndexReader::query_node_ranks(
     std::string_view reference_name,
     std::string_view sequence_name,
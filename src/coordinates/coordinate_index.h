@@ -1,8 +1,8 @@
 #ifndef GFAIDX_COORDINATE_INDEX_H
 #define GFAIDX_COORDINATE_INDEX_H
 
+#include <cstddef>
 #include <cstdint>
-#include <fstream>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -16,11 +16,17 @@ struct CoordinateTrackInfo {
     char source_type{};  // 'W' walk, 'P' path, or 'S' rGFA SR:i:0 nodes.
     std::string reference_name;
     std::string sequence_name;
+    // Queryable namespace: sequence_name without a P path's :start-end suffix.
+    std::string coordinate_name;
     std::uint64_t haplotype{};
     std::uint64_t sequence_start{};
     std::uint64_t sequence_end{};
     std::uint64_t entry_begin{};
     std::uint64_t entry_count{};
+    // Range of the track's community runs: consecutive entries whose nodes
+    // share one .ndx community, stored as (first start, community id).
+    std::uint64_t community_run_begin{};
+    std::uint64_t community_run_count{};
 };
 
 // One exact slice selected from a coordinate track. start_step and step_count
@@ -39,25 +45,59 @@ struct CoordinateQueryResult {
     std::vector<CoordinateTrackSlice> slices;
 };
 
+// Default memory budget for the SR:i:0 records buffered by
+// build_coordinate_index before they spill to sorted runs on disk.
+inline constexpr std::uint64_t kDefaultCoordinateEntryMemoryBytes = 128ULL * 1024ULL * 1024ULL;
+
 // Build a standalone coordinate index aligned to ranks in the supplied .ndx.
 // An empty reference filter indexes every sample named by the header RS:Z tag.
+//
+// The GFA is read at most once. Segment lengths come from the rank-aligned
+// .lnx when one is given, reference W tracks from the .pdx when it holds any
+// for the selected samples, and with both the body after the header block is
+// not read at all. Track entries are kept in a scratch file under a temp
+// directory in tmp_base_dir (default: the output directory) instead of in
+// memory, and SR:i:0 segments are sorted in runs of at most
+// entry_memory_bytes.
 bool build_coordinate_index(const std::string& input_gfa,
                             const std::string& output_index,
                             const std::string& node_index_path,
                             const std::string& reference_filter = std::string(""),
                             const Reader::Options& reader_options = Reader::Options{},
                             const std::string& path_index_path = std::string(""),
-                            const std::string& path_names_file = std::string(""));
-
-// Read the compact .cdx metadata eagerly while leaving the potentially large
-// coordinate entry table on disk for binary-search and range reads.
+                            const std::string& path_names_file = std::string(""),
+                            const std::string& node_length_index_path = std::string(""),
+                            const std::string& tmp_base_dir = std::string(""),
+                            std::uint64_t entry_memory_bytes = kDefaultCoordinateEntryMemoryBytes);
+
+// Read the compact .cdx metadata eagerly and mmap the potentially large
+// coordinate entry table. Region lookups find their fragments through the
+// sorted sequence directory, then bisect the fence of every kFenceStride-th
+// entry start before searching the single fence block of entries that holds
+// the partition point. Fence values are read straight from the mapping, so
+// opening a large .cdx touches none of its entry table.
 class CoordinateIndexReader {
 public:
     explicit CoordinateIndexReader(const std::string& index_path);
+    ~CoordinateIndexReader();
+
+    CoordinateIndexReader(const CoordinateIndexReader&) = delete;
+    CoordinateIndexReader& operator=(const CoordinateIndexReader&) = delete;
 
     [[nodiscard]] std::uint64_t node_count() const { return node_count_; }
     [[nodiscard]] const std::vector<CoordinateTrackInfo>& tracks() const { return tracks_; }
 
+    // Start and node rank of local entry step of a track; step must be below
+    // track.entry_count.
+    [[nodiscard]] std::uint64_t entry_start(const CoordinateTrackInfo& track,
+                                            std::uint64_t step) const {
+        return entries_[track.entry_begin + step].start;
+    }
+    [[nodiscard]] std::uint32_t entry_node_rank(const CoordinateTrackInfo& track,
+                                                std::uint64_t step) const {
+        return entries_[track.entry_begin + step].node_rank;
+    }
+
     // Return both unique graph ranks and the exact track slices that
     // overlap the requested 0-based, half-open interval [begin, end).
     [[nodiscard]] CoordinateQueryResult query_region(
@@ -66,6 +106,16 @@ public:
         std::uint64_t begin,
         std::uint64_t end) const;
 
+    // Return the sorted, unique .ndx community ids of the nodes query_region()
+    // would select, read from the per-track community runs alone. Neither the
+    // entry table nor a node index is touched, so the result maps straight to
+    // gzip members through the .idx.
+    [[nodiscard]] std::vector<std::uint32_t> query_region_communities(
+        std::string_view reference_name,
+        std::string_view sequence_name,
+        std::uint64_t begin,
+        std::uint64_t end) const;
+
     // Return sorted, unique .ndx/.pdx node ranks whose reference intervals
     // overlap the requested interval. This compatibility helper discards exact
     // track bounds; all-haplotype queries use query_region().
@@ -76,21 +126,72 @@ public:
         std::uint64_t end) const;
 
 private:
-    struct CoordinateEntry {
-        std::uint64_t start{};
-        std::uint32_t node_rank{};
+    // 256 entries of 16 bytes fill one 4 KiB page.
+    static constexpr std::uint64_t kFenceStride = 256;
+
+    // Mirror the on-disk entry and directory records.
+    struct CoordinateEntryView {
+        std::uint64_t start;
+        std::uint32_t node_rank;
+        std::uint32_t reserved;
+    };
+    struct CoordinateKeyView {
+        std::uint64_t sequence_offset;
+        std::uint64_t sequence_length;
+        std::uint64_t reference_offset;
+        std::uint64_t reference_length;
+        std::uint64_t fragment_begin;
+        std::uint64_t fragment_count;
+    };
+    struct CoordinateFragmentView {
+        std::uint64_t sequence_start;
+        std::uint64_t sequence_end;
+        std::uint64_t max_end;
+        std::uint32_t track_id;
+        std::uint32_t reserved;
+    };
+    struct CoordinateCommunityRunView {
+        std::uint64_t start;
+        std::uint32_t community_id;
+        std::uint32_t reserved;
     };
 
-    [[nodiscard]] CoordinateEntry read_entry(std::uint64_t entry_index) const;
-    void read_entries(std::uint64_t entry_index,
-                      std::uint64_t count,
-                      std::vector<CoordinateEntry>& out) const;
+    void close_mapping();
+    [[nodiscard]] std::string_view key_sequence(const CoordinateKeyView& key) const {
+        return strings_.substr(key.sequence_offset, key.sequence_length);
+    }
+    [[nodiscard]] std::string_view key_reference(const CoordinateKeyView& key) const {
+        return strings_.substr(key.reference_offset, key.reference_length);
+    }
+    // Directory key of the sequence under the reference, or its only key when
+    // the reference is empty; throws when there is none or several.
+    [[nodiscard]] const CoordinateKeyView& find_key(std::string_view reference_name,
+                                                    std::string_view sequence_name) const;
+    // Append the ids of the key's fragments that overlap [begin, end).
+    void find_overlapping_tracks(const CoordinateKeyView& key,
+                                 std::uint64_t begin,
+                                 std::uint64_t end,
+                                 std::vector<std::uint32_t>& track_ids) const;
+    // First local entry of the track whose start is greater than value, or
+    // greater than or equal to it when inclusive is set.
+    [[nodiscard]] std::uint64_t partition_entries(std::size_t track_index,
+                                                  std::uint64_t value,
+                                                  bool inclusive) const;
+    [[nodiscard]] std::uint64_t fence_start(std::size_t track_index,
+                                            std::uint64_t fence) const;
 
     std::string index_path_;
-    mutable std::ifstream in_;
+    int fd_{-1};
+    void* mapping_{nullptr};
+    std::size_t file_size_{0};
+    const CoordinateEntryView* entries_{nullptr};
+    const CoordinateKeyView* keys_{nullptr};
+    const CoordinateFragmentView* fragments_{nullptr};
+    const CoordinateCommunityRunView* community_runs_{nullptr};
+    std::string_view strings_;
     std::uint64_t node_count_{};
     std::uint64_t entry_count_{};
-    std::uint64_t entry_table_offset_{};
+    std::uint64_t key_count_{};
     std::vector<CoordinateTrackInfo> tracks_;
 };
 
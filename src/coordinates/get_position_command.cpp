@@ -0,0 +1,224 @@
+#include "coordinates/get_position_command.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "coordinates/path_coordinate_query.h"
+#include "coordinates/path_liftover.h"
+#include "fs/fs_helpers.h"
+#include "indexer/node_hash_index.h"
+#include "indexer/node_length_index.h"
+#include "paths/node_positions.h"
+#include "paths/path_index.h"
+#include "utils/Timer.h"
+#include "utils/cli_helpers.h"
+
+namespace gfaidx::coordinates {
+namespace {
+
+constexpr std::uint32_t kMaxPositionThreads = 256;
+
+void append_csv_tokens(std::vector<std::string>& out, const std::string& csv) {
+    for (std::size_t pos = 0; pos < csv.size();) {
+        const std::size_t comma = csv.find(',', pos);
+        const std::size_t end = (comma == std::string::npos) ? csv.size() : comma;
+        if (end > pos) out.emplace_back(csv.substr(pos, end - pos));
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+}
+
+// Node names in first-seen order, without repeats.
+std::vector<std::string> load_query_nodes(const std::string& csv, const std::string& file_path) {
+    std::vector<std::string> nodes;
+    append_csv_tokens(nodes, csv);
+    if (!file_path.empty()) {
+        std::ifstream in(file_path);
+        if (!in) {
+            throw std::runtime_error("Failed to open nodes file: " + file_path);
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            append_csv_tokens(nodes, line);
+        }
+    }
+    std::unordered_set<std::string> seen;
+    seen.reserve(nodes.size());
+    nodes.erase(std::remove_if(nodes.begin(), nodes.end(),
+                               [&](const std::string& node) { return !seen.insert(node).second; }),
+                nodes.end());
+    return nodes;
+}
+
+}  // namespace
+
+void configure_get_position_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("in_gz")
+      .help("indexed GFA graph used to infer companion .ndx, .pdx, .lnx and .pcx files");
+
+    parser.add_argument("--nodes")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("comma-separated node ids to locate");
+
+    parser.add_argument("--nodes_file")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("file with node ids, one per line or comma-separated per line");
+
+    parser.add_argument("--target")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("only report visits on this P/W record name or coordinate namespace");
+
+    parser.add_argument("--ndx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("node hash index override; defaults to <in_gz>.ndx");
+
+    parser.add_argument("--pdx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("path index override; defaults to <in_gz>.pdx");
+
+    parser.add_argument("--lnx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("node length index override; defaults to <in_gz>.lnx");
+
+    parser.add_argument("--pcx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("path coordinate checkpoints that bound each step lookup; defaults to <in_gz>.pcx when present");
+
+    parser.add_argument("--threads")
+      .default_value(std::string("1"))
+      .nargs(1)
+      .help("number of posting and path-scan workers; the output does not depend on it (default: 1)");
+
+    parser.add_argument("--no_header")
+      .default_value(false)
+      .implicit_value(true)
+      .help("omit the TSV header");
+}
+
+int run_get_position(const argparse::ArgumentParser& program) {
+    try {
+        const auto input_gz = program.get<std::string>("in_gz");
+        auto ndx_path = program.get<std::string>("ndx");
+        auto pdx_path = program.get<std::string>("pdx");
+        auto lnx_path = program.get<std::string>("lnx");
+        auto pcx_path = program.get<std::string>("pcx");
+        const bool pcx_explicit = !pcx_path.empty();
+        if (ndx_path.empty()) ndx_path = utils::companion_path(input_gz, ".ndx");
+        if (pdx_path.empty()) pdx_path = utils::companion_path(input_gz, ".pdx");
+        if (lnx_path.empty()) lnx_path = utils::companion_path(input_gz, ".lnx");
+        if (pcx_path.empty()) pcx_path = utils::companion_path(input_gz, ".pcx");
+        const auto threads = utils::parse_u32_strict(
+            program.get<std::string>("threads"), "--threads", 1, kMaxPositionThreads);
+
+        const auto node_names = load_query_nodes(program.get<std::string>("nodes"),
+                                                 program.get<std::string>("nodes_file"));
+        if (node_names.empty()) {
+            throw std::runtime_error("Provide node ids with --nodes or --nodes_file");
+        }
+        for (const auto* path : {&ndx_path, &pdx_path, &lnx_path}) {
+            if (!file_exists(path->c_str())) {
+                throw std::runtime_error("Index file does not exist: " + *path);
+            }
+        }
+        if (pcx_explicit && !file_exists(pcx_path.c_str())) {
+            throw std::runtime_error("Path checkpoint index does not exist: " + pcx_path);
+        }
+
+        Timer timer;
+        const indexer::NodeHashIndex node_index(ndx_path);
+        const paths::PathIndexReader path_index(pdx_path);
+        const indexer::NodeLengthIndexReader lengths(lnx_path);
+        if (path_index.node_count() != node_index.size()) {
+            throw std::runtime_error(".pdx and .ndx node counts differ; rebuild aligned indexes");
+        }
+        std::unique_ptr<paths::PathCoordinateCheckpointIndexReader> checkpoints;
+        if (file_exists(pcx_path.c_str())) {
+            checkpoints = open_on_the_fly_checkpoints(pcx_path, path_index, lengths.node_count());
+        }
+        const PathCoordinateNames names(path_index);
+
+        // .pdx node ids are .ndx ranks. Unknown names are reported and skipped.
+        std::vector<std::string> found_names;
+        std::vector<std::uint32_t> node_ids;
+        for (const auto& name : node_names) {
+            std::uint32_t rank = 0;
+            if (!node_index.lookup_rank(name, rank)) {
+                std::cerr << get_time() << ": Warning: skipped node " << name
+                          << ": it was not found in .ndx" << std::endl;
+                continue;
+            }
+            found_names.push_back(name);
+            node_ids.push_back(rank);
+        }
+
+        // A target limits posting decodes to its path-id range.
+        std::vector<std::uint8_t> target_paths;
+        std::uint32_t path_begin = 0;
+        std::uint32_t path_end = path_index.path_count();
+        const auto target = program.get<std::string>("target");
+        if (!target.empty()) {
+            const auto paths = names.find_paths(target);
+            if (paths.empty()) {
+                throw std::runtime_error("No indexed P path or W walk is named '" + target + "'");
+            }
+            target_paths.assign(path_index.path_count(), 0);
+            for (const auto path_id : paths) target_paths[path_id] = 1;
+            path_begin = paths.front();
+            path_end = paths.back() + 1;
+        }
+
+        auto positions = paths::find_node_positions(path_index, lengths, checkpoints.get(),
+                                                    node_ids, path_begin, path_end, threads);
+        if (!target_paths.empty()) {
+            positions.erase(std::remove_if(positions.begin(), positions.end(),
+                                           [&](const paths::NodePosition& position) {
+                                               return target_paths[position.path_id] == 0;
+                                           }),
+                            positions.end());
+        }
+
+        auto& out = std::cout;
+        if (!program.get<bool>("no_header")) out << "node\tpath\tstart\tend\tstrand\n";
+        std::size_t next = 0;
+        for (std::size_t i = 0; i < node_ids.size(); ++i) {
+            const auto length = lengths.length(node_ids[i]);
+            const auto first = next;
+            for (; next < positions.size() && positions[next].node_index == i; ++next) {
+                const auto& position = positions[next];
+                const auto start = names.coordinate_base(position.path_id) + position.offset;
+                out << found_names[i] << '\t' << names.namespace_name(position.path_id) << '\t'
+                    << start << '\t' << start + length << '\t'
+                    << (position.is_reverse ? '-' : '+') << '\n';
+            }
+            if (next == first) out << found_names[i] << "\t*\t*\t*\t*\n";
+        }
+        out.flush();
+        if (!out) throw std::runtime_error("Failed while writing node positions");
+
+        std::cerr << get_time() << ": Located " << positions.size() << " visits of "
+                  << node_ids.size() << " nodes in " << timer.elapsed() << " seconds"
+                  << std::endl;
+        return 0;
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
+
+}  // namespace gfaidx::coordinates
@@ -0,0 +1,14 @@
+#ifndef GFAIDX_GET_POSITION_COMMAND_H
+#define GFAIDX_GET_POSITION_COMMAND_H
+
+#include <argparse/argparse.hpp>
+
+namespace gfaidx::coordinates {
+
+// Configure and execute node-name to path-position lookup.
+void configure_get_position_parser(argparse::ArgumentParser& parser);
+int run_get_position(const argparse::ArgumentParser& program);
+
+}  // namespace gfaidx::coordinates
+
+#endif  // GFAIDX_GET_POSITION_COMMAND_H
@@ -0,0 +1,467 @@
+#include "coordinates/haplotype_projection.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fs/fs_helpers.h"
+#include "paths/path_index.h"
+
+namespace gfaidx::coordinates {
+namespace {
+
+// The file holds a fixed header, one record per .cdx track in track-table
+// order, the windows of all tracks, and the path bounds of all windows.
+constexpr char kProjectionMagic[8] = {'G', 'F', 'A', 'H', 'P', 'X', '0', '1'};
+constexpr std::uint32_t kProjectionVersion = 1;
+
+// The .cdx and .pdx counts are kept to reject a sidecar paired with other
+// indexes; the per-track records are compared against the .cdx track table.
+struct ProjectionHeaderDisk {
+    char magic[8]{};
+    std::uint32_t version{};
+    std::uint32_t reserved{};
+    std::uint64_t window_bases{};
+    std::uint64_t node_count{};
+    std::uint64_t path_count{};
+    std::uint64_t total_step_count{};
+    std::uint64_t track_count{};
+    std::uint64_t window_count{};
+    std::uint64_t bound_count{};
+    std::uint64_t track_table_offset{};
+    std::uint64_t window_table_offset{};
+    std::uint64_t bound_table_offset{};
+};
+
+struct ProjectionTrackDisk {
+    std::uint64_t sequence_start{};
+    std::uint64_t entry_begin{};
+    std::uint64_t entry_count{};
+    std::uint64_t window_begin{};
+    std::uint64_t window_count{};
+};
+
+// entry_begin is local to the track: the first entry starting at or after
+// the window start. A window's bounds end where the next window's begin.
+struct ProjectionWindowDisk {
+    std::uint64_t entry_begin{};
+    std::uint64_t bound_begin{};
+};
+
+struct ProjectionBoundDisk {
+    std::uint32_t path_id{};
+    std::uint32_t min_step{};
+    std::uint32_t max_step{};
+};
+
+static_assert(sizeof(ProjectionHeaderDisk) == 96, "Unexpected .hpx header size");
+static_assert(sizeof(ProjectionTrackDisk) == 40, "Unexpected .hpx track size");
+static_assert(sizeof(ProjectionWindowDisk) == 16, "Unexpected .hpx window size");
+static_assert(sizeof(ProjectionBoundDisk) == 12, "Unexpected .hpx bound size");
+
+std::uint64_t track_window_count(const CoordinateTrackInfo& track, std::uint64_t window_bases) {
+    if (track.entry_count == 0) return 0;
+    const auto span = track.sequence_end - track.sequence_start;
+    return std::max<std::uint64_t>(1, span / window_bases + (span % window_bases != 0));
+}
+
+template <typename T>
+void write_records(std::ofstream& out, const std::vector<T>& values) {
+    if (values.empty()) return;
+    out.write(reinterpret_cast<const char*>(values.data()),
+              static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+// Per-path bounds merged over a set of nodes. touched lists the paths seen
+// since the last take(), so clearing costs the paths seen, not the path count.
+class PathBoundsAccumulator {
+public:
+    explicit PathBoundsAccumulator(std::size_t path_count) : bounds_(path_count) {}
+
+    void add(std::uint32_t path_id, std::uint32_t min_step, std::uint32_t max_step) {
+        if (path_id >= bounds_.size()) {
+            throw std::runtime_error("Path posting refers to a path outside the .pdx path table");
+        }
+        auto& bounds = bounds_[path_id];
+        if (!bounds.seen) {
+            bounds = Bounds{min_step, max_step, true};
+            touched_.push_back(path_id);
+            return;
+        }
+        bounds.min_step = std::min(bounds.min_step, min_step);
+        bounds.max_step = std::max(bounds.max_step, max_step);
+    }
+
+    // Move the merged bounds out in path-id order and reset.
+    void take(std::vector<ProjectedPathBounds>& out) {
+        std::sort(touched_.begin(), touched_.end());
+        for (const auto path_id : touched_) {
+            auto& bounds = bounds_[path_id];
+            out.push_back(ProjectedPathBounds{path_id, bounds.min_step, bounds.max_step});
+            bounds.seen = false;
+        }
+        touched_.clear();
+    }
+
+private:
+    struct Bounds {
+        std::uint32_t min_step{};
+        std::uint32_t max_step{};
+        bool seen{false};
+    };
+
+    std::vector<Bounds> bounds_;
+    std::vector<std::uint32_t> touched_;
+};
+
+}  // namespace
+
+void build_haplotype_projection_index(const std::string& coordinate_index_path,
+                                      const std::string& path_index_path,
+                                      const std::string& output_path,
+                                      std::uint64_t window_bases) {
+    if (window_bases == 0) {
+        throw std::runtime_error("Haplotype projection window must be greater than zero");
+    }
+    const CoordinateIndexReader coordinate_index(coordinate_index_path);
+    const paths::PathIndexReader path_index(path_index_path);
+    if (coordinate_index.node_count() != path_index.node_count()) {
+        throw std::runtime_error(".cdx and .pdx node counts differ; rebuild them against the same .ndx");
+    }
+    const auto& tracks = coordinate_index.tracks();
+
+    std::vector<ProjectionTrackDisk> track_records;
+    track_records.reserve(tracks.size());
+    std::uint64_t window_count = 0;
+    for (const auto& track : tracks) {
+        const auto count = track_window_count(track, window_bases);
+        track_records.push_back(ProjectionTrackDisk{
+            track.sequence_start, track.entry_begin, track.entry_count, window_count, count});
+        window_count += count;
+    }
+    std::vector<ProjectionWindowDisk> window_records;
+    window_records.reserve(static_cast<std::size_t>(window_count));
+
+    ProjectionHeaderDisk header{};
+    std::memcpy(header.magic, kProjectionMagic, sizeof(header.magic));
+    header.version = kProjectionVersion;
+    header.window_bases = window_bases;
+    header.node_count = path_index.node_count();
+    header.path_count = path_index.path_count();
+    header.total_step_count = path_index.total_step_count();
+    header.track_count = track_records.size();
+    header.window_count = window_count;
+    header.track_table_offset = sizeof(ProjectionHeaderDisk);
+    header.window_table_offset =
+        header.track_table_offset + track_records.size() * sizeof(ProjectionTrackDisk);
+    header.bound_table_offset =
+        header.window_table_offset + window_count * sizeof(ProjectionWindowDisk);
+
+    const auto staged_output = make_temp_output_path(output_path);
+    try {
+        std::ofstream out(staged_output, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Failed to open haplotype projection output: " + staged_output);
+        // Window bound offsets are only known once the bounds are written, so
+        // the header and window table are written again at the end.
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        write_records(out, track_records);
+        window_records.resize(static_cast<std::size_t>(window_count));
+        write_records(out, window_records);
+        window_records.clear();
+
+        PathBoundsAccumulator accumulator(path_index.path_count());
+        std::vector<ProjectedPathBounds> window_bounds;
+        std::vector<std::uint32_t> window_nodes;
+        std::uint64_t bound_count = 0;
+        const auto finish_window = [&]() {
+            std::sort(window_nodes.begin(), window_nodes.end());
+            window_nodes.erase(std::unique(window_nodes.begin(), window_nodes.end()),
+                               window_nodes.end());
+            for (const auto node_rank : window_nodes) {
+                path_index.for_each_node_posting(
+                    node_rank, [&](std::uint32_t path_id, std::uint32_t step_rank) {
+                        accumulator.add(path_id, step_rank, step_rank);
+                    });
+            }
+            window_nodes.clear();
+            window_bounds.clear();
+            accumulator.take(window_bounds);
+            static_assert(sizeof(ProjectedPathBounds) == sizeof(ProjectionBoundDisk),
+                          "Projected bounds must match the on-disk bound table");
+            write_records(out, window_bounds);
+            bound_count += window_bounds.size();
+        };
+
+        for (std::size_t t = 0; t < tracks.size(); ++t) {
+            const auto& track = tracks[t];
+            const auto count = track_records[t].window_count;
+            std::uint64_t step = 0;
+            for (std::uint64_t window = 0; window < count; ++window) {
+                window_records.push_back(ProjectionWindowDisk{step, bound_count});
+                // The last window also takes any entry past the track span.
+                const bool last = window + 1 == count;
+                const auto window_end = track.sequence_start + (window + 1) * window_bases;
+                for (; step < track.entry_count &&
+                       (last || coordinate_index.entry_start(track, step) < window_end);
+                     ++step) {
+                    const auto node_rank = coordinate_index.entry_node_rank(track, step);
+                    if (node_rank >= path_index.node_count()) {
+                        throw std::runtime_error(".cdx entry has a node rank outside the .pdx node table");
+                    }
+                    window_nodes.push_back(node_rank);
+                }
+                finish_window();
+            }
+        }
+
+        header.bound_count = bound_count;
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        write_records(out, track_records);
+        write_records(out, window_records);
+        out.close();
+        if (!out) throw std::runtime_error("Failed while writing haplotype projection: " + output_path);
+        rename_path_or_throw(staged_output, output_path);
+    } catch (...) {
+        remove_path_if_exists(staged_output);
+        throw;
+    }
+}
+
+void HaplotypeProjectionReader::close_mapping() {
+    if (mapping_) {
+        munmap(mapping_, file_size_);
+        mapping_ = nullptr;
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+HaplotypeProjectionReader::HaplotypeProjectionReader(const std::string& index_path)
+    : index_path_(index_path) {
+    static_assert(sizeof(TrackView) == sizeof(ProjectionTrackDisk),
+                  "Mapped .hpx tracks must match the on-disk track table");
+    static_assert(sizeof(WindowView) == sizeof(ProjectionWindowDisk),
+                  "Mapped .hpx windows must match the on-disk window table");
+    static_assert(sizeof(BoundView) == sizeof(ProjectionBoundDisk),
+                  "Mapped .hpx bounds must match the on-disk bound table");
+    fd_ = ::open(index_path.c_str(), O_RDONLY);
+    if (fd_ == -1) throw std::runtime_error("Failed to open haplotype projection: " + index_path);
+
+    struct stat st{};
+    if (fstat(fd_, &st) == -1) {
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Failed to stat haplotype projection: " + index_path);
+    }
+    file_size_ = static_cast<std::size_t>(st.st_size);
+    if (file_size_ < sizeof(ProjectionHeaderDisk)) {
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Failed to read haplotype projection header: " + index_path);
+    }
+    mapping_ = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("mmap failed for haplotype projection: " + index_path);
+    }
+
+    try {
+        const auto* bytes = static_cast<const char*>(mapping_);
+        ProjectionHeaderDisk header{};
+        std::memcpy(&header, bytes, sizeof(header));
+        if (std::memcmp(header.magic, kProjectionMagic, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("Invalid haplotype projection magic: " + index_path);
+        }
+        if (header.version != kProjectionVersion) {
+            throw std::runtime_error("Unsupported haplotype projection version: " +
+                                     std::to_string(header.version) +
+                                     "; rebuild it with gfaidx index_haplotype_projection");
+        }
+
+        // Check the contiguous layout header, tracks, windows, bounds.
+        const auto file_size = static_cast<std::uint64_t>(file_size_);
+        const auto max_u64 = std::numeric_limits<std::uint64_t>::max();
+        if (header.window_bases == 0 ||
+            header.track_count > max_u64 / sizeof(ProjectionTrackDisk) ||
+            header.window_count > max_u64 / sizeof(ProjectionWindowDisk) ||
+            header.bound_count > max_u64 / sizeof(ProjectionBoundDisk)) {
+            throw std::runtime_error("Haplotype projection header is invalid");
+        }
+        const std::uint64_t section_offsets[] = {
+            header.track_table_offset,
+            header.window_table_offset,
+            header.bound_table_offset,
+        };
+        const std::uint64_t section_bytes[] = {
+            header.track_count * sizeof(ProjectionTrackDisk),
+            header.window_count * sizeof(ProjectionWindowDisk),
+            header.bound_count * sizeof(ProjectionBoundDisk),
+        };
+        std::uint64_t expected_offset = sizeof(ProjectionHeaderDisk);
+        for (std::size_t i = 0; i < std::size(section_offsets); ++i) {
+            if (section_offsets[i] != expected_offset ||
+                section_bytes[i] > file_size ||
+                expected_offset > file_size - section_bytes[i]) {
+                throw std::runtime_error("Haplotype projection section offsets are invalid");
+            }
+            expected_offset += section_bytes[i];
+        }
+        if (expected_offset != file_size) {
+            throw std::runtime_error("Haplotype projection section offsets are invalid");
+        }
+
+        window_bases_ = header.window_bases;
+        node_count_ = header.node_count;
+        path_count_ = header.path_count;
+        total_step_count_ = header.total_step_count;
+        track_count_ = header.track_count;
+        window_count_ = header.window_count;
+        bound_count_ = header.bound_count;
+        tracks_ = reinterpret_cast<const TrackView*>(bytes + header.track_table_offset);
+        windows_ = reinterpret_cast<const WindowView*>(bytes + header.window_table_offset);
+        bounds_ = reinterpret_cast<const BoundView*>(bytes + header.bound_table_offset);
+
+        // Windows of one track are contiguous and in order, and the bound
+        // ranges of all windows tile the bound table.
+        std::uint64_t next_window = 0;
+        std::uint64_t previous_bound = 0;
+        for (std::uint64_t t = 0; t < track_count_; ++t) {
+            const auto& track = tracks_[t];
+            if (track.window_begin != next_window ||
+                track.window_count > window_count_ - next_window) {
+                throw std::runtime_error("Haplotype projection track table is invalid");
+            }
+            std::uint64_t previous_entry = 0;
+            for (std::uint64_t w = 0; w < track.window_count; ++w) {
+                const auto& window = windows_[track.window_begin + w];
+                if (window.entry_begin < previous_entry || window.entry_begin > track.entry_count ||
+                    window.bound_begin < previous_bound || window.bound_begin > bound_count_) {
+                    throw std::runtime_error("Haplotype projection window table is invalid");
+                }
+                previous_entry = window.entry_begin;
+                previous_bound = window.bound_begin;
+            }
+            next_window += track.window_count;
+        }
+        if (next_window != window_count_) {
+            throw std::runtime_error("Haplotype projection track table is invalid");
+        }
+    } catch (...) {
+        close_mapping();
+        throw;
+    }
+}
+
+HaplotypeProjectionReader::~HaplotypeProjectionReader() {
+    close_mapping();
+}
+
+void HaplotypeProjectionReader::validate_against(const CoordinateIndexReader& coordinate_index,
+                                                 const paths::PathIndexReader& path_index) const {
+    if (node_count_ != path_index.node_count() ||
+        node_count_ != coordinate_index.node_count() ||
+        path_count_ != path_index.path_count() ||
+        total_step_count_ != path_index.total_step_count()) {
+        throw std::runtime_error(".hpx counts do not match the supplied .cdx/.pdx");
+    }
+    const auto& tracks = coordinate_index.tracks();
+    if (track_count_ != tracks.size()) {
+        throw std::runtime_error(".hpx track table does not match the supplied .cdx");
+    }
+    for (std::size_t t = 0; t < tracks.size(); ++t) {
+        const auto& record = tracks_[t];
+        if (record.sequence_start != tracks[t].sequence_start ||
+            record.entry_begin != tracks[t].entry_begin ||
+            record.entry_count != tracks[t].entry_count ||
+            record.window_count != track_window_count(tracks[t], window_bases_)) {
+            throw std::runtime_error(".hpx track table does not match the supplied .cdx");
+        }
+    }
+}
+
+const HaplotypeProjectionReader::TrackView* HaplotypeProjectionReader::find_track(
+    std::uint64_t entry_begin) const {
+    // Tracks are in .cdx order, so entry_begin never decreases; tracks
+    // without entries share it with the next one and have no windows.
+    const auto* first = std::lower_bound(
+        tracks_, tracks_ + track_count_, entry_begin,
+        [](const TrackView& track, std::uint64_t value) { return track.entry_begin < value; });
+    for (; first != tracks_ + track_count_ && first->entry_begin == entry_begin; ++first) {
+        if (first->entry_count != 0) return first;
+    }
+    return nullptr;
+}
+
+HaplotypeProjection HaplotypeProjectionReader::project(
+    const CoordinateIndexReader& coordinate_index,
+    const std::vector<CoordinateTrackSlice>& slices) const {
+    HaplotypeProjection projection;
+    PathBoundsAccumulator accumulator(static_cast<std::size_t>(path_count_));
+    const auto add_nodes = [&](const CoordinateTrackInfo& track,
+                               std::uint64_t begin,
+                               std::uint64_t end) {
+        for (auto step = begin; step < end; ++step) {
+            projection.posting_node_ranks.push_back(coordinate_index.entry_node_rank(track, step));
+        }
+    };
+
+    for (const auto& slice : slices) {
+        const auto* track = find_track(slice.track.entry_begin);
+        if (track == nullptr || track->entry_count != slice.track.entry_count) {
+            throw std::runtime_error(".hpx has no windows for a .cdx track slice");
+        }
+        const auto low = slice.start_step;
+        const auto high = slice.start_step + slice.step_count;
+        const auto* windows = windows_ + track->window_begin;
+        const auto window_end = [&](std::uint64_t w) {
+            return w + 1 < track->window_count ? windows[w + 1].entry_begin : track->entry_count;
+        };
+
+        // Windows whose entries all lie in [low, high) are answered from the
+        // stored bounds; the entries before and after them need postings.
+        const auto* first_full = std::lower_bound(
+            windows, windows + track->window_count, low,
+            [](const WindowView& window, std::uint64_t value) { return window.entry_begin < value; });
+        auto full_begin = static_cast<std::uint64_t>(first_full - windows);
+        auto full_end = full_begin;
+        while (full_end < track->window_count && window_end(full_end) <= high) ++full_end;
+        if (full_begin == full_end) {
+            add_nodes(slice.track, low, high);
+            continue;
+        }
+
+        add_nodes(slice.track, low, windows[full_begin].entry_begin);
+        for (auto w = full_begin; w < full_end; ++w) {
+            const auto window_index = track->window_begin + w;
+            const auto bound_end = window_index + 1 < window_count_
+                ? windows_[window_index + 1].bound_begin
+                : bound_count_;
+            for (auto b = windows_[window_index].bound_begin; b < bound_end; ++b) {
+                accumulator.add(bounds_[b].path_id, bounds_[b].min_step, bounds_[b].max_step);
+            }
+        }
+        projection.window_count += full_end - full_begin;
+        add_nodes(slice.track, window_end(full_end - 1), high);
+    }
+
+    accumulator.take(projection.path_bounds);
+    std::sort(projection.posting_node_ranks.begin(), projection.posting_node_ranks.end());
+    projection.posting_node_ranks.erase(
+        std::unique(projection.posting_node_ranks.begin(), projection.posting_node_ranks.end()),
+        projection.posting_node_ranks.end());
+    return projection;
+}
+
+}  // namespace gfaidx::coordinates
@@ -0,0 +1,117 @@
+#ifndef GFAIDX_HAPLOTYPE_PROJECTION_H
+#define GFAIDX_HAPLOTYPE_PROJECTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "coordinates/coordinate_index.h"
+
+namespace gfaidx::paths {
+class PathIndexReader;
+}
+
+namespace gfaidx::coordinates {
+
+// A 10 kb window keeps the .pdx postings decoded for one region to at most
+// two partial windows, while one window of a few thousand haplotypes costs
+// tens of kilobytes of bounds.
+inline constexpr std::uint64_t kDefaultProjectionWindowBases = 10000;
+
+// The steps at which one path passes through the reference nodes of a window
+// or region: every posting of those nodes on path_id lies in
+// [min_step, max_step].
+struct ProjectedPathBounds {
+    std::uint32_t path_id{};
+    std::uint32_t min_step{};
+    std::uint32_t max_step{};
+};
+
+// The part of an all-haplotype query that a .hpx answers. path_bounds merges
+// the stored bounds of every window the query covers completely, one record
+// per path in path-id order. posting_node_ranks holds the sorted, unique
+// nodes of the partial windows at the query ends, whose postings still have
+// to be decoded from .pdx.
+struct HaplotypeProjection {
+    std::vector<ProjectedPathBounds> path_bounds;
+    std::vector<std::uint32_t> posting_node_ranks;
+    std::uint64_t window_count{};
+};
+
+// Build a .hpx for every track of a .cdx. Each track is cut into windows of
+// window_bases bases from its sequence_start, and an entry belongs to the
+// window holding its start. For every window the bounds of each path through
+// the window's reference nodes are stored, so the build decodes the .pdx
+// postings of each reference node once.
+void build_haplotype_projection_index(const std::string& coordinate_index_path,
+                                      const std::string& path_index_path,
+                                      const std::string& output_path,
+                                      std::uint64_t window_bases = kDefaultProjectionWindowBases);
+
+// Mmap-backed .hpx reader. The bound table is only touched for the windows a
+// query covers.
+class HaplotypeProjectionReader {
+public:
+    explicit HaplotypeProjectionReader(const std::string& index_path);
+    ~HaplotypeProjectionReader();
+
+    HaplotypeProjectionReader(const HaplotypeProjectionReader&) = delete;
+    HaplotypeProjectionReader& operator=(const HaplotypeProjectionReader&) = delete;
+
+    // Throw unless this sidecar was built from the supplied .cdx tracks and
+    // .pdx path table; callers then fall back to decoding every posting.
+    void validate_against(const CoordinateIndexReader& coordinate_index,
+                          const paths::PathIndexReader& path_index) const;
+
+    [[nodiscard]] std::uint64_t window_bases() const { return window_bases_; }
+    [[nodiscard]] std::uint64_t window_count() const { return window_count_; }
+    [[nodiscard]] std::uint64_t bound_count() const { return bound_count_; }
+
+    // Project the track slices of a CoordinateIndexReader::query_region()
+    // result. Merging path_bounds with the postings of posting_node_ranks
+    // gives the same per-path bounds as the postings of every slice node.
+    [[nodiscard]] HaplotypeProjection project(
+        const CoordinateIndexReader& coordinate_index,
+        const std::vector<CoordinateTrackSlice>& slices) const;
+
+private:
+    struct TrackView {
+        std::uint64_t sequence_start;
+        std::uint64_t entry_begin;
+        std::uint64_t entry_count;
+        std::uint64_t window_begin;
+        std::uint64_t window_count;
+    };
+    struct WindowView {
+        std::uint64_t entry_begin;
+        std::uint64_t bound_begin;
+    };
+    struct BoundView {
+        std::uint32_t path_id;
+        std::uint32_t min_step;
+        std::uint32_t max_step;
+    };
+
+    void close_mapping();
+    [[nodiscard]] const TrackView* find_track(std::uint64_t entry_begin) const;
+
+    std::string index_path_;
+    int fd_{-1};
+    void* mapping_{nullptr};
+    std::size_t file_size_{0};
+    const TrackView* tracks_{nullptr};
+    const WindowView* windows_{nullptr};
+    const BoundView* bounds_{nullptr};
+    std::uint64_t window_bases_{};
+    std::uint64_t node_count_{};
+    std::uint64_t path_count_{};
+    std::uint64_t total_step_count_{};
+    std::uint64_t track_count_{};
+    std::uint64_t window_count_{};
+    std::uint64_t bound_count_{};
+};
+
+}  // namespace gfaidx::coordinates
+
+#endif  // GFAIDX_HAPLOTYPE_PROJECTION_H
@@ -0,0 +1,266 @@
+#include "coordinates/liftover_command.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "coordinates/path_coordinate_query.h"
+#include "coordinates/path_liftover.h"
+#include "fs/fs_helpers.h"
+#include "indexer/node_length_index.h"
+#include "paths/path_index.h"
+#include "paths/path_step_offsets.h"
+#include "utils/Timer.h"
+#include "utils/cli_helpers.h"
+
+namespace gfaidx::coordinates {
+namespace {
+
+// Positions are lifted in batches so the pending target hits stay bounded
+// while each batch still shares its decoded .pcx blocks.
+constexpr std::size_t kLiftoverBatchPositions = 1U << 16;
+
+struct QueryPosition {
+    std::string name;
+    std::uint64_t coordinate{};
+};
+
+QueryPosition parse_query_position(const std::string& value) {
+    // Path names may contain colons, including a :start-end suffix, so the
+    // coordinate follows the last one.
+    const auto colon = value.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 >= value.size()) {
+        throw std::runtime_error("Position must have the form path:coordinate");
+    }
+    return QueryPosition{value.substr(0, colon),
+                         utils::parse_u64_strict(value.substr(colon + 1), "position", true)};
+}
+
+// Read path and coordinate from the first two tab-separated columns; further
+// columns are ignored. Comment and blank lines are skipped.
+std::vector<QueryPosition> read_query_positions(const std::string& positions_path) {
+    std::ifstream in(positions_path);
+    if (!in) {
+        throw std::runtime_error("Failed to open positions file: " + positions_path);
+    }
+    std::vector<QueryPosition> positions;
+    std::string line;
+    std::uint64_t line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        const auto context = positions_path + " line " + std::to_string(line_number);
+        const auto tab = line.find('\t');
+        if (tab == std::string::npos || tab == 0) {
+            throw std::runtime_error(context + " needs tab-separated path and coordinate");
+        }
+        const auto end = line.find('\t', tab + 1);
+        const std::string_view coordinate(line.data() + tab + 1,
+                                          (end == std::string::npos ? line.size() : end) - tab - 1);
+        positions.push_back(QueryPosition{line.substr(0, tab),
+                                          utils::parse_u64_strict(coordinate,
+                                                                  context + " coordinate")});
+    }
+    return positions;
+}
+
+std::vector<std::string> read_target_names(const std::string& target,
+                                           const std::string& targets_path) {
+    std::vector<std::string> names;
+    if (!target.empty()) names.push_back(target);
+    if (!targets_path.empty()) {
+        std::ifstream in(targets_path);
+        if (!in) {
+            throw std::runtime_error("Failed to open targets file: " + targets_path);
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            names.push_back(line);
+        }
+    }
+    return names;
+}
+
+}  // namespace
+
+void configure_liftover_parser(argparse::ArgumentParser& parser) {
+    parser.add_argument("in_gz")
+      .help("indexed GFA graph used to infer companion .pdx, .lnx and .pcx files");
+
+    parser.add_argument("position")
+      .default_value(std::string(""))
+      .nargs(argparse::nargs_pattern::optional)
+      .help("0-based position to lift, as path:coordinate; use --positions for a batch");
+
+    parser.add_argument("--positions")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("file of tab-separated path and 0-based coordinate columns to lift in one run");
+
+    parser.add_argument("--target")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("P/W record name or coordinate namespace to lift to; defaults to every indexed path");
+
+    parser.add_argument("--targets_file")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("file with one target record name or coordinate namespace per line");
+
+    parser.add_argument("--pdx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("path index override; defaults to <in_gz>.pdx");
+
+    parser.add_argument("--lnx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("node length index override; defaults to <in_gz>.lnx");
+
+    parser.add_argument("--pcx")
+      .default_value(std::string(""))
+      .nargs(1)
+      .help("path coordinate checkpoints that bound each step lookup; defaults to <in_gz>.pcx when present");
+
+    parser.add_argument("--no_header")
+      .default_value(false)
+      .implicit_value(true)
+      .help("omit the TSV header");
+}
+
+int run_liftover(const argparse::ArgumentParser& program) {
+    try {
+        const auto input_gz = program.get<std::string>("in_gz");
+        const auto position_arg = program.get<std::string>("position");
+        const auto positions_path = program.get<std::string>("positions");
+        auto pdx_path = program.get<std::string>("pdx");
+        auto lnx_path = program.get<std::string>("lnx");
+        auto pcx_path = program.get<std::string>("pcx");
+        const bool pcx_explicit = !pcx_path.empty();
+        if (position_arg.empty() == positions_path.empty()) {
+            throw std::runtime_error("Provide either one path:coordinate position or --positions");
+        }
+        if (pdx_path.empty()) pdx_path = utils::companion_path(input_gz, ".pdx");
+        if (lnx_path.empty()) lnx_path = utils::companion_path(input_gz, ".lnx");
+        if (pcx_path.empty()) pcx_path = utils::companion_path(input_gz, ".pcx");
+        if (!file_exists(pdx_path.c_str())) {
+            throw std::runtime_error("Path index does not exist: " + pdx_path);
+        }
+        if (!file_exists(lnx_path.c_str())) {
+            throw std::runtime_error("Node length index does not exist: " + lnx_path);
+        }
+        if (pcx_explicit && !file_exists(pcx_path.c_str())) {
+            throw std::runtime_error("Path checkpoint index does not exist: " + pcx_path);
+        }
+
+        const auto queries = positions_path.empty()
+            ? std::vector<QueryPosition>{parse_query_position(position_arg)}
+            : read_query_positions(positions_path);
+
+        Timer timer;
+        const paths::PathIndexReader path_index(pdx_path);
+        const indexer::NodeLengthIndexReader lengths(lnx_path);
+        std::unique_ptr<paths::PathCoordinateCheckpointIndexReader> checkpoints;
+        if (file_exists(pcx_path.c_str())) {
+            checkpoints = open_on_the_fly_checkpoints(pcx_path, path_index, lengths.node_count());
+        }
+        paths::PathStepOffsets offsets(path_index, lengths, checkpoints.get());
+        const PathCoordinateNames names(path_index);
+
+        std::vector<std::uint8_t> target_paths;
+        const auto target_names = read_target_names(program.get<std::string>("target"),
+                                                    program.get<std::string>("targets_file"));
+        if (!target_names.empty()) {
+            target_paths.assign(path_index.path_count(), 0);
+            for (const auto& name : target_names) {
+                const auto paths = names.find_paths(name);
+                if (paths.empty()) {
+                    throw std::runtime_error("No indexed P path or W walk is named '" + name +
+                                             "'");
+                }
+                for (const auto path_id : paths) target_paths[path_id] = 1;
+            }
+        }
+
+        auto& out = std::cout;
+        if (!program.get<bool>("no_header")) {
+            out << "query_path\tquery_position\ttarget_path\ttarget_position\tstrand\tnode\n";
+        }
+
+        // A position that cannot be resolved is reported and skipped; one
+        // without any other occurrence is written with '*' target columns.
+        std::uint64_t skipped = 0;
+        std::uint64_t lifted = 0;
+        std::uint64_t hit_count = 0;
+        std::vector<PathLocalPosition> batch;
+        std::vector<std::size_t> batch_queries;
+        for (std::size_t next = 0; next < queries.size();) {
+            batch.clear();
+            batch_queries.clear();
+            for (; next < queries.size() && batch.size() < kLiftoverBatchPositions; ++next) {
+                try {
+                    batch.push_back(names.resolve(queries[next].name, queries[next].coordinate));
+                    batch_queries.push_back(next);
+                } catch (const std::exception& err) {
+                    ++skipped;
+                    std::cerr << get_time() << ": Warning: skipped position "
+                              << queries[next].name << ':' << queries[next].coordinate << ": "
+                              << err.what() << std::endl;
+                }
+            }
+
+            const auto result = lift_path_positions(path_index, offsets, batch, target_paths);
+            std::size_t hit = 0;
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                const auto& query = queries[batch_queries[i]];
+                const auto node_id = result.source_nodes[i];
+                if (node_id == kNoLiftoverNode) {
+                    ++skipped;
+                    std::cerr << get_time() << ": Warning: skipped position " << query.name
+                              << ':' << query.coordinate << ": it lies past the end of "
+                              << path_index.get_path_name(batch[i].path_id) << std::endl;
+                    continue;
+                }
+                const auto node_name = path_index.get_node_name(node_id);
+                const auto first_hit = hit;
+                for (; hit < result.hits.size() && result.hits[hit].position_index == i; ++hit) {
+                    const auto& target = result.hits[hit];
+                    out << query.name << '\t' << query.coordinate << '\t'
+                        << names.namespace_name(target.path_id) << '\t'
+                        << names.coordinate_base(target.path_id) + target.offset << '\t'
+                        << (target.is_reverse ? '-' : '+') << '\t' << node_name << '\n';
+                }
+                if (hit == first_hit) {
+                    out << query.name << '\t' << query.coordinate << "\t*\t*\t*\t" << node_name
+                        << '\n';
+                } else {
+                    ++lifted;
+                    hit_count += hit - first_hit;
+                }
+            }
+            if (!out) throw std::runtime_error("Failed while writing liftover output");
+        }
+        out.flush();
+
+        std::cerr << get_time() << ": Lifted " << lifted << " of " << queries.size()
+                  << " positions to " << hit_count << " target positions";
+        if (skipped != 0) std::cerr << "; skipped " << skipped;
+        std::cerr << " in " << timer.elapsed() << " seconds (" << offsets.decoded_block_count()
+                  << " step blocks decoded)" << std::endl;
+        return 0;
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
+
+}  // namespace gfaidx::coordinates
@@ -0,0 +1,14 @@
+#ifndef GFAIDX_LIFTOVER_COMMAND_H
+#define GFAIDX_LIFTOVER_COMMAND_H
+
+#include <argparse/argparse.hpp>
+
+namespace gfaidx::coordinates {
+
+// Configure and execute position liftover between indexed P/W records.
+void configure_liftover_parser(argparse::ArgumentParser& parser);
+int run_liftover(const argparse::ArgumentParser& program);
+
+}  // namespace gfaidx::coordinates
+
+#endif  // GFAIDX_LIFTOVER_COMMAND_H
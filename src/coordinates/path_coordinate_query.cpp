@@ -1,13 +1,16 @@
 #include "coordinates/path_coordinate_query.h"
 
 #include <algorithm>
+#include <iostream>
 #include <limits>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
 #include "indexer/node_length_index.h"
 #include "paths/p_path_coordinates.h"
+#include "paths/path_coordinate_checkpoints.h"
 
 namespace gfaidx::coordinates {
 namespace {
@@ -19,12 +22,6 @@ struct CandidatePath {
     bool has_expected_end{false};
 };
 
-struct StepCoordinateTable {
-    std::vector<std::uint64_t> starts;
-    std::vector<std::uint32_t> node_ranks;
-    std::uint64_t path_end{};
-};
-
 bool has_concrete_walk_coordinates(const paths::PathInfo& info) {
     return info.seq_start >= 0 && info.seq_end >= 0 && info.seq_end >= info.seq_start;
 }
@@ -45,104 +42,136 @@ void add_unique_reference(std::vector<std::string>& references, std::string_view
     }
 }
 
-StepCoordinateTable build_step_coordinate_table(
+struct CandidateSpan {
+    std::uint64_t start{};
+    std::uint64_t end{};
+};
+
+// Scan steps [first_step, last_step) of one path, the first of which starts at
+// coordinate, and append the ranks of the steps overlapping [begin, end).
+// Step starts and ends both increase along the path, so the overlapping steps
+// form one run. Return the coordinate after the last scanned step.
+std::uint64_t scan_overlapping_steps(
     const paths::PathIndexReader& path_index,
     const indexer::NodeLengthIndexReader& lengths,
     const paths::PathInfo& info,
-    std::uint64_t coordinate_base) {
-
-    if (info.step_count > static_cast<std::uint64_t>(std::numeric_limits<std::size_t>::max())) {
-        throw std::runtime_error("Path has too many steps to coordinate-index on the fly: " +
-                                 path_label(info));
-    }
-
-    StepCoordinateTable table;
-    table.starts.reserve(static_cast<std::size_t>(info.step_count));
-    table.node_ranks.reserve(static_cast<std::size_t>(info.step_count));
+    std::uint64_t first_step,
+    std::uint64_t last_step,
+    std::uint64_t coordinate,
+    std::uint64_t begin,
+    std::uint64_t end,
+    paths::SubpathRun& run,
+    std::vector<std::uint32_t>& node_ranks) {
 
-    std::uint64_t coordinate = coordinate_base;
-    path_index.for_each_step(info.path_id, 0, info.step_count,
-        [&](const paths::StepRecord& step, std::uint64_t) {
+    path_index.for_each_step(info.path_id, first_step, last_step - first_step,
+        [&](const paths::StepRecord& step, std::uint64_t step_rank) {
             if (step.node_id >= lengths.node_count()) {
                 throw std::runtime_error("Path references a node outside the .lnx length table: " +
                                          path_label(info));
             }
-            table.starts.push_back(coordinate);
-            table.node_ranks.push_back(step.node_id);
-
             const auto length = static_cast<std::uint64_t>(lengths.length(step.node_id));
             if (length > std::numeric_limits<std::uint64_t>::max() - coordinate) {
                 throw std::runtime_error("Coordinate overflow while scanning path: " +
                                          path_label(info));
             }
+            if (coordinate + length > begin && coordinate < end) {
+                if (run.step_count == 0) run.start_step = step_rank;
+                ++run.step_count;
+                node_ranks.push_back(step.node_id);
+            }
             coordinate += length;
         });
-
-    table.path_end = coordinate;
-    return table;
+    return coordinate;
 }
 
-struct CandidateSpan {
-    std::uint64_t start{};
-    std::uint64_t end{};
-};
+// Coordinate of .pcx checkpoint k of a path, i.e. of step k * stride.
+std::uint64_t checkpoint_coordinate(const paths::PathCoordinateCheckpointIndexReader& checkpoints,
+                                    const paths::PathInfo& info,
+                                    std::uint64_t coordinate_base,
+                                    std::uint64_t checkpoint) {
+    std::uint64_t checkpoint_step = 0;
+    const auto prefix = checkpoints.prefix_before_step(
+        info.path_id, checkpoint * checkpoints.checkpoint_stride(), checkpoint_step);
+    if (prefix > std::numeric_limits<std::uint64_t>::max() - coordinate_base) {
+        throw std::runtime_error("Coordinate overflow while scanning path: " + path_label(info));
+    }
+    return coordinate_base + prefix;
+}
 
 CandidateSpan append_overlapping_nodes(
     const paths::PathIndexReader& path_index,
     const indexer::NodeLengthIndexReader& lengths,
+    const paths::PathCoordinateCheckpointIndexReader* checkpoints,
     const CandidatePath& candidate,
     std::uint64_t begin,
     std::uint64_t end,
     PathCoordinateQueryResult& result) {
     const auto info = path_index.get_path_info(candidate.path_id);
 
-    // Build one start-coordinate table from the selected fragment base so the
-    // expensive path scan is done once, then use binary searches to isolate the
-    // requested interval.
-    const auto table = build_step_coordinate_table(path_index,
-                                                   lengths,
-                                                   info,
-                                                   candidate.coordinate_start);
-    if (candidate.has_expected_end &&
-        table.path_end != candidate.expected_end) {
+    paths::SubpathRun run{candidate.path_id, 0, 0};
+    std::uint64_t path_end = 0;
+    if (checkpoints == nullptr) {
+        // Without .pcx, stream the whole path once from the fragment base.
+        path_end = scan_overlapping_steps(path_index, lengths, info, 0, info.step_count,
+                                          candidate.coordinate_start, begin, end,
+                                          run, result.node_ranks);
+    } else {
+        // Bisect the checkpoint coordinates for the last checkpoint at or
+        // before begin and the first at or after end. Steps outside that
+        // window cannot overlap the query, so at most the window plus one
+        // stride of steps is decoded.
+        const auto stride = checkpoints->checkpoint_stride();
+        const auto checkpoint_count = info.step_count / stride + 1;
+        const auto coordinate_at = [&](std::uint64_t checkpoint) {
+            return checkpoint_coordinate(*checkpoints, info, candidate.coordinate_start,
+                                         checkpoint);
+        };
+        std::uint64_t low = 0;
+        std::uint64_t high = checkpoint_count;
+        while (low < high) {
+            const auto mid = low + (high - low) / 2;
+            if (coordinate_at(mid) <= begin) low = mid + 1;
+            else high = mid;
+        }
+        const auto first_checkpoint = low == 0 ? 0 : low - 1;
+        high = checkpoint_count;
+        while (low < high) {
+            const auto mid = low + (high - low) / 2;
+            if (coordinate_at(mid) < end) low = mid + 1;
+            else high = mid;
+        }
+        const auto first_step = first_checkpoint * stride;
+        const auto last_step = low < checkpoint_count ? low * stride : info.step_count;
+        const auto window_end = scan_overlapping_steps(path_index, lengths, info,
+                                                       first_step, last_step,
+                                                       coordinate_at(first_checkpoint),
+                                                       begin, end, run, result.node_ranks);
+
+        // The span end still needs the steps after the last checkpoint; scan
+        // them against an empty interval.
+        if (last_step == info.step_count) {
+            path_end = window_end;
+        } else {
+            const auto last_checkpoint = checkpoint_count - 1;
+            paths::SubpathRun tail_run{candidate.path_id, 0, 0};
+            std::vector<std::uint32_t> unused_ranks;
+            path_end = scan_overlapping_steps(path_index, lengths, info,
+                                              last_checkpoint * stride, info.step_count,
+                                              coordinate_at(last_checkpoint), 0, 0,
+                                              tail_run, unused_ranks);
+        }
+    }
+
+    if (candidate.has_expected_end && path_end != candidate.expected_end) {
         throw std::runtime_error(
             std::string(1, info.record_type) +
             " path span does not match segment lengths: " + path_label(info));
     }
-    if (table.starts.empty() || end <= candidate.coordinate_start ||
-        begin >= table.path_end) {
-        return CandidateSpan{candidate.coordinate_start, table.path_end};
-    }
-
-    auto high_it = std::lower_bound(table.starts.begin(), table.starts.end(), end);
-    std::size_t high = static_cast<std::size_t>(high_it - table.starts.begin());
-    auto low_it = std::upper_bound(table.starts.begin(), table.starts.end(), begin);
-    std::size_t low = static_cast<std::size_t>(low_it - table.starts.begin());
-    if (low > 0) --low;
-
-    while (low < high) {
-        const auto step_end = (low + 1 < table.starts.size())
-            ? table.starts[low + 1]
-            : table.path_end;
-        if (step_end > begin) break;
-        ++low;
-    }
 
-    if (low >= high) {
-        return CandidateSpan{candidate.coordinate_start, table.path_end};
-    }
-
-    // Preserve the exact path occurrence selected by the coordinate binary
-    // search. Repeated node ids elsewhere on the same path must not widen it.
-    result.reference_path_runs.push_back(paths::SubpathRun{
-        candidate.path_id,
-        static_cast<std::uint64_t>(low),
-        static_cast<std::uint64_t>(high - low),
-    });
-    for (std::size_t i = low; i < high; ++i) {
-        result.node_ranks.push_back(table.node_ranks[i]);
-    }
-    return CandidateSpan{candidate.coordinate_start, table.path_end};
+    // Preserve the exact path occurrence selected by coordinates. Repeated
+    // node ids elsewhere on the same path must not widen it.
+    if (run.step_count != 0) result.reference_path_runs.push_back(run);
+    return CandidateSpan{candidate.coordinate_start, path_end};
 }
 
 std::vector<CandidatePath> find_candidate_paths(
@@ -227,9 +256,28 @@ std::vector<CandidatePath> find_candidate_paths(
 
 }  // namespace
 
+std::unique_ptr<paths::PathCoordinateCheckpointIndexReader> open_on_the_fly_checkpoints(
+    const std::string& checkpoint_index_path,
+    const paths::PathIndexReader& path_index,
+    std::uint64_t node_count) {
+    std::unique_ptr<paths::PathCoordinateCheckpointIndexReader> checkpoints;
+    try {
+        checkpoints = std::make_unique<paths::PathCoordinateCheckpointIndexReader>(
+            checkpoint_index_path);
+        checkpoints->validate_against(path_index, node_count);
+    } catch (const std::exception& err) {
+        checkpoints.reset();
+        std::cerr << "Warning: could not use path checkpoint index '"
+                  << checkpoint_index_path << "' (" << err.what()
+                  << "), falling back to full path scans" << std::endl;
+    }
+    return checkpoints;
+}
+
 PathCoordinateQueryResult query_path_coordinates_on_the_fly(
     const paths::PathIndexReader& path_index,
     const std::string& length_index_path,
+    const std::string& checkpoint_index_path,
     std::string_view reference_name,
     std::string_view sequence_name,
     std::uint64_t begin,
@@ -247,6 +295,34 @@ PathCoordinateQueryResult query_path_coordinates_on_the_fly(
         throw std::runtime_error(".lnx and .pdx node counts differ; rebuild them against the same .ndx");
     }
 
+    std::unique_ptr<paths::PathCoordinateCheckpointIndexReader> checkpoints;
+    if (!checkpoint_index_path.empty()) {
+        checkpoints = open_on_the_fly_checkpoints(checkpoint_index_path,
+                                                  path_index,
+                                                  lengths.node_count());
+    }
+    return query_path_coordinates_on_the_fly(path_index,
+                                             lengths,
+                                             checkpoints.get(),
+                                             reference_name,
+                                             sequence_name,
+                                             begin,
+                                             end);
+}
+
+PathCoordinateQueryResult query_path_coordinates_on_the_fly(
+    const paths::PathIndexReader& path_index,
+    const indexer::NodeLengthIndexReader& lengths,
+    const paths::PathCoordinateCheckpointIndexReader* checkpoints,
+    std::string_view reference_name,
+    std::string_view sequence_name,
+    std::uint64_t begin,
+    std::uint64_t end) {
+
+    if (end <= begin) {
+        throw std::runtime_error("Coordinate query end must be greater than start");
+    }
+
     auto candidates = find_candidate_paths(path_index,
                                            reference_name,
                                            sequence_name,
@@ -268,6 +344,7 @@ PathCoordinateQueryResult query_path_coordinates_on_the_fly(
     for (const auto& candidate : candidates) {
         const auto span = append_overlapping_nodes(path_index,
                                                    lengths,
+                                                   checkpoints,
                                                    candidate,
                                                    begin,
                                                    end,
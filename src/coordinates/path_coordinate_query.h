@@ -3,10 +3,13 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "indexer/node_length_index.h"
+#include "paths/path_coordinate_checkpoints.h"
 #include "paths/path_index.h"
 
 namespace gfaidx::coordinates {
@@ -20,16 +23,39 @@ struct PathCoordinateQueryResult {
 };
 
 // Resolve a coordinate interval directly from .pdx path steps and rank-aligned
-// .lnx node lengths. This is the slower fallback for paths/walks that were not
-// preselected into the .cdx coordinate sidecar.
+// .lnx node lengths. This is the fallback for paths/walks that were not
+// preselected into the .cdx coordinate sidecar. With a valid .pcx, the
+// checkpoint prefixes bound each path scan to the steps around the interval;
+// an empty checkpoint_index_path scans every candidate path in full.
 PathCoordinateQueryResult query_path_coordinates_on_the_fly(
     const paths::PathIndexReader& path_index,
     const std::string& length_index_path,
+    const std::string& checkpoint_index_path,
     std::string_view reference_name,
     std::string_view sequence_name,
     std::uint64_t begin,
     std::uint64_t end);
 
+// The same lookup against readers the caller keeps open across many queries.
+// lengths must be rank-aligned with path_index, and checkpoints, when given,
+// must already be validated against it.
+PathCoordinateQueryResult query_path_coordinates_on_the_fly(
+    const paths::PathIndexReader& path_index,
+    const indexer::NodeLengthIndexReader& lengths,
+    const paths::PathCoordinateCheckpointIndexReader* checkpoints,
+    std::string_view reference_name,
+    std::string_view sequence_name,
+    std::uint64_t begin,
+    std::uint64_t end);
+
+// Open and validate a .pcx for on-the-fly lookups. Checkpoints only bound the
+// scanned steps, so a missing or mismatched file prints a warning and returns
+// null; the lookups then give the same answer through full path scans.
+std::unique_ptr<paths::PathCoordinateCheckpointIndexReader> open_on_the_fly_checkpoints(
+    const std::string& checkpoint_index_path,
+    const paths::PathIndexReader& path_index,
+    std::uint64_t node_count);
+
 }  // namespace gfaidx::coordinates
 
 #endif  // GFAIDX_PATH_COORDINATE_QUERY_H
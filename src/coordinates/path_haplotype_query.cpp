@@ -9,6 +9,7 @@
 
 #include "paths/path_index.h"
 #include "utils/Timer.h"
+#include "utils/sparse_bitmap.h"
 
 namespace gfaidx::coordinates {
 namespace {
@@ -91,6 +92,10 @@ PathHaplotypeQueryResult query_path_haplotype_nodes(
         throw std::runtime_error(
             ".lnx node count does not match .pdx for local haplotype selection");
     }
+    if (local_gap_mode && options.projection != nullptr) {
+        throw std::runtime_error(
+            "Local haplotype gap selection cannot use a haplotype projection");
+    }
 
     // De-duplicate coordinate hits before reading postings. A reference path
     // can revisit a node, while its posting block is needed only once.
@@ -106,44 +111,30 @@ PathHaplotypeQueryResult query_path_haplotype_nodes(
     PathHaplotypeQueryResult result;
     result.reference_node_count = unique_reference_nodes.size();
 
-    // A dense bitset bounds temporary rank memory by the graph node count.
-    // Every selected path run sets bits here, and the final ascending scan
-    // produces the sorted unique rank vector required by materialization.
-    std::vector<std::uint64_t> selected_node_bits(
-        (static_cast<std::size_t>(path_index.node_count()) + 63) / 64,
-        0);
-    std::uint64_t selected_node_count = 0;
+    // A sparse bitmap keeps temporary rank memory proportional to the
+    // selected nodes rather than the graph node count. Every selected path run
+    // sets bits here, and the final ascending walk produces the sorted unique
+    // rank vector required by materialization.
+    utils::SparseBitmap selected_nodes;
     auto select_node_rank = [&](const std::uint32_t node_rank) {
         if (node_rank >= path_index.node_count()) {
             throw std::runtime_error(
                 "Selected path step has a node rank outside the .pdx node table");
         }
-        auto& word = selected_node_bits[node_rank / 64];
-        const std::uint64_t mask = 1ULL << (node_rank % 64);
-        if ((word & mask) == 0) {
-            word |= mask;
-            ++selected_node_count;
-        }
+        selected_nodes.insert(node_rank);
     };
     for (const auto node_rank : unique_reference_nodes) {
         select_node_rank(node_rank);
     }
 
     // Local mode marks anchor occurrences by absolute packed-step rank. This
-    // avoids retaining and sorting one uint32 posting for every anchor hit.
-    std::vector<std::uint64_t> anchor_step_bits;
+    // avoids retaining and sorting one uint32 posting for every anchor hit,
+    // and the sparse bitmap only grows with the anchors of this query.
+    utils::SparseBitmap anchor_steps;
     std::vector<std::uint64_t> path_step_begins;
     std::vector<std::uint64_t> path_step_counts;
     if (local_gap_mode) {
         const auto total_steps = path_index.total_step_count();
-        const auto anchor_word_count =
-            total_steps / 64 + (total_steps % 64 != 0 ? 1 : 0);
-        if (anchor_word_count > anchor_step_bits.max_size()) {
-            throw std::runtime_error(
-                "Path step table is too large for local anchor selection");
-        }
-        anchor_step_bits.assign(
-            static_cast<std::size_t>(anchor_word_count), 0);
         path_step_begins.resize(path_index.path_count());
         path_step_counts.resize(path_index.path_count());
         for (std::uint32_t path_id = 0;
@@ -167,21 +158,46 @@ PathHaplotypeQueryResult query_path_haplotype_nodes(
             throw std::runtime_error(
                 "Path posting step rank is outside its .pdx path step range");
         }
-        const auto absolute_step = path_step_begins[path_id] + step_rank;
-        anchor_step_bits[static_cast<std::size_t>(absolute_step / 64)] |=
-            1ULL << (absolute_step % 64);
+        anchor_steps.insert(path_step_begins[path_id] + step_rank);
     };
     const auto is_anchor_step = [&](const std::uint32_t path_id,
                                     const std::uint64_t step_rank) {
-        const auto absolute_step = path_step_begins[path_id] + step_rank;
-        return (anchor_step_bits[static_cast<std::size_t>(absolute_step / 64)] &
-                (1ULL << (absolute_step % 64))) != 0;
+        return anchor_steps.contains(path_step_begins[path_id] + step_rank);
     };
 
     // The default path still aggregates only min/max bounds. Local mode adds
     // the absolute anchor marker used later to split distant repeat hits.
+    // A projection supplies the merged bounds of the windows it covers, and
+    // only the nodes outside them are read from postings.
     Timer phase_timer;
-    for (const auto node_rank : unique_reference_nodes) {
+    const auto add_path_bounds = [&](const std::uint32_t path_id,
+                                     const std::uint32_t min_step,
+                                     const std::uint32_t max_step) {
+        if (path_id >= path_bounds.size()) {
+            throw std::runtime_error(
+                "Path posting refers to a path outside the .pdx path table");
+        }
+        auto& bounds = path_bounds[path_id];
+        if (!bounds.seen) {
+            bounds.min_step = min_step;
+            bounds.max_step = max_step;
+            bounds.seen = true;
+            ++result.matched_path_count;
+        } else {
+            bounds.min_step = std::min(bounds.min_step, min_step);
+            bounds.max_step = std::max(bounds.max_step, max_step);
+        }
+    };
+    const auto* posting_nodes = &unique_reference_nodes;
+    if (options.projection != nullptr) {
+        for (const auto& bounds : options.projection->path_bounds) {
+            add_path_bounds(bounds.path_id, bounds.min_step, bounds.max_step);
+        }
+        result.projected_window_count = options.projection->window_count;
+        result.projected_bound_count = options.projection->path_bounds.size();
+        posting_nodes = &options.projection->posting_node_ranks;
+    }
+    for (const auto node_rank : *posting_nodes) {
         if (node_rank >= path_index.node_count()) {
             throw std::runtime_error(
                 "Reference node rank is outside the .pdx node table");
@@ -190,21 +206,7 @@ PathHaplotypeQueryResult query_path_haplotype_nodes(
         path_index.for_each_node_posting(
             node_rank,
             [&](const std::uint32_t path_id, const std::uint32_t step_rank) {
-                if (path_id >= path_bounds.size()) {
-                    throw std::runtime_error(
-                        "Path posting refers to a path outside the .pdx path table");
-                }
-
-                auto& bounds = path_bounds[path_id];
-                if (!bounds.seen) {
-                    bounds.min_step = step_rank;
-                    bounds.max_step = step_rank;
-                    bounds.seen = true;
-                    ++result.matched_path_count;
-                } else {
-                    bounds.min_step = std::min(bounds.min_step, step_rank);
-                    bounds.max_step = std::max(bounds.max_step, step_rank);
-                }
+                add_path_bounds(path_id, step_rank, step_rank);
                 mark_anchor_step(path_id, step_rank);
                 ++result.posting_count;
             });
@@ -335,17 +337,12 @@ PathHaplotypeQueryResult query_path_haplotype_nodes(
     result.selected_step_seconds = phase_timer.elapsed();
 
     phase_timer.reset();
-    // Enumerating the rank-addressed bitset preserves deterministic node order
+    // Enumerating the rank bitmap in order preserves deterministic node order
     // without retaining duplicate occurrences from selected path runs.
-    result.node_ranks.reserve(static_cast<std::size_t>(selected_node_count));
-    for (std::uint32_t node_rank = 0;
-         node_rank < path_index.node_count();
-         ++node_rank) {
-        if ((selected_node_bits[node_rank / 64] &
-             (1ULL << (node_rank % 64))) != 0) {
-            result.node_ranks.push_back(node_rank);
-        }
-    }
+    result.node_ranks.reserve(static_cast<std::size_t>(selected_nodes.size()));
+    selected_nodes.for_each([&](const std::uint64_t node_rank) {
+        result.node_ranks.push_back(static_cast<std::uint32_t>(node_rank));
+    });
     result.node_rank_materialization_seconds = phase_timer.elapsed();
     return result;
 }
@@ -5,6 +5,7 @@
 #include <optional>
 #include <vector>
 
+#include "coordinates/haplotype_projection.h"
 #include "indexer/node_length_index.h"
 #include "paths/path_index.h"
 
@@ -15,6 +16,10 @@ namespace gfaidx::coordinates {
 struct PathHaplotypeQueryOptions {
     std::optional<std::uint64_t> max_gap_bases;
     const indexer::NodeLengthIndexReader* node_lengths{nullptr};
+    // Path bounds of the reference nodes already known from a .hpx. Postings
+    // are then decoded only for its posting_node_ranks. Local gap mode needs
+    // every anchor occurrence and cannot use it.
+    const HaplotypeProjection* projection{nullptr};
 };
 
 // Summary of one posting-driven all-haplotype selection. The returned node
@@ -33,8 +38,11 @@ struct PathHaplotypeQueryResult {
     std::uint64_t exact_reference_path_count{};
     std::uint64_t local_non_reference_run_count{};
     std::uint64_t local_split_path_count{};
+    // Windows and path bounds taken from a .hpx instead of postings.
+    std::uint64_t projected_window_count{};
+    std::uint64_t projected_bound_count{};
     // Phase timings distinguish posting lookup, selected path scanning, and
-    // final dense-rank materialization for large-query benchmarks.
+    // final rank materialization for large-query benchmarks.
     double posting_seconds{};
     double selected_step_seconds{};
     double node_rank_materialization_seconds{};
@@ -0,0 +1,178 @@
+#include "coordinates/path_liftover.h"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+#include "paths/p_path_coordinates.h"
+
+namespace gfaidx::coordinates {
+namespace {
+
+// A resolved source base: its step, and its offset within the node read in
+// the node's own orientation, which is what every other visit shares.
+struct SourceStep {
+    std::uint64_t step_rank{};
+    std::uint32_t node_offset{};
+    bool is_reverse{};
+};
+
+struct PendingHit {
+    std::uint32_t path_id{};
+    std::uint32_t step_rank{};
+    std::uint32_t position_index{};
+};
+
+}  // namespace
+
+std::vector<std::uint32_t> PathCoordinateNames::find_paths(std::string_view name) const {
+    std::uint32_t path_id = 0;
+    if (path_index_.lookup_path_id(name, path_id)) return {path_id};
+    return path_index_.lookup_namespace_paths(name);
+}
+
+const PathCoordinateNames::Fragment& PathCoordinateNames::fragment(std::uint32_t path_id) const {
+    const auto found = fragments_.find(path_id);
+    if (found != fragments_.end()) return found->second;
+
+    const auto info = path_index_.get_path_info(path_id);
+    Fragment out;
+    out.namespace_name = paths::path_coordinate_namespace(info);
+    if (info.record_type == 'W') {
+        if (info.seq_start >= 0) out.base = static_cast<std::uint64_t>(info.seq_start);
+        if (info.seq_end >= 0) out.end = static_cast<std::uint64_t>(info.seq_end);
+    } else {
+        const auto parsed = paths::parse_p_path_coordinate_name(info.name);
+        if (parsed.has_coordinates) {
+            out.base = parsed.start;
+            out.end = parsed.end;
+        }
+    }
+    return fragments_.emplace(path_id, std::move(out)).first->second;
+}
+
+PathLocalPosition PathCoordinateNames::resolve(std::string_view name,
+                                               std::uint64_t coordinate) const {
+    const auto paths = find_paths(name);
+    if (paths.empty()) {
+        throw std::runtime_error("No indexed P path or W walk is named '" + std::string(name) +
+                                 "'");
+    }
+    PathLocalPosition out;
+    std::size_t covering = 0;
+    for (const auto path_id : paths) {
+        const auto& bounds = fragment(path_id);
+        if (coordinate < bounds.base || coordinate >= bounds.end) continue;
+        out = PathLocalPosition{path_id, coordinate - bounds.base};
+        ++covering;
+    }
+    if (covering == 0) {
+        throw std::runtime_error("No P/W record of '" + std::string(name) + "' covers position " +
+                                 std::to_string(coordinate));
+    }
+    if (covering > 1) {
+        throw std::runtime_error("Position " + std::to_string(coordinate) + " of '" +
+                                 std::string(name) + "' is covered by more than one P/W record");
+    }
+    return out;
+}
+
+LiftoverResult lift_path_positions(const paths::PathIndexReader& path_index,
+                                   paths::PathStepOffsets& offsets,
+                                   const std::vector<PathLocalPosition>& positions,
+                                   const std::vector<std::uint8_t>& target_paths) {
+    if (positions.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Too many liftover positions in one batch");
+    }
+    if (!target_paths.empty() && target_paths.size() != path_index.path_count()) {
+        throw std::runtime_error("Liftover target flags do not match the .pdx path table");
+    }
+    const auto is_target = [&](std::uint32_t path_id) {
+        return target_paths.empty() || target_paths[path_id] != 0;
+    };
+
+    LiftoverResult result;
+    result.source_nodes.assign(positions.size(), kNoLiftoverNode);
+    std::vector<SourceStep> sources(positions.size());
+    std::vector<std::uint32_t> order(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    // Resolve the source steps in path then offset order.
+    std::sort(order.begin(), order.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+        return std::tie(positions[lhs].path_id, positions[lhs].offset) <
+               std::tie(positions[rhs].path_id, positions[rhs].offset);
+    });
+    for (const auto index : order) {
+        const auto& position = positions[index];
+        paths::PathStepPosition step;
+        if (!offsets.find_step(position.path_id, position.offset, step)) continue;
+        const auto within = static_cast<std::uint32_t>(position.offset - step.offset);
+        result.source_nodes[index] = step.node_id;
+        sources[index] = SourceStep{step.step_rank,
+                                    step.is_reverse ? step.length - 1 - within : within,
+                                    step.is_reverse};
+    }
+
+    // Postings limited to the target path range, decoded once per node.
+    std::uint32_t path_begin = 0;
+    std::uint32_t path_end = path_index.path_count();
+    if (!target_paths.empty()) {
+        while (path_begin < path_end && target_paths[path_begin] == 0) ++path_begin;
+        while (path_end > path_begin && target_paths[path_end - 1] == 0) --path_end;
+    }
+    std::sort(order.begin(), order.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+        return result.source_nodes[lhs] < result.source_nodes[rhs];
+    });
+    std::vector<PendingHit> pending;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> postings;
+    for (std::size_t i = 0; i < order.size() && path_begin < path_end;) {
+        const auto node_id = result.source_nodes[order[i]];
+        if (node_id == kNoLiftoverNode) break;
+        postings.clear();
+        path_index.for_each_node_posting_in_paths(
+            node_id, path_begin, path_end,
+            [&](std::uint32_t path_id, std::uint32_t step_rank) {
+                if (is_target(path_id)) postings.emplace_back(path_id, step_rank);
+            });
+        result.posting_count += postings.size();
+        for (; i < order.size() && result.source_nodes[order[i]] == node_id; ++i) {
+            const auto index = order[i];
+            for (const auto& [path_id, step_rank] : postings) {
+                if (path_id == positions[index].path_id && step_rank == sources[index].step_rank) {
+                    continue;
+                }
+                pending.push_back(PendingHit{path_id, step_rank, index});
+            }
+        }
+    }
+
+    // Turn target steps into offsets in path then step order.
+    std::sort(pending.begin(), pending.end(), [](const PendingHit& lhs, const PendingHit& rhs) {
+        return std::tie(lhs.path_id, lhs.step_rank, lhs.position_index) <
+               std::tie(rhs.path_id, rhs.step_rank, rhs.position_index);
+    });
+    result.hits.reserve(pending.size());
+    for (const auto& hit : pending) {
+        const auto step = offsets.step_position(hit.path_id, hit.step_rank);
+        const auto& source = sources[hit.position_index];
+        if (step.node_id != result.source_nodes[hit.position_index]) {
+            throw std::runtime_error(".pdx posting does not match the path step it names");
+        }
+        const auto node_offset = step.is_reverse ? step.length - 1 - source.node_offset
+                                                 : source.node_offset;
+        result.hits.push_back(LiftoverHit{hit.position_index,
+                                          hit.path_id,
+                                          step.offset + node_offset,
+                                          step.is_reverse != source.is_reverse});
+    }
+    std::sort(result.hits.begin(), result.hits.end(),
+              [](const LiftoverHit& lhs, const LiftoverHit& rhs) {
+                  return std::tie(lhs.position_index, lhs.path_id, lhs.offset) <
+                         std::tie(rhs.position_index, rhs.path_id, rhs.offset);
+              });
+    return result;
+}
+
+}  // namespace gfaidx::coordinates
@@ -0,0 +1,99 @@
+#ifndef GFAIDX_PATH_LIFTOVER_H
+#define GFAIDX_PATH_LIFTOVER_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "paths/path_index.h"
+#include "paths/path_step_offsets.h"
+
+namespace gfaidx::coordinates {
+
+inline constexpr std::uint32_t kNoLiftoverNode = std::numeric_limits<std::uint32_t>::max();
+
+// A base on one P/W record, as an offset from the record's first step.
+struct PathLocalPosition {
+    std::uint32_t path_id{};
+    std::uint64_t offset{};
+};
+
+// Coordinate namespaces of the .pdx records. A P record belongs to its name
+// without a terminal :start-end suffix, which also supplies its coordinate
+// base; a W record belongs to SampleId#HapIndex#SeqId and starts at SeqStart.
+// Several records of one namespace are coordinate fragments of one sequence.
+// Names are looked up in the .pdx name tables, and each record's namespace and
+// bounds are read the first time a query touches it, so the cost follows the
+// records a query uses rather than the path count. Not thread-safe.
+class PathCoordinateNames {
+public:
+    explicit PathCoordinateNames(const paths::PathIndexReader& path_index)
+        : path_index_(path_index) {}
+
+    // The records addressed by name: one exact .pdx record name (a P name or a
+    // W key), otherwise every record of the namespace name, in path-id order.
+    [[nodiscard]] std::vector<std::uint32_t> find_paths(std::string_view name) const;
+
+    // The record and offset holding coordinate on name. Throw when no record
+    // or more than one fragment covers it.
+    [[nodiscard]] PathLocalPosition resolve(std::string_view name,
+                                            std::uint64_t coordinate) const;
+
+    // The view stays valid for the lifetime of this object.
+    [[nodiscard]] std::string_view namespace_name(std::uint32_t path_id) const {
+        return fragment(path_id).namespace_name;
+    }
+    [[nodiscard]] std::uint64_t coordinate_base(std::uint32_t path_id) const {
+        return fragment(path_id).base;
+    }
+
+private:
+    struct Fragment {
+        std::string namespace_name;
+        std::uint64_t base{};
+        // From the name or W record; max for P records without one.
+        std::uint64_t end{std::numeric_limits<std::uint64_t>::max()};
+    };
+
+    const Fragment& fragment(std::uint32_t path_id) const;
+
+    const paths::PathIndexReader& path_index_;
+    // Node-based, so namespace_name() views survive later insertions.
+    mutable std::unordered_map<std::uint32_t, Fragment> fragments_;
+};
+
+// One place a lifted base occurs on a target record.
+struct LiftoverHit {
+    std::uint32_t position_index{};
+    std::uint32_t path_id{};
+    std::uint64_t offset{};
+    // The target step traverses the node in the other orientation than the
+    // source step.
+    bool is_reverse{};
+};
+
+struct LiftoverResult {
+    // Node under each position, or kNoLiftoverNode past the end of its record.
+    std::vector<std::uint32_t> source_nodes;
+    // Ordered by position index, then target path id and offset.
+    std::vector<LiftoverHit> hits;
+    std::uint64_t posting_count{};
+};
+
+// Lift every position to the same base of its node on each record flagged in
+// target_paths (indexed by path id; empty selects every record). A node
+// visited more than once on a target gives one hit per visit. The source step
+// itself is never reported. Positions are resolved in path then offset order
+// and the hits in target path then step order, so each .pcx block of steps is
+// decoded once per batch.
+LiftoverResult lift_path_positions(const paths::PathIndexReader& path_index,
+                                   paths::PathStepOffsets& offsets,
+                                   const std::vector<PathLocalPosition>& positions,
+                                   const std::vector<std::uint8_t>& target_paths);
+
+}  // namespace gfaidx::coordinates
+
+#endif  // GFAIDX_PATH_LIFTOVER_H
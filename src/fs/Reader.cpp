@@ -10,6 +10,7 @@
  *
  * readLine() returns a string_view valid until the next readLine() call.
  * Long lines (> buffer) are supported via an internal fallback string.
+ * read_line_piece() is the streaming alternative that never builds long_line_.
  *
  * I need to check if I can change the lon_line_ string assembly and not use append
  * Maybe I can just keep adding to the buffer, however, this will introduce other edge cases:
@@ -72,6 +73,7 @@ Reader& Reader::operator=(Reader&& other) noexcept {
     eof_ = other.eof_;
     file_off_ = other.file_off_;
     line_no_ = other.line_no_;
+    in_piece_line_ = other.in_piece_line_;
     long_line_ = std::move(other.long_line_);
     is_gzip_ = other.is_gzip_;
     gzip_eof_ = other.gzip_eof_;
@@ -85,6 +87,7 @@ Reader& Reader::operator=(Reader&& other) noexcept {
     other.eof_ = false;
     other.file_off_ = 0;
     other.line_no_ = 0;
+    other.in_piece_line_ = false;
     other.long_line_.clear();
     other.is_gzip_ = false;
     other.gzip_eof_ = false;
@@ -107,6 +110,7 @@ bool Reader::open(const std::string& path) {
     cur_ = end_ = 0;
     file_off_ = 0;
     line_no_ = 0;
+    in_piece_line_ = false;
     long_line_.clear();
     is_gzip_ = false;
     gzip_eof_ = false;
@@ -447,3 +451,67 @@ std::string_view Reader::read_line_view(bool& ok) {
     ok = read_line(v);
     return v;
 }
+
+bool Reader::read_line_piece(std::string_view& out, bool& line_done) {
+    out = {};
+    line_done = false;
+
+    if (long_ready_) {
+        long_line_.clear();
+        long_ready_ = false;
+    }
+
+    if (fd_ < 0) {
+        last_errno_ = EBADF; return false;
+    }
+    last_errno_ = 0;
+
+    for (;;) {
+        if (cur_ >= end_) {
+            if (!refill()) return false;
+            if (cur_ >= end_ && eof_) {
+                // EOF right after a piece: close the unterminated last line.
+                if (!in_piece_line_) return false;
+                in_piece_line_ = false;
+                line_done = true;
+                ++line_no_;
+                report_progress();
+                return true;
+            }
+        }
+
+        const char* base = buf_.data() + cur_;
+        const std::size_t available = end_ - cur_;
+        const char* nl = static_cast<const char*>(std::memchr(base, '\n', available));
+        if (nl != nullptr || eof_) {
+            const std::size_t len = nl != nullptr ? static_cast<std::size_t>(nl - base) : available;
+            std::size_t out_len = len;
+            if (opt_.strip_cr && out_len > 0 && base[out_len - 1] == '\r') --out_len;
+            out = std::string_view(base, out_len);
+
+            const std::size_t consumed = nl != nullptr ? len + 1 : len;
+            cur_ += consumed;
+            file_off_ += consumed;
+            in_piece_line_ = false;
+            line_done = true;
+            ++line_no_;
+            report_progress();
+            return true;
+        }
+
+        // Hold back a trailing '\r' so it can still be stripped if the next
+        // refill starts with the '\n'.
+        std::size_t len = available;
+        if (opt_.strip_cr && base[len - 1] == '\r') --len;
+        if (len == 0) {
+            if (!refill()) return false;
+            continue;
+        }
+
+        out = std::string_view(base, len);
+        cur_ += len;
+        file_off_ += len;
+        in_piece_line_ = true;
+        return true;
+    }
+}
@@ -10,6 +10,8 @@
  *
  * readLine() returns a string_view valid until the next readLine() call.
  * Long lines (> buffer) are supported via an internal fallback string.
+ * read_line_piece() instead hands out a line in buffer-sized pieces, so
+ * chromosome-scale P/W lines can be parsed without ever being assembled.
  *
  * If the input is gzip-compressed (detected via magic bytes), the reader
  * transparently inflates data into the same buffer and still returns
@@ -65,6 +67,14 @@ public:
     // Convenience overload returning a view.
     std::string_view read_line_view(bool& ok);
 
+    // Reads the next piece of the current line: a view into the buffer up to
+    // the next '\n' or the end of the buffered bytes, valid until the next
+    // read call. line_done is set on the piece that ends the line (the '\n'
+    // and an optional '\r' are excluded). A piece is empty only if it ends
+    // the line. Returns false on EOF before a new line starts (or on error).
+    // read_line() may be mixed in between whole lines.
+    bool read_line_piece(std::string_view& out, bool& line_done);
+
     // 0 if no error, else errno from the last failing syscall.
     [[nodiscard]] int last_error_no() const {
         return last_errno_;
@@ -97,6 +107,7 @@ private:
     int last_errno_ = 0;
     bool assembling_long_ = false;   // are we assembling a long line or not
     bool long_ready_ = false;        // last call returned a view into long_line_; clear on next call
+    bool in_piece_line_ = false;     // read_line_piece() handed out part of a line that has not ended
 
     // Buffer layout:
     // [0 .. end_) valid bytes, cur_ is the current cursor within that.
@@ -0,0 +1,67 @@
+//
+// Streaming tokenizer over one line of a Reader.
+//
+
+#include "line_tokenizer.h"
+
+#include <stdexcept>
+
+void LineTokenizer::start(std::string_view first_piece, bool line_done) {
+    piece_ = first_piece;
+    piece_is_last_ = line_done;
+    exhausted_ = false;
+}
+
+void LineTokenizer::read_piece() {
+    if (reader_ == nullptr || !reader_->read_line_piece(piece_, piece_is_last_)) {
+        throw std::runtime_error("Line ended before its last piece was read");
+    }
+}
+
+bool LineTokenizer::next(std::string_view delims, std::string_view& token, char& terminator) {
+    if (exhausted_) return false;
+
+    bool carrying = false;
+    for (;;) {
+        const std::size_t end = delims.empty() ? std::string_view::npos : piece_.find_first_of(delims);
+        if (end != std::string_view::npos) {
+            terminator = piece_[end];
+            if (carrying) {
+                carry_.append(piece_.data(), end);
+                token = carry_;
+            } else {
+                token = piece_.substr(0, end);
+            }
+            piece_.remove_prefix(end + 1);
+            return true;
+        }
+
+        if (piece_is_last_) {
+            terminator = '\n';
+            if (carrying) {
+                carry_.append(piece_.data(), piece_.size());
+                token = carry_;
+            } else {
+                token = piece_;
+            }
+            piece_ = {};
+            exhausted_ = true;
+            return true;
+        }
+
+        if (!carrying) {
+            carry_.clear();
+            carrying = true;
+        }
+        carry_.append(piece_.data(), piece_.size());
+        read_piece();
+    }
+}
+
+void LineTokenizer::skip_line() {
+    while (!exhausted_ && !piece_is_last_) {
+        read_piece();
+    }
+    piece_ = {};
+    exhausted_ = true;
+}
@@ -0,0 +1,53 @@
+//
+// Streaming tokenizer over one line of a Reader.
+//
+
+#ifndef GFAIDX_LINE_TOKENIZER_H
+#define GFAIDX_LINE_TOKENIZER_H
+
+
+#include <string>
+#include <string_view>
+
+#include "Reader.h"
+
+// Splits one line into delimiter-separated tokens while the line is read in
+// pieces through Reader::read_line_piece(), so lines longer than the read
+// buffer are never assembled in memory. Tokens are views into the reader
+// buffer, or into a carry string when a token straddles two pieces, and stay
+// valid until the next call. Memory is bounded by the longest token.
+class LineTokenizer {
+public:
+    // Without a reader only complete lines can be tokenized (start() with
+    // line_done set), e.g. lines copied into a batch for worker threads.
+    LineTokenizer() = default;
+    explicit LineTokenizer(Reader& reader) : reader_(&reader) {}
+
+    // Start tokenizing a line whose first piece the caller already read. The
+    // piece may also live outside the reader buffer (e.g. a copied prefix);
+    // it must stay valid until the tokenizer moves past it.
+    void start(std::string_view first_piece, bool line_done);
+
+    // Read the next token, which ends at any byte in delims or at the end of
+    // the line. terminator receives that byte, or '\n' at the end of the line.
+    // An empty delims set returns the rest of the line. Returns false once the
+    // whole line has been returned.
+    bool next(std::string_view delims, std::string_view& token, char& terminator);
+
+    // Consume the rest of the line.
+    void skip_line();
+
+    [[nodiscard]] bool line_done() const { return exhausted_; }
+
+private:
+    void read_piece();
+
+    Reader* reader_{nullptr};
+    std::string_view piece_;
+    bool piece_is_last_{true};
+    bool exhausted_{true};
+    std::string carry_;
+};
+
+
+#endif //GFAIDX_LINE_TOKENIZER_H
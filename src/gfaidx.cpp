@@ -5,6 +5,8 @@
 #include "chunk/get_chunk_command.h"
 #include "chunk/get_subgraph_command.h"
 #include "coordinates/coordinate_commands.h"
+#include "coordinates/get_position_command.h"
+#include "coordinates/liftover_command.h"
 #include "indexer/index_gfa_helpers.h"
 #include "indexer/index_gfa_main.h"
 #include "paths/get_path_command.h"
@@ -58,11 +60,32 @@ int main(int argc, char** argv) {
     gfaidx::coordinates::configure_index_coordinates_parser(index_coordinates);
     program.add_subparser(index_coordinates);
 
+    argparse::ArgumentParser index_haplotype_projection("index_haplotype_projection", version);
+    index_haplotype_projection.add_description(
+        "Build per-window haplotype path bounds from existing .cdx and .pdx indexes");
+    gfaidx::coordinates::configure_index_haplotype_projection_parser(index_haplotype_projection);
+    program.add_subparser(index_haplotype_projection);
+
     argparse::ArgumentParser get_region("get_region", version);
     get_region.add_description("Extract a graph neighborhood from a reference-coordinate interval");
     gfaidx::coordinates::configure_get_region_parser(get_region);
     program.add_subparser(get_region);
 
+    argparse::ArgumentParser get_depth("get_depth", version);
+    get_depth.add_description("Summarize path depth over the reference nodes of a coordinate interval");
+    gfaidx::coordinates::configure_get_depth_parser(get_depth);
+    program.add_subparser(get_depth);
+
+    argparse::ArgumentParser liftover("liftover", version);
+    liftover.add_description("Lift path positions to the same bases on other indexed P/W records");
+    gfaidx::coordinates::configure_liftover_parser(liftover);
+    program.add_subparser(liftover);
+
+    argparse::ArgumentParser get_position("get_position", version);
+    get_position.add_description("Print every path position of the given nodes");
+    gfaidx::coordinates::configure_get_position_parser(get_position);
+    program.add_subparser(get_position);
+
     if (argc == 2 && std::string(argv[1]) == "index_gfa") {
         std::cerr << index_gfa;
         return 1;
@@ -99,11 +122,31 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    if (argc == 2 && std::string(argv[1]) == "index_haplotype_projection") {
+        std::cerr << index_haplotype_projection;
+        return 1;
+    }
+
     if (argc == 2 && std::string(argv[1]) == "get_region") {
         std::cerr << get_region;
         return 1;
     }
 
+    if (argc == 2 && std::string(argv[1]) == "get_depth") {
+        std::cerr << get_depth;
+        return 1;
+    }
+
+    if (argc == 2 && std::string(argv[1]) == "liftover") {
+        std::cerr << liftover;
+        return 1;
+    }
+
+    if (argc == 2 && std::string(argv[1]) == "get_position") {
+        std::cerr << get_position;
+        return 1;
+    }
+
     try {
         program.parse_args(argc, argv);
     } catch (const std::exception& err) {
@@ -141,10 +184,26 @@ int main(int argc, char** argv) {
         return gfaidx::coordinates::run_index_coordinates(index_coordinates);
     }
 
+    if (program.is_subcommand_used("index_haplotype_projection")) {
+        return gfaidx::coordinates::run_index_haplotype_projection(index_haplotype_projection);
+    }
+
     if (program.is_subcommand_used("get_region")) {
         return gfaidx::coordinates::run_get_region(get_region);
     }
 
+    if (program.is_subcommand_used("get_depth")) {
+        return gfaidx::coordinates::run_get_depth(get_depth);
+    }
+
+    if (program.is_subcommand_used("liftover")) {
+        return gfaidx::coordinates::run_liftover(liftover);
+    }
+
+    if (program.is_subcommand_used("get_position")) {
+        return gfaidx::coordinates::run_get_position(get_position);
+    }
+
     std::cerr << program;
     return 1;
 }
@@ -90,6 +90,24 @@ void configure_index_gfa_parser(argparse::ArgumentParser& parser) {
       .implicit_value(true)
       .help("skip building the .pdx path index; still write .gz, .idx, .ndx, and .lnx");
 
+    parser.add_argument("--flat_steps").default_value(false)
+      .implicit_value(true)
+      .help("store every path's steps in the .pdx on their own instead of sharing step runs repeated across paths; lowers build memory, grows the .pdx");
+
+    parser.add_argument("--threads").default_value(std::string("1"))
+      .nargs(1)
+      .help("number of P/W parsing and posting merge workers for the .pdx; the output is identical for any value (default: 1)");
+
+    parser.add_argument("--max_memory").default_value(std::string("128M"))
+      .nargs(1)
+      .help("memory for buffered .pdx postings before they spill to sorted runs on disk, with an optional K/M/G suffix (default: 128M)");
+
+    // Sharing step runs keeps a window of recent steps in memory; this bounds
+    // it so path indexing stays within a fixed budget on any graph.
+    parser.add_argument("--step_memory").default_value(std::string("1G"))
+      .nargs(1)
+      .help("memory for the recent steps that shared step runs are matched against, at most 38 bytes per step, with an optional K/M/G suffix; ignored with --flat_steps (default: 1G)");
+
     parser.add_argument("--checkpoint_steps")
       .default_value(std::to_string(
           paths::kDefaultPathCheckpointStride))
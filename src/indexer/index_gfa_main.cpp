@@ -98,6 +98,45 @@ int run_index_gfa(const argparse::ArgumentParser& program) {
         return 1;
     }
 
+    // The shared step history is only allocated for path indexing, but reject
+    // a budget too small to hold one match window before any work starts.
+    const bool flat_steps = program.get<bool>("flat_steps");
+    std::uint64_t step_memory;
+    try {
+        step_memory = utils::parse_byte_size_strict(
+            program.get<std::string>("step_memory"), "--step_memory");
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+    if (step_memory < gfaidx::paths::kMinStepHistoryBytes) {
+        std::cerr << "--step_memory must be at least 64K" << std::endl;
+        return 1;
+    }
+
+    std::uint32_t path_threads;
+    try {
+        path_threads = utils::parse_u32_strict(
+            program.get<std::string>("threads"), "--threads",
+            1, gfaidx::paths::kMaxPathParseThreads);
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+
+    std::uint64_t posting_memory;
+    try {
+        posting_memory = utils::parse_byte_size_strict(
+            program.get<std::string>("max_memory"), "--max_memory");
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+    if (posting_memory < gfaidx::paths::kMinPostingMemoryBytes) {
+        std::cerr << "--max_memory must be at least 64K" << std::endl;
+        return 1;
+    }
+
     bool keep_tmp = program.get<bool>("keep_tmp");
 
     // check progress_every user input
@@ -380,30 +419,26 @@ int run_index_gfa(const argparse::ArgumentParser& program) {
             // index_gfa run now produces the full graph + path query stack.
             std::cout << get_time() << ": Building path index " << path_index_path << std::endl;
             // Point the path builder at the staged .ndx so every staged artifact stays internally consistent.
+            // The finished .lnx lets it accumulate the .pcx checkpoints while
+            // it writes the steps, instead of rescanning the .pdx afterwards.
+            gfaidx::paths::PathCheckpointOutput checkpoint_output;
+            checkpoint_output.node_length_index_path = staged_node_length_index_path;
+            checkpoint_output.output_path = staged_path_checkpoint_index_path;
+            checkpoint_output.checkpoint_stride = checkpoint_steps;
             gfaidx::paths::build_path_index(input_gfa,
                                             staged_path_index_path,
                                             staged_node_index_path,
                                             reader_options,
                                             tmp_dir,
-                                            keep_tmp);
-            std::cout << get_time() << ": Finished path index in " << timer.elapsed() << " seconds" << std::endl;
-            log_memory("After path index");
-
-            timer.reset();
-            // Build the small optional acceleration sidecar after both rank-
-            // aligned source indexes are complete.
-            std::cout << get_time()
-                      << ": Building path coordinate checkpoint index "
-                      << path_checkpoint_index_path << std::endl;
-            gfaidx::paths::build_path_coordinate_checkpoint_index(
-                staged_path_index_path,
-                staged_node_length_index_path,
-                staged_path_checkpoint_index_path,
-                checkpoint_steps);
-            std::cout << get_time()
-                      << ": Finished path coordinate checkpoint index in "
+                                            keep_tmp,
+                                            !flat_steps,
+                                            path_threads,
+                                            posting_memory,
+                                            &checkpoint_output,
+                                            step_memory);
+            std::cout << get_time() << ": Finished path index and path coordinate checkpoint index in "
                       << timer.elapsed() << " seconds" << std::endl;
-            log_memory("After path coordinate checkpoint index");
+            log_memory("After path index");
         }
 
         std::cout << get_time() << ": Publishing final output files" << std::endl;
@@ -149,23 +149,36 @@ NodeHashIndex::~NodeHashIndex() {
     }
 }
 
-bool NodeHashIndex::lookup_rank(std::string_view node_id, std::uint32_t& out_rank) const {
-    // Binary search lookup through the on-disk hash table. The returned rank is
-    // the sorted entry position inside the .ndx file; path indexing can reuse
-    // that stable rank as a compact node id without building another on-disk
-    // name->id side index.
-    const std::uint64_t query_hash = fnv1a_hash64(node_id);
-    const std::uint32_t query_hash32 = fnv1a_hash32(node_id);
-
+bool NodeHashIndex::find_rank(std::uint64_t query_hash,
+                              std::uint32_t query_hash32,
+                              std::uint32_t& out_rank,
+                              bool& hash64_seen) const {
+    // FNV-1a hashes are close to uniform, so interpolating between the range
+    // ends usually lands within a few entries of the target. A few rounds of
+    // interpolation shrink the range, and bisection finishes it so skewed
+    // inputs still cost O(log n) probes.
+    constexpr int kInterpolationRounds = 3;
+    hash64_seen = false;
     std::size_t low_val = 0;
     std::size_t high_val = n_entries_;
-    while (low_val < high_val) {
-        const std::size_t mid_val = low_val + (high_val - low_val) / 2;
+    for (int round = 0; low_val < high_val; ++round) {
+        std::size_t mid_val = low_val + (high_val - low_val) / 2;
+        if (round < kInterpolationRounds && high_val - low_val > 2) {
+            const std::uint64_t low_hash = data_[low_val].hash;
+            const std::uint64_t high_hash = data_[high_val - 1].hash;
+            if (query_hash < low_hash || query_hash > high_hash) return false;
+            if (high_hash != low_hash) {
+                const auto offset = static_cast<unsigned __int128>(query_hash - low_hash) *
+                                    (high_val - 1 - low_val) / (high_hash - low_hash);
+                mid_val = low_val + static_cast<std::size_t>(offset);
+            }
+        }
         const std::uint64_t mid_val_hash = data_[mid_val].hash;
 
         if (mid_val_hash < query_hash) low_val = mid_val + 1;
         else if (mid_val_hash > query_hash) high_val = mid_val;
         else {
+            hash64_seen = true;
             // Walk left to the first matching hash, then scan right to resolve collisions.
             std::size_t left = mid_val;
             while (left > 0 && data_[left - 1].hash == query_hash) {
@@ -180,18 +193,43 @@ bool NodeHashIndex::lookup_rank(std::string_view node_id, std::uint32_t& out_ran
                     return true;
                 }
             }
-            // Log failed collision resolution so the temporary get_subgraph
-            // trace can distinguish a true miss from a later rank corruption.
-            if (gfaidx::debug::subgraph_trace_enabled()) {
-                std::ostringstream oss;
-                oss << "lookup_rank miss after hash64 match for node '" << node_id
-                    << "' hash64=" << query_hash
-                    << " hash32=" << query_hash32;
-                gfaidx::debug::log_subgraph_trace(oss.str());
-            }
             return false;
         }
     }
+    return false;
+}
+
+bool NodeHashIndex::lookup_rank_hashed(std::uint64_t hash,
+                                       std::uint32_t hash32,
+                                       std::uint32_t& out_rank) const {
+    bool hash64_seen = false;
+    return find_rank(hash, hash32, out_rank, hash64_seen);
+}
+
+bool NodeHashIndex::lookup_rank(std::string_view node_id, std::uint32_t& out_rank) const {
+    // Search the on-disk hash table. The returned rank is the sorted entry
+    // position inside the .ndx file; path indexing can reuse that stable rank
+    // as a compact node id without building another on-disk name->id side
+    // index.
+    const std::uint64_t query_hash = fnv1a_hash64(node_id);
+    const std::uint32_t query_hash32 = fnv1a_hash32(node_id);
+
+    bool hash64_seen = false;
+    if (find_rank(query_hash, query_hash32, out_rank, hash64_seen)) {
+        return true;
+    }
+    if (hash64_seen) {
+        // Log failed collision resolution so the temporary get_subgraph
+        // trace can distinguish a true miss from a later rank corruption.
+        if (gfaidx::debug::subgraph_trace_enabled()) {
+            std::ostringstream oss;
+            oss << "lookup_rank miss after hash64 match for node '" << node_id
+                << "' hash64=" << query_hash
+                << " hash32=" << query_hash32;
+            gfaidx::debug::log_subgraph_trace(oss.str());
+        }
+        return false;
+    }
     // Log the full miss path once when the query hash never appears in .ndx.
     if (gfaidx::debug::subgraph_trace_enabled()) {
         std::ostringstream oss;
@@ -37,11 +37,21 @@ public:
     [[nodiscard]] std::uint64_t size() const;
     bool lookup(std::string_view node_id, std::uint32_t& out_com) const;
     bool lookup_rank(std::string_view node_id, std::uint32_t& out_rank) const;
+    // lookup_rank() for callers that already hashed the node id with
+    // fnv1a_hash64/fnv1a_hash32, e.g. to key a cache of their own.
+    bool lookup_rank_hashed(std::uint64_t hash, std::uint32_t hash32, std::uint32_t& out_rank) const;
     // When .pdx node IDs are aligned to .ndx entry rank, this gives direct
     // rank->community access without rebuilding a separate in-memory map.
     [[nodiscard]] std::uint32_t community_id_by_rank(std::uint32_t rank) const;
 
 private:
+    // Search for the entry with both hashes; hash64_seen reports whether the
+    // 64-bit hash was present at all.
+    bool find_rank(std::uint64_t hash,
+                   std::uint32_t hash32,
+                   std::uint32_t& out_rank,
+                   bool& hash64_seen) const;
+
     // The node hash index is mmap-backed and only supported on Unix-like
     // systems. gfaidx does not target Windows builds.
     int fd_ = -1;
@@ -12,6 +12,12 @@
 
 namespace gfaidx::paths {
 
+namespace {
+
+constexpr std::uint32_t kMaxCheckpointThreads = 256;
+
+}  // namespace
+
 void configure_index_path_checkpoints_parser(
     argparse::ArgumentParser& parser) {
     parser.add_argument("in_gfa")
@@ -43,6 +49,11 @@ void configure_index_path_checkpoints_parser(
           std::to_string(kDefaultPathCheckpointProgressEvery))
       .nargs(1)
       .help("report progress every N completed paths; 0 disables periodic progress");
+
+    parser.add_argument("--threads")
+      .default_value(std::string("1"))
+      .nargs(1)
+      .help("number of path scan workers; the .pcx is identical for any value (default: 1)");
 }
 
 int run_index_path_checkpoints(
@@ -84,6 +95,8 @@ int run_index_path_checkpoints(
         const auto progress_every_paths = utils::parse_u64_strict(
             program.get<std::string>("progress_every_paths"),
             "--progress_every_paths");
+        const auto threads = utils::parse_u32_strict(
+            program.get<std::string>("threads"), "--threads", 1, kMaxCheckpointThreads);
 
         Timer timer;
         std::cout << "Building path coordinate checkpoints "
@@ -93,7 +106,8 @@ int run_index_path_checkpoints(
                                                length_index,
                                                output_index,
                                                stride,
-                                               progress_every_paths);
+                                               progress_every_paths,
+                                               threads);
 
         // Reopen the completed sidecar to validate its header and report the
         // number of checkpoint values actually published.
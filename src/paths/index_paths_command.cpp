@@ -1,5 +1,6 @@
 #include "paths/index_paths_command.h"
 
+#include <cstdint>
 #include <iostream>
 #include <stdexcept>
 #include <string>
@@ -29,6 +30,26 @@ void configure_index_paths_parser(argparse::ArgumentParser& parser) {
     parser.add_argument("--progress_every").default_value(std::string("1000000"))
       .nargs(1)
       .help("print progress every N lines while reading (default: 1000000), give 0 to disable");
+
+    parser.add_argument("--flat_steps")
+      .default_value(false)
+      .implicit_value(true)
+      .help("store every path's steps on their own instead of sharing step runs repeated across paths; lowers build memory, grows the .pdx");
+
+    parser.add_argument("--step_memory")
+      .default_value(std::string("1G"))
+      .nargs(1)
+      .help("memory for the recent steps that shared step runs are matched against, at most 38 bytes per step, with an optional K/M/G suffix; ignored with --flat_steps (default: 1G)");
+
+    parser.add_argument("--threads")
+      .default_value(std::string("1"))
+      .nargs(1)
+      .help("number of P/W parsing and posting merge workers; the .pdx is identical for any value (default: 1)");
+
+    parser.add_argument("--max_memory")
+      .default_value(std::string("128M"))
+      .nargs(1)
+      .help("memory for buffered postings before they spill to sorted runs on disk, with an optional K/M/G suffix (default: 128M)");
 }
 
 int run_index_paths(const argparse::ArgumentParser& program) {
@@ -36,6 +57,7 @@ int run_index_paths(const argparse::ArgumentParser& program) {
     const auto out_index = program.get<std::string>("out_index");
     auto node_index = program.get<std::string>("ndx");
     const auto tmp_dir = program.get<std::string>("tmp_dir");
+    const bool flat_steps = program.get<bool>("flat_steps");
 
     if (!file_exists(input_gfa.c_str())) {
         std::cerr << "Input file does not exist: " << input_gfa << std::endl;
@@ -72,7 +94,20 @@ int run_index_paths(const argparse::ArgumentParser& program) {
     }
 
     try {
-        build_path_index(input_gfa, out_index, node_index, reader_options, tmp_dir, false);
+        const auto threads = utils::parse_u32_strict(
+            program.get<std::string>("threads"), "--threads", 1, kMaxPathParseThreads);
+        const auto posting_memory = utils::parse_byte_size_strict(
+            program.get<std::string>("max_memory"), "--max_memory");
+        if (posting_memory < kMinPostingMemoryBytes) {
+            throw std::runtime_error("--max_memory must be at least 64K");
+        }
+        const auto step_memory = utils::parse_byte_size_strict(
+            program.get<std::string>("step_memory"), "--step_memory");
+        if (step_memory < kMinStepHistoryBytes) {
+            throw std::runtime_error("--step_memory must be at least 64K");
+        }
+        build_path_index(input_gfa, out_index, node_index, reader_options, tmp_dir, false,
+                         !flat_steps, threads, posting_memory, nullptr, step_memory);
     } catch (const std::exception& err) {
         std::cerr << err.what() << std::endl;
         return 1;
@@ -0,0 +1,126 @@
+#include "paths/node_positions.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+#include "paths/path_step_offsets.h"
+#include "utils/parallel_tasks.h"
+
+namespace gfaidx::paths {
+namespace {
+
+// Visits are resolved in chunks of at least this many, each with its own
+// block cache. A chunk only ends where the block changes, so every block is
+// decoded by one chunk. Without .pcx a chunk starting inside a path would sum
+// the path's earlier blocks again, so chunks then end only between paths.
+constexpr std::size_t kPositionChunk = 1U << 14;
+
+}  // namespace
+
+std::vector<NodePosition> find_node_positions(const PathIndexReader& path_index,
+                                              const indexer::NodeLengthIndexReader& lengths,
+                                              const PathCoordinateCheckpointIndexReader* checkpoints,
+                                              const std::vector<std::uint32_t>& node_ids,
+                                              std::uint32_t path_begin,
+                                              std::uint32_t path_end,
+                                              unsigned threads) {
+    if (node_ids.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Too many nodes in one position query");
+    }
+    if (lengths.node_count() != path_index.node_count()) {
+        throw std::runtime_error(".lnx and .pdx node counts differ; rebuild them against the same .ndx");
+    }
+    path_end = std::min(path_end, path_index.path_count());
+
+    // Postings come out in path then step order for each node.
+    std::vector<std::vector<NodePosition>> node_visits(node_ids.size());
+    utils::run_parallel_tasks(node_ids.size(), threads, [&](std::size_t i) {
+        if (node_ids[i] >= path_index.node_count()) {
+            throw std::runtime_error("Node rank is outside the .pdx node table");
+        }
+        if (path_begin >= path_end) return;
+        path_index.for_each_node_posting_in_paths(
+            node_ids[i], path_begin, path_end,
+            [&](std::uint32_t path_id, std::uint32_t step_rank) {
+                node_visits[i].push_back(NodePosition{
+                    static_cast<std::uint32_t>(i), path_id, step_rank, 0, false});
+            });
+    });
+    std::size_t visit_count = 0;
+    for (const auto& visits : node_visits) visit_count += visits.size();
+    std::vector<NodePosition> positions;
+    positions.reserve(visit_count);
+    for (auto& visits : node_visits) {
+        positions.insert(positions.end(), visits.begin(), visits.end());
+        std::vector<NodePosition>().swap(visits);
+    }
+
+    std::vector<std::size_t> order(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
+        return std::tie(positions[lhs].path_id, positions[lhs].step_rank, lhs) <
+               std::tie(positions[rhs].path_id, positions[rhs].step_rank, rhs);
+    });
+    const auto block_steps = checkpoints != nullptr
+        ? PathStepOffsets::block_step_count(checkpoints)
+        : std::numeric_limits<std::uint64_t>::max();
+    std::vector<std::size_t> chunk_ends;
+    std::size_t chunk_begin = 0;
+    for (std::size_t k = 1; k < order.size(); ++k) {
+        if (k - chunk_begin < kPositionChunk) continue;
+        const auto& previous = positions[order[k - 1]];
+        const auto& current = positions[order[k]];
+        if (current.path_id != previous.path_id ||
+            current.step_rank / block_steps != previous.step_rank / block_steps) {
+            chunk_ends.push_back(k);
+            chunk_begin = k;
+        }
+    }
+    if (!order.empty()) chunk_ends.push_back(order.size());
+    utils::run_parallel_tasks(chunk_ends.size(), threads, [&](std::size_t chunk) {
+        PathStepOffsets offsets(path_index, lengths, checkpoints);
+        const auto begin = chunk == 0 ? 0 : chunk_ends[chunk - 1];
+        for (auto k = begin; k < chunk_ends[chunk]; ++k) {
+            auto& position = positions[order[k]];
+            const auto step = offsets.step_position(position.path_id, position.step_rank);
+            if (step.node_id != node_ids[position.node_index]) {
+                throw std::runtime_error(".pdx posting does not match the path step it names");
+            }
+            position.offset = step.offset;
+            position.is_reverse = step.is_reverse;
+        }
+    });
+    return positions;
+}
+
+std::vector<std::uint64_t> count_node_visits(const PathIndexReader& path_index,
+                                             const std::vector<std::uint32_t>& node_ids,
+                                             bool distinct_paths,
+                                             unsigned threads) {
+    std::vector<std::uint64_t> counts(node_ids.size());
+    utils::run_parallel_tasks(node_ids.size(), distinct_paths ? threads : 1, [&](std::size_t i) {
+        if (node_ids[i] >= path_index.node_count()) {
+            throw std::runtime_error("Node rank is outside the .pdx node table");
+        }
+        if (!distinct_paths) {
+            counts[i] = path_index.node_posting_count(node_ids[i]);
+            return;
+        }
+        // Postings are in path-id order, so each path is one run.
+        std::uint64_t count = 0;
+        std::uint32_t last_path = std::numeric_limits<std::uint32_t>::max();
+        path_index.for_each_node_posting(node_ids[i], [&](std::uint32_t path_id, std::uint32_t) {
+            if (path_id != last_path) {
+                ++count;
+                last_path = path_id;
+            }
+        });
+        counts[i] = count;
+    });
+    return counts;
+}
+
+}  // namespace gfaidx::paths
@@ -0,0 +1,49 @@
+#ifndef GFAIDX_NODE_POSITIONS_H
+#define GFAIDX_NODE_POSITIONS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "indexer/node_length_index.h"
+#include "paths/path_coordinate_checkpoints.h"
+#include "paths/path_index.h"
+
+namespace gfaidx::paths {
+
+// One visit of a queried node: node_index is the node's position in the
+// query, offset the path-local base offset of the visiting step.
+struct NodePosition {
+    std::uint32_t node_index{};
+    std::uint32_t path_id{};
+    std::uint32_t step_rank{};
+    std::uint64_t offset{};
+    bool is_reverse{};
+};
+
+// Find every visit of node_ids on the paths in [path_begin, path_end) and its
+// path-local offset. Postings are decoded per node; the visits are then
+// turned into offsets in path then step order through PathStepOffsets, in
+// chunks split only where a block or, without .pcx, a path ends, so each block
+// of steps is decoded once. Both phases run on up to threads workers. The
+// result is ordered by node index, path id and step, independently of the
+// thread count.
+std::vector<NodePosition> find_node_positions(const PathIndexReader& path_index,
+                                              const indexer::NodeLengthIndexReader& lengths,
+                                              const PathCoordinateCheckpointIndexReader* checkpoints,
+                                              const std::vector<std::uint32_t>& node_ids,
+                                              std::uint32_t path_begin,
+                                              std::uint32_t path_end,
+                                              unsigned threads = 1);
+
+// Count the visits of each of node_ids across all paths, or with
+// distinct_paths the paths that visit it at least once. Plain counts come
+// straight from the .pdx node table; only distinct_paths decodes postings, on
+// up to threads workers.
+std::vector<std::uint64_t> count_node_visits(const PathIndexReader& path_index,
+                                             const std::vector<std::uint32_t>& node_ids,
+                                             bool distinct_paths,
+                                             unsigned threads = 1);
+
+}  // namespace gfaidx::paths
+
+#endif  // GFAIDX_NODE_POSITIONS_H
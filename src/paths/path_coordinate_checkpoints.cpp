@@ -1,11 +1,13 @@
 #include "paths/path_coordinate_checkpoints.h"
 
+#include <algorithm>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -20,6 +22,7 @@
 #include "indexer/node_length_index.h"
 #include "paths/path_index.h"
 #include "utils/Timer.h"
+#include "utils/parallel_tasks.h"
 
 namespace gfaidx::paths {
 namespace {
@@ -28,6 +31,9 @@ constexpr char kCheckpointMagic[8] =
     {'G', 'F', 'A', 'P', 'C', 'X', '0', '1'};
 constexpr std::uint32_t kCheckpointVersion = 1;
 
+// Parallel builds split paths into scan tasks of about this many steps.
+constexpr std::uint64_t kCheckpointTaskSteps = 1ULL << 22;
+
 // The header records enough information to reject a sidecar paired with a
 // different .pdx even when the filenames happen to look compatible.
 struct CheckpointHeaderDisk {
@@ -57,48 +63,6 @@ static_assert(sizeof(CheckpointHeaderDisk) == 80,
 static_assert(sizeof(CheckpointPathRecordDisk) == 24,
               "Unexpected path checkpoint record size");
 
-constexpr std::uint64_t kFnvOffset = 1469598103934665603ULL;
-constexpr std::uint64_t kFnvPrime = 1099511628211ULL;
-
-void hash_bytes(std::uint64_t& hash, const void* data, std::size_t size) {
-    const auto* bytes = static_cast<const unsigned char*>(data);
-    for (std::size_t i = 0; i < size; ++i) {
-        hash ^= bytes[i];
-        hash *= kFnvPrime;
-    }
-}
-
-void hash_string(std::uint64_t& hash, std::string_view value) {
-    const auto size = static_cast<std::uint64_t>(value.size());
-    hash_bytes(hash, &size, sizeof(size));
-    hash_bytes(hash, value.data(), value.size());
-}
-
-// Hash path metadata that is cheap to validate at query time. Step contents are
-// not hashed because rereading the full step table would defeat the checkpoint.
-std::uint64_t path_layout_hash(const PathIndexReader& index) {
-    std::uint64_t hash = kFnvOffset;
-    const auto path_count = index.path_count();
-    const auto node_count = index.node_count();
-    const auto total_steps = index.total_step_count();
-    hash_bytes(hash, &path_count, sizeof(path_count));
-    hash_bytes(hash, &node_count, sizeof(node_count));
-    hash_bytes(hash, &total_steps, sizeof(total_steps));
-
-    for (std::uint32_t path_id = 0; path_id < path_count; ++path_id) {
-        const auto info = index.get_path_info(path_id);
-        hash_bytes(hash, &info.record_type, sizeof(info.record_type));
-        hash_bytes(hash, &info.step_count, sizeof(info.step_count));
-        hash_bytes(hash, &info.hap_index, sizeof(info.hap_index));
-        hash_bytes(hash, &info.seq_start, sizeof(info.seq_start));
-        hash_bytes(hash, &info.seq_end, sizeof(info.seq_end));
-        hash_string(hash, info.name);
-        hash_string(hash, info.sample_id);
-        hash_string(hash, info.seq_id);
-    }
-    return hash;
-}
-
 std::uint64_t checked_add(std::uint64_t lhs,
                           std::uint64_t rhs,
                           std::string_view context) {
@@ -131,6 +95,101 @@ void write_or_throw(std::ofstream& out,
     }
 }
 
+// One scan task covers a step range of one path that starts on a checkpoint
+// boundary. Long paths are split so that one chromosome-scale path does not
+// leave the other threads idle.
+struct CheckpointScanTask {
+    std::uint32_t path_id{};
+    std::uint64_t step_begin{};
+    std::uint64_t step_end{};
+    std::uint64_t checkpoint_begin{};
+    std::uint64_t length{};
+};
+
+// Writable mapping of a file created at its final size, so scan tasks can
+// store their checkpoints at precomputed positions from any thread.
+class MappedOutputFile {
+public:
+    MappedOutputFile(const std::string& path, std::uint64_t size)
+        : path_(path), size_(static_cast<std::size_t>(size)) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ == -1) {
+            throw std::runtime_error(
+                "Failed to open path checkpoint output: " + path);
+        }
+        if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            close_file();
+            throw std::runtime_error(
+                "Failed to resize path checkpoint output: " + path);
+        }
+        void* mapped = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd_, 0);
+        if (mapped == MAP_FAILED) {
+            close_file();
+            throw std::runtime_error(
+                "mmap failed for path checkpoint output: " + path);
+        }
+        data_ = static_cast<unsigned char*>(mapped);
+    }
+
+    ~MappedOutputFile() {
+        if (data_) munmap(data_, size_);
+        close_file();
+    }
+
+    MappedOutputFile(const MappedOutputFile&) = delete;
+    MappedOutputFile& operator=(const MappedOutputFile&) = delete;
+
+    [[nodiscard]] unsigned char* data() const { return data_; }
+
+    void close() {
+        const bool unmapped = munmap(data_, size_) == 0;
+        data_ = nullptr;
+        const bool closed = ::close(fd_) == 0;
+        fd_ = -1;
+        if (!unmapped || !closed) {
+            throw std::runtime_error(
+                "Failed while closing path checkpoint index: " + path_);
+        }
+    }
+
+private:
+    void close_file() {
+        if (fd_ != -1) ::close(fd_);
+        fd_ = -1;
+    }
+
+    std::string path_;
+    std::size_t size_{0};
+    int fd_{-1};
+    unsigned char* data_{nullptr};
+};
+
+// Fill in everything except checkpoint_count, which the builders only know
+// once every path has been scanned.
+CheckpointHeaderDisk make_checkpoint_header(const PathIndexReader& path_index,
+                                            std::uint64_t checkpoint_stride) {
+    CheckpointHeaderDisk header{};
+    std::memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+    header.version = kCheckpointVersion;
+    header.path_count = path_index.path_count();
+    header.node_count = path_index.node_count();
+    header.total_step_count = path_index.total_step_count();
+    header.checkpoint_stride = checkpoint_stride;
+    header.path_layout_hash = path_index.path_layout_hash();
+    header.path_table_offset = sizeof(CheckpointHeaderDisk);
+
+    const auto path_table_bytes = checked_multiply(
+        header.path_count,
+        sizeof(CheckpointPathRecordDisk),
+        "Path checkpoint table size");
+    header.checkpoint_table_offset =
+        checked_add(header.path_table_offset,
+                    path_table_bytes,
+                    "Path checkpoint table offset");
+    return header;
+}
+
 const CheckpointHeaderDisk& mapped_header(const void* header) {
     return *static_cast<const CheckpointHeaderDisk*>(header);
 }
@@ -146,7 +205,8 @@ void build_path_coordinate_checkpoint_index(
     const std::string& node_length_index_path,
     const std::string& output_path,
     std::uint64_t checkpoint_stride,
-    std::uint64_t progress_every_paths) {
+    std::uint64_t progress_every_paths,
+    unsigned threads) {
 
     if (checkpoint_stride == 0) {
         throw std::runtime_error(
@@ -164,9 +224,9 @@ void build_path_coordinate_checkpoint_index(
             ".pdx and .lnx node counts differ; rebuild aligned indexes");
     }
 
-    // Keep the growing output in a visible run directory beside the final
-    // sidecar. If the process is interrupted, users can find that directory
-    // through latest_path_checkpoints instead of accumulating hidden files.
+    // Keep the output in a visible run directory beside the final sidecar.
+    // If the process is interrupted, users can find that directory through
+    // latest_path_checkpoints instead of accumulating hidden files.
     const std::filesystem::path output_target(output_path);
     const auto output_parent = output_target.has_parent_path()
         ? output_target.parent_path()
@@ -188,41 +248,71 @@ void build_path_coordinate_checkpoint_index(
 
     try {
         Timer progress_timer;
-        CheckpointHeaderDisk header{};
-        std::memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
-        header.version = kCheckpointVersion;
-        header.path_count = path_index.path_count();
-        header.node_count = path_index.node_count();
-        header.total_step_count = path_index.total_step_count();
-        header.checkpoint_stride = checkpoint_stride;
-        header.path_layout_hash = path_layout_hash(path_index);
-        header.path_table_offset = sizeof(CheckpointHeaderDisk);
-
-        const auto path_table_bytes = checked_multiply(
-            header.path_count,
-            sizeof(CheckpointPathRecordDisk),
-            "Path checkpoint table size");
-        header.checkpoint_table_offset =
-            checked_add(header.path_table_offset,
-                        path_table_bytes,
-                        "Path checkpoint table offset");
+        auto header = make_checkpoint_header(path_index, checkpoint_stride);
 
+        // Every path's checkpoint count follows from its step count, so each
+        // path's slice of the checkpoint table is known before any step is
+        // read. Long paths are split into scan tasks on checkpoint boundaries.
+        const std::uint64_t task_steps = std::max<std::uint64_t>(
+            1, kCheckpointTaskSteps / checkpoint_stride) * checkpoint_stride;
         std::vector<CheckpointPathRecordDisk> path_records(
             static_cast<std::size_t>(header.path_count));
-        std::ofstream out(staged_output,
-                          std::ios::binary | std::ios::trunc);
-        if (!out) {
+        std::vector<CheckpointScanTask> tasks;
+        std::uint64_t total_steps = 0;
+        std::uint64_t total_checkpoints = 0;
+        for (std::uint32_t path_id = 0;
+             path_id < path_index.path_count();
+             ++path_id) {
+            auto& record = path_records[path_id];
+            record.step_count = path_index.get_path_info(path_id).step_count;
+            record.checkpoint_begin = total_checkpoints;
+            // Every path stores checkpoint zero, including an empty path.
+            record.checkpoint_count = 1 + record.step_count / checkpoint_stride;
+            total_checkpoints = checked_add(total_checkpoints,
+                                            record.checkpoint_count,
+                                            "Path checkpoint count");
+            total_steps = checked_add(total_steps,
+                                      record.step_count,
+                                      "Total path step count");
+            for (std::uint64_t begin = 0; begin < record.step_count;
+                 begin += task_steps) {
+                CheckpointScanTask task;
+                task.path_id = path_id;
+                task.step_begin = begin;
+                task.step_end = std::min(record.step_count, begin + task_steps);
+                task.checkpoint_begin =
+                    record.checkpoint_begin + begin / checkpoint_stride + 1;
+                tasks.push_back(task);
+            }
+        }
+        if (total_steps != header.total_step_count) {
             throw std::runtime_error(
-                "Failed to open path checkpoint output: " + staged_output);
+                ".pdx path metadata does not sum to its header step count");
         }
+        header.checkpoint_count = total_checkpoints;
+
+        const auto file_size = checked_add(
+            header.checkpoint_table_offset,
+            checked_multiply(total_checkpoints,
+                             sizeof(std::uint64_t),
+                             "Path checkpoint table size"),
+            "Path checkpoint file size");
+        MappedOutputFile out(staged_output, file_size);
+        auto* checkpoints = reinterpret_cast<std::uint64_t*>(
+            out.data() + header.checkpoint_table_offset);
+
+        const std::size_t worker_count = std::max<std::size_t>(
+            1, std::min<std::size_t>(threads, tasks.size()));
         std::cout << get_time()
-                  << ": Streaming path checkpoints to temporary file "
+                  << ": Writing path checkpoints to temporary file "
                   << staged_output << std::endl;
         std::cout << get_time() << ": Latest checkpoint temp directory: "
                   << latest_path << std::endl;
         std::cout << get_time() << ": Checkpoint scan covers "
                   << header.path_count << " paths and "
-                  << header.total_step_count << " path steps";
+                  << header.total_step_count << " path steps in "
+                  << tasks.size() << " tasks on " << worker_count
+                  << " thread(s)";
         if (progress_every_paths == 0) {
             std::cout << "; periodic progress is disabled" << std::endl;
         } else {
@@ -230,47 +320,29 @@ void build_path_coordinate_checkpoint_index(
                       << " completed path(s)" << std::endl;
         }
 
-        // Reserve the fixed tables first. They are rewritten after checkpoint
-        // counts and offsets become known during the streaming path scan.
-        write_or_throw(out, &header, sizeof(header),
-                       "path checkpoint header");
-        if (!path_records.empty()) {
-            write_or_throw(out,
-                           path_records.data(),
-                           path_records.size() *
-                               sizeof(CheckpointPathRecordDisk),
-                           "path checkpoint metadata");
+        // Count each path's outstanding tasks so progress can report whole
+        // paths; empty paths have no task and are complete from the start.
+        std::vector<std::uint32_t> tasks_left(path_records.size(), 0);
+        for (const auto& task : tasks) ++tasks_left[task.path_id];
+        std::uint64_t completed_paths = 0;
+        for (const auto& record : path_records) {
+            if (record.step_count == 0) ++completed_paths;
         }
+        std::uint64_t completed_steps = 0;
+        std::mutex progress_mutex;
 
-        std::uint64_t total_steps_seen = 0;
-        std::uint64_t total_checkpoints = 0;
-        for (std::uint32_t path_id = 0;
-             path_id < path_index.path_count();
-             ++path_id) {
-            const auto info = path_index.get_path_info(path_id);
-            if (progress_every_paths != 0 && path_id == 0) {
-                // Announce the first path before scanning it so one unusually
-                // long first record does not look like a stalled process.
-                std::cout << get_time() << ": Starting checkpoint path "
-                          << (static_cast<std::uint64_t>(path_id) + 1)
-                          << "/" << header.path_count << " ("
-                          << info.step_count << " steps)" << std::endl;
-            }
-            auto& record = path_records[path_id];
-            record.step_count = info.step_count;
-            record.checkpoint_begin = total_checkpoints;
+        // Each task writes checkpoint sums relative to its first step into
+        // its own slice of the mapped table, and keeps its total length so
+        // the slices can be shifted by the preceding tasks afterwards.
+        utils::run_parallel_tasks(tasks.size(), worker_count, [&](std::size_t task_index) {
+            auto& task = tasks[task_index];
 
-            // Every path stores checkpoint zero, including an empty path.
             std::uint64_t cumulative = 0;
-            write_or_throw(out, &cumulative, sizeof(cumulative),
-                           "path checkpoint value");
-            record.checkpoint_count = 1;
-            ++total_checkpoints;
-
+            std::uint64_t checkpoint = task.checkpoint_begin;
             path_index.for_each_step(
-                path_id,
-                0,
-                info.step_count,
+                task.path_id,
+                task.step_begin,
+                task.step_end - task.step_begin,
                 [&](const StepRecord& step, std::uint64_t step_rank) {
                     if (step.node_id >= lengths.node_count()) {
                         throw std::runtime_error(
@@ -280,85 +352,69 @@ void build_path_coordinate_checkpoint_index(
                         cumulative,
                         lengths.length(step.node_id),
                         "Path cumulative coordinate");
-
-                    const auto next_step = step_rank + 1;
-                    if (next_step % checkpoint_stride == 0) {
-                        write_or_throw(out,
-                                       &cumulative,
-                                       sizeof(cumulative),
-                                       "path checkpoint value");
-                        ++record.checkpoint_count;
-                        ++total_checkpoints;
+                    if ((step_rank + 1) % checkpoint_stride == 0) {
+                        checkpoints[checkpoint++] = cumulative;
                     }
                 });
-            total_steps_seen = checked_add(total_steps_seen,
-                                           info.step_count,
-                                           "Total path step count");
-
-            const auto completed_paths =
-                static_cast<std::uint64_t>(path_id) + 1;
-            if (progress_every_paths != 0 &&
-                (completed_paths % progress_every_paths == 0 ||
-                 completed_paths == header.path_count)) {
-                // Flushing at reporting boundaries makes staged-file growth
-                // visible to filesystem tools and detects write errors early.
-                out.flush();
-                if (!out) {
-                    throw std::runtime_error(
-                        "Failed while flushing path checkpoint output");
-                }
-                const double percent = header.total_step_count == 0
-                    ? 100.0
-                    : 100.0 * static_cast<double>(total_steps_seen) /
-                          static_cast<double>(header.total_step_count);
-                std::cout << get_time() << ": Processed "
-                          << completed_paths << "/" << header.path_count
-                          << " paths, " << total_steps_seen << "/"
-                          << header.total_step_count << " steps ("
-                          << std::fixed << std::setprecision(1) << percent
-                          << "%), wrote " << total_checkpoints
-                          << " checkpoints in " << std::defaultfloat
-                          << std::setprecision(6)
-                          << progress_timer.elapsed() << " seconds";
-                if (completed_paths < header.path_count) {
-                    const auto next_info = path_index.get_path_info(
-                        static_cast<std::uint32_t>(completed_paths));
-                    std::cout << "; next path "
-                              << (completed_paths + 1) << "/"
-                              << header.path_count << " has "
-                              << next_info.step_count << " steps";
+            task.length = cumulative;
+
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            completed_steps += task.step_end - task.step_begin;
+            if (--tasks_left[task.path_id] != 0) return;
+            ++completed_paths;
+            if (progress_every_paths == 0 ||
+                (completed_paths % progress_every_paths != 0 &&
+                 completed_paths != header.path_count)) {
+                return;
+            }
+            const double percent = header.total_step_count == 0
+                ? 100.0
+                : 100.0 * static_cast<double>(completed_steps) /
+                      static_cast<double>(header.total_step_count);
+            std::cout << get_time() << ": Processed "
+                      << completed_paths << "/" << header.path_count
+                      << " paths, " << completed_steps << "/"
+                      << header.total_step_count << " steps ("
+                      << std::fixed << std::setprecision(1) << percent
+                      << "%) in " << std::defaultfloat
+                      << std::setprecision(6)
+                      << progress_timer.elapsed() << " seconds"
+                      << std::endl;
+        });
+
+        // Shift every task's checkpoints by the length of the path before it.
+        // Tasks of one path are contiguous and in step order.
+        std::uint64_t path_prefix = 0;
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            const auto& task = tasks[i];
+            if (task.step_begin == 0) {
+                checkpoints[path_records[task.path_id].checkpoint_begin] = 0;
+                path_prefix = 0;
+            }
+            const std::uint64_t checkpoint_end =
+                task.checkpoint_begin +
+                task.step_end / checkpoint_stride -
+                task.step_begin / checkpoint_stride;
+            if (path_prefix != 0) {
+                for (auto c = task.checkpoint_begin; c < checkpoint_end; ++c) {
+                    checkpoints[c] = checked_add(checkpoints[c],
+                                                 path_prefix,
+                                                 "Path cumulative coordinate");
                 }
-                std::cout << std::endl;
             }
+            path_prefix = checked_add(path_prefix,
+                                      task.length,
+                                      "Path cumulative coordinate");
         }
 
-        if (total_steps_seen != header.total_step_count) {
-            throw std::runtime_error(
-                ".pdx path metadata does not sum to its header step count");
-        }
-        header.checkpoint_count = total_checkpoints;
-
-        // Publish the completed metadata only after every checkpoint value has
-        // been written successfully.
-        out.seekp(0, std::ios::beg);
-        if (!out) {
-            throw std::runtime_error(
-                "Failed to seek while finalizing path checkpoint index");
-        }
-        write_or_throw(out, &header, sizeof(header),
-                       "path checkpoint header");
+        // Publish the metadata only after every checkpoint value is in place.
+        std::memcpy(out.data(), &header, sizeof(header));
         if (!path_records.empty()) {
-            write_or_throw(out,
-                           path_records.data(),
-                           path_records.size() *
-                               sizeof(CheckpointPathRecordDisk),
-                           "path checkpoint metadata");
+            std::memcpy(out.data() + header.path_table_offset,
+                        path_records.data(),
+                        path_records.size() * sizeof(CheckpointPathRecordDisk));
         }
         out.close();
-        if (!out) {
-            throw std::runtime_error(
-                "Failed while closing path checkpoint index: " + output_path);
-        }
 
         rename_path_or_throw(staged_output, output_path);
         cleanup_temp_output();
@@ -370,6 +426,117 @@ void build_path_coordinate_checkpoint_index(
     }
 }
 
+PathCheckpointWriter::PathCheckpointWriter(
+    const std::string& node_length_index_path,
+    const std::string& values_path,
+    std::uint64_t checkpoint_stride,
+    std::uint64_t expected_node_count)
+    : lengths_(node_length_index_path),
+      values_path_(values_path),
+      values_out_(values_path, std::ios::binary | std::ios::trunc),
+      checkpoint_stride_(checkpoint_stride) {
+    if (checkpoint_stride_ == 0) {
+        throw std::runtime_error(
+            "Path coordinate checkpoint stride must be greater than zero");
+    }
+    if (lengths_.node_count() != expected_node_count) {
+        throw std::runtime_error(
+            ".pdx and .lnx node counts differ; rebuild aligned indexes");
+    }
+    if (!values_out_) {
+        throw std::runtime_error(
+            "Failed to open temporary path checkpoint file: " + values_path);
+    }
+}
+
+void PathCheckpointWriter::write_value(std::uint64_t value) {
+    values_out_.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    ++checkpoint_count_;
+}
+
+void PathCheckpointWriter::add_step(std::uint32_t node_id) {
+    // Every path stores checkpoint zero, including an empty path.
+    if (!path_open_) {
+        write_value(0);
+        path_open_ = true;
+    }
+    cumulative_ = checked_add(cumulative_,
+                              lengths_.length(node_id),
+                              "Path cumulative coordinate");
+    ++path_steps_;
+    if (path_steps_ % checkpoint_stride_ == 0) write_value(cumulative_);
+}
+
+void PathCheckpointWriter::finish_path() {
+    if (!path_open_) write_value(0);
+    if (!values_out_) {
+        throw std::runtime_error("Failed while writing path checkpoint value");
+    }
+    path_step_counts_.push_back(path_steps_);
+    path_steps_ = 0;
+    cumulative_ = 0;
+    path_open_ = false;
+}
+
+void PathCheckpointWriter::finish(const std::string& path_index_path,
+                                  const std::string& output_path) {
+    values_out_.close();
+    if (!values_out_) {
+        throw std::runtime_error("Failed while writing path checkpoint value");
+    }
+
+    // Only the path metadata of the finished .pdx is read here, to hash its
+    // layout; the steps were already seen on their way into it.
+    PathIndexReader path_index(path_index_path);
+    if (path_index.path_count() != path_step_counts_.size()) {
+        throw std::runtime_error(
+            "Path checkpoint stream does not match the finished .pdx path count");
+    }
+    auto header = make_checkpoint_header(path_index, checkpoint_stride_);
+    header.checkpoint_count = checkpoint_count_;
+
+    std::vector<CheckpointPathRecordDisk> path_records(path_step_counts_.size());
+    std::uint64_t checkpoint_begin = 0;
+    for (std::size_t path_id = 0; path_id < path_records.size(); ++path_id) {
+        auto& record = path_records[path_id];
+        record.step_count = path_step_counts_[path_id];
+        if (record.step_count !=
+            path_index.get_path_info(static_cast<std::uint32_t>(path_id)).step_count) {
+            throw std::runtime_error(
+                "Path checkpoint stream does not match the finished .pdx step counts");
+        }
+        record.checkpoint_begin = checkpoint_begin;
+        record.checkpoint_count = 1 + record.step_count / checkpoint_stride_;
+        checkpoint_begin += record.checkpoint_count;
+    }
+    if (checkpoint_begin != checkpoint_count_) {
+        throw std::runtime_error("Path checkpoint count mismatch");
+    }
+
+    std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error(
+            "Failed to open path checkpoint output: " + output_path);
+    }
+    write_or_throw(out, &header, sizeof(header), "path checkpoint header");
+    write_or_throw(out,
+                   path_records.data(),
+                   path_records.size() * sizeof(CheckpointPathRecordDisk),
+                   "path checkpoint metadata");
+
+    std::ifstream values(values_path_, std::ios::binary);
+    if (!values) {
+        throw std::runtime_error(
+            "Failed to open temporary path checkpoint file: " + values_path_);
+    }
+    if (checkpoint_count_ != 0) out << values.rdbuf();
+    out.close();
+    if (!out) {
+        throw std::runtime_error(
+            "Failed while closing path checkpoint index: " + output_path);
+    }
+}
+
 PathCoordinateCheckpointIndexReader::
 PathCoordinateCheckpointIndexReader(const std::string& path) {
     fd_ = ::open(path.c_str(), O_RDONLY);
@@ -492,36 +659,10 @@ void PathCoordinateCheckpointIndexReader::validate_against(
         throw std::runtime_error(
             ".pcx counts do not match the supplied .pdx/.lnx");
     }
-    if (header.path_layout_hash != path_layout_hash(path_index)) {
+    if (header.path_layout_hash != path_index.path_layout_hash()) {
         throw std::runtime_error(
             ".pcx path metadata does not match the supplied .pdx");
     }
-
-    const auto* records = mapped_path_records(path_records_);
-    std::uint64_t step_sum = 0;
-    for (std::uint32_t path_id = 0;
-         path_id < path_index.path_count();
-         ++path_id) {
-        const auto info = path_index.get_path_info(path_id);
-        const auto& record = records[path_id];
-        const auto expected_checkpoints =
-            info.step_count / header.checkpoint_stride + 1;
-        if (record.step_count != info.step_count ||
-            record.checkpoint_count != expected_checkpoints ||
-            record.checkpoint_begin > header.checkpoint_count ||
-            record.checkpoint_count >
-                header.checkpoint_count - record.checkpoint_begin) {
-            throw std::runtime_error(
-                ".pcx path checkpoint metadata is incompatible with .pdx");
-        }
-        step_sum = checked_add(step_sum,
-                               info.step_count,
-                               "Validated path step count");
-    }
-    if (step_sum != header.total_step_count) {
-        throw std::runtime_error(
-            ".pcx validated path steps do not match its header");
-    }
 }
 
 std::uint64_t
@@ -3,7 +3,11 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <fstream>
 #include <string>
+#include <vector>
+
+#include "indexer/node_length_index.h"
 
 namespace gfaidx::paths {
 
@@ -18,13 +22,58 @@ inline constexpr std::uint64_t kDefaultPathCheckpointProgressEvery = 10;
 
 // Build an optional path-coordinate checkpoint sidecar from an existing .pdx
 // and its rank-aligned .lnx. The original graph and other indexes are unchanged.
+// Paths are scanned on up to threads workers, each writing its checkpoints
+// into the path's precomputed slice of the output; the file is the same for
+// any thread count.
 void build_path_coordinate_checkpoint_index(
     const std::string& path_index_path,
     const std::string& node_length_index_path,
     const std::string& output_path,
     std::uint64_t checkpoint_stride = kDefaultPathCheckpointStride,
     std::uint64_t progress_every_paths =
-        kDefaultPathCheckpointProgressEvery);
+        kDefaultPathCheckpointProgressEvery,
+    unsigned threads = 1);
+
+// Optional .pcx that build_path_index emits from the steps it writes, so a
+// fresh build needs no second scan of the .pdx step table.
+struct PathCheckpointOutput {
+    std::string node_length_index_path;
+    std::string output_path;
+    std::uint64_t checkpoint_stride{kDefaultPathCheckpointStride};
+};
+
+// Accumulates .pcx checkpoints from a stream of path steps in .pdx order. The
+// checkpoint values are spooled to values_path; finish() validates the path
+// table against the finished .pdx and writes the same bytes as
+// build_path_coordinate_checkpoint_index() would.
+class PathCheckpointWriter {
+public:
+    PathCheckpointWriter(const std::string& node_length_index_path,
+                         const std::string& values_path,
+                         std::uint64_t checkpoint_stride,
+                         std::uint64_t expected_node_count);
+
+    PathCheckpointWriter(const PathCheckpointWriter&) = delete;
+    PathCheckpointWriter& operator=(const PathCheckpointWriter&) = delete;
+
+    void add_step(std::uint32_t node_id);
+    void finish_path();
+    void finish(const std::string& path_index_path,
+                const std::string& output_path);
+
+private:
+    void write_value(std::uint64_t value);
+
+    indexer::NodeLengthIndexReader lengths_;
+    std::string values_path_;
+    std::ofstream values_out_;
+    std::uint64_t checkpoint_stride_{};
+    std::uint64_t checkpoint_count_{0};
+    std::uint64_t path_steps_{0};
+    std::uint64_t cumulative_{0};
+    bool path_open_{false};
+    std::vector<std::uint64_t> path_step_counts_;
+};
 
 // Mmap-backed reader for the small .pcx sidecar. Checkpoint values are path-local
 // cumulative sequence lengths immediately before a checkpointed step.
@@ -40,6 +89,8 @@ public:
 
     // Validate that this sidecar was built for the supplied path index and
     // rank-aligned node-length table. A mismatch must fall back to prefix scans.
+    // Only header counts and the .pdx layout hash are compared, so the cost
+    // does not grow with the number of paths.
     void validate_against(const PathIndexReader& path_index,
                           std::uint64_t node_length_count) const;
 
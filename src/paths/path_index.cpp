@@ -1,40 +1,60 @@
 #include "paths/path_index.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <stdexcept>
 #include <system_error>
-#include <unordered_set>
+#include <thread>
 #include <utility>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "fs/fs_helpers.h"
 #include "fs/gfa_line_parsers.h"
+#include "fs/line_tokenizer.h"
 #include "indexer/node_hash_index.h"
+#include "paths/p_path_coordinates.h"
 #include "utils/Timer.h"
+#include "utils/parallel_tasks.h"
 
 namespace gfaidx::paths {
 namespace {
 
 // The path index is a single binary file with:
-// - a fixed header
+// - a fixed header, ending with a hash of the path table layout
 // - a path table
 // - a node table
-// - a flat step array
-// - a per-node compressed posting blob
+// - a step table made of:
+//   - one StepBlockDisk per literal block of up to kStepBlockSize steps
+//   - one StepPhraseDisk per path phrase; each path record stores its phrase
+//     range, and phrases point at runs of the shared literal step stream
+//   - the bitpacked literal block data
+// - a per-node posting blob of bitpacked posting chunks, with a skip table in
+//   front of the chunks of high-occurrence nodes, followed by zero padding for
+//   the unpack loads
 // - one shared string blob for names / overlap fields / tags
+// - a path-name hash table sorted by (hash, hash32, path_id), starting at the
+//   first 8-byte boundary after the string blob
+// - a coordinate-namespace hash table of the same layout and order, keyed by
+//   path_coordinate_namespace(), ending at end of file
 constexpr char kPathIndexMagic[8] = {'G', 'F', 'P', 'A', 'T', 'H', '1', '\0'};
-constexpr std::uint32_t kPathIndexVersion = 4;
-
-// Each step is stored in one packed uint32:
-// - low 31 bits: node_id
-// - top bit: reverse-orientation flag
-constexpr std::uint32_t kStepPackedNodeMask = 0x7fffffffu;
-constexpr std::uint32_t kStepPackedReverseBit = 0x80000000u;
+constexpr std::uint32_t kPathIndexVersion = 11;
 
 // File header with counts plus offsets to each top-level section.
 struct PathIndexHeaderDisk {
@@ -51,6 +71,10 @@ struct PathIndexHeaderDisk {
     std::uint64_t posting_table_offset{};
     std::uint64_t strings_offset{};
     std::uint64_t strings_size{};
+    std::uint64_t step_block_count{};
+    std::uint64_t step_phrase_count{};
+    std::uint64_t literal_step_count{};
+    std::uint64_t path_layout_hash{};
 };
 
 // Path metadata supporting both P-lines and W-lines.
@@ -72,8 +96,53 @@ struct PathRecordDisk {
     std::uint64_t seq_id_len{};
     std::int64_t seq_start{-1};
     std::int64_t seq_end{-1};
+    std::uint64_t step_phrase_begin{};
+    std::uint64_t step_phrase_count{};
+};
+
+// One run of path steps stored in the literal stream. step_end is exclusive
+// and counts from the start of the path, so a reader finds the phrase holding
+// a step by binary search; the run starts where the previous phrase ended.
+struct StepPhraseDisk {
+    std::uint64_t literal_begin{};
+    std::uint64_t step_end{};
+};
+
+// Directory entry for one literal step block. data_offset is relative to the start of
+// the packed step data. Values are (node_id - base) << 1 | is_reverse, stored
+// LSB-first at width bits each; width 0 means every step is base, forward.
+struct StepBlockDisk {
+    std::uint64_t data_offset{};
+    std::uint32_t base{};
+    std::uint8_t width{};
+    std::uint8_t reserved[3]{};
+};
+
+// The packed step data ends with this much zero padding so the decoder can
+// always load a full 64-bit word at the byte holding a value's first bit.
+constexpr std::uint64_t kStepDataPadding = 8;
+
+// The posting blob ends with the same padding so the last chunk of the last
+// node can be unpacked with 64-bit loads too.
+constexpr std::uint64_t kPostingDataPadding = 8;
+
+// Skip-table entry written in front of a high-occurrence node's posting
+// chunks. Entry i describes chunk i * kPostingSkipInterval, so it also records
+// that kPostingChunkSize * chunk_index postings come before it.
+struct PostingSkipDisk {
+    std::uint64_t byte_offset{};
+    std::uint32_t first_path_id{};
+    std::uint32_t chunk_index{};
 };
 
+// Skip entries are implied by the node's posting count, so the node table
+// needs no extra field to find where the chunks start.
+std::uint64_t posting_skip_count(std::uint64_t posting_count) {
+    const std::uint64_t chunks = (posting_count + kPostingChunkSize - 1) / kPostingChunkSize;
+    if (chunks < kPostingSkipMinChunks) return 0;
+    return (chunks + kPostingSkipInterval - 1) / kPostingSkipInterval;
+}
+
 // Node metadata points at the node's slice in the posting table.
 // posting_begin is a byte offset into
 // the compressed posting blob". posting_count remains the decoded posting
@@ -85,28 +154,15 @@ struct NodeRecordDisk {
     std::uint64_t posting_count{};
 };
 
-// Packed step layout. This cuts the step table from 8 bytes/step to 4
-// bytes/step while preserving direct random access by step index.
-struct StepRecordDisk {
-    std::uint32_t packed{};
-};
-
-// Parsed views into one P line before we materialize it into the binary index.
-struct ParsedPathFields {
-    std::string name;
-    std::string_view segments;
-    std::string_view overlaps;
-    std::string_view tags;
-};
-
-struct ParsedWalkFields {
-    std::string sample_id;
-    std::uint64_t hap_index{};
-    std::string seq_id;
-    std::int64_t seq_start{-1};
-    std::int64_t seq_end{-1};
-    std::string_view walk;
-    std::string_view tags;
+// One path-name lookup entry. Version 5 stores these so readers can resolve a
+// path name by binary search in the mapping instead of hashing every name at
+// open time. Hash collisions are resolved by comparing the stored name.
+// Version 10 adds a second table of these keyed by coordinate namespace, so
+// the fragments of one sequence are found without reading every record.
+struct PathNameEntryDisk {
+    std::uint64_t hash{};
+    std::uint32_t hash32{};
+    std::uint32_t path_id{};
 };
 
 // Temporary in-memory metadata used while building the final path table.
@@ -115,6 +171,8 @@ struct PathBuildEntry {
     std::string name;
     std::uint64_t step_begin{};
     std::uint64_t step_count{};
+    std::uint64_t step_phrase_begin{};
+    std::uint64_t step_phrase_count{};
     std::string overlaps;
     std::string tags;
     std::string sample_id;
@@ -124,37 +182,65 @@ struct PathBuildEntry {
     std::int64_t seq_end{-1};
 };
 
-static_assert(sizeof(PathIndexHeaderDisk) == 96, "Unexpected path index header size");
-static_assert(sizeof(PathRecordDisk) == 128, "Unexpected path record size");
+static_assert(sizeof(PathIndexHeaderDisk) == 128, "Unexpected path index header size");
+static_assert(sizeof(PathRecordDisk) == 144, "Unexpected path record size");
+static_assert(sizeof(StepPhraseDisk) == 16, "Unexpected step phrase entry size");
+static_assert(sizeof(StepBlockDisk) == 16, "Unexpected step block entry size");
 static_assert(sizeof(NodeRecordDisk) == 32, "Unexpected node record size");
 static_assert(sizeof(StepRecordDisk) == 4, "Unexpected packed step record size");
+static_assert(sizeof(PathNameEntryDisk) == 16, "Unexpected path-name entry size");
+
+// Posting runs are ordered by an LSD radix sort on the node id, one digit of
+// this many bits per pass.
+constexpr unsigned kPostingRadixBits = 11;
+constexpr std::size_t kPostingRadixBuckets = std::size_t{1} << kPostingRadixBits;
 
-// Bound the posting sort working set so large path collections spill to disk
-// instead of accumulating one giant in-memory postings vector.
-constexpr std::size_t kPostingChunkBytes = 64ULL * 1024ULL * 1024ULL;
-constexpr std::size_t kPostingChunkRecords =
-    kPostingChunkBytes / sizeof(detail::TempPosting) == 0
-        ? 1
-        : kPostingChunkBytes / sizeof(detail::TempPosting);
+// Run files are read and written through buffers of these sizes.
+constexpr std::size_t kPostingRunReadBufferBytes = 64ULL * 1024ULL;
+constexpr std::size_t kPostingRunWriteBufferBytes = 1ULL << 20;
 
 constexpr std::uint64_t kPathRecordProgressInterval = 5000;
 constexpr std::uint64_t kPostingRunProgressInterval = 50;
 constexpr std::uint64_t kPostingMergeProgressInterval = 100000000;
 
 // Keep the k-way merge comfortably below typical open-file limits by
-// collapsing large run sets in multiple passes when needed.
+// collapsing large run sets in multiple passes when needed. Every final merge
+// worker opens all remaining runs, so the fan-in is split between them.
 constexpr std::size_t kPostingMergeFanIn = 128;
+constexpr std::size_t kPostingMinMergeFanIn = 16;
+
+// Parallel final merges split the node ids into this many ranges per worker,
+// so a worker that finishes early can pick up another range.
+constexpr std::size_t kPostingRangesPerWorker = 4;
 
 constexpr std::size_t kFileCopyBufferBytes = 1ULL << 20;
 
+// Path parsing resolves step names through a direct-mapped cache of this many
+// .ndx ranks per thread in front of the mmap-backed lookup.
+constexpr unsigned kNodeRankCacheBits = 16;
+
+// Parallel path scans hand workers batches of about this many bytes of P/W
+// lines, and keep at most two batches per worker between reader and writer.
+constexpr std::size_t kPathBatchBytes = 8ULL * 1024ULL * 1024ULL;
+constexpr std::size_t kPathBatchesPerWorker = 2;
+
+// Subpath discovery decodes the postings of this many selected nodes per
+// task, and radix-sorts the collected postings once there are enough of them
+// to amortize the digit histograms.
+constexpr std::size_t kSubpathNodesPerTask = 256;
+constexpr std::size_t kSubpathRadixSortMinKeys = 1ULL << 14;
+
 // Hash lookup is cheaper for small node sets; rank-addressed lookup wins once
 // coordinate output repeatedly visits a substantial number of distinct nodes.
 constexpr std::size_t kDenseNodeNamePromotionThreshold = 1ULL << 16;
 
 using detail::PostingHeapGreater;
 using detail::PostingHeapItem;
+using detail::PostingRun;
+using detail::PostingRunBlock;
 using detail::PostingRunBuilder;
 using detail::PostingRunCursor;
+using detail::PostingRunWriter;
 using detail::TempPosting;
 
 void append_varint(std::string& out, std::uint64_t value) {
@@ -165,11 +251,13 @@ void append_varint(std::string& out, std::uint64_t value) {
     out.push_back(static_cast<char>(value));
 }
 
-std::uint64_t read_varint(const std::vector<unsigned char>& data, std::size_t& cursor) {
+std::uint64_t read_posting_varint(const unsigned char* data,
+                                  std::size_t size,
+                                  std::size_t& cursor) {
     std::uint64_t value = 0;
     unsigned shift = 0;
 
-    while (cursor < data.size()) {
+    while (cursor < size) {
         const auto byte = static_cast<std::uint64_t>(data[cursor++]);
         value |= (byte & 0x7f) << shift;
         if ((byte & 0x80) == 0) {
@@ -197,11 +285,38 @@ void set_seen_bit(std::vector<std::uint64_t>& bits, std::uint32_t value) {
     bits[word] |= (1ULL << bit);
 }
 
-std::uint64_t append_string(std::string& blob, std::string_view s) {
-    const auto offset = static_cast<std::uint64_t>(blob.size());
-    blob.append(s.data(), s.size());
-    return offset;
-}
+// Streams the shared string section to a temp file, so node and path names
+// are never all held in memory at once.
+class StringSectionWriter {
+public:
+    explicit StringSectionWriter(const std::string& path)
+        : out_(path, std::ios::binary | std::ios::trunc) {
+        if (!out_) {
+            throw std::runtime_error("Failed to open temporary string file: " + path);
+        }
+    }
+
+    // Append s and return its offset inside the section.
+    std::uint64_t append(std::string_view s) {
+        const std::uint64_t offset = size_;
+        out_.write(s.data(), static_cast<std::streamsize>(s.size()));
+        size_ += s.size();
+        return offset;
+    }
+
+    void finish() {
+        out_.close();
+        if (!out_) {
+            throw std::runtime_error("Failed while writing temporary string file");
+        }
+    }
+
+    [[nodiscard]] std::uint64_t size() const { return size_; }
+
+private:
+    std::ofstream out_;
+    std::uint64_t size_{0};
+};
 
 template <typename T>
 void write_vector(std::ofstream& out, const std::vector<T>& values) {
@@ -215,6 +330,34 @@ void write_binary_record(std::ofstream& out, const T& value) {
     out.write(reinterpret_cast<const char*>(&value), static_cast<std::streamsize>(sizeof(T)));
 }
 
+bool path_name_entry_less(const PathNameEntryDisk& lhs, const PathNameEntryDisk& rhs) {
+    if (lhs.hash != rhs.hash) return lhs.hash < rhs.hash;
+    if (lhs.hash32 != rhs.hash32) return lhs.hash32 < rhs.hash32;
+    return lhs.path_id < rhs.path_id;
+}
+
+std::uint64_t path_name_table_offset(std::uint64_t strings_offset, std::uint64_t strings_size) {
+    const std::uint64_t end = strings_offset + strings_size;
+    return (end + alignof(PathNameEntryDisk) - 1) & ~static_cast<std::uint64_t>(alignof(PathNameEntryDisk) - 1);
+}
+
+constexpr std::uint64_t kLayoutHashOffset = 1469598103934665603ULL;
+constexpr std::uint64_t kLayoutHashPrime = 1099511628211ULL;
+
+void hash_layout_bytes(std::uint64_t& hash, const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= kLayoutHashPrime;
+    }
+}
+
+void hash_layout_string(std::uint64_t& hash, std::string_view value) {
+    const auto size = static_cast<std::uint64_t>(value.size());
+    hash_layout_bytes(hash, &size, sizeof(size));
+    hash_layout_bytes(hash, value.data(), value.size());
+}
+
 bool temp_posting_less(const TempPosting& lhs, const TempPosting& rhs) {
     if (lhs.node_id != rhs.node_id) return lhs.node_id < rhs.node_id;
     if (lhs.path_id != rhs.path_id) return lhs.path_id < rhs.path_id;
@@ -231,51 +374,591 @@ StepRecordDisk pack_step_record(std::uint32_t node_id, bool is_reverse) {
     return out;
 }
 
-StepRecord unpack_step_record(const StepRecordDisk& rec) {
-    return StepRecord{
-        rec.packed & kStepPackedNodeMask,
-        (rec.packed & kStepPackedReverseBit) != 0
+unsigned bit_width(std::uint64_t value) {
+    unsigned width = 0;
+    while (value != 0) {
+        ++width;
+        value >>= 1;
+    }
+    return width;
+}
+
+// Streams the literal step stream into two temp files: the block directory and
+// the bitpacked block data.
+class StepBlockWriter {
+public:
+    StepBlockWriter(const std::string& blocks_path, const std::string& data_path)
+        : blocks_out_(blocks_path, std::ios::binary | std::ios::trunc),
+          data_out_(data_path, std::ios::binary | std::ios::trunc) {
+        if (!blocks_out_) {
+            throw std::runtime_error("Failed to open temporary step block file: " + blocks_path);
+        }
+        if (!data_out_) {
+            throw std::runtime_error("Failed to open temporary step file: " + data_path);
+        }
+    }
+
+    void add(StepRecordDisk step) {
+        pending_[pending_count_++] = step;
+        ++step_count_;
+        if (pending_count_ == kStepBlockSize) flush_block();
+    }
+
+    void finish() {
+        if (pending_count_ != 0) flush_block();
+        const char zeros[kStepDataPadding] = {};
+        data_out_.write(zeros, static_cast<std::streamsize>(kStepDataPadding));
+        data_bytes_ += kStepDataPadding;
+        blocks_out_.close();
+        data_out_.close();
+        if (!blocks_out_ || !data_out_) {
+            throw std::runtime_error("Failed while writing temporary step file");
+        }
+    }
+
+    [[nodiscard]] std::uint64_t step_count() const { return step_count_; }
+    [[nodiscard]] std::uint64_t block_count() const { return block_count_; }
+    [[nodiscard]] std::uint64_t data_bytes() const { return data_bytes_; }
+
+private:
+    void flush_block() {
+        std::uint32_t base = std::numeric_limits<std::uint32_t>::max();
+        for (std::size_t i = 0; i < pending_count_; ++i) {
+            base = std::min(base, pending_[i].node_id());
+        }
+
+        std::uint64_t max_value = 0;
+        for (std::size_t i = 0; i < pending_count_; ++i) {
+            values_[i] = (static_cast<std::uint64_t>(pending_[i].node_id() - base) << 1) |
+                         (pending_[i].is_reverse() ? 1u : 0u);
+            max_value = std::max(max_value, values_[i]);
+        }
+
+        StepBlockDisk block{};
+        block.data_offset = data_bytes_;
+        block.base = base;
+        block.width = static_cast<std::uint8_t>(bit_width(max_value));
+
+        const std::size_t packed_bytes = (pending_count_ * block.width + 7) / 8;
+        packed_.assign(packed_bytes + kStepDataPadding, 0);
+        for (std::size_t i = 0; i < pending_count_; ++i) {
+            const std::size_t bit = i * block.width;
+            std::uint64_t word = 0;
+            std::memcpy(&word, packed_.data() + bit / 8, sizeof(word));
+            word |= values_[i] << (bit % 8);
+            std::memcpy(packed_.data() + bit / 8, &word, sizeof(word));
+        }
+
+        data_out_.write(reinterpret_cast<const char*>(packed_.data()),
+                        static_cast<std::streamsize>(packed_bytes));
+        write_binary_record(blocks_out_, block);
+        if (!data_out_.good() || !blocks_out_.good()) {
+            throw std::runtime_error("Failed while writing temporary step file");
+        }
+
+        data_bytes_ += packed_bytes;
+        ++block_count_;
+        pending_count_ = 0;
+    }
+
+    std::ofstream blocks_out_;
+    std::ofstream data_out_;
+    std::array<StepRecordDisk, kStepBlockSize> pending_{};
+    std::array<std::uint64_t, kStepBlockSize> values_{};
+    std::vector<unsigned char> packed_;
+    std::size_t pending_count_{0};
+    std::uint64_t step_count_{0};
+    std::uint64_t block_count_{0};
+    std::uint64_t data_bytes_{0};
+};
+
+// Turns each path into phrases over the shared literal step stream. With
+// sharing enabled this is a greedy relative Lempel-Ziv parse against the
+// literal stream. Every literal window of kStepMatchWindow steps that starts
+// on a kStepMatchStride boundary is hashed. Each path position looks up the
+// windows starting at the next kStepMatchStride positions and tries the most
+// recent occurrences of each. The longest verified run becomes one phrase;
+// positions without a match become new literal steps.
+//
+// The literal stream only helps later paths when whole haplotypes appear in
+// it contiguously. A path is parsed in blocks of kSharedParseSteps steps, and
+// a block that parses poorly against the current stream is therefore stored
+// whole, so the next haplotype that follows it can match it in long runs.
+//
+// Only the most recent history_steps literal steps can be matched. They are
+// kept in a ring, and window-index entries that fall out of it are dropped
+// when the index would otherwise grow, so build memory stays below
+// kStepHistoryBytesPerStep per history step however many steps are stored.
+class StepPhraseWriter {
+public:
+    StepPhraseWriter(const std::string& blocks_path,
+                     const std::string& data_path,
+                     const std::string& phrases_path,
+                     std::uint64_t node_count,
+                     bool share_runs,
+                     std::uint64_t history_steps)
+        : literals_out_(blocks_path, data_path),
+          phrases_out_(phrases_path, std::ios::binary | std::ios::trunc),
+          share_runs_(share_runs),
+          literal_bits_(bit_width(node_count) + 1),
+          history_steps_(history_steps),
+          chain_capacity_(history_steps / kStepMatchStride + 2) {
+        if (!phrases_out_) {
+            throw std::runtime_error("Failed to open temporary step phrase file: " + phrases_path);
+        }
+        if (share_runs_ && history_steps_ < kStepMatchWindow) {
+            throw std::runtime_error("Shared step history is shorter than one match window");
+        }
+    }
+
+    // Shared runs are parsed a block of kSharedParseSteps steps at a time, so
+    // like flat storage, which writes each step straight to the literal
+    // stream, memory does not grow with the path length.
+    void add(StepRecordDisk step) {
+        if (share_runs_) {
+            path_steps_.push_back(step.packed);
+            if (path_steps_.size() == kSharedParseSteps) encode_shared_block(false);
+            return;
+        }
+        if (flat_path_steps_ == 0) flat_path_begin_ = literals_out_.step_count();
+        append_literal(step.packed);
+        ++flat_path_steps_;
+    }
+
+    // Encode the steps added since the previous call as one path's phrases.
+    // Returns the path's first phrase id; phrase_count receives its length.
+    std::uint64_t finish_path(std::uint64_t& phrase_count) {
+        if (!path_steps_.empty()) {
+            encode_shared_block(true);
+        } else if (flat_path_steps_ != 0) {
+            emit_run(flat_path_begin_, flat_path_steps_);
+        }
+        close_open_phrase();
+        const std::uint64_t first_phrase = path_first_phrase_;
+        phrase_count = phrase_count_ - first_phrase;
+        path_first_phrase_ = phrase_count_;
+        path_step_end_ = 0;
+        next_literal_ = kNoPosition;
+        flat_path_steps_ = 0;
+        return first_phrase;
+    }
+
+    void finish() {
+        literals_out_.finish();
+        phrases_out_.close();
+        if (!phrases_out_) {
+            throw std::runtime_error("Failed while writing temporary step phrase file");
+        }
+    }
+
+    [[nodiscard]] std::uint64_t literal_step_count() const { return literals_out_.step_count(); }
+    [[nodiscard]] std::uint64_t block_count() const { return literals_out_.block_count(); }
+    [[nodiscard]] std::uint64_t data_bytes() const { return literals_out_.data_bytes(); }
+    [[nodiscard]] std::uint64_t phrase_count() const { return phrase_count_; }
+
+private:
+    static constexpr std::size_t kStepMatchWindow = 16;
+    static constexpr std::size_t kStepMatchStride = 4;
+    static constexpr std::size_t kStepMatchCandidates = 16;
+    // Steps buffered per shared parse block, and how many of them are held
+    // back so matches near the block end can still run into the next block.
+    static constexpr std::size_t kSharedParseSteps = 1u << 16;
+    static constexpr std::size_t kSharedParseLookahead = 1024;
+    // Keep a parse only if it is at least this many times smaller than
+    // storing the path whole.
+    static constexpr std::uint64_t kMinSharedGain = 4;
+    static constexpr std::uint64_t kHashBase = 0x9e3779b97f4a7c15ULL;
+    static constexpr std::uint64_t kNoPosition = std::numeric_limits<std::uint64_t>::max();
+
+    // One parsed run: a literal run indexes path_steps_, a match run indexes
+    // the literal stream.
+    struct ParsedRun {
+        bool is_literal{};
+        std::uint64_t begin{};
+        std::uint64_t length{};
+    };
+
+    // Encode path_steps_ up to its last kSharedParseLookahead steps, or all of
+    // them for the path's last block, and keep the rest for the next block.
+    // Each block is parsed or stored whole on its own, so a long path that
+    // only partly repeats earlier ones still shares the parts that do.
+    void encode_shared_block(bool last_block) {
+        const std::size_t stop = last_block ? path_steps_.size()
+                                            : path_steps_.size() - kSharedParseLookahead;
+        std::size_t consumed = 0;
+        std::uint64_t next_literal = next_literal_;
+        if (parse_shared_block(stop, consumed, next_literal)) {
+            for (const auto& run : runs_) {
+                if (run.is_literal) {
+                    const std::uint64_t literal_begin = literals_out_.step_count();
+                    for (std::uint64_t k = 0; k < run.length; ++k) {
+                        append_literal(path_steps_[run.begin + k]);
+                    }
+                    emit_run(literal_begin, run.length);
+                } else {
+                    emit_run(run.begin, run.length);
+                }
+            }
+            next_literal_ = next_literal;
+        } else {
+            const std::uint64_t literal_begin = literals_out_.step_count();
+            for (std::size_t k = 0; k < consumed; ++k) append_literal(path_steps_[k]);
+            emit_run(literal_begin, consumed);
+            next_literal_ = kNoPosition;
+        }
+        path_steps_.erase(path_steps_.begin(), path_steps_.begin() + static_cast<std::ptrdiff_t>(consumed));
+    }
+
+    // Parse path_steps_ into runs_ until a run ends at or after stop, without
+    // touching the literal stream. consumed receives where the runs end and
+    // next_literal where the last match would continue. Returns whether the
+    // parse is worth keeping over storing those steps whole; when it is not,
+    // consumed is still the number of steps to store.
+    bool parse_shared_block(std::size_t stop, std::size_t& consumed, std::uint64_t& next_literal) {
+        const std::size_t n = path_steps_.size();
+        runs_.clear();
+        if (literal_end_ == 0) {
+            consumed = stop;
+            return false;
+        }
+
+        path_prefix_.assign(n + 1, 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            path_prefix_[i + 1] = path_prefix_[i] * kHashBase + path_steps_[i] + 1;
+        }
+
+        std::uint64_t phrase_estimate = 0;
+        std::uint64_t literal_steps = 0;
+        std::size_t i = 0;
+        while (i < stop) {
+            std::uint64_t match_begin = 0;
+            const std::size_t match_len = find_match(i, next_literal, match_begin);
+            if (match_len != 0) {
+                if (runs_.empty() || runs_.back().is_literal ||
+                    runs_.back().begin + runs_.back().length != match_begin) {
+                    runs_.push_back(ParsedRun{false, match_begin, 0});
+                    ++phrase_estimate;
+                }
+                runs_.back().length += match_len;
+                next_literal = match_begin + match_len;
+                i += match_len;
+                continue;
+            }
+            if (runs_.empty() || !runs_.back().is_literal) {
+                runs_.push_back(ParsedRun{true, i, 0});
+                ++phrase_estimate;
+            }
+            ++runs_.back().length;
+            ++literal_steps;
+            // After a mismatch, keep trying the stream position the previous
+            // match would have continued at; single-step variants resume there.
+            if (next_literal != kNoPosition) ++next_literal;
+            ++i;
+        }
+        consumed = i;
+
+        const std::uint64_t parsed_bits =
+            phrase_estimate * sizeof(StepPhraseDisk) * 8 + literal_steps * literal_bits_;
+        const std::uint64_t whole_bits = consumed * literal_bits_ + sizeof(StepPhraseDisk) * 8;
+        return parsed_bits * kMinSharedGain <= whole_bits;
+    }
+
+    // Return the longest verified literal run matching path_steps_[i...], or
+    // zero when nothing long enough matches. continuation is where the
+    // previous match would continue in the literal stream.
+    std::size_t find_match(std::size_t i, std::uint64_t continuation, std::uint64_t& match_begin) const {
+        const std::size_t n = path_steps_.size();
+        const std::uint64_t oldest = oldest_literal();
+        std::size_t best_len = 0;
+        auto try_candidate = [&](std::uint64_t begin, std::size_t required) {
+            if (begin < oldest) return;
+            std::size_t len = 0;
+            std::size_t slot = literal_slot(begin);
+            while (i + len < n && begin + len < literal_end_ &&
+                   path_steps_[i + len] == literals_[slot]) {
+                ++len;
+                if (++slot == literals_.size()) slot = 0;
+            }
+            if (len >= required && len > best_len) {
+                best_len = len;
+                match_begin = begin;
+            }
+        };
+
+        if (continuation < literal_end_) try_candidate(continuation, kStepMatchWindow);
+        for (std::size_t j = 0; j < kStepMatchStride && i + j + kStepMatchWindow <= n; ++j) {
+            std::uint64_t sampled = window_index_.find(window_hash(path_prefix_, i + j));
+            // Chains run from newer to older windows, so the first one that
+            // left the history ends the walk.
+            for (std::size_t tries = 0;
+                 sampled != kNoPosition && sampled >= oldest && tries < kStepMatchCandidates;
+                 ++tries) {
+                // Hash hits are only candidates; the run must cover the window.
+                if (sampled >= j) try_candidate(sampled - j, j + kStepMatchWindow);
+                sampled = window_chain_[(sampled / kStepMatchStride) % chain_capacity_];
+            }
+        }
+        return best_len;
+    }
+
+    std::uint64_t window_hash(const std::vector<std::uint64_t>& prefix, std::size_t begin) const {
+        return prefix[begin + kStepMatchWindow] - prefix[begin] * window_power_;
+    }
+
+    // The same hash as window_hash(), computed from the ring so the literal
+    // stream needs no prefix array.
+    std::uint64_t literal_window_hash(std::uint64_t begin) const {
+        std::uint64_t hash = 0;
+        std::size_t slot = literal_slot(begin);
+        for (std::size_t k = 0; k < kStepMatchWindow; ++k) {
+            hash = hash * kHashBase + literals_[slot] + 1;
+            if (++slot == literals_.size()) slot = 0;
+        }
+        return hash;
+    }
+
+    [[nodiscard]] std::uint64_t oldest_literal() const {
+        return literal_end_ > history_steps_ ? literal_end_ - history_steps_ : 0;
+    }
+
+    // Ring slot of a literal inside the history; the ring fills up before it
+    // wraps, so positions below its size map to themselves.
+    [[nodiscard]] std::size_t literal_slot(std::uint64_t position) const {
+        return static_cast<std::size_t>(position % literals_.size());
+    }
+
+    void append_literal(std::uint32_t packed) {
+        literals_out_.add(StepRecordDisk{packed});
+        if (!share_runs_) return;
+
+        if (literals_.size() < history_steps_) {
+            literals_.push_back(packed);
+        } else {
+            literals_[literal_slot(literal_end_)] = packed;
+        }
+        ++literal_end_;
+        if (literal_end_ < kStepMatchWindow) return;
+        const std::uint64_t window_begin = literal_end_ - kStepMatchWindow;
+        if (window_begin % kStepMatchStride == 0) {
+            // Sampled windows are inserted in order, so window_chain_ is a
+            // ring indexed by window_begin / kStepMatchStride.
+            const std::uint64_t previous = window_index_.insert(
+                literal_window_hash(window_begin), window_begin, oldest_literal());
+            const auto window = window_begin / kStepMatchStride;
+            if (window_chain_.size() < chain_capacity_) {
+                window_chain_.push_back(previous);
+            } else {
+                window_chain_[window % chain_capacity_] = previous;
+            }
+        }
+    }
+
+    // Extend the open phrase when the run continues it in the literal stream;
+    // otherwise close it and start a new one.
+    void emit_run(std::uint64_t literal_begin, std::uint64_t length) {
+        if (has_open_phrase_ && open_phrase_.literal_begin + open_length_ == literal_begin) {
+            open_length_ += length;
+            open_phrase_.step_end += length;
+            return;
+        }
+        close_open_phrase();
+        open_phrase_.literal_begin = literal_begin;
+        open_phrase_.step_end = path_step_end_ + length;
+        open_length_ = length;
+        has_open_phrase_ = true;
+    }
+
+    void close_open_phrase() {
+        if (!has_open_phrase_) return;
+        write_binary_record(phrases_out_, open_phrase_);
+        if (!phrases_out_.good()) {
+            throw std::runtime_error("Failed while writing temporary step phrase file");
+        }
+        ++phrase_count_;
+        path_step_end_ = open_phrase_.step_end;
+        has_open_phrase_ = false;
+    }
+
+    // Open-addressing table from window hash to its latest literal position.
+    // Positions before the history may still be returned; callers skip them.
+    class WindowIndex {
+    public:
+        [[nodiscard]] std::uint64_t find(std::uint64_t hash) const {
+            if (slots_.empty()) return kNoPosition;
+            for (std::size_t slot = hash & mask_;; slot = (slot + 1) & mask_) {
+                if (slots_[slot].position == kNoPosition) return kNoPosition;
+                if (slots_[slot].hash == hash) return slots_[slot].position;
+            }
+        }
+
+        // Make position the latest occurrence of hash and return the previous
+        // one, or kNoPosition. oldest is the first position still in the
+        // history; older entries are dropped whenever the table fills up.
+        std::uint64_t insert(std::uint64_t hash, std::uint64_t position, std::uint64_t oldest) {
+            if ((size_ + 1) * 2 > slots_.size()) rebuild(oldest);
+            return insert_slot(hash, position);
+        }
+
+    private:
+        struct Slot {
+            std::uint64_t hash{0};
+            std::uint64_t position{kNoPosition};
+        };
+
+        std::uint64_t insert_slot(std::uint64_t hash, std::uint64_t position) {
+            for (std::size_t slot = hash & mask_;; slot = (slot + 1) & mask_) {
+                if (slots_[slot].position == kNoPosition) {
+                    slots_[slot] = Slot{hash, position};
+                    ++size_;
+                    return kNoPosition;
+                }
+                if (slots_[slot].hash == hash) {
+                    return std::exchange(slots_[slot].position, position);
+                }
+            }
+        }
+
+        // Rehash without the entries that left the history. The table only
+        // doubles while more than a quarter of it is live, so it stays below
+        // two slots per live window.
+        void rebuild(std::uint64_t oldest) {
+            std::size_t live = 0;
+            for (const auto& slot : slots_) {
+                if (slot.position != kNoPosition && slot.position >= oldest) ++live;
+            }
+            std::vector<Slot> old;
+            old.swap(slots_);
+            std::size_t size = old.empty() ? 1024 : old.size();
+            if (live * 4 > size) size *= 2;
+            slots_.assign(size, Slot{});
+            mask_ = slots_.size() - 1;
+            size_ = 0;
+            for (const auto& slot : old) {
+                if (slot.position != kNoPosition && slot.position >= oldest) {
+                    insert_slot(slot.hash, slot.position);
+                }
+            }
+        }
+
+        std::vector<Slot> slots_;
+        std::size_t mask_{0};
+        std::size_t size_{0};
     };
+
+    static std::uint64_t power(std::uint64_t base, std::size_t exponent) {
+        std::uint64_t out = 1;
+        for (std::size_t i = 0; i < exponent; ++i) out *= base;
+        return out;
+    }
+
+    StepBlockWriter literals_out_;
+    std::ofstream phrases_out_;
+    bool share_runs_{true};
+    std::uint64_t literal_bits_{};
+    std::vector<std::uint32_t> path_steps_;
+    std::uint64_t flat_path_begin_{0};
+    std::uint64_t flat_path_steps_{0};
+    std::vector<std::uint64_t> path_prefix_;
+    std::vector<ParsedRun> runs_;
+    // Ring of the last history_steps_ literal steps; literal_end_ counts every
+    // literal appended so far.
+    std::uint64_t history_steps_{};
+    std::vector<std::uint32_t> literals_;
+    std::uint64_t literal_end_{0};
+    WindowIndex window_index_;
+    std::size_t chain_capacity_{};
+    std::vector<std::uint64_t> window_chain_;
+    const std::uint64_t window_power_{power(kHashBase, kStepMatchWindow)};
+    StepPhraseDisk open_phrase_{};
+    std::uint64_t open_length_{0};
+    std::uint64_t path_step_end_{0};
+    bool has_open_phrase_{false};
+    std::uint64_t phrase_count_{0};
+    std::uint64_t path_first_phrase_{0};
+    // Where the current path's last kept match continues in the literal
+    // stream, carried from one parse block to the next.
+    std::uint64_t next_literal_{kNoPosition};
+};
+
+// Append count values LSB-first at width bits each, rounded up to whole bytes.
+void append_packed_values(std::string& out,
+                          const std::uint32_t* values,
+                          std::size_t count,
+                          unsigned width) {
+    const std::size_t begin = out.size();
+    const std::size_t packed_bytes = (count * width + 7) / 8;
+    out.append(packed_bytes + sizeof(std::uint64_t), '\0');
+    auto* data = reinterpret_cast<unsigned char*>(out.data() + begin);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t bit = i * width;
+        std::uint64_t word = 0;
+        std::memcpy(&word, data + bit / 8, sizeof(word));
+        word |= static_cast<std::uint64_t>(values[i]) << (bit % 8);
+        std::memcpy(data + bit / 8, &word, sizeof(word));
+    }
+    out.resize(begin + packed_bytes);
 }
 
-// Encode one node's postings as path-grouped varints:
-// - delta(path_id) from the previous path group
-// - count of occurrences for this path
-// - first step rank in that path
-// - delta(step_rank) for each later occurrence in the same path
+// Encode one node's postings as chunks of up to kPostingChunkSize postings:
+// - varint first path id in the chunk
+// - varint step base: the smallest step rank in the chunk
+// - u8 path-delta width, u8 step-value width
+// - bitpacked path-id deltas from the previous posting (0 for the first)
+// - bitpacked step values: step_rank - step_base
 //
-// This keeps random access at node granularity: the node table still points to
-// one contiguous byte block per node, but that block is typically much smaller
-// than the old fixed-width array of (path_id, step_rank) pairs.
+// Steps are frame-of-reference coded rather than delta coded so they decode
+// without a dependency between postings; haplotypes that cross a node at
+// similar ranks still share a small step width. The node table still points
+// at one contiguous byte block per node; for nodes with a skip table the block
+// starts with the PostingSkipDisk entries.
 void append_compressed_posting_block(std::string& out,
                                      const std::vector<TempPosting>& postings,
                                      std::size_t begin,
                                      std::size_t end) {
-    std::uint32_t prev_path_id = 0;
-    bool first_group = true;
-
-    for (std::size_t cursor = begin; cursor < end;) {
-        const std::uint32_t path_id = postings[cursor].path_id;
-        std::size_t group_end = cursor + 1;
-        while (group_end < end && postings[group_end].path_id == path_id) {
-            ++group_end;
+    std::array<std::uint32_t, kPostingChunkSize> path_deltas;
+    std::array<std::uint32_t, kPostingChunkSize> step_values;
+
+    const std::uint64_t skip_count = posting_skip_count(end - begin);
+    const std::size_t skip_table_begin = out.size();
+    out.append(static_cast<std::size_t>(skip_count * sizeof(PostingSkipDisk)), '\0');
+    const std::size_t chunks_begin = out.size();
+
+    std::uint32_t chunk_index = 0;
+    for (std::size_t chunk = begin; chunk < end; chunk += kPostingChunkSize, ++chunk_index) {
+        const std::size_t count = std::min(kPostingChunkSize, end - chunk);
+        if (skip_count != 0 && chunk_index % kPostingSkipInterval == 0) {
+            PostingSkipDisk skip{};
+            skip.byte_offset = out.size() - chunks_begin;
+            skip.first_path_id = postings[chunk].path_id;
+            skip.chunk_index = chunk_index;
+            std::memcpy(out.data() + skip_table_begin +
+                            (chunk_index / kPostingSkipInterval) * sizeof(PostingSkipDisk),
+                        &skip, sizeof(skip));
         }
 
-        const std::uint64_t path_delta = first_group ? path_id
-                                                     : static_cast<std::uint64_t>(path_id - prev_path_id);
-        append_varint(out, path_delta);
-        append_varint(out, group_end - cursor);
-        append_varint(out, postings[cursor].step_rank);
+        std::uint32_t step_base = std::numeric_limits<std::uint32_t>::max();
+        for (std::size_t i = 0; i < count; ++i) {
+            step_base = std::min(step_base, postings[chunk + i].step_rank);
+        }
 
-        std::uint32_t prev_step_rank = postings[cursor].step_rank;
-        for (std::size_t i = cursor + 1; i < group_end; ++i) {
-            append_varint(out, static_cast<std::uint64_t>(postings[i].step_rank - prev_step_rank));
-            prev_step_rank = postings[i].step_rank;
+        std::uint32_t max_path_delta = 0;
+        std::uint32_t max_step_value = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto& posting = postings[chunk + i];
+            path_deltas[i] = i == 0 ? 0 : posting.path_id - postings[chunk + i - 1].path_id;
+            step_values[i] = posting.step_rank - step_base;
+            max_path_delta = std::max(max_path_delta, path_deltas[i]);
+            max_step_value = std::max(max_step_value, step_values[i]);
         }
 
-        prev_path_id = path_id;
-        first_group = false;
-        cursor = group_end;
+        const unsigned path_width = bit_width(max_path_delta);
+        const unsigned step_width = bit_width(max_step_value);
+        append_varint(out, postings[chunk].path_id);
+        append_varint(out, step_base);
+        out.push_back(static_cast<char>(path_width));
+        out.push_back(static_cast<char>(step_width));
+        append_packed_values(out, path_deltas.data(), count, path_width);
+        append_packed_values(out, step_values.data(), count, step_width);
     }
 }
 
@@ -308,15 +991,77 @@ void remove_paths_if_present(const std::vector<std::string>& paths) {
     }
 }
 
+// Stable LSD radix sort on the node id. Runs are filled in (path, step)
+// order, so ordering by node alone gives the full (node, path, step) order.
+void radix_sort_postings_by_node(std::vector<TempPosting>& postings,
+                                 std::vector<TempPosting>& scratch,
+                                 std::uint32_t max_node_id) {
+    const unsigned key_bits = bit_width(max_node_id);
+    scratch.resize(postings.size());
+    std::array<std::size_t, kPostingRadixBuckets> offsets;
+    for (unsigned shift = 0; shift < key_bits; shift += kPostingRadixBits) {
+        offsets.fill(0);
+        for (const auto& posting : postings) {
+            ++offsets[(posting.node_id >> shift) & (kPostingRadixBuckets - 1)];
+        }
+        std::size_t offset = 0;
+        for (auto& bucket : offsets) {
+            const std::size_t count = bucket;
+            bucket = offset;
+            offset += count;
+        }
+        for (const auto& posting : postings) {
+            scratch[offsets[(posting.node_id >> shift) & (kPostingRadixBuckets - 1)]++] = posting;
+        }
+        postings.swap(scratch);
+    }
+}
+
+// Stable LSD radix sort of (path_id << 32 | step_rank) keys. Only the digits
+// that can be set are sorted: step_bits low bits of the step rank and
+// path_bits low bits of the path id.
+void radix_sort_path_step_keys(std::vector<std::uint64_t>& keys,
+                               std::vector<std::uint64_t>& scratch,
+                               unsigned step_bits,
+                               unsigned path_bits) {
+    scratch.resize(keys.size());
+    std::array<std::size_t, kPostingRadixBuckets> offsets;
+    const auto sort_digit = [&](unsigned shift) {
+        offsets.fill(0);
+        for (const auto key : keys) {
+            ++offsets[(key >> shift) & (kPostingRadixBuckets - 1)];
+        }
+        std::size_t offset = 0;
+        for (auto& bucket : offsets) {
+            const std::size_t count = bucket;
+            bucket = offset;
+            offset += count;
+        }
+        for (const auto key : keys) {
+            scratch[offsets[(key >> shift) & (kPostingRadixBuckets - 1)]++] = key;
+        }
+        keys.swap(scratch);
+    };
+    for (unsigned shift = 0; shift < step_bits; shift += kPostingRadixBits) {
+        sort_digit(shift);
+    }
+    for (unsigned shift = 0; shift < path_bits; shift += kPostingRadixBits) {
+        sort_digit(32 + shift);
+    }
+}
+
 // Open every posting run in one bounded merge group so the heap can pull the
 // next smallest posting from each run without loading whole files into memory.
-std::vector<PostingRunCursor> open_posting_runs(const std::vector<std::string>& run_paths) {
-    std::vector<PostingRunCursor> runs;
-    runs.reserve(run_paths.size());
-    for (const auto& path : run_paths) {
-        runs.emplace_back(path);
-    }
-    return runs;
+// The runs must outlive the cursors.
+std::vector<PostingRunCursor> open_posting_runs(const std::vector<PostingRun>& runs,
+                                                std::uint32_t node_begin,
+                                                std::uint32_t node_end) {
+    std::vector<PostingRunCursor> cursors;
+    cursors.reserve(runs.size());
+    for (const auto& run : runs) {
+        cursors.emplace_back(run, node_begin, node_end);
+    }
+    return cursors;
 }
 
 // Seed the heap with the first posting from each sorted run.
@@ -335,131 +1080,142 @@ std::priority_queue<PostingHeapItem,
 }
 
 // Merge one bounded group of sorted posting runs into a larger sorted run.
-void merge_sorted_runs_to_run_file(const std::vector<std::string>& run_paths,
-                                   const std::string& output_path) {
-    std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
-    if (!out) {
-        throw std::runtime_error("Failed to open intermediate posting run file: " + output_path);
-    }
-
-    auto runs = open_posting_runs(run_paths);
+PostingRun merge_sorted_runs_to_run_file(const std::vector<PostingRun>& group,
+                                         const std::string& output_path) {
+    PostingRunWriter out(output_path);
+    auto runs = open_posting_runs(group, 0, std::numeric_limits<std::uint32_t>::max());
     auto heap = build_posting_heap(runs);
 
     while (!heap.empty()) {
         const auto item = heap.top();
         heap.pop();
 
-        write_binary_record(out, item.posting);
-        if (!out.good()) {
-            throw std::runtime_error("Failed while writing intermediate posting run file: " + output_path);
-        }
+        out.add(item.posting);
 
         auto& run = runs[item.run_index];
         if (run.advance()) {
             heap.push(PostingHeapItem{run.current, item.run_index});
         }
     }
+    return out.finish();
+}
+
+void remove_posting_runs(const std::vector<PostingRun>& runs) {
+    for (const auto& run : runs) {
+        std::error_code ec;
+        std::filesystem::remove(run.path, ec);
+    }
 }
 
 // Repeatedly merge posting runs in bounded groups until the final merge width
-// fits under the configured fan-in cap.
-std::vector<std::string> collapse_posting_runs(std::vector<std::string> run_paths,
-                                               const std::string& temp_dir) {
-    if (run_paths.size() <= kPostingMergeFanIn) {
-        return run_paths;
+// fits under fan_in. The groups of one pass are merged on worker threads.
+std::vector<PostingRun> collapse_posting_runs(std::vector<PostingRun> runs,
+                                              const std::string& temp_dir,
+                                              std::size_t fan_in,
+                                              std::size_t threads) {
+    if (runs.size() <= fan_in) {
+        return runs;
     }
 
-    std::cout << get_time() << ": Collapsing " << run_paths.size()
-              << " posting runs with fan-in " << kPostingMergeFanIn << std::endl;
+    std::cout << get_time() << ": Collapsing " << runs.size()
+              << " posting runs with fan-in " << fan_in << std::endl;
 
     std::size_t pass = 0;
-    while (run_paths.size() > kPostingMergeFanIn) {
-        std::vector<std::string> merged_paths;
-        merged_paths.reserve((run_paths.size() + kPostingMergeFanIn - 1) / kPostingMergeFanIn);
-        const std::size_t input_run_count = run_paths.size();
-        const std::size_t total_groups = merged_paths.capacity();
+    while (runs.size() > fan_in) {
+        const std::size_t group_count = (runs.size() + fan_in - 1) / fan_in;
+        std::vector<PostingRun> merged(group_count);
 
         std::cout << get_time() << ": Merge pass " << pass
-                  << ": " << input_run_count << " runs -> "
-                  << total_groups << " merged runs" << std::endl;
+                  << ": " << runs.size() << " runs -> "
+                  << group_count << " merged runs" << std::endl;
 
-        for (std::size_t begin = 0; begin < run_paths.size(); begin += kPostingMergeFanIn) {
-            const std::size_t end = std::min(run_paths.size(), begin + kPostingMergeFanIn);
-            std::vector<std::string> group(run_paths.begin() + static_cast<std::ptrdiff_t>(begin),
-                                           run_paths.begin() + static_cast<std::ptrdiff_t>(end));
+        utils::run_parallel_tasks(group_count, threads, [&](std::size_t group_index) {
+            const std::size_t begin = group_index * fan_in;
+            const std::size_t end = std::min(runs.size(), begin + fan_in);
+            std::vector<PostingRun> group(runs.begin() + static_cast<std::ptrdiff_t>(begin),
+                                          runs.begin() + static_cast<std::ptrdiff_t>(end));
 
             const std::string merged_path =
                 temp_dir + "/posting_merge_pass_" + std::to_string(pass) + "_" +
-                std::to_string(merged_paths.size()) + ".bin";
-            merge_sorted_runs_to_run_file(group, merged_path);
-            merged_paths.push_back(merged_path);
+                std::to_string(group_index) + ".bin";
+            merged[group_index] = merge_sorted_runs_to_run_file(group, merged_path);
 
             // Once a bounded-fan-in merge group has been materialized, its input
             // runs are no longer needed for later passes or final assembly.
-            remove_paths_if_present(group);
+            remove_posting_runs(group);
+        });
 
-            if (merged_paths.size() % 10 == 0 || merged_paths.size() == total_groups) {
-                std::cout << get_time() << ": Merge pass " << pass
-                          << " completed " << merged_paths.size()
-                          << "/" << total_groups << " groups" << std::endl;
-            }
-        }
+        std::cout << get_time() << ": Merge pass " << pass
+                  << " completed " << group_count << " groups" << std::endl;
 
-        run_paths.swap(merged_paths);
+        runs.swap(merged);
         ++pass;
     }
 
-    return run_paths;
+    return runs;
 }
 
-// Merge the final posting runs in node/path/step order and compress one node's
-// postings at a time into the on-disk posting blob.
-std::uint64_t build_compressed_posting_blob_from_runs(
-    const std::vector<std::string>& run_paths,
-    std::vector<NodeRecordDisk>& node_records,
-    const std::string& output_path) {
-
-    std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
-    if (!out) {
-        throw std::runtime_error("Failed to open temporary posting blob: " + output_path);
+// Split the node ids into up to range_count ranges holding about the same
+// number of postings, using the run block directories as the sample.
+std::vector<std::uint32_t> posting_range_bounds(const std::vector<PostingRun>& runs,
+                                                std::uint32_t node_count,
+                                                std::size_t range_count) {
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> samples;
+    std::uint64_t total = 0;
+    for (const auto& run : runs) {
+        for (const auto& block : run.blocks) {
+            samples.emplace_back(block.first_node_id, block.posting_count);
+            total += block.posting_count;
+        }
     }
+    std::sort(samples.begin(), samples.end());
 
-    if (run_paths.empty()) {
-        for (auto& rec : node_records) {
-            rec.posting_begin = 0;
-            rec.posting_count = 0;
+    std::vector<std::uint32_t> bounds{0};
+    std::uint64_t seen = 0;
+    for (const auto& [node_id, count] : samples) {
+        if (bounds.size() < range_count &&
+            seen * range_count >= total * bounds.size() &&
+            node_id > bounds.back()) {
+            bounds.push_back(node_id);
         }
-        return 0;
+        seen += count;
     }
+    bounds.push_back(node_count);
+    return bounds;
+}
 
-    auto runs = open_posting_runs(run_paths);
-    auto heap = build_posting_heap(runs);
-
-    std::cout << get_time() << ": Final posting merge across "
-              << run_paths.size() << " run files" << std::endl;
+// Merge the postings of nodes [node_begin, node_end) from every run and
+// compress one node at a time into out. Node records in the range get offsets
+// relative to the start of this range's output; returns the bytes written.
+std::uint64_t compress_posting_range(const std::vector<PostingRun>& runs,
+                                     std::uint32_t node_begin,
+                                     std::uint32_t node_end,
+                                     std::vector<NodeRecordDisk>& node_records,
+                                     std::ofstream& out,
+                                     std::atomic<std::uint64_t>& merged_postings) {
+    auto cursors = open_posting_runs(runs, node_begin, node_end);
+    auto heap = build_posting_heap(cursors);
 
     std::vector<TempPosting> node_postings;
+    std::string block;
     std::uint64_t current_offset = 0;
-    std::size_t next_node_record = 0;
-    std::uint32_t current_node_id = 0;
-    bool have_current_node = false;
-    std::uint64_t merged_postings = 0;
+    std::uint32_t next_node_record = node_begin;
 
     auto flush_node = [&]() {
-        if (!have_current_node) return;
+        if (node_postings.empty()) return;
+        const std::uint32_t node_id = node_postings.front().node_id;
 
-        while (next_node_record < current_node_id) {
+        while (next_node_record < node_id) {
             node_records[next_node_record].posting_begin = current_offset;
             node_records[next_node_record].posting_count = 0;
             ++next_node_record;
         }
 
-        std::string block;
-        block.reserve(node_postings.size() * 2);
+        block.clear();
         append_compressed_posting_block(block, node_postings, 0, node_postings.size());
 
-        node_records[current_node_id].posting_begin = current_offset;
-        node_records[current_node_id].posting_count =
+        node_records[node_id].posting_begin = current_offset;
+        node_records[node_id].posting_count =
             static_cast<std::uint64_t>(node_postings.size());
         if (!block.empty()) {
             out.write(block.data(), static_cast<std::streamsize>(block.size()));
@@ -469,32 +1225,27 @@ std::uint64_t build_compressed_posting_blob_from_runs(
         }
 
         current_offset += block.size();
-        ++next_node_record;
+        next_node_record = node_id + 1;
+
+        const std::uint64_t before = merged_postings.fetch_add(node_postings.size());
+        const std::uint64_t after = before + node_postings.size();
+        if (before / kPostingMergeProgressInterval != after / kPostingMergeProgressInterval) {
+            std::cout << (get_time() + ": Merged " + std::to_string(after) +
+                          " postings into node blocks\n") << std::flush;
+        }
         node_postings.clear();
-        have_current_node = false;
     };
 
     while (!heap.empty()) {
         const auto item = heap.top();
         heap.pop();
 
-        if (!have_current_node) {
-            current_node_id = item.posting.node_id;
-            have_current_node = true;
-        } else if (item.posting.node_id != current_node_id) {
+        if (!node_postings.empty() && item.posting.node_id != node_postings.front().node_id) {
             flush_node();
-            current_node_id = item.posting.node_id;
-            have_current_node = true;
         }
-
         node_postings.push_back(item.posting);
-        ++merged_postings;
-        if (merged_postings % kPostingMergeProgressInterval == 0) {
-            std::cout << get_time() << ": Merged "
-                      << merged_postings << " postings into node blocks" << std::endl;
-        }
 
-        auto& run = runs[item.run_index];
+        auto& run = cursors[item.run_index];
         if (run.advance()) {
             heap.push(PostingHeapItem{run.current, item.run_index});
         }
@@ -502,40 +1253,115 @@ std::uint64_t build_compressed_posting_blob_from_runs(
 
     flush_node();
 
-    std::cout << get_time() << ": Final posting merge wrote "
-              << merged_postings << " postings into compressed node blocks" << std::endl;
-
-    while (next_node_record < node_records.size()) {
+    while (next_node_record < node_end) {
         node_records[next_node_record].posting_begin = current_offset;
         node_records[next_node_record].posting_count = 0;
         ++next_node_record;
     }
+    return current_offset;
+}
+
+// Merge the final posting runs in node/path/step order and compress one node's
+// postings at a time into the on-disk posting blob. With several threads each
+// worker compresses its own node range into a segment file, and the segments
+// are concatenated in node order, which gives the same bytes as one merge.
+std::uint64_t build_compressed_posting_blob_from_runs(
+    const std::vector<PostingRun>& runs,
+    std::vector<NodeRecordDisk>& node_records,
+    const std::string& output_path,
+    const std::string& temp_dir,
+    std::size_t threads) {
+
+    std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Failed to open temporary posting blob: " + output_path);
+    }
+
+    const char padding[kPostingDataPadding] = {};
+    if (runs.empty()) {
+        for (auto& rec : node_records) {
+            rec.posting_begin = 0;
+            rec.posting_count = 0;
+        }
+        out.write(padding, static_cast<std::streamsize>(kPostingDataPadding));
+        if (!out.good()) {
+            throw std::runtime_error("Failed while writing temporary posting blob");
+        }
+        return kPostingDataPadding;
+    }
+
+    const auto node_count = static_cast<std::uint32_t>(node_records.size());
+    const auto bounds = posting_range_bounds(
+        runs, node_count, threads > 1 ? threads * kPostingRangesPerWorker : 1);
+    const std::size_t range_count = bounds.size() - 1;
+
+    std::cout << get_time() << ": Final posting merge across "
+              << runs.size() << " run files";
+    if (range_count > 1) {
+        std::cout << " in " << range_count << " node ranges";
+    }
+    std::cout << std::endl;
 
+    std::atomic<std::uint64_t> merged_postings{0};
+    std::uint64_t current_offset = 0;
+    if (range_count == 1) {
+        current_offset = compress_posting_range(runs, 0, node_count, node_records, out, merged_postings);
+    } else {
+        std::vector<std::string> segment_paths(range_count);
+        std::vector<std::uint64_t> segment_bytes(range_count);
+        for (std::size_t i = 0; i < range_count; ++i) {
+            segment_paths[i] = temp_dir + "/posting_segment_" + std::to_string(i) + ".bin";
+        }
+
+        utils::run_parallel_tasks(range_count, threads, [&](std::size_t i) {
+            std::ofstream segment(segment_paths[i], std::ios::binary | std::ios::trunc);
+            if (!segment) {
+                throw std::runtime_error("Failed to open temporary posting segment: " + segment_paths[i]);
+            }
+            segment_bytes[i] = compress_posting_range(runs, bounds[i], bounds[i + 1],
+                                                      node_records, segment, merged_postings);
+            segment.close();
+            if (!segment) {
+                throw std::runtime_error("Failed while writing temporary posting segment: " + segment_paths[i]);
+            }
+        });
+
+        for (std::size_t i = 0; i < range_count; ++i) {
+            for (std::uint32_t node_id = bounds[i]; node_id < bounds[i + 1]; ++node_id) {
+                node_records[node_id].posting_begin += current_offset;
+            }
+            append_file_to_stream(out, segment_paths[i]);
+            current_offset += segment_bytes[i];
+        }
+        remove_paths_if_present(segment_paths);
+    }
+
+    std::cout << get_time() << ": Final posting merge wrote "
+              << merged_postings.load() << " postings into compressed node blocks" << std::endl;
+
+    out.write(padding, static_cast<std::streamsize>(kPostingDataPadding));
     if (!out.good()) {
         throw std::runtime_error("Failed while finalizing temporary posting blob");
     }
-    return current_offset;
+    return current_offset + kPostingDataPadding;
 }
 
-ParsedPathFields parse_path_fields(std::string_view line) {
-    const size_t t1 = line.find('\t');
-    if (t1 == npos) offending_line(line);
-    const size_t t2 = line.find('\t', t1 + 1);
-    if (t2 == npos) offending_line(line);
-    const size_t t3 = line.find('\t', t2 + 1);
-    if (t3 == npos) offending_line(line);
-    const size_t t4 = line.find('\t', t3 + 1);
-
-    ParsedPathFields out;
-    out.name = std::string(line.substr(t1 + 1, t2 - (t1 + 1)));
-    out.segments = line.substr(t2 + 1, t3 - (t2 + 1));
-    if (t4 == npos) {
-        out.overlaps = line.substr(t3 + 1);
-    } else {
-        out.overlaps = line.substr(t3 + 1, t4 - (t3 + 1));
-        out.tags = line.substr(t4 + 1);
+// Field delimiters of streamed P/W lines: a tab ends a field, the end of
+// the line ends the last one.
+bool is_field_end(char terminator) {
+    return terminator == '\t' || terminator == '\n';
+}
+
+// Read the next tab-separated field of a streamed P/W line that must be
+// followed by another field.
+std::string_view next_inner_field(LineTokenizer& tokens, char record_type) {
+    std::string_view field;
+    char terminator = 0;
+    if (!tokens.next("\t", field, terminator) || terminator != '\t') {
+        throw std::runtime_error(std::string("Malformed ") + record_type +
+                                 " line: missing tab-separated fields");
     }
-    return out;
+    return field;
 }
 
 std::int64_t parse_optional_int_field(std::string_view value) {
@@ -543,6 +1369,22 @@ std::int64_t parse_optional_int_field(std::string_view value) {
     return std::stoll(std::string(value));
 }
 
+std::string coordinate_namespace(char record_type,
+                                 std::string_view name,
+                                 std::string_view sample_id,
+                                 std::uint64_t hap_index,
+                                 std::string_view seq_id) {
+    if (record_type != 'W') {
+        return std::string(parse_p_path_coordinate_name(name).coordinate_name);
+    }
+    std::string out(sample_id);
+    out += '#';
+    out += std::to_string(hap_index);
+    out += '#';
+    out += seq_id;
+    return out;
+}
+
 // W-lines do not have a single path-name field, so we synthesize a canonical
 // key that exact lookup can use just like a normal path id.
 std::string make_walk_key(const std::string& sample_id,
@@ -555,130 +1397,415 @@ std::string make_walk_key(const std::string& sample_id,
     return sample_id + "|" + std::to_string(hap_index) + "|" + seq_id + "|" + start_text + "|" + end_text;
 }
 
-ParsedWalkFields parse_walk_fields(std::string_view line) {
-    size_t tabs[6];
-    size_t pos = 0;
-    for (int i = 0; i < 6; ++i) {
-        tabs[i] = line.find('\t', pos);
-        if (tabs[i] == npos) offending_line(line);
-        pos = tabs[i] + 1;
-    }
-    const size_t t7 = line.find('\t', tabs[5] + 1);
-
-    ParsedWalkFields out;
-    out.sample_id = std::string(line.substr(tabs[0] + 1, tabs[1] - (tabs[0] + 1)));
-    out.hap_index = static_cast<std::uint64_t>(std::stoull(std::string(
-        line.substr(tabs[1] + 1, tabs[2] - (tabs[1] + 1)))));
-    out.seq_id = std::string(line.substr(tabs[2] + 1, tabs[3] - (tabs[2] + 1)));
-    out.seq_start = parse_optional_int_field(line.substr(tabs[3] + 1, tabs[4] - (tabs[3] + 1)));
-    out.seq_end = parse_optional_int_field(line.substr(tabs[4] + 1, tabs[5] - (tabs[4] + 1)));
-    if (t7 == npos) {
-        out.walk = line.substr(tabs[5] + 1);
-    } else {
-        out.walk = line.substr(tabs[5] + 1, t7 - (tabs[5] + 1));
-        out.tags = line.substr(t7 + 1);
-    }
-    return out;
+// We only need the node id field from S lines here, so this avoids the heavier
+// generic S-line parsing path and never reads the sequence into memory.
+std::string extract_s_node_id(LineTokenizer& tokens) {
+    next_inner_field(tokens, 'S');
+    return std::string(next_inner_field(tokens, 'S'));
 }
 
-// We only need the node id field from S lines here, so this avoids the heavier
-// generic S-line parsing path.
-std::string extract_s_node_id(std::string_view line) {
-    const size_t t1 = line.find('\t');
-    if (t1 == npos) offending_line(line);
-    const size_t t2 = line.find('\t', t1 + 1);
-    if (t2 == npos) offending_line(line);
-    return std::string(line.substr(t1 + 1, t2 - (t1 + 1)));
-}
-
-// Parse the step list of one P line and emit:
-// - the path-first step records
-// - the node-first postings used later for node-set queries
+// Resolves P/W step names to their .ndx ranks. Pass 1 checks that the S lines
+// and the .ndx hold the same node set, so the .ndx stands in for an in-memory
+// name table. Graphs revisit the same nodes in many paths, so the 96 bits of
+// name hash are cached per slot and a repeated name costs two hashes and one
+// compare. Each parse thread owns its own resolver.
+class NodeRankResolver {
+public:
+    explicit NodeRankResolver(const indexer::NodeHashIndex& node_index)
+        : node_index_(node_index), slots_(std::size_t{1} << kNodeRankCacheBits) {}
+
+    bool resolve(std::string_view node_name, std::uint32_t& out_rank) {
+        const std::uint64_t hash = indexer::fnv1a_hash64(node_name);
+        const std::uint32_t hash32 = indexer::fnv1a_hash32(node_name);
+        auto& slot = slots_[static_cast<std::size_t>(hash >> (64 - kNodeRankCacheBits))];
+        if (slot.filled && slot.hash == hash && slot.hash32 == hash32) {
+            out_rank = slot.rank;
+            return true;
+        }
+        if (!node_index_.lookup_rank_hashed(hash, hash32, out_rank)) return false;
+        slot = Slot{hash, hash32, out_rank, true};
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::uint64_t hash{};
+        std::uint32_t hash32{};
+        std::uint32_t rank{};
+        bool filled{false};
+    };
+
+    const indexer::NodeHashIndex& node_index_;
+    std::vector<Slot> slots_;
+};
+
+// Parse the step list of one streamed P line and pass each resolved step to
+// sink(StepRecordDisk step, uint32_t step_rank). Callers turn those into the
+// path-first step records and the node-first postings. Only one step token is
+// held at a time, so memory does not grow with the path length. terminator
+// receives the byte that ended the field.
+template <typename StepSink>
 std::uint64_t parse_path_steps(
-    std::string_view segments,
-    const std::unordered_map<std::string, std::uint32_t>& node_to_id,
-    std::uint32_t path_id,
-    std::ofstream& steps_out,
-    PostingRunBuilder& posting_runs) {
+    LineTokenizer& tokens,
+    NodeRankResolver& node_ranks,
+    StepSink&& sink,
+    char& terminator) {
 
-    std::string node_name;
     std::uint32_t step_rank = 0;
+    std::string_view token;
 
-    for (size_t pos = 0; pos < segments.size();) {
-        const size_t comma = segments.find_first_of(",;", pos);
-        const size_t end = (comma == npos) ? segments.size() : comma;
-        const std::string_view token = segments.substr(pos, end - pos);
+    while (tokens.next(",;\t", token, terminator)) {
+        const bool field_end = is_field_end(terminator);
+        // An empty step list, or a trailing separator, ends the field.
+        if (token.empty() && field_end) break;
         if (token.size() < 2) {
             throw std::runtime_error("Malformed path step token");
         }
 
-        const char orient = token.back();
-        if (orient != '+' && orient != '-') {
-            throw std::runtime_error("Malformed path step orientation");
+        const char orient = token.back();
+        if (orient != '+' && orient != '-') {
+            throw std::runtime_error("Malformed path step orientation");
+        }
+
+        const std::string_view node_name = token.substr(0, token.size() - 1);
+        std::uint32_t node_id = 0;
+        if (!node_ranks.resolve(node_name, node_id)) {
+            throw std::runtime_error("Path references unknown node id: " + std::string(node_name));
+        }
+
+        sink(pack_step_record(node_id, orient == '-'), step_rank);
+        ++step_rank;
+        if (field_end) break;
+    }
+
+    return step_rank;
+}
+
+// Parse the oriented step sequence of one streamed W line and pass each
+// resolved step to sink the same way as parse_path_steps().
+template <typename StepSink>
+std::uint64_t parse_walk_steps(
+    LineTokenizer& tokens,
+    NodeRankResolver& node_ranks,
+    StepSink&& sink,
+    char& terminator) {
+
+    std::uint32_t step_rank = 0;
+    std::string_view token;
+
+    // Every node name follows its orientation, so the text before the first
+    // orientation must be empty.
+    if (!tokens.next("><\t", token, terminator)) return 0;
+    if (!token.empty()) {
+        throw std::runtime_error("Malformed W walk orientation");
+    }
+
+    while (!is_field_end(terminator)) {
+        const char orient = terminator;
+        tokens.next("><\t", token, terminator);
+        if (token.empty()) {
+            throw std::runtime_error("Malformed W walk token");
+        }
+
+        std::uint32_t node_id = 0;
+        if (!node_ranks.resolve(token, node_id)) {
+            throw std::runtime_error("Walk references unknown node id: " + std::string(token));
+        }
+
+        sink(pack_step_record(node_id, orient == '<'), step_rank);
+        ++step_rank;
+    }
+
+    return step_rank;
+}
+
+// Parse one streamed P or W line into its path metadata and pass its steps to
+// sink. The caller fills in the step and phrase offsets.
+template <typename StepSink>
+PathBuildEntry parse_path_record(LineTokenizer& tokens,
+                                 NodeRankResolver& node_ranks,
+                                 StepSink&& sink) {
+    PathBuildEntry entry;
+    entry.record_type = next_inner_field(tokens, 'P')[0];
+
+    std::string_view field;
+    char terminator = 0;
+    if (entry.record_type == 'P') {
+        entry.name = std::string(next_inner_field(tokens, 'P'));
+        entry.step_count = parse_path_steps(tokens, node_ranks, sink, terminator);
+        if (terminator != '\t') {
+            throw std::runtime_error("Malformed P line: missing tab-separated fields");
+        }
+        tokens.next("\t", field, terminator);
+        entry.overlaps = std::string(field);
+    } else {
+        entry.sample_id = std::string(next_inner_field(tokens, 'W'));
+        entry.hap_index = static_cast<std::uint64_t>(
+            std::stoull(std::string(next_inner_field(tokens, 'W'))));
+        entry.seq_id = std::string(next_inner_field(tokens, 'W'));
+        entry.seq_start = parse_optional_int_field(next_inner_field(tokens, 'W'));
+        entry.seq_end = parse_optional_int_field(next_inner_field(tokens, 'W'));
+        entry.name = make_walk_key(entry.sample_id,
+                                   entry.hap_index,
+                                   entry.seq_id,
+                                   entry.seq_start,
+                                   entry.seq_end);
+        entry.step_count = parse_walk_steps(tokens, node_ranks, sink, terminator);
+    }
+    // Everything after the last fixed field is kept verbatim as tags.
+    if (terminator == '\t' && tokens.next("", field, terminator)) {
+        entry.tags = std::string(field);
+    }
+    return entry;
+}
+
+// Pass 2 with worker threads. The calling thread reads P/W lines into
+// batches, workers tokenize them, resolve node ids, and spill postings into
+// their own PostingRunBuilder, and one writer thread feeds the resolved steps
+// to steps_out in input order. Path ids and step offsets are assigned in
+// input order, and the final posting merge sorts by (node, path, step), so
+// the .pdx is byte-identical to the serial scan.
+void scan_path_records_parallel(const std::string& input_gfa,
+                                const Reader::Options& reader_options,
+                                const indexer::NodeHashIndex& node_index,
+                                std::size_t worker_count,
+                                std::vector<PostingRunBuilder>& posting_runs,
+                                StepPhraseWriter& steps_out,
+                                PathCheckpointWriter* checkpoints,
+                                std::vector<PathBuildEntry>& paths,
+                                std::uint64_t& total_steps) {
+    struct LineBatch {
+        std::uint32_t first_path_id{};
+        std::string text;
+        std::vector<std::size_t> line_ends;
+    };
+    struct ParsedBatch {
+        std::vector<PathBuildEntry> entries;
+        std::vector<StepRecordDisk> steps;
+    };
+
+    std::mutex state_mutex;
+    std::condition_variable work_available;
+    std::condition_variable result_available;
+    std::condition_variable space_available;
+    std::deque<std::pair<std::size_t, LineBatch>> pending;
+    std::map<std::size_t, ParsedBatch> parsed;
+    std::size_t next_sequence = 0;
+    std::size_t next_write = 0;
+    bool input_done = false;
+    bool stop = false;
+    std::exception_ptr error;
+    const std::size_t max_in_flight = worker_count * kPathBatchesPerWorker;
+
+    const auto fail = [&](std::exception_ptr failure) {
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            if (!error) error = failure;
+            stop = true;
         }
+        work_available.notify_all();
+        result_available.notify_all();
+        space_available.notify_all();
+    };
 
-        node_name.assign(token.data(), token.size() - 1);
-        const auto it = node_to_id.find(node_name);
-        if (it == node_to_id.end()) {
-            throw std::runtime_error("Path references unknown node id: " + node_name);
-        }
+    const auto run_worker = [&](PostingRunBuilder& worker_postings) {
+        try {
+            NodeRankResolver node_ranks(node_index);
+            while (true) {
+                std::size_t sequence = 0;
+                LineBatch batch;
+                {
+                    std::unique_lock<std::mutex> lock(state_mutex);
+                    work_available.wait(lock, [&]() { return stop || input_done || !pending.empty(); });
+                    if (stop || pending.empty()) return;
+                    sequence = pending.front().first;
+                    batch = std::move(pending.front().second);
+                    pending.pop_front();
+                }
 
-        const auto step = pack_step_record(it->second, orient == '-');
-        write_binary_record(steps_out, step);
-        if (!steps_out.good()) {
-            throw std::runtime_error("Failed while writing temporary step file");
+                ParsedBatch result;
+                result.entries.reserve(batch.line_ends.size());
+                LineTokenizer tokens;
+                std::size_t line_begin = 0;
+                for (std::size_t i = 0; i < batch.line_ends.size(); ++i) {
+                    tokens.start(std::string_view(batch.text.data() + line_begin,
+                                                  batch.line_ends[i] - line_begin),
+                                 true);
+                    const auto path_id = static_cast<std::uint32_t>(batch.first_path_id + i);
+                    result.entries.push_back(parse_path_record(tokens, node_ranks,
+                        [&](StepRecordDisk step, std::uint32_t step_rank) {
+                            result.steps.push_back(step);
+                            worker_postings.add(step.node_id(), path_id, step_rank);
+                        }));
+                    line_begin = batch.line_ends[i];
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(state_mutex);
+                    parsed.emplace(sequence, std::move(result));
+                }
+                result_available.notify_all();
+            }
+        } catch (...) {
+            fail(std::current_exception());
         }
-        posting_runs.add(it->second, path_id, step_rank);
-        ++step_rank;
+    };
 
-        if (comma == npos) break;
-        pos = comma + 1;
-    }
+    // Close the steps of one path in steps_out and record it. Called by the
+    // writer, or by the reader thread for a streamed line once the writer has
+    // drained every earlier batch.
+    const auto finish_entry = [&](PathBuildEntry&& entry) {
+        entry.step_begin = total_steps;
+        entry.step_phrase_begin = steps_out.finish_path(entry.step_phrase_count);
+        if (checkpoints) checkpoints->finish_path();
+        total_steps += entry.step_count;
+        paths.push_back(std::move(entry));
+        if (paths.size() % kPathRecordProgressInterval == 0) {
+            std::cout << get_time() << ": Parsed "
+                      << paths.size() << " P/W records covering "
+                      << total_steps << " steps" << std::endl;
+        }
+    };
 
-    return step_rank;
-}
+    const auto run_writer = [&]() {
+        try {
+            while (true) {
+                ParsedBatch batch;
+                {
+                    std::unique_lock<std::mutex> lock(state_mutex);
+                    result_available.wait(lock, [&]() {
+                        return stop || parsed.count(next_write) != 0 ||
+                               (input_done && next_write == next_sequence);
+                    });
+                    if (stop) return;
+                    const auto it = parsed.find(next_write);
+                    if (it == parsed.end()) return;
+                    batch = std::move(it->second);
+                    parsed.erase(it);
+                }
 
-// Parse the oriented step sequence of one W line and emit packed steps plus
-// raw postings for the external-sort pipeline.
-std::uint64_t parse_walk_steps(
-    std::string_view walk,
-    const std::unordered_map<std::string, std::uint32_t>& node_to_id,
-    std::uint32_t path_id,
-    std::ofstream& steps_out,
-    PostingRunBuilder& posting_runs) {
+                std::size_t step_cursor = 0;
+                for (auto& entry : batch.entries) {
+                    for (std::uint64_t i = 0; i < entry.step_count; ++i) {
+                        const auto step = batch.steps[step_cursor++];
+                        steps_out.add(step);
+                        if (checkpoints) checkpoints->add_step(step.node_id());
+                    }
+                    finish_entry(std::move(entry));
+                }
 
-    std::string node_name;
-    std::uint32_t step_rank = 0;
+                {
+                    std::lock_guard<std::mutex> lock(state_mutex);
+                    ++next_write;
+                }
+                space_available.notify_one();
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    };
 
-    for (size_t pos = 0; pos < walk.size();) {
-        const char orient = walk[pos];
-        if (orient != '>' && orient != '<') {
-            throw std::runtime_error("Malformed W walk orientation");
+    std::vector<std::thread> threads;
+    threads.reserve(worker_count + 1);
+    const auto stop_and_join = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            input_done = true;
         }
+        work_available.notify_all();
+        result_available.notify_all();
+        for (auto& thread : threads) {
+            if (thread.joinable()) thread.join();
+        }
+    };
 
-        const size_t next = walk.find_first_of("><", pos + 1);
-        const size_t end = (next == npos) ? walk.size() : next;
-        if (end <= pos + 1) {
-            throw std::runtime_error("Malformed W walk token");
+    try {
+        for (std::size_t w = 0; w < worker_count; ++w) {
+            threads.emplace_back(run_worker, std::ref(posting_runs[w]));
         }
+        threads.emplace_back(run_writer);
 
-        node_name.assign(walk.data() + pos + 1, end - (pos + 1));
-        const auto it = node_to_id.find(node_name);
-        if (it == node_to_id.end()) {
-            throw std::runtime_error("Walk references unknown node id: " + node_name);
+        Reader reader(reader_options);
+        if (!reader.open(input_gfa)) {
+            throw std::runtime_error("Could not open file: " + input_gfa);
         }
 
-        const auto step = pack_step_record(it->second, orient == '<');
-        write_binary_record(steps_out, step);
-        if (!steps_out.good()) {
-            throw std::runtime_error("Failed while writing temporary step file");
+        std::string_view piece;
+        bool line_done = false;
+        LineTokenizer tokens(reader);
+        NodeRankResolver node_ranks(node_index);
+        std::string long_line_prefix;
+        LineBatch batch;
+        std::uint64_t path_count = 0;
+        const auto dispatch = [&]() {
+            std::unique_lock<std::mutex> lock(state_mutex);
+            space_available.wait(lock, [&]() {
+                return stop || next_sequence - next_write < max_in_flight;
+            });
+            if (stop) return false;
+            pending.emplace_back(next_sequence++, std::move(batch));
+            lock.unlock();
+            work_available.notify_one();
+            batch = LineBatch{};
+            batch.first_path_id = static_cast<std::uint32_t>(path_count);
+            return true;
+        };
+
+        while (reader.read_line_piece(piece, line_done)) {
+            tokens.start(piece, line_done);
+            if (piece.empty() || (piece[0] != 'P' && piece[0] != 'W')) {
+                tokens.skip_line();
+                continue;
+            }
+            if (path_count == std::numeric_limits<std::uint32_t>::max()) {
+                throw std::runtime_error("Too many P/W records for 32-bit path ids");
+            }
+
+            // Lines up to one batch long are copied into the batch. Anything
+            // longer is parsed here, streamed piece by piece, once the writer
+            // has caught up, so no line is ever held in memory whole.
+            long_line_prefix.assign(piece.data(), piece.size());
+            while (!line_done && long_line_prefix.size() < kPathBatchBytes) {
+                if (!reader.read_line_piece(piece, line_done)) {
+                    throw std::runtime_error("Failed while reading P/W line from: " + input_gfa);
+                }
+                long_line_prefix.append(piece.data(), piece.size());
+            }
+
+            if (line_done) {
+                batch.text.append(long_line_prefix);
+                batch.line_ends.push_back(batch.text.size());
+                ++path_count;
+                if (batch.text.size() >= kPathBatchBytes && !dispatch()) break;
+                continue;
+            }
+
+            if (!batch.line_ends.empty() && !dispatch()) break;
+            {
+                std::unique_lock<std::mutex> lock(state_mutex);
+                space_available.wait(lock, [&]() { return stop || next_write == next_sequence; });
+                if (stop) break;
+            }
+            // Every worker is idle now, and later batches only hold larger path
+            // ids, so the first worker's posting runs stay in path order.
+            const auto path_id = static_cast<std::uint32_t>(path_count);
+            tokens.start(long_line_prefix, false);
+            finish_entry(parse_path_record(tokens, node_ranks,
+                [&](StepRecordDisk step, std::uint32_t step_rank) {
+                    steps_out.add(step);
+                    if (checkpoints) checkpoints->add_step(step.node_id());
+                    posting_runs.front().add(step.node_id(), path_id, step_rank);
+                }));
+            ++path_count;
+            batch.first_path_id = static_cast<std::uint32_t>(path_count);
         }
-        posting_runs.add(it->second, path_id, step_rank);
-        ++step_rank;
-        pos = end;
+        if (!batch.line_ends.empty()) dispatch();
+    } catch (...) {
+        fail(std::current_exception());
     }
 
-    return step_rank;
+    stop_and_join();
+    if (error) std::rethrow_exception(error);
 }
 
 // Reconstruct just the overlap slice for a subpath. A subpath with N steps has
@@ -740,16 +1867,86 @@ void write_w_segments(std::ostream& out,
 
 namespace detail {
 
-PostingRunBuilder::PostingRunBuilder(std::string temp_dir, std::size_t max_records)
+PostingRunWriter::PostingRunWriter(std::string path)
+    : out_(path, std::ios::binary | std::ios::trunc) {
+    if (!out_) {
+        throw std::runtime_error("Failed to open posting run file: " + path);
+    }
+    run_.path = std::move(path);
+    buffer_.reserve(kPostingRunWriteBufferBytes + 16);
+}
+
+// Each posting is three varints against the previous posting in its block:
+// - node delta
+// - if the node changed: path id, step rank
+// - else the path delta, then the step rank if the path changed or the step
+//   delta if it did not
+void PostingRunWriter::add(const TempPosting& posting) {
+    if (block_postings_ == 0) {
+        run_.blocks.push_back(PostingRunBlock{bytes_written_ + buffer_.size(), posting.node_id, 0});
+        previous_ = TempPosting{};
+    }
+
+    const std::uint32_t node_delta = posting.node_id - previous_.node_id;
+    append_varint(buffer_, node_delta);
+    if (node_delta != 0) {
+        append_varint(buffer_, posting.path_id);
+        append_varint(buffer_, posting.step_rank);
+    } else {
+        const std::uint32_t path_delta = posting.path_id - previous_.path_id;
+        append_varint(buffer_, path_delta);
+        append_varint(buffer_, path_delta != 0 ? posting.step_rank
+                                               : posting.step_rank - previous_.step_rank);
+    }
+
+    previous_ = posting;
+    ++run_.blocks.back().posting_count;
+    ++run_.posting_count;
+    if (++block_postings_ == kPostingRunBlockSize) {
+        block_postings_ = 0;
+    }
+    if (buffer_.size() >= kPostingRunWriteBufferBytes) {
+        flush_buffer();
+    }
+}
+
+PostingRun PostingRunWriter::finish() {
+    flush_buffer();
+    out_.close();
+    if (!out_) {
+        throw std::runtime_error("Failed while writing posting run file: " + run_.path);
+    }
+    return std::move(run_);
+}
+
+void PostingRunWriter::flush_buffer() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    if (!out_.good()) {
+        throw std::runtime_error("Failed while writing posting run file: " + run_.path);
+    }
+    bytes_written_ += buffer_.size();
+    buffer_.clear();
+}
+
+PostingRunBuilder::PostingRunBuilder(std::string temp_dir, std::size_t max_records, bool log_spills)
     : temp_dir_(std::move(temp_dir)),
-      max_records_(std::max<std::size_t>(1, max_records)) {
+      max_records_(std::max<std::size_t>(1, max_records)),
+      log_spills_(log_spills) {
     chunk_.reserve(max_records_);
+    scratch_.reserve(max_records_);
 }
 
 void PostingRunBuilder::add(std::uint32_t node_id,
                             std::uint32_t path_id,
                             std::uint32_t step_rank) {
+    if (!chunk_.empty()) {
+        const auto& last = chunk_.back();
+        if (path_id < last.path_id || (path_id == last.path_id && step_rank <= last.step_rank)) {
+            path_ordered_ = false;
+        }
+    }
     chunk_.push_back(TempPosting{node_id, path_id, step_rank});
+    max_node_id_ = std::max(max_node_id_, node_id);
     ++total_postings_;
     if (chunk_.size() >= max_records_) {
         flush_run();
@@ -760,8 +1957,8 @@ void PostingRunBuilder::finish() {
     flush_run();
 }
 
-const std::vector<std::string>& PostingRunBuilder::run_paths() const {
-    return run_paths_;
+const std::vector<PostingRun>& PostingRunBuilder::runs() const {
+    return runs_;
 }
 
 std::uint64_t PostingRunBuilder::total_postings() const {
@@ -769,53 +1966,110 @@ std::uint64_t PostingRunBuilder::total_postings() const {
 }
 
 std::size_t PostingRunBuilder::run_count() const {
-    return run_paths_.size();
+    return runs_.size();
 }
 
 void PostingRunBuilder::flush_run() {
     if (chunk_.empty()) return;
 
-    std::sort(chunk_.begin(), chunk_.end(), temp_posting_less);
-
-    const std::string run_path =
-        temp_dir_ + "/posting_run_" + std::to_string(run_paths_.size()) + ".bin";
-    std::ofstream out(run_path, std::ios::binary | std::ios::trunc);
-    if (!out) {
-        throw std::runtime_error("Failed to open posting run file: " + run_path);
-    }
-    write_vector(out, chunk_);
-    if (!out.good()) {
-        throw std::runtime_error("Failed while writing posting run file: " + run_path);
+    if (path_ordered_) {
+        radix_sort_postings_by_node(chunk_, scratch_, max_node_id_);
+    } else {
+        std::sort(chunk_.begin(), chunk_.end(), temp_posting_less);
     }
 
-    run_paths_.push_back(run_path);
+    PostingRunWriter out(temp_dir_ + "/posting_run_" + std::to_string(runs_.size()) + ".bin");
+    for (const auto& posting : chunk_) {
+        out.add(posting);
+    }
+    runs_.push_back(out.finish());
     chunk_.clear();
+    max_node_id_ = 0;
+    path_ordered_ = true;
 
-    if (run_paths_.size() % kPostingRunProgressInterval == 0) {
+    if (log_spills_ && runs_.size() % kPostingRunProgressInterval == 0) {
         std::cout << get_time() << ": Spilled "
-                  << run_paths_.size() << " posting runs covering "
+                  << runs_.size() << " posting runs covering "
                   << total_postings_ << " postings" << std::endl;
     }
 }
 
-PostingRunCursor::PostingRunCursor(const std::string& path)
-    : in(path, std::ios::binary) {
-    if (!in) {
-        throw std::runtime_error("Failed to open posting run file: " + path);
+PostingRunCursor::PostingRunCursor(const PostingRun& run,
+                                   std::uint32_t node_begin,
+                                   std::uint32_t node_end)
+    : in_(run.path, std::ios::binary),
+      buffer_(kPostingRunReadBufferBytes),
+      run_(&run),
+      node_end_(node_end) {
+    if (!in_) {
+        throw std::runtime_error("Failed to open posting run file: " + run.path);
+    }
+
+    // A block starting at node_begin may follow one that already holds some
+    // of node_begin's postings, so start one block before the first such block.
+    const auto first = std::lower_bound(
+        run.blocks.begin(), run.blocks.end(), node_begin,
+        [](const PostingRunBlock& block, std::uint32_t node_id) { return block.first_node_id < node_id; });
+    next_block_ = static_cast<std::size_t>(first - run.blocks.begin());
+    if (next_block_ != 0) --next_block_;
+    if (next_block_ < run.blocks.size()) {
+        in_.seekg(static_cast<std::streamoff>(run.blocks[next_block_].byte_offset));
+    }
+
+    while (decode_next()) {
+        if (current.node_id >= node_begin) {
+            valid = current.node_id < node_end_;
+            return;
+        }
     }
-    advance();
+    valid = false;
 }
 
 bool PostingRunCursor::advance() {
-    in.read(reinterpret_cast<char*>(&current), static_cast<std::streamsize>(sizeof(current)));
-    if (in.gcount() == 0) {
-        valid = false;
-        return false;
+    valid = decode_next() && current.node_id < node_end_;
+    return valid;
+}
+
+bool PostingRunCursor::read_varint(std::uint32_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7) {
+        if (buffer_pos_ == buffer_end_) {
+            in_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            buffer_end_ = static_cast<std::size_t>(in_.gcount());
+            buffer_pos_ = 0;
+            if (buffer_end_ == 0) return false;
+        }
+        const auto byte = static_cast<unsigned char>(buffer_[buffer_pos_++]);
+        value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
     }
-    if (in.gcount() != static_cast<std::streamsize>(sizeof(current))) {
-        throw std::runtime_error("Posting run file ended in the middle of a record");
+    throw std::runtime_error("Malformed varint in posting run file: " + run_->path);
+}
+
+bool PostingRunCursor::decode_next() {
+    if (block_remaining_ == 0) {
+        if (next_block_ == run_->blocks.size()) return false;
+        block_remaining_ = run_->blocks[next_block_++].posting_count;
+        current = TempPosting{};
+    }
+
+    std::uint32_t node_delta = 0;
+    std::uint32_t second = 0;
+    std::uint32_t third = 0;
+    if (!read_varint(node_delta) || !read_varint(second) || !read_varint(third)) {
+        throw std::runtime_error("Posting run file ended in the middle of a record: " + run_->path);
+    }
+    if (node_delta != 0) {
+        current.node_id += node_delta;
+        current.path_id = second;
+        current.step_rank = third;
+    } else if (second != 0) {
+        current.path_id += second;
+        current.step_rank = third;
+    } else {
+        current.step_rank += third;
     }
-    valid = true;
+    --block_remaining_;
     return true;
 }
 
@@ -831,7 +2085,12 @@ bool build_path_index(const std::string& input_gfa,
                       const std::string& node_index_path,
                       const Reader::Options& reader_options,
                       const std::string& tmp_base_dir,
-                      bool keep_tmp) {
+                      bool keep_tmp,
+                      bool share_step_runs,
+                      unsigned threads,
+                      std::uint64_t posting_memory_bytes,
+                      const PathCheckpointOutput* checkpoint_output,
+                      std::uint64_t step_history_bytes) {
     Timer timer;
     // Stage the final .pdx beside its destination so failed builds never leave a truncated index behind.
     const std::string temp_output_index = make_temp_output_path(output_index);
@@ -852,8 +2111,14 @@ bool build_path_index(const std::string& input_gfa,
                                                 "gfaidx_paths_tmp_",
                                                 "latest_paths",
                                                 false);
+    const std::string tmp_step_blocks_path = tmp_dir + "/tmp_step_blocks.bin";
+    const std::string tmp_step_phrases_path = tmp_dir + "/tmp_step_phrases.bin";
     const std::string tmp_steps_path = tmp_dir + "/tmp_steps.bin";
     const std::string tmp_posting_blob_path = tmp_dir + "/tmp_posting_blob.bin";
+    const std::string tmp_strings_path = tmp_dir + "/tmp_strings.bin";
+    const std::string tmp_checkpoints_path = tmp_dir + "/tmp_checkpoints.bin";
+    const std::string temp_checkpoint_output =
+        checkpoint_output ? make_temp_output_path(checkpoint_output->output_path) : std::string();
 
     if (keep_tmp) {
         std::cout << get_time() << ": Using path-index temp directory " << tmp_dir << std::endl;
@@ -868,31 +2133,38 @@ bool build_path_index(const std::string& input_gfa,
     auto cleanup_output = [&]() {
         // Remove any staged .pdx file left behind by an interrupted or failed write.
         remove_path_if_exists(temp_output_index);
+        if (checkpoint_output) remove_path_if_exists(temp_checkpoint_output);
     };
 
     try {
-        std::unordered_map<std::string, std::uint32_t> node_to_id;
-        node_to_id.reserve(static_cast<std::size_t>(node_index.size()));
         std::vector<NodeRecordDisk> node_records(static_cast<std::size_t>(node_index.size()));
         std::vector<std::uint64_t> seen_nodes((static_cast<std::size_t>(node_index.size()) + 63) / 64, 0);
         std::uint64_t seen_node_count = 0;
-        std::string strings_blob;
-        strings_blob.reserve(1024);
+        StringSectionWriter strings_out(tmp_strings_path);
 
         {
-            // Pass 1: resolve each S-line node through the prebuilt .ndx file.
-            // This still keeps the node-name lookup table in RAM, but it avoids
-            // carrying the much larger step/posting tables in memory later on.
-            std::string_view line;
+            // Pass 1: resolve each S-line node through the prebuilt .ndx file
+            // and check that both hold the same node set, so pass 2 can resolve
+            // step names through the .ndx alone. Node names go straight to the
+            // string section on disk. Lines are read in pieces, so long
+            // sequences and paths are skipped without being assembled.
+            std::string_view piece;
+            bool line_done = false;
             Reader reader(reader_options);
             if (!reader.open(input_gfa)) {
                 throw std::runtime_error("Could not open file: " + input_gfa);
             }
+            LineTokenizer tokens(reader);
 
             std::cout << get_time() << ": Scanning S lines for node ids" << std::endl;
-            while (reader.read_line(line)) {
-                if (line.empty() || line[0] != 'S') continue;
-                auto node_id = extract_s_node_id(line);
+            while (reader.read_line_piece(piece, line_done)) {
+                tokens.start(piece, line_done);
+                if (piece.empty() || piece[0] != 'S') {
+                    tokens.skip_line();
+                    continue;
+                }
+                auto node_id = extract_s_node_id(tokens);
+                tokens.skip_line();
 
                 std::uint32_t int_id = 0;
                 if (!node_index.lookup_rank(node_id, int_id)) {
@@ -904,10 +2176,9 @@ bool build_path_index(const std::string& input_gfa,
 
                 set_seen_bit(seen_nodes, int_id);
                 ++seen_node_count;
-                node_to_id.emplace(node_id, int_id);
 
                 auto& rec = node_records[int_id];
-                rec.name_offset = append_string(strings_blob, node_id);
+                rec.name_offset = strings_out.append(node_id);
                 rec.name_len = node_id.size();
             }
 
@@ -920,121 +2191,180 @@ bool build_path_index(const std::string& input_gfa,
 
         std::vector<PathBuildEntry> paths;
         std::uint64_t total_steps = 0;
-        std::ofstream steps_out(tmp_steps_path, std::ios::binary | std::ios::trunc);
-        if (!steps_out) {
-            throw std::runtime_error("Failed to open temporary step file: " + tmp_steps_path);
+        StepPhraseWriter steps_out(tmp_step_blocks_path,
+                                   tmp_steps_path,
+                                   tmp_step_phrases_path,
+                                   node_index.size(),
+                                   share_step_runs,
+                                   step_history_bytes / kStepHistoryBytesPerStep);
+        std::unique_ptr<PathCheckpointWriter> checkpoints;
+        if (checkpoint_output) {
+            checkpoints = std::make_unique<PathCheckpointWriter>(
+                checkpoint_output->node_length_index_path,
+                tmp_checkpoints_path,
+                checkpoint_output->checkpoint_stride,
+                node_index.size());
         }
-        PostingRunBuilder posting_runs(tmp_dir, kPostingChunkRecords);
 
-        {
-            // Pass 2: write packed steps straight to a temp file and spill
+        // Each parse worker spills postings into its own run directory, and
+        // the workers split the posting memory budget. Every buffered posting
+        // needs room in both the run buffer and the radix sort scratch.
+        const std::size_t worker_count = threads > 1 ? threads : 0;
+        const auto posting_run_records = static_cast<std::size_t>(
+            posting_memory_bytes / (2 * sizeof(TempPosting)));
+        std::vector<PostingRunBuilder> posting_runs;
+        if (worker_count == 0) {
+            posting_runs.emplace_back(tmp_dir, posting_run_records);
+        } else {
+            posting_runs.reserve(worker_count);
+            for (std::size_t w = 0; w < worker_count; ++w) {
+                const std::string worker_dir = tmp_dir + "/postings_" + std::to_string(w);
+                std::filesystem::create_directories(worker_dir);
+                posting_runs.emplace_back(worker_dir, posting_run_records / worker_count, false);
+            }
+        }
+
+        if (worker_count == 0) {
+            // Pass 2: encode each path as phrases over the literal step stream,
+            // write literal blocks and phrases to temp files, and spill
             // postings into sorted runs once the chunk buffer reaches its
-            // memory budget.
-            std::string_view line;
+            // memory budget. Lines are tokenized piece by piece, so memory
+            // does not grow with the length of a path.
+            std::string_view piece;
+            bool line_done = false;
             Reader reader(reader_options);
             if (!reader.open(input_gfa)) {
                 throw std::runtime_error("Could not open file: " + input_gfa);
             }
+            LineTokenizer tokens(reader);
 
             std::cout << get_time() << ": Scanning P/W lines for path steps" << std::endl;
-            while (reader.read_line(line)) {
-                if (line.empty() || (line[0] != 'P' && line[0] != 'W')) continue;
+            auto& postings = posting_runs.front();
+            NodeRankResolver node_ranks(node_index);
+            while (reader.read_line_piece(piece, line_done)) {
+                tokens.start(piece, line_done);
+                if (piece.empty() || (piece[0] != 'P' && piece[0] != 'W')) {
+                    tokens.skip_line();
+                    continue;
+                }
 
                 const auto path_id = static_cast<std::uint32_t>(paths.size());
-                PathBuildEntry entry;
+                PathBuildEntry entry = parse_path_record(tokens, node_ranks,
+                    [&](StepRecordDisk step, std::uint32_t step_rank) {
+                        steps_out.add(step);
+                        if (checkpoints) checkpoints->add_step(step.node_id());
+                        postings.add(step.node_id(), path_id, step_rank);
+                    });
                 entry.step_begin = total_steps;
-
-                if (line[0] == 'P') {
-                    ParsedPathFields parsed = parse_path_fields(line);
-                    entry.record_type = 'P';
-                    entry.name = std::move(parsed.name);
-                    entry.overlaps = std::string(parsed.overlaps);
-                    entry.tags = std::string(parsed.tags);
-                    entry.step_count = parse_path_steps(parsed.segments,
-                                                        node_to_id,
-                                                        path_id,
-                                                        steps_out,
-                                                        posting_runs);
-                } else {
-                    ParsedWalkFields parsed = parse_walk_fields(line);
-                    entry.record_type = 'W';
-                    entry.sample_id = std::move(parsed.sample_id);
-                    entry.hap_index = parsed.hap_index;
-                    entry.seq_id = std::move(parsed.seq_id);
-                    entry.seq_start = parsed.seq_start;
-                    entry.seq_end = parsed.seq_end;
-                    entry.name = make_walk_key(entry.sample_id,
-                                               entry.hap_index,
-                                               entry.seq_id,
-                                               entry.seq_start,
-                                               entry.seq_end);
-                    entry.tags = std::string(parsed.tags);
-                    entry.step_count = parse_walk_steps(parsed.walk,
-                                                        node_to_id,
-                                                        path_id,
-                                                        steps_out,
-                                                        posting_runs);
-                }
-
+                entry.step_phrase_begin = steps_out.finish_path(entry.step_phrase_count);
+                if (checkpoints) checkpoints->finish_path();
                 total_steps += entry.step_count;
                 paths.push_back(std::move(entry));
                 if (paths.size() % kPathRecordProgressInterval == 0) {
                     std::cout << get_time() << ": Parsed "
                               << paths.size() << " P/W records covering "
                               << total_steps << " steps and "
-                              << posting_runs.run_count() << " completed posting runs"
+                              << postings.run_count() << " completed posting runs"
                               << std::endl;
                 }
             }
+        } else {
+            std::cout << get_time() << ": Scanning P/W lines for path steps with "
+                      << worker_count << " parse threads" << std::endl;
+            scan_path_records_parallel(input_gfa, reader_options, node_index, worker_count,
+                                       posting_runs, steps_out, checkpoints.get(),
+                                       paths, total_steps);
         }
 
-        if (!steps_out.good()) {
-            throw std::runtime_error("Failed while writing temporary step file");
+        steps_out.finish();
+        std::vector<PostingRun> posting_run_files;
+        std::uint64_t posting_count = 0;
+        for (auto& runs : posting_runs) {
+            runs.finish();
+            posting_run_files.insert(posting_run_files.end(),
+                                     runs.runs().begin(), runs.runs().end());
+            posting_count += runs.total_postings();
         }
-        steps_out.close();
-        posting_runs.finish();
+        std::vector<PostingRunBuilder>().swap(posting_runs);
 
         std::cout << get_time() << ": Finished scanning " << paths.size()
                   << " P/W records covering " << total_steps
-                  << " steps; spilled " << posting_runs.run_count()
+                  << " steps; spilled " << posting_run_files.size()
                   << " posting runs" << std::endl;
-
-        std::unordered_map<std::string, std::uint32_t>().swap(node_to_id);
+        std::cout << get_time() << ": Stored " << total_steps << " steps as "
+                  << steps_out.phrase_count() << " phrases over "
+                  << steps_out.literal_step_count() << " literal steps" << std::endl;
 
         std::vector<PathRecordDisk> path_records(paths.size());
+        std::vector<PathNameEntryDisk> path_names(paths.size());
+        std::vector<PathNameEntryDisk> namespace_names(paths.size());
+        // The layout hash covers the counts and each record's type, extent and
+        // names. A .pcx stores it, so opening one only compares two values.
+        std::uint64_t layout_hash = kLayoutHashOffset;
+        const auto layout_path_count = static_cast<std::uint32_t>(paths.size());
+        const auto layout_node_count = static_cast<std::uint32_t>(node_records.size());
+        hash_layout_bytes(layout_hash, &layout_path_count, sizeof(layout_path_count));
+        hash_layout_bytes(layout_hash, &layout_node_count, sizeof(layout_node_count));
+        hash_layout_bytes(layout_hash, &total_steps, sizeof(total_steps));
         for (std::size_t i = 0; i < paths.size(); ++i) {
             auto& dst = path_records[i];
             const auto& src = paths[i];
+            hash_layout_bytes(layout_hash, &src.record_type, sizeof(src.record_type));
+            hash_layout_bytes(layout_hash, &src.step_count, sizeof(src.step_count));
+            hash_layout_bytes(layout_hash, &src.hap_index, sizeof(src.hap_index));
+            hash_layout_bytes(layout_hash, &src.seq_start, sizeof(src.seq_start));
+            hash_layout_bytes(layout_hash, &src.seq_end, sizeof(src.seq_end));
+            hash_layout_string(layout_hash, src.name);
+            hash_layout_string(layout_hash, src.sample_id);
+            hash_layout_string(layout_hash, src.seq_id);
+            path_names[i] = PathNameEntryDisk{indexer::fnv1a_hash64(src.name),
+                                              indexer::fnv1a_hash32(src.name),
+                                              static_cast<std::uint32_t>(i)};
+            const auto namespace_name = coordinate_namespace(
+                src.record_type, src.name, src.sample_id, src.hap_index, src.seq_id);
+            namespace_names[i] = PathNameEntryDisk{indexer::fnv1a_hash64(namespace_name),
+                                                   indexer::fnv1a_hash32(namespace_name),
+                                                   static_cast<std::uint32_t>(i)};
             dst.record_type = src.record_type;
-            dst.name_offset = append_string(strings_blob, src.name);
+            dst.name_offset = strings_out.append(src.name);
             dst.name_len = src.name.size();
             dst.step_begin = src.step_begin;
             dst.step_count = src.step_count;
-            dst.overlap_offset = append_string(strings_blob, src.overlaps);
+            dst.overlap_offset = strings_out.append(src.overlaps);
             dst.overlap_len = src.overlaps.size();
-            dst.tags_offset = append_string(strings_blob, src.tags);
+            dst.tags_offset = strings_out.append(src.tags);
             dst.tags_len = src.tags.size();
-            dst.sample_offset = append_string(strings_blob, src.sample_id);
+            dst.sample_offset = strings_out.append(src.sample_id);
             dst.sample_len = src.sample_id.size();
             dst.hap_index = src.hap_index;
-            dst.seq_id_offset = append_string(strings_blob, src.seq_id);
+            dst.seq_id_offset = strings_out.append(src.seq_id);
             dst.seq_id_len = src.seq_id.size();
             dst.seq_start = src.seq_start;
             dst.seq_end = src.seq_end;
+            dst.step_phrase_begin = src.step_phrase_begin;
+            dst.step_phrase_count = src.step_phrase_count;
         }
 
         std::vector<PathBuildEntry>().swap(paths);
+        strings_out.finish();
+        std::sort(path_names.begin(), path_names.end(), path_name_entry_less);
+        std::sort(namespace_names.begin(), namespace_names.end(), path_name_entry_less);
 
         std::cout << get_time() << ": Building per-node path postings" << std::endl;
         // Cap the final merge width so very large graphs do not require one
-        // open file handle per spilled posting run.
-        auto final_run_paths = collapse_posting_runs(posting_runs.run_paths(), tmp_dir);
+        // open file handle per spilled posting run and merge worker.
+        const std::size_t merge_workers = std::max(1u, threads);
+        const std::size_t merge_fan_in =
+            std::max(kPostingMinMergeFanIn, kPostingMergeFanIn / merge_workers);
+        auto final_runs = collapse_posting_runs(std::move(posting_run_files), tmp_dir,
+                                                merge_fan_in, merge_workers);
         const std::uint64_t posting_blob_bytes =
-            build_compressed_posting_blob_from_runs(final_run_paths,
+            build_compressed_posting_blob_from_runs(final_runs,
                                                     node_records,
-                                                    tmp_posting_blob_path);
-        const std::uint64_t posting_count = posting_runs.total_postings();
-        remove_paths_if_present(final_run_paths);
+                                                    tmp_posting_blob_path,
+                                                    tmp_dir,
+                                                    merge_workers);
+        remove_posting_runs(final_runs);
 
         PathIndexHeaderDisk header{};
         std::memcpy(header.magic, kPathIndexMagic, sizeof(kPathIndexMagic));
@@ -1043,13 +2373,20 @@ bool build_path_index(const std::string& input_gfa,
         header.node_count = node_records.size();
         header.step_count = total_steps;
         header.posting_count = posting_count;
+        header.step_block_count = steps_out.block_count();
+        header.step_phrase_count = steps_out.phrase_count();
+        header.literal_step_count = steps_out.literal_step_count();
+        header.path_layout_hash = layout_hash;
 
         header.path_table_offset = sizeof(PathIndexHeaderDisk);
         header.node_table_offset = header.path_table_offset + path_records.size() * sizeof(PathRecordDisk);
         header.step_table_offset = header.node_table_offset + node_records.size() * sizeof(NodeRecordDisk);
-        header.posting_table_offset = header.step_table_offset + total_steps * sizeof(StepRecordDisk);
+        header.posting_table_offset = header.step_table_offset +
+                                      header.step_block_count * sizeof(StepBlockDisk) +
+                                      header.step_phrase_count * sizeof(StepPhraseDisk) +
+                                      steps_out.data_bytes();
         header.strings_offset = header.posting_table_offset + posting_blob_bytes;
-        header.strings_size = strings_blob.size();
+        header.strings_size = strings_out.size();
 
         // Assemble the final binary index into the staged sibling file first.
         std::ofstream out(temp_output_index, std::ios::binary | std::ios::trunc);
@@ -1060,11 +2397,21 @@ bool build_path_index(const std::string& input_gfa,
         out.write(reinterpret_cast<const char*>(&header), sizeof(header));
         write_vector(out, path_records);
         write_vector(out, node_records);
+        append_file_to_stream(out, tmp_step_blocks_path);
+        append_file_to_stream(out, tmp_step_phrases_path);
         append_file_to_stream(out, tmp_steps_path);
         append_file_to_stream(out, tmp_posting_blob_path);
-        if (!strings_blob.empty()) {
-            out.write(strings_blob.data(), static_cast<std::streamsize>(strings_blob.size()));
+        append_file_to_stream(out, tmp_strings_path);
+        const std::uint64_t names_offset =
+            path_name_table_offset(header.strings_offset, header.strings_size);
+        const std::uint64_t name_padding =
+            names_offset - (header.strings_offset + header.strings_size);
+        if (name_padding != 0) {
+            const char zeros[alignof(PathNameEntryDisk)] = {};
+            out.write(zeros, static_cast<std::streamsize>(name_padding));
         }
+        write_vector(out, path_names);
+        write_vector(out, namespace_names);
 
         if (!out.good()) {
             throw std::runtime_error("Failed while writing path index: " + output_index);
@@ -1075,8 +2422,17 @@ bool build_path_index(const std::string& input_gfa,
             throw std::runtime_error("Failed while finalizing path index: " + output_index);
         }
 
+        if (checkpoints) {
+            std::cout << get_time() << ": Writing path coordinate checkpoint index "
+                      << checkpoint_output->output_path << std::endl;
+            checkpoints->finish(temp_output_index, temp_checkpoint_output);
+        }
+
         // Publish the fully written staged index into its final path in one rename step.
         rename_path_or_throw(temp_output_index, output_index);
+        if (checkpoints) {
+            rename_path_or_throw(temp_checkpoint_output, checkpoint_output->output_path);
+        }
 
         cleanup_tmp();
         std::cout << get_time() << ": Indexed " << path_records.size() << " paths, "
@@ -1091,367 +2447,479 @@ bool build_path_index(const std::string& input_gfa,
     }
 }
 
+namespace detail {
+
+void unpack_step_block(const unsigned char* data,
+                       std::uint32_t base,
+                       unsigned width,
+                       std::size_t count,
+                       StepRecordDisk* out) {
+    if (width == 0) {
+        for (std::size_t i = 0; i < count; ++i) out[i].packed = base;
+        return;
+    }
+
+    // Fixed-width values never straddle more than one 64-bit load because
+    // width <= 32 and the in-byte shift is at most 7. Keeping the loop free of
+    // branches lets the compiler unroll and vectorize it.
+    const std::uint64_t mask = (1ULL << width) - 1;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t bit = i * width;
+        std::uint64_t word = 0;
+        std::memcpy(&word, data + bit / 8, sizeof(word));
+        const std::uint64_t value = (word >> (bit % 8)) & mask;
+        out[i].packed = (base + static_cast<std::uint32_t>(value >> 1)) |
+                        (static_cast<std::uint32_t>(value & 1u) << 31);
+    }
+}
+
+namespace {
+
+// Unpack count values of Width bits each, stored LSB-first. Plain columns
+// add base to every value; prefix-summed columns add each value to a running
+// total that starts at base, and the final total is returned. Like
+// unpack_step_block(), this relies on padding after the packed bytes. Eight
+// values always fill exactly Width bytes, so with Width fixed at compile time
+// every load offset and shift in the inner loop is a constant.
+template <unsigned Width, bool PrefixSum>
+std::uint64_t unpack_posting_column(const unsigned char* data,
+                                    std::size_t count,
+                                    std::uint64_t base,
+                                    std::uint32_t* out) {
+    constexpr std::uint64_t mask = (1ULL << Width) - 1;
+    std::uint64_t total = base;
+    auto emit = [&](std::uint32_t* slot, std::uint64_t value) {
+        if constexpr (PrefixSum) {
+            total += value;
+            *slot = static_cast<std::uint32_t>(total);
+        } else {
+            *slot = static_cast<std::uint32_t>(base + value);
+        }
+    };
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8, data += Width) {
+        for (unsigned j = 0; j < 8; ++j) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, data + j * Width / 8, sizeof(word));
+            emit(out + i + j, (word >> (j * Width % 8)) & mask);
+        }
+    }
+    for (unsigned j = 0; i < count; ++i, ++j) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, data + j * Width / 8, sizeof(word));
+        emit(out + i, (word >> (j * Width % 8)) & mask);
+    }
+    return total;
+}
+
+using UnpackPostingColumnFn =
+    std::uint64_t (*)(const unsigned char*, std::size_t, std::uint64_t, std::uint32_t*);
+
+template <bool PrefixSum, std::size_t... Widths>
+constexpr std::array<UnpackPostingColumnFn, sizeof...(Widths)> make_posting_unpackers(
+    std::index_sequence<Widths...>) {
+    return {&unpack_posting_column<static_cast<unsigned>(Widths), PrefixSum>...};
+}
+
+// One specialization per width 0..32, picked once per chunk column.
+constexpr auto kPostingDeltaUnpackers =
+    make_posting_unpackers<true>(std::make_index_sequence<33>{});
+constexpr auto kPostingValueUnpackers =
+    make_posting_unpackers<false>(std::make_index_sequence<33>{});
+
+}  // namespace
+
+void decode_posting_chunk(const unsigned char* data,
+                          std::size_t size,
+                          std::size_t& cursor,
+                          std::size_t count,
+                          std::uint32_t* path_ids,
+                          std::uint32_t* step_ranks) {
+    const std::uint64_t first_path_id = read_posting_varint(data, size, cursor);
+    const std::uint64_t step_base = read_posting_varint(data, size, cursor);
+    if (size - cursor < 2) {
+        throw std::runtime_error("Unexpected end of compressed posting block");
+    }
+    const unsigned path_width = data[cursor];
+    const unsigned step_width = data[cursor + 1];
+    cursor += 2;
+    if (path_width > 32 || step_width > 32 ||
+        first_path_id > std::numeric_limits<std::uint32_t>::max() ||
+        step_base > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Malformed compressed posting chunk header");
+    }
+    const std::size_t path_bytes = (count * path_width + 7) / 8;
+    const std::size_t step_bytes = (count * step_width + 7) / 8;
+    if (path_bytes + step_bytes > size - cursor) {
+        throw std::runtime_error("Unexpected end of compressed posting block");
+    }
+
+    // Both columns decode straight into place: path ids as a running sum of
+    // deltas, steps as offsets from the chunk's step base. The path sum is
+    // monotonic, so checking the last one catches any overflow.
+    const std::uint64_t last_path_id =
+        kPostingDeltaUnpackers[path_width](data + cursor, count, first_path_id, path_ids);
+    kPostingValueUnpackers[step_width](data + cursor + path_bytes, count, step_base, step_ranks);
+    cursor += path_bytes + step_bytes;
+    if (last_path_id > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Compressed posting chunk path id overflow");
+    }
+}
+
+}  // namespace detail
+
+void PathIndexReader::close_mapping() {
+    if (mapping_) {
+        munmap(mapping_, file_size_);
+        mapping_ = nullptr;
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    path_records_ = nullptr;
+    path_names_ = nullptr;
+    namespace_names_ = nullptr;
+    node_records_ = nullptr;
+    step_blocks_ = nullptr;
+    step_phrases_ = nullptr;
+    step_data_ = nullptr;
+    postings_ = nullptr;
+    strings_ = nullptr;
+    file_size_ = 0;
+}
+
 PathIndexReader::PathIndexReader(const std::string& index_path)
-    : index_path_(index_path), in_(index_path, std::ios::binary) {
-    if (!in_) {
+    : index_path_(index_path) {
+    static_assert(sizeof(PathRecordView) == sizeof(PathRecordDisk),
+                  "Mapped path records must match the on-disk path table");
+    static_assert(sizeof(PathNameEntryView) == sizeof(PathNameEntryDisk),
+                  "Mapped path-name entries must match the on-disk name table");
+    static_assert(sizeof(NodeRecordView) == sizeof(NodeRecordDisk),
+                  "Mapped node records must match the on-disk node table");
+    static_assert(sizeof(StepBlockView) == sizeof(StepBlockDisk),
+                  "Mapped step blocks must match the on-disk block directory");
+    static_assert(sizeof(StepPhraseView) == sizeof(StepPhraseDisk),
+                  "Mapped step phrases must match the on-disk phrase table");
+    fd_ = ::open(index_path.c_str(), O_RDONLY);
+    if (fd_ == -1) {
         throw std::runtime_error("Failed to open path index: " + index_path);
     }
 
-    PathIndexHeaderDisk header{};
-    in_.read(reinterpret_cast<char*>(&header), sizeof(header));
-    if (!in_) {
+    struct stat st{};
+    if (fstat(fd_, &st) == -1) {
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Failed to stat path index: " + index_path);
+    }
+    file_size_ = static_cast<std::size_t>(st.st_size);
+    if (file_size_ < sizeof(PathIndexHeaderDisk)) {
+        ::close(fd_);
+        fd_ = -1;
         throw std::runtime_error("Failed to read path index header: " + index_path);
     }
 
-    if (std::memcmp(header.magic, kPathIndexMagic, sizeof(kPathIndexMagic)) != 0) {
-        throw std::runtime_error("Invalid path index magic: " + index_path);
-    }
-    if (header.version != kPathIndexVersion) {
-        throw std::runtime_error("Unsupported path index version: " + std::to_string(header.version));
-    }
-    if (header.node_count > kStepPackedNodeMask) {
-        throw std::runtime_error("Path index node count exceeds packed node id range");
-    }
-
-    node_table_offset_ = header.node_table_offset;
-    step_table_offset_ = header.step_table_offset;
-    posting_table_offset_ = header.posting_table_offset;
-    strings_offset_ = header.strings_offset;
-    posting_table_bytes_ = header.strings_offset - header.posting_table_offset;
-    total_step_count_ = header.step_count;
-    node_count_ = static_cast<std::uint32_t>(header.node_count);
-
-    // Load the small path metadata table eagerly. Node metadata and node names
-    // stay on disk and are fetched lazily, which avoids a large fixed memory
-    // cost when the graph has many millions of nodes.
-    paths_.reserve(header.path_count);
-    std::vector<PathRecordDisk> path_records(static_cast<std::size_t>(header.path_count));
-    read_exact(header.path_table_offset,
-               path_records.data(),
-               path_records.size() * sizeof(PathRecordDisk));
-    for (const auto& rec : path_records) {
-        paths_.push_back(PathMeta{
-            rec.record_type,
-            read_string(rec.name_offset, rec.name_len),
-            rec.step_begin,
-            rec.step_count,
-            read_string(rec.overlap_offset, rec.overlap_len),
-            read_string(rec.tags_offset, rec.tags_len),
-            read_string(rec.sample_offset, rec.sample_len),
-            rec.hap_index,
-            read_string(rec.seq_id_offset, rec.seq_id_len),
-            rec.seq_start,
-            rec.seq_end
-        });
+    mapping_ = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("mmap failed for path index: " + index_path);
     }
 
-    // Build name -> id maps once so repeated lookups stay cheap.
-    for (std::uint32_t i = 0; i < path_count(); ++i) {
-        path_name_to_id_.emplace(std::string(get_path_name(i)), i);
+    try {
+        PathIndexHeaderDisk header{};
+        std::memcpy(&header, mapping_, sizeof(header));
+        if (std::memcmp(header.magic, kPathIndexMagic, sizeof(kPathIndexMagic)) != 0) {
+            throw std::runtime_error("Invalid path index magic: " + index_path);
+        }
+        if (header.version != kPathIndexVersion) {
+            throw std::runtime_error("Unsupported path index version: " + std::to_string(header.version));
+        }
+        if (header.node_count > kStepPackedNodeMask) {
+            throw std::runtime_error("Path index node count exceeds packed node id range");
+        }
+        if (header.path_count > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("Path index path count exceeds 32-bit path id range");
+        }
+
+        // Every section is addressed directly through the mapping, so check
+        // the section layout once here instead of on every query.
+        const bool sections_valid =
+            header.path_table_offset == sizeof(PathIndexHeaderDisk) &&
+            header.node_table_offset ==
+                header.path_table_offset + header.path_count * sizeof(PathRecordDisk) &&
+            header.step_table_offset ==
+                header.node_table_offset + header.node_count * sizeof(NodeRecordDisk) &&
+            header.step_block_count ==
+                (header.literal_step_count + kStepBlockSize - 1) / kStepBlockSize &&
+            header.step_phrase_count <= header.step_count &&
+            header.posting_table_offset >=
+                header.step_table_offset + header.step_block_count * sizeof(StepBlockDisk) +
+                    header.step_phrase_count * sizeof(StepPhraseDisk) + kStepDataPadding &&
+            header.strings_offset >= header.posting_table_offset + kPostingDataPadding &&
+            header.strings_offset <= file_size_ &&
+            header.strings_size <= file_size_ - header.strings_offset &&
+            path_name_table_offset(header.strings_offset, header.strings_size) +
+                2 * header.path_count * sizeof(PathNameEntryDisk) == file_size_;
+        if (!sections_valid) {
+            throw std::runtime_error("Path index section layout is invalid: " + index_path);
+        }
+
+        const auto* base = static_cast<const unsigned char*>(mapping_);
+        node_records_ = reinterpret_cast<const NodeRecordView*>(base + header.node_table_offset);
+        step_blocks_ = reinterpret_cast<const StepBlockView*>(base + header.step_table_offset);
+        step_block_count_ = header.step_block_count;
+        step_phrases_ = reinterpret_cast<const StepPhraseView*>(
+            base + header.step_table_offset + header.step_block_count * sizeof(StepBlockDisk));
+        step_phrase_count_ = header.step_phrase_count;
+        literal_step_count_ = header.literal_step_count;
+        step_data_ = reinterpret_cast<const unsigned char*>(step_phrases_ + step_phrase_count_);
+        step_data_size_ = static_cast<std::uint64_t>((base + header.posting_table_offset) - step_data_);
+        postings_ = base + header.posting_table_offset;
+        strings_ = reinterpret_cast<const char*>(base + header.strings_offset);
+        strings_size_ = header.strings_size;
+        posting_table_bytes_ = header.strings_offset - header.posting_table_offset;
+        total_step_count_ = header.step_count;
+        node_count_ = static_cast<std::uint32_t>(header.node_count);
+        path_layout_hash_ = header.path_layout_hash;
+
+        path_count_ = static_cast<std::uint32_t>(header.path_count);
+        path_records_ = reinterpret_cast<const PathRecordView*>(base + header.path_table_offset);
+        path_names_ = reinterpret_cast<const PathNameEntryView*>(
+            base + path_name_table_offset(header.strings_offset, header.strings_size));
+        namespace_names_ = path_names_ + path_count_;
+    } catch (...) {
+        close_mapping();
+        throw;
     }
 }
 
-bool PathIndexReader::lookup_path_id(const std::string& name, std::uint32_t& out_path_id) const {
-    const auto it = path_name_to_id_.find(name);
-    if (it == path_name_to_id_.end()) return false;
-    out_path_id = it->second;
-    return true;
+PathIndexReader::~PathIndexReader() {
+    close_mapping();
 }
 
-PathInfo PathIndexReader::get_path_info(std::uint32_t path_id) const {
-    if (path_id >= paths_.size()) {
-        throw std::runtime_error("Path id out of range");
+bool PathIndexReader::lookup_path_id(std::string_view name, std::uint32_t& out_path_id) const {
+    const std::uint64_t hash = indexer::fnv1a_hash64(name);
+    const auto* begin = path_names_;
+    const auto* end = path_names_ + path_count_;
+    const auto* it = std::lower_bound(begin, end, hash,
+        [](const PathNameEntryView& entry, std::uint64_t value) { return entry.hash < value; });
+    if (it == end || it->hash != hash) return false;
+
+    // Entries with the same 64-bit hash are adjacent; the 32-bit hash filters
+    // almost all of them before the stored name is compared.
+    const std::uint32_t hash32 = indexer::fnv1a_hash32(name);
+    for (; it != end && it->hash == hash; ++it) {
+        if (it->hash32 != hash32) continue;
+        if (get_path_name(it->path_id) == name) {
+            out_path_id = it->path_id;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::uint32_t> PathIndexReader::lookup_namespace_paths(std::string_view name) const {
+    const std::uint64_t hash = indexer::fnv1a_hash64(name);
+    const std::uint32_t hash32 = indexer::fnv1a_hash32(name);
+    const auto* end = namespace_names_ + path_count_;
+    const auto* it = std::lower_bound(namespace_names_, end, std::make_pair(hash, hash32),
+        [](const PathNameEntryView& entry, const std::pair<std::uint64_t, std::uint32_t>& value) {
+            return entry.hash != value.first ? entry.hash < value.first
+                                             : entry.hash32 < value.second;
+        });
+
+    // Entries of one hash pair are in path-id order; a colliding namespace
+    // is filtered out by comparing the namespace of each record.
+    std::vector<std::uint32_t> out;
+    for (; it != end && it->hash == hash && it->hash32 == hash32; ++it) {
+        if (path_coordinate_namespace(get_path_info(it->path_id)) == name) {
+            out.push_back(it->path_id);
+        }
     }
+    return out;
+}
+
+std::string path_coordinate_namespace(const PathInfo& info) {
+    return coordinate_namespace(info.record_type, info.name, info.sample_id, info.hap_index,
+                                info.seq_id);
+}
 
-    const auto& rec = paths_[path_id];
+PathInfo PathIndexReader::get_path_info(std::uint32_t path_id) const {
+    const auto& rec = path_record(path_id);
     return PathInfo{
         rec.record_type,
         path_id,
         rec.step_begin,
         rec.step_count,
-        rec.name,
-        rec.overlap_field,
-        rec.tags,
-        rec.sample_id,
+        string_at(rec.name_offset, rec.name_len),
+        string_at(rec.overlap_offset, rec.overlap_len),
+        string_at(rec.tags_offset, rec.tags_len),
+        string_at(rec.sample_offset, rec.sample_len),
         rec.hap_index,
-        rec.seq_id,
+        string_at(rec.seq_id_offset, rec.seq_id_len),
         rec.seq_start,
         rec.seq_end
     };
 }
 
 std::string_view PathIndexReader::get_path_name(std::uint32_t path_id) const {
-    if (path_id >= paths_.size()) {
-        throw std::runtime_error("Path id out of range");
-    }
-    const auto& rec = paths_[path_id];
-    return rec.name;
-}
-
-void PathIndexReader::promote_node_name_cache() const {
-    const auto missing = std::numeric_limits<std::uint32_t>::max();
-    node_name_rank_to_dense_.assign(node_count_, missing);
-    for (auto& entry : node_name_cache_) {
-        if (dense_node_names_.size() >= missing) {
-            throw std::runtime_error("Dense node-name cache exceeds uint32 range");
-        }
-        const auto dense_id =
-            static_cast<std::uint32_t>(dense_node_names_.size());
-        node_name_rank_to_dense_[entry.first] = dense_id;
-        dense_node_names_.push_back(std::move(entry.second));
-    }
-
-    // Release both hash nodes and buckets after moving their strings. Future
-    // repeated lookups use one rank-table access and one deque access.
-    std::unordered_map<std::uint32_t, std::string>().swap(node_name_cache_);
+    const auto& rec = path_record(path_id);
+    return string_at(rec.name_offset, rec.name_len);
 }
 
 std::string_view PathIndexReader::get_node_name(std::uint32_t node_id) const {
-    if (node_id >= node_count_) {
-        throw std::runtime_error("Node id out of range");
-    }
-
-    if (!node_name_rank_to_dense_.empty()) {
-        auto& dense_id = node_name_rank_to_dense_[node_id];
-        const auto missing = std::numeric_limits<std::uint32_t>::max();
-        if (dense_id == missing) {
-            if (dense_node_names_.size() >= missing) {
-                throw std::runtime_error(
-                    "Dense node-name cache exceeds uint32 range");
-            }
-            dense_id = static_cast<std::uint32_t>(dense_node_names_.size());
-            // Node names are consumed repeatedly but their node metadata is
-            // not, so bypass the separate metadata hash cache on this miss.
-            dense_node_names_.push_back(copy_node_name(node_id));
-        }
-        return dense_node_names_[dense_id];
-    }
-
-    const auto it = node_name_cache_.find(node_id);
-    if (it != node_name_cache_.end()) {
-        return it->second;
-    }
-
-    // Name lookup does not need to retain NodeMeta: the owned name itself is
-    // sufficient for all later hits and avoids a second large hash table.
-    auto [inserted_it, inserted] =
-        node_name_cache_.emplace(node_id, copy_node_name(node_id));
-    (void)inserted;
-    if (node_name_cache_.size() == kDenseNodeNamePromotionThreshold) {
-        promote_node_name_cache();
-        return dense_node_names_[node_name_rank_to_dense_[node_id]];
-    }
-    return inserted_it->second;
+    const auto& rec = node_record(node_id);
+    return string_at(rec.name_offset, rec.name_len);
 }
 
 std::string PathIndexReader::copy_node_name(std::uint32_t node_id) const {
-    if (node_id >= node_count_) {
-        throw std::runtime_error("Node id out of range");
-    }
-
-    // Bypass both lazy node caches because callers consume each name once and
-    // keep their own selected-node representation.
-    NodeRecordDisk rec{};
-    const auto offset =
-        node_table_offset_ +
-        static_cast<std::uint64_t>(node_id) * sizeof(NodeRecordDisk);
-    read_exact(offset, &rec, sizeof(rec));
-    return read_string(rec.name_offset, rec.name_len);
+    return std::string(get_node_name(node_id));
 }
 
 std::string_view PathIndexReader::get_overlap_field(std::uint32_t path_id) const {
-    if (path_id >= paths_.size()) {
-        throw std::runtime_error("Path id out of range");
-    }
-    const auto& rec = paths_[path_id];
-    return rec.overlap_field;
+    const auto& rec = path_record(path_id);
+    return string_at(rec.overlap_offset, rec.overlap_len);
 }
 
 std::string_view PathIndexReader::get_tags(std::uint32_t path_id) const {
-    if (path_id >= paths_.size()) {
-        throw std::runtime_error("Path id out of range");
-    }
-    const auto& rec = paths_[path_id];
-    return rec.tags;
+    const auto& rec = path_record(path_id);
+    return string_at(rec.tags_offset, rec.tags_len);
 }
 
 std::vector<StepRecord> PathIndexReader::read_steps(std::uint32_t path_id,
                                                     std::uint64_t start_step,
                                                     std::uint64_t max_steps) const {
-    const auto info = get_path_info(path_id);
-    if (start_step > info.step_count) {
-        throw std::runtime_error("Requested start step beyond path length");
-    }
-
-    const std::uint64_t available = info.step_count - start_step;
-    const std::uint64_t take = std::min(available, max_steps);
     std::vector<StepRecord> out;
-    out.reserve(static_cast<std::size_t>(take));
-    if (take == 0) return out;
-
-    // Steps are stored in one flat array, so reading a path slice is one seek
-    // and one contiguous read.
-    const std::uint64_t byte_offset = step_table_offset_ +
-        (info.step_begin + start_step) * sizeof(StepRecordDisk);
-
-    std::vector<StepRecordDisk> raw(static_cast<std::size_t>(take));
-    read_exact(byte_offset, raw.data(), raw.size() * sizeof(StepRecordDisk));
-    for (const auto& rec : raw) {
-        out.push_back(unpack_step_record(rec));
-    }
+    const auto& rec = path_record(path_id);
+    if (start_step < rec.step_count) {
+        out.reserve(static_cast<std::size_t>(std::min(rec.step_count - start_step, max_steps)));
+    }
+    for_each_step_block(path_id, start_step, max_steps,
+        [&](const StepSpan& steps, std::uint64_t) {
+            for (const auto& rec : steps) {
+                out.push_back(rec.unpack());
+            }
+        });
     return out;
 }
 
-void PathIndexReader::for_each_step(
-    std::uint32_t path_id,
-    std::uint64_t start_step,
-    std::uint64_t max_steps,
-    const std::function<void(const StepRecord& step, std::uint64_t step_rank)>& callback) const {
-    const auto info = get_path_info(path_id);
-    if (start_step > info.step_count) {
-        throw std::runtime_error("Requested start step beyond path length");
+const PathIndexReader::PathRecordView& PathIndexReader::path_record(std::uint32_t path_id) const {
+    if (path_id >= path_count_) {
+        throw std::runtime_error("Path id out of range");
     }
+    // Step ranges are checked on access rather than at open so opening an
+    // index with many paths does not touch the whole path table.
+    const auto& rec = path_records_[path_id];
+    if (rec.step_begin > total_step_count_ ||
+        rec.step_count > total_step_count_ - rec.step_begin) {
+        throw std::runtime_error("Path step range is outside the step table: " + index_path_);
+    }
+    if (rec.step_phrase_begin > step_phrase_count_ ||
+        rec.step_phrase_count > step_phrase_count_ - rec.step_phrase_begin ||
+        (rec.step_phrase_count == 0) != (rec.step_count == 0) ||
+        (rec.step_phrase_count != 0 &&
+         step_phrases_[rec.step_phrase_begin + rec.step_phrase_count - 1].step_end != rec.step_count)) {
+        throw std::runtime_error("Path step phrases are outside the phrase table: " + index_path_);
+    }
+    return rec;
+}
 
-    const std::uint64_t available = info.step_count - start_step;
-    std::uint64_t remaining = std::min(available, max_steps);
-    if (remaining == 0) return;
-
-    // Coordinate emission may need cumulative length up to a high step in a
-    // chromosome-scale path. Read the flat step table in bounded chunks so
-    // query memory is independent of full path length.
-    constexpr std::uint64_t kStepReadChunkRecords = 1ULL << 20;
-    std::vector<StepRecordDisk> raw;
-    raw.resize(static_cast<std::size_t>(std::min(remaining, kStepReadChunkRecords)));
-
-    std::uint64_t consumed = 0;
-    while (remaining > 0) {
-        const std::uint64_t take = std::min<std::uint64_t>(remaining, kStepReadChunkRecords);
-        if (raw.size() != static_cast<std::size_t>(take)) {
-            raw.resize(static_cast<std::size_t>(take));
-        }
-
-        const std::uint64_t byte_offset = step_table_offset_ +
-            (info.step_begin + start_step + consumed) * sizeof(StepRecordDisk);
-        read_exact(byte_offset, raw.data(), raw.size() * sizeof(StepRecordDisk));
-
-        for (std::uint64_t i = 0; i < take; ++i) {
-            const auto step = unpack_step_record(raw[static_cast<std::size_t>(i)]);
-            callback(step, start_step + consumed + i);
-        }
+std::size_t PathIndexReader::decode_literal_block(std::uint64_t block, StepRecordDisk* out) const {
+    if (block >= step_block_count_) {
+        throw std::runtime_error("Literal step block is out of range: " + index_path_);
+    }
+    const auto count = static_cast<std::size_t>(
+        std::min<std::uint64_t>(kStepBlockSize, literal_step_count_ - block * kStepBlockSize));
 
-        consumed += take;
-        remaining -= take;
+    const auto& entry = step_blocks_[block];
+    const std::uint64_t packed_bytes = (count * entry.width + 7) / 8;
+    if (entry.width > 32 || entry.data_offset > step_data_size_ ||
+        packed_bytes + kStepDataPadding > step_data_size_ - entry.data_offset) {
+        throw std::runtime_error("Step block data is out of range: " + index_path_);
     }
+
+    detail::unpack_step_block(step_data_ + entry.data_offset, entry.base, entry.width, count, out);
+    return count;
 }
 
-void PathIndexReader::for_each_node_posting(
-    std::uint32_t node_id,
-    const std::function<void(std::uint32_t path_id, std::uint32_t step_rank)>& callback) const {
+const PathIndexReader::NodeRecordView& PathIndexReader::node_record(std::uint32_t node_id) const {
     if (node_id >= node_count_) {
         throw std::runtime_error("Node id out of range");
     }
+    return node_records_[node_id];
+}
 
-    const auto node = read_node_meta(node_id);
-    if (node.posting_count == 0) return;
+PathIndexReader::PostingBlock PathIndexReader::posting_block(std::uint32_t node_id) const {
+    const auto& node = node_record(node_id);
+    if (node.posting_count == 0) return PostingBlock{};
 
+    // Each node's block ends where the next node's block begins; the final
+    // block ends at the blob padding.
+    const std::uint64_t data_bytes = posting_table_bytes_ - kPostingDataPadding;
     const std::uint64_t block_begin = node.posting_begin;
     const std::uint64_t block_end = (node_id + 1 < node_count_)
-        ? read_node_meta(node_id + 1).posting_begin
-        : posting_table_bytes_;
-    if (block_end < block_begin) {
+        ? node_records_[node_id + 1].posting_begin
+        : data_bytes;
+    if (block_end < block_begin || block_end > data_bytes) {
         throw std::runtime_error("Compressed posting block offsets are out of order");
     }
 
-    std::vector<unsigned char> block(static_cast<std::size_t>(block_end - block_begin));
-    read_exact(posting_table_offset_ + block_begin, block.data(), block.size());
-
-    std::size_t cursor = 0;
-    std::uint32_t current_path_id = 0;
-    std::uint64_t emitted = 0;
-
-    while (emitted < node.posting_count) {
-        const auto path_delta = read_varint(block, cursor);
-        if (path_delta > std::numeric_limits<std::uint32_t>::max() - current_path_id) {
-            throw std::runtime_error("Compressed posting block path id overflow");
-        }
-        current_path_id = static_cast<std::uint32_t>(current_path_id + path_delta);
-
-        const auto group_count = read_varint(block, cursor);
-        if (group_count == 0) {
-            throw std::runtime_error("Compressed posting block has an empty path group");
-        }
-        if (group_count > node.posting_count - emitted) {
-            throw std::runtime_error("Compressed posting block overruns node posting count");
-        }
-
-        std::uint64_t current_step_rank = read_varint(block, cursor);
-        if (current_step_rank > std::numeric_limits<std::uint32_t>::max()) {
-            throw std::runtime_error("Compressed posting block step rank overflow");
-        }
-        callback(current_path_id, static_cast<std::uint32_t>(current_step_rank));
-        ++emitted;
-
-        for (std::uint64_t i = 1; i < group_count; ++i) {
-            const auto step_delta = read_varint(block, cursor);
-            if (step_delta == 0) {
-                throw std::runtime_error("Compressed posting block step delta must be positive");
-            }
-            if (step_delta > std::numeric_limits<std::uint32_t>::max() - current_step_rank) {
-                throw std::runtime_error("Compressed posting block step rank overflow");
-            }
-            current_step_rank += step_delta;
-            callback(current_path_id, static_cast<std::uint32_t>(current_step_rank));
-            ++emitted;
-        }
-    }
-
-    if (cursor != block.size()) {
-        throw std::runtime_error("Compressed posting block has trailing bytes");
+    const std::uint64_t skip_bytes = posting_skip_count(node.posting_count) * sizeof(PostingSkipDisk);
+    if (skip_bytes > block_end - block_begin) {
+        throw std::runtime_error("Compressed posting block is smaller than its skip table");
     }
+    return PostingBlock{postings_ + block_begin + skip_bytes,
+                        static_cast<std::size_t>(block_end - block_begin - skip_bytes),
+                        node.posting_count,
+                        postings_ + block_begin,
+                        static_cast<std::size_t>(skip_bytes / sizeof(PostingSkipDisk))};
 }
 
-PathIndexReader::NodeMeta PathIndexReader::read_node_meta(std::uint32_t node_id) const {
-    if (node_id >= node_count_) {
-        throw std::runtime_error("Node id out of range");
-    }
+void PathIndexReader::seek_posting_chunk(const PostingBlock& block,
+                                         std::uint32_t path_begin,
+                                         std::size_t& cursor,
+                                         std::uint64_t& emitted) const {
+    auto skip_at = [&](std::size_t i) {
+        PostingSkipView entry{};
+        std::memcpy(&entry, block.skips + i * sizeof(PostingSkipView), sizeof(entry));
+        return entry;
+    };
 
-    const auto it = node_meta_cache_.find(node_id);
-    if (it != node_meta_cache_.end()) {
-        return it->second;
+    // Find the first entry whose chunk starts at or after path_begin. Earlier
+    // postings of path_begin can sit in the chunks just before it, so start
+    // one entry back.
+    std::size_t lo = 0;
+    std::size_t hi = block.skip_count;
+    while (lo < hi) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (skip_at(mid).first_path_id < path_begin) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
     }
+    if (lo <= 1) return;
 
-    NodeRecordDisk rec{};
-    const auto offset = node_table_offset_ + static_cast<std::uint64_t>(node_id) * sizeof(NodeRecordDisk);
-    read_exact(offset, &rec, sizeof(rec));
-
-    NodeMeta meta{
-        rec.name_offset,
-        rec.name_len,
-        rec.posting_begin,
-        rec.posting_count
-    };
-    node_meta_cache_.emplace(node_id, meta);
-    return meta;
+    const auto entry = skip_at(lo - 1);
+    if (entry.chunk_index != (lo - 1) * kPostingSkipInterval || entry.byte_offset >= block.size) {
+        throw std::runtime_error("Compressed posting skip table is invalid: " + index_path_);
+    }
+    cursor = static_cast<std::size_t>(entry.byte_offset);
+    emitted = static_cast<std::uint64_t>(entry.chunk_index) * kPostingChunkSize;
 }
 
-std::string PathIndexReader::read_string(std::uint64_t offset, std::uint64_t len) const {
-    std::string out(static_cast<std::size_t>(len), '\0');
-    if (len == 0) return out;
-    read_exact(strings_offset_ + offset, out.data(), out.size());
-    return out;
+std::uint64_t PathIndexReader::node_posting_count(std::uint32_t node_id) const {
+    return node_record(node_id).posting_count;
 }
 
-void PathIndexReader::read_exact(std::uint64_t offset, void* dst, std::size_t bytes) const {
-    if (bytes == 0) return;
-    in_.clear();
-    in_.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
-    if (!in_) {
-        throw std::runtime_error("seekg failed while reading path index");
-    }
-    in_.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(bytes));
-    if (!in_) {
-        throw std::runtime_error("Failed to read bytes from path index");
+std::string_view PathIndexReader::string_at(std::uint64_t offset, std::uint64_t len) const {
+    if (offset > strings_size_ || len > strings_size_ - offset) {
+        throw std::runtime_error("Path index string reference is out of range");
     }
+    return std::string_view(strings_ + offset, static_cast<std::size_t>(len));
 }
 
 SelectedNodeNameLookup::SelectedNodeNameLookup(
@@ -1467,9 +2935,9 @@ SelectedNodeNameLookup::SelectedNodeNameLookup(
         throw std::runtime_error("Selected node-name lookup exceeds uint32 range");
     }
 
-    // Match PathIndexReader's adaptive policy: avoid a graph-sized table for
-    // ordinary small queries, but use direct indexing when billions of steps
-    // repeatedly visit a large selected node set.
+    // Avoid a graph-sized table for ordinary small queries, but use direct
+    // indexing when billions of steps repeatedly visit a large selected node
+    // set.
     if (node_ids.size() < kDenseNodeNamePromotionThreshold) {
         sparse_rank_to_name_.reserve(node_ids.size());
         for (std::size_t i = 0; i < node_ids.size(); ++i) {
@@ -1504,66 +2972,79 @@ SelectedNodeNameLookup::SelectedNodeNameLookup(
 }
 
 std::vector<SubpathRun> find_subpaths_for_node_ids(const PathIndexReader& index,
-                                                   const std::vector<std::uint32_t>& node_ids) {
-    std::unordered_set<std::uint32_t> unique_nodes;
+                                                   const std::vector<std::uint32_t>& node_ids,
+                                                   unsigned threads) {
+    // Drop repeated node ids with a rank bitset so no posting is collected
+    // twice, then give every node a fixed slice of one flat posting buffer.
+    std::vector<std::uint64_t> seen((static_cast<std::size_t>(index.node_count()) + 63) / 64, 0);
+    std::vector<std::uint32_t> unique_nodes;
     unique_nodes.reserve(node_ids.size());
-
     for (const auto node_id : node_ids) {
-        unique_nodes.insert(node_id);
-    }
-
-    // Collect every step occurrence of every requested node, grouped by path.
-    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> path_to_steps;
-    for (const auto node_id : unique_nodes) {
-        index.for_each_node_posting(node_id,
-        [&](const std::uint32_t path_id, const std::uint32_t step_rank) {
-            path_to_steps[path_id].push_back(step_rank);
-        });
-    }
-
-    std::vector<std::pair<std::uint32_t, std::vector<std::uint32_t>>> grouped;
-    grouped.reserve(path_to_steps.size());
-    for (auto& kv : path_to_steps) {
-        grouped.emplace_back(kv.first, std::move(kv.second));
-    }
-    std::sort(grouped.begin(), grouped.end(),
-              [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+        if (node_id >= index.node_count()) {
+            throw std::runtime_error("Node id out of range");
+        }
+        if (test_seen_bit(seen, node_id)) continue;
+        set_seen_bit(seen, node_id);
+        unique_nodes.push_back(node_id);
+    }
+    std::vector<std::uint64_t>().swap(seen);
+
+    std::vector<std::size_t> node_offsets(unique_nodes.size() + 1, 0);
+    for (std::size_t i = 0; i < unique_nodes.size(); ++i) {
+        node_offsets[i + 1] = node_offsets[i] +
+            static_cast<std::size_t>(index.node_posting_count(unique_nodes[i]));
+    }
+
+    // Each posting becomes one (path_id << 32 | step_rank) key, so sorting
+    // the keys orders every occurrence by path and then step.
+    std::vector<std::uint64_t> keys(node_offsets.back());
+    const std::size_t task_count =
+        (unique_nodes.size() + kSubpathNodesPerTask - 1) / kSubpathNodesPerTask;
+    std::vector<std::uint32_t> task_max_steps(task_count, 0);
+    utils::run_parallel_tasks(task_count, std::max(1u, threads), [&](std::size_t task) {
+        const std::size_t node_begin = task * kSubpathNodesPerTask;
+        const std::size_t node_end = std::min(unique_nodes.size(), node_begin + kSubpathNodesPerTask);
+        std::uint32_t max_step = 0;
+        for (std::size_t i = node_begin; i < node_end; ++i) {
+            std::uint64_t* out = keys.data() + node_offsets[i];
+            index.for_each_node_posting(unique_nodes[i],
+                [&](const std::uint32_t path_id, const std::uint32_t step_rank) {
+                    *out++ = (static_cast<std::uint64_t>(path_id) << 32) | step_rank;
+                    max_step = std::max(max_step, step_rank);
+                });
+        }
+        task_max_steps[task] = max_step;
+    });
 
+    if (keys.size() < kSubpathRadixSortMinKeys) {
+        std::sort(keys.begin(), keys.end());
+    } else {
+        std::uint32_t max_step = 0;
+        for (const auto step : task_max_steps) max_step = std::max(max_step, step);
+        const std::uint32_t max_path = index.path_count() == 0 ? 0 : index.path_count() - 1;
+        std::vector<std::uint64_t> scratch;
+        radix_sort_path_step_keys(keys, scratch, bit_width(max_step), bit_width(max_path));
+    }
+
+    // Consecutive step ranks of one path become one subpath; gaps split the
+    // path into multiple runs, which is what we want for arbitrary
+    // communities. Only multi-step runs are kept so extracted path output
+    // always spans at least one edge instead of degenerating into
+    // single-node fragments, which confuse users and graph visualizers more
+    // than they help.
     std::vector<SubpathRun> runs;
-    for (auto& entry : grouped) {
-        auto& ranks = entry.second;
-        std::sort(ranks.begin(), ranks.end());
-        if (ranks.empty()) continue;
-
-        // Only keep multi-step runs so extracted path output always spans at
-        // least one edge instead of degenerating into single-node fragments.
-        auto push_run_if_useful = [&](const std::uint64_t start_step,
-                                      const std::uint64_t end_step) {
-            const auto step_count = end_step - start_step + 1;
-            // Suppress singleton runs because they are valid formally but tend
-            // to confuse users and graph visualizers more than they help.
-            if (step_count < 2) {
-                return;
-            }
-            runs.push_back(SubpathRun{entry.first, start_step, step_count});
-        };
-
-        // Consecutive step ranks become one subpath; gaps split the path into
-        // multiple runs, which is what we want for arbitrary communities.
-        std::uint64_t start = ranks.front();
-        std::uint64_t prev = ranks.front();
-        for (std::size_t i = 1; i < ranks.size(); ++i) {
-            if (ranks[i] == prev + 1) {
-                prev = ranks[i];
-                continue;
-            }
-            // Flush the finished contiguous run, but only if it spans at least
-            // two path steps after the singleton filter above.
-            push_run_if_useful(start, prev);
-            start = prev = ranks[i];
+    std::size_t run_begin = 0;
+    for (std::size_t i = 1; i <= keys.size(); ++i) {
+        if (i < keys.size() && keys[i] == keys[i - 1] + 1 &&
+            (keys[i] >> 32) == (keys[run_begin] >> 32)) {
+            continue;
+        }
+        if (i - run_begin >= 2) {
+            runs.push_back(SubpathRun{static_cast<std::uint32_t>(keys[run_begin] >> 32),
+                                      keys[run_begin] & 0xffffffffULL,
+                                      i - run_begin});
         }
-        // Apply the same singleton suppression to the trailing run.
-        push_run_if_useful(start, prev);
+        run_begin = i;
     }
 
     return runs;
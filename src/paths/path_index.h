@@ -1,11 +1,11 @@
 #ifndef GFAIDX_PATH_INDEX_H
 #define GFAIDX_PATH_INDEX_H
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
-#include <deque>
 #include <fstream>
-#include <functional>
 #include <iosfwd>
 #include <limits>
 #include <stdexcept>
@@ -15,11 +15,12 @@
 #include <vector>
 
 #include "fs/Reader.h"
+#include "paths/path_coordinate_checkpoints.h"
 
 namespace gfaidx::paths {
 
 // Lightweight path metadata returned by the reader. String views point into the
-// path metadata strings owned by PathIndexReader.
+// mapped .pdx string blob and stay valid for the lifetime of PathIndexReader.
 struct PathInfo {
     char record_type{};
     std::uint32_t path_id{};
@@ -35,11 +36,95 @@ struct PathInfo {
     std::int64_t seq_end{-1};
 };
 
+// Coordinate namespace of a P/W record: a P name without a terminal :start-end
+// suffix, or SampleId#HapIndex#SeqId for a W record. Records of one namespace
+// are coordinate fragments of one sequence.
+std::string path_coordinate_namespace(const PathInfo& info);
+
 struct StepRecord {
     std::uint32_t node_id{};
     bool is_reverse{};
 };
 
+// Each decoded step is one packed uint32:
+// - low 31 bits: node_id
+// - top bit: reverse-orientation flag
+inline constexpr std::uint32_t kStepPackedNodeMask = 0x7fffffffu;
+inline constexpr std::uint32_t kStepPackedReverseBit = 0x80000000u;
+
+// Step runs that occur in more than one path are stored once. Each path is a
+// list of phrases, and each phrase points at a run in one shared literal step
+// stream. The literal stream is split into fixed-size blocks, and each block is
+// bitpacked against its smallest node id, so a block only costs as many bits
+// per step as the node-id spread inside it needs.
+inline constexpr std::size_t kStepBlockSize = 128;
+
+// Decoded step word. Blocks are unpacked into arrays of these so scans can
+// walk decoded steps without building a heap vector of StepRecord first.
+struct StepRecordDisk {
+    std::uint32_t packed{};
+
+    [[nodiscard]] std::uint32_t node_id() const { return packed & kStepPackedNodeMask; }
+    [[nodiscard]] bool is_reverse() const { return (packed & kStepPackedReverseBit) != 0; }
+    [[nodiscard]] StepRecord unpack() const { return StepRecord{node_id(), is_reverse()}; }
+};
+
+// View of consecutive decoded steps. The build is C++17, so this is the small
+// pointer/count subset of std::span we need. Spans passed to
+// for_each_step_block() point into a per-call decode buffer and are only valid
+// during the visitor call.
+class StepSpan {
+public:
+    StepSpan() = default;
+    StepSpan(const StepRecordDisk* data, std::size_t size) : data_(data), size_(size) {}
+
+    [[nodiscard]] const StepRecordDisk* data() const { return data_; }
+    [[nodiscard]] std::size_t size() const { return size_; }
+    [[nodiscard]] bool empty() const { return size_ == 0; }
+    [[nodiscard]] const StepRecordDisk* begin() const { return data_; }
+    [[nodiscard]] const StepRecordDisk* end() const { return data_ + size_; }
+    [[nodiscard]] const StepRecordDisk& operator[](std::size_t i) const { return data_[i]; }
+
+private:
+    const StepRecordDisk* data_{nullptr};
+    std::size_t size_{0};
+};
+
+// Node postings are stored in chunks of this many (path_id, step_rank) pairs.
+// Each chunk bitpacks its path-id deltas and its step values at one width per
+// chunk, so a whole chunk decodes with two fixed-width unpack loops instead of
+// one varint at a time.
+inline constexpr std::size_t kPostingChunkSize = 128;
+
+// Nodes with at least kPostingSkipMinChunks chunks start their posting block
+// with a skip table: one entry every kPostingSkipInterval chunks holding the
+// chunk's first path id and byte offset. Path-filtered scans binary-search it
+// instead of decoding every chunk before the requested paths.
+inline constexpr std::size_t kPostingSkipInterval = 8;
+inline constexpr std::size_t kPostingSkipMinChunks = 16;
+
+// Upper bound for the threads argument of build_path_index.
+inline constexpr std::uint32_t kMaxPathParseThreads = 256;
+
+// Default memory budget for the in-memory posting runs of build_path_index,
+// shared by all parse workers and including the radix sort scratch buffers.
+inline constexpr std::uint64_t kDefaultPostingMemoryBytes = 128ULL * 1024ULL * 1024ULL;
+
+// Smallest posting budget the build commands accept; below this the posting
+// runs get so small that merge passes dominate.
+inline constexpr std::uint64_t kMinPostingMemoryBytes = 64ULL * 1024ULL;
+
+// Default memory for the literal step history that shared step runs are
+// matched against. Each history step costs at most kStepHistoryBytesPerStep:
+// the step itself, its share of the window chain, and two window-index slots
+// per sampled window.
+inline constexpr std::uint64_t kDefaultStepHistoryBytes = 1024ULL * 1024ULL * 1024ULL;
+inline constexpr std::uint64_t kStepHistoryBytesPerStep = 38;
+
+// Smallest step history the build commands accept; a history must hold at
+// least one match window, and much below this almost nothing is shared.
+inline constexpr std::uint64_t kMinStepHistoryBytes = 64ULL * 1024ULL;
+
 // A contiguous run of steps from one original path that stays inside a queried
 // node set. Node-set queries can yield multiple runs per path.
 struct SubpathRun {
@@ -51,12 +136,33 @@ struct SubpathRun {
 // Build the disk-backed .pdx path index for P/W records in a GFA file. Node
 // ids are aligned to the supplied .ndx file so path queries and graph queries
 // share the same integer node space.
+//
+// With share_step_runs, each path is matched against the steps of earlier
+// paths and repeated runs become references. Matches are only searched among
+// the most recent literal steps that fit in step_history_bytes, which bounds
+// the history and its sampled hash index; a haplotype whose copy has left the
+// history is stored again. Without it, every path stores its own steps and no
+// history is kept.
+//
+// With threads > 1, P/W lines are tokenized and resolved on that many worker
+// threads while steps are still written in input order; the output is
+// byte-identical to the single-threaded build. The same number of workers
+// merges and compresses the posting runs, each over its own node-id range.
+// posting_memory_bytes bounds the buffered postings before they spill to disk.
+//
+// With checkpoint_output, the .pcx sidecar is accumulated from the steps as
+// they are written and published after the .pdx.
 bool build_path_index(const std::string& input_gfa,
                       const std::string& output_index,
                       const std::string& node_index_path,
                       const Reader::Options& reader_options = Reader::Options{},
                       const std::string& tmp_base_dir = std::string(""),
-                      bool keep_tmp = false);
+                      bool keep_tmp = false,
+                      bool share_step_runs = true,
+                      unsigned threads = 1,
+                      std::uint64_t posting_memory_bytes = kDefaultPostingMemoryBytes,
+                      const PathCheckpointOutput* checkpoint_output = nullptr,
+                      std::uint64_t step_history_bytes = kDefaultStepHistoryBytes);
 
 namespace detail {
 
@@ -68,16 +174,57 @@ struct TempPosting {
     std::uint32_t step_rank{};
 };
 
+// Spilled posting runs are written as delta-coded blocks of up to
+// kPostingRunBlockSize postings. Every block restarts the delta coding, so a
+// merge over one node range can start at the block holding its first node.
+inline constexpr std::size_t kPostingRunBlockSize = 4096;
+
+struct PostingRunBlock {
+    std::uint64_t byte_offset{};
+    std::uint32_t first_node_id{};
+    std::uint32_t posting_count{};
+};
+
+// One sorted posting run on disk and the block directory needed to seek it.
+struct PostingRun {
+    std::string path;
+    std::uint64_t posting_count{};
+    std::vector<PostingRunBlock> blocks;
+};
+
+// Buffered writer for one sorted posting run file.
+class PostingRunWriter {
+public:
+    explicit PostingRunWriter(std::string path);
+
+    void add(const TempPosting& posting);
+    PostingRun finish();
+
+private:
+    void flush_buffer();
+
+    std::ofstream out_;
+    PostingRun run_;
+    std::string buffer_;
+    std::uint64_t bytes_written_{};
+    std::uint32_t block_postings_{};
+    TempPosting previous_{};
+};
+
 // Bounded in-memory posting accumulator that spills sorted posting runs to disk
-// once the configured chunk size is reached.
+// once the configured chunk size is reached. Postings added in (path_id,
+// step_rank) order, as both path scans do, are ordered by a stable radix sort
+// on the node id alone; any other order falls back to a comparison sort.
 class PostingRunBuilder {
 public:
-    explicit PostingRunBuilder(std::string temp_dir, std::size_t max_records);
+    // log_spills reports every kPostingRunProgressInterval spilled runs; the
+    // parallel path scan turns it off for its per-worker builders.
+    PostingRunBuilder(std::string temp_dir, std::size_t max_records, bool log_spills = true);
 
     void add(std::uint32_t node_id, std::uint32_t path_id, std::uint32_t step_rank);
     void finish();
 
-    [[nodiscard]] const std::vector<std::string>& run_paths() const;
+    [[nodiscard]] const std::vector<PostingRun>& runs() const;
     [[nodiscard]] std::uint64_t total_postings() const;
     [[nodiscard]] std::size_t run_count() const;
 
@@ -88,18 +235,35 @@ private:
     std::size_t max_records_{};
     std::uint64_t total_postings_{};
     std::vector<TempPosting> chunk_;
-    std::vector<std::string> run_paths_;
+    std::vector<TempPosting> scratch_;
+    std::uint32_t max_node_id_{};
+    bool path_ordered_{true};
+    bool log_spills_{true};
+    std::vector<PostingRun> runs_;
 };
 
-// Sequential reader over one sorted posting run file used during k-way merge.
+// Sequential reader over the postings of one sorted run whose node ids fall in
+// [node_begin, node_end), used during k-way merges.
 struct PostingRunCursor {
-    explicit PostingRunCursor(const std::string& path);
+    PostingRunCursor(const PostingRun& run, std::uint32_t node_begin, std::uint32_t node_end);
 
     bool advance();
 
-    std::ifstream in;
     TempPosting current{};
     bool valid{false};
+
+private:
+    bool read_varint(std::uint32_t& value);
+    bool decode_next();
+
+    std::ifstream in_;
+    std::vector<char> buffer_;
+    std::size_t buffer_pos_{};
+    std::size_t buffer_end_{};
+    const PostingRun* run_{};
+    std::size_t next_block_{};
+    std::uint32_t block_remaining_{};
+    std::uint32_t node_end_{};
 };
 
 // Heap payload and comparator used by the posting-run k-way merge.
@@ -112,14 +276,41 @@ struct PostingHeapGreater {
     bool operator()(const PostingHeapItem& lhs, const PostingHeapItem& rhs) const;
 };
 
+// Decode one posting chunk of count postings starting at cursor inside a node's
+// posting block and advance cursor past it. data must stay readable for eight
+// bytes past size; the .pdx posting blob is padded for it.
+void decode_posting_chunk(const unsigned char* data,
+                          std::size_t size,
+                          std::size_t& cursor,
+                          std::size_t count,
+                          std::uint32_t* path_ids,
+                          std::uint32_t* step_ranks);
+
+// Unpack count frame-of-reference values of width bits each into step words.
+// Each value is (node_id - base) << 1 | is_reverse. data must stay readable for
+// eight bytes past the last packed value; the .pdx step data is padded for it.
+void unpack_step_block(const unsigned char* data,
+                       std::uint32_t base,
+                       unsigned width,
+                       std::size_t count,
+                       StepRecordDisk* out);
+
 }  // namespace detail
 
+// Mmap-backed .pdx reader. All query methods are const and touch only the
+// read-only mapping, so one reader can be shared by any number of threads
+// without external locking. Opening is O(1): path records, names, and the
+// sorted path-name hash table are all used in place.
 class PathIndexReader {
 public:
     explicit PathIndexReader(const std::string& index_path);
+    ~PathIndexReader();
+
+    PathIndexReader(const PathIndexReader&) = delete;
+    PathIndexReader& operator=(const PathIndexReader&) = delete;
 
     [[nodiscard]] std::uint32_t path_count() const {
-        return static_cast<std::uint32_t>(paths_.size());
+        return path_count_;
     }
 
     [[nodiscard]] std::uint32_t node_count() const {
@@ -130,13 +321,20 @@ public:
         return total_step_count_;
     }
 
-    [[nodiscard]] bool lookup_path_id(const std::string& name, std::uint32_t& out_path_id) const;
+    // Hash of the path table layout, computed when the index was built. A
+    // .pcx records it to detect a .pdx rebuilt from a different graph.
+    [[nodiscard]] std::uint64_t path_layout_hash() const {
+        return path_layout_hash_;
+    }
+
+    [[nodiscard]] bool lookup_path_id(std::string_view name, std::uint32_t& out_path_id) const;
+    // Every record whose path_coordinate_namespace() is name, in path-id order.
+    [[nodiscard]] std::vector<std::uint32_t> lookup_namespace_paths(std::string_view name) const;
 
     [[nodiscard]] PathInfo get_path_info(std::uint32_t path_id) const;
     [[nodiscard]] std::string_view get_path_name(std::uint32_t path_id) const;
+    // Node names are views into the mapped string blob; no copy is retained.
     [[nodiscard]] std::string_view get_node_name(std::uint32_t node_id) const;
-    // Return one owned node name without retaining it in the reader cache.
-    // Large one-pass rank materializations use this to keep memory bounded.
     [[nodiscard]] std::string copy_node_name(std::uint32_t node_id) const;
     [[nodiscard]] std::string_view get_overlap_field(std::uint32_t path_id) const;
     [[nodiscard]] std::string_view get_tags(std::uint32_t path_id) const;
@@ -146,67 +344,276 @@ public:
         std::uint64_t start_step = 0,
         std::uint64_t max_steps = std::numeric_limits<std::uint64_t>::max()) const;
 
-    void for_each_step(
-        std::uint32_t path_id,
-        std::uint64_t start_step,
-        std::uint64_t max_steps,
-        const std::function<void(const StepRecord& step, std::uint64_t step_rank)>& callback) const;
+    // Decode the requested path slice and visit each decoded run as
+    // visitor(StepSpan steps, uint64_t first_step_rank). Runs never cross a
+    // phrase or literal block boundary. Only the blocks referenced by the
+    // slice are read from the mapping.
+    template <typename Visitor>
+    void for_each_step_block(std::uint32_t path_id,
+                             std::uint64_t start_step,
+                             std::uint64_t max_steps,
+                             Visitor&& visitor) const;
+
+    // Visit each step as visitor(const StepRecord& step, uint64_t step_rank).
+    // The visitor is a template parameter so the per-step call is inlined.
+    template <typename Visitor>
+    void for_each_step(std::uint32_t path_id,
+                       std::uint64_t start_step,
+                       std::uint64_t max_steps,
+                       Visitor&& visitor) const {
+        for_each_step_block(path_id, start_step, max_steps,
+            [&](const StepSpan& steps, std::uint64_t first_step_rank) {
+                for (std::size_t i = 0; i < steps.size(); ++i) {
+                    visitor(steps[i].unpack(), first_step_rank + i);
+                }
+            });
+    }
+
+    // Visit each occurrence of node_id as visitor(uint32_t path_id,
+    // uint32_t step_rank), in path-id then step-rank order.
+    template <typename Visitor>
+    void for_each_node_posting(std::uint32_t node_id, Visitor&& visitor) const;
 
-    void for_each_node_posting(
-        std::uint32_t node_id,
-        const std::function<void(std::uint32_t path_id, std::uint32_t step_rank)>& callback) const;
+    // Number of occurrences of node_id across all paths.
+    [[nodiscard]] std::uint64_t node_posting_count(std::uint32_t node_id) const;
+
+    // Visit the occurrences of node_id on paths in [path_begin, path_end), in
+    // the same order as for_each_node_posting(). Nodes with a skip table start
+    // decoding near path_begin; every node stops after path_end.
+    template <typename Visitor>
+    void for_each_node_posting_in_paths(std::uint32_t node_id,
+                                        std::uint32_t path_begin,
+                                        std::uint32_t path_end,
+                                        Visitor&& visitor) const;
 
 private:
-    // Path metadata is loaded eagerly because the number of paths is small
-    // compared to the number of graph nodes. Node metadata stays on disk and is
-    // loaded lazily on demand to keep query-time memory bounded on large graphs.
-    struct PathMeta {
+    // Mirrors PathRecordDisk in the .pdx path table. Offsets point into the
+    // shared string blob.
+    struct PathRecordView {
         char record_type{};
-        std::string name;
+        char reserved[7]{};
+        std::uint64_t name_offset{};
+        std::uint64_t name_len{};
         std::uint64_t step_begin{};
         std::uint64_t step_count{};
-        std::string overlap_field;
-        std::string tags;
-        std::string sample_id;
+        std::uint64_t overlap_offset{};
+        std::uint64_t overlap_len{};
+        std::uint64_t tags_offset{};
+        std::uint64_t tags_len{};
+        std::uint64_t sample_offset{};
+        std::uint64_t sample_len{};
         std::uint64_t hap_index{};
-        std::string seq_id;
+        std::uint64_t seq_id_offset{};
+        std::uint64_t seq_id_len{};
         std::int64_t seq_start{-1};
         std::int64_t seq_end{-1};
+        std::uint64_t step_phrase_begin{};
+        std::uint64_t step_phrase_count{};
+    };
+
+    // Mirrors StepPhraseDisk: the path steps before step_end that follow the
+    // previous phrase are the literal steps starting at literal_begin.
+    struct StepPhraseView {
+        std::uint64_t literal_begin{};
+        std::uint64_t step_end{};
     };
 
-    struct NodeMeta {
+    // Mirrors StepBlockDisk: where one bitpacked literal block starts inside
+    // the step data, plus its frame-of-reference base and value width.
+    struct StepBlockView {
+        std::uint64_t data_offset{};
+        std::uint32_t base{};
+        std::uint8_t width{};
+        std::uint8_t reserved[3]{};
+    };
+
+    // Mirrors PathNameEntryDisk: path-name hashes sorted for binary search,
+    // using the same FNV-1a pair as .ndx.
+    struct PathNameEntryView {
+        std::uint64_t hash{};
+        std::uint32_t hash32{};
+        std::uint32_t path_id{};
+    };
+
+    // Mirrors NodeRecordDisk in the .pdx node table. posting_begin is a byte
+    // offset into the compressed posting blob.
+    struct NodeRecordView {
         std::uint64_t name_offset{};
         std::uint64_t name_len{};
         std::uint64_t posting_begin{};
         std::uint64_t posting_count{};
     };
 
-    [[nodiscard]] NodeMeta read_node_meta(std::uint32_t node_id) const;
-    [[nodiscard]] std::string read_string(std::uint64_t offset, std::uint64_t len) const;
-    void promote_node_name_cache() const;
-    void read_exact(std::uint64_t offset, void* dst, std::size_t bytes) const;
+    // Mirrors PostingSkipDisk. Entry i points at chunk
+    // i * kPostingSkipInterval; byte_offset is relative to the chunk data
+    // that follows the skip table.
+    struct PostingSkipView {
+        std::uint64_t byte_offset{};
+        std::uint32_t first_path_id{};
+        std::uint32_t chunk_index{};
+    };
+
+    // One node's compressed posting chunks inside the mapping, plus its skip
+    // table. The blob has no alignment, so skip entries are copied out.
+    struct PostingBlock {
+        const unsigned char* data{nullptr};
+        std::size_t size{0};
+        std::uint64_t posting_count{0};
+        const unsigned char* skips{nullptr};
+        std::size_t skip_count{0};
+    };
+
+    [[nodiscard]] const PathRecordView& path_record(std::uint32_t path_id) const;
+    // Decode one literal block into out and return its step count.
+    std::size_t decode_literal_block(std::uint64_t block, StepRecordDisk* out) const;
+    [[nodiscard]] const NodeRecordView& node_record(std::uint32_t node_id) const;
+    [[nodiscard]] PostingBlock posting_block(std::uint32_t node_id) const;
+    // Move cursor and emitted to the last skip-table chunk that starts at or
+    // before path_begin. Nodes without a skip table stay at the first chunk.
+    void seek_posting_chunk(const PostingBlock& block,
+                            std::uint32_t path_begin,
+                            std::size_t& cursor,
+                            std::uint64_t& emitted) const;
+    [[nodiscard]] std::string_view string_at(std::uint64_t offset, std::uint64_t len) const;
+    void close_mapping();
 
     std::string index_path_;
-    mutable std::ifstream in_;
-    std::uint64_t node_table_offset_{};
-    std::uint64_t step_table_offset_{};
-    std::uint64_t posting_table_offset_{};
-    std::uint64_t strings_offset_{};
+    int fd_{-1};
+    void* mapping_{nullptr};
+    std::size_t file_size_{0};
+    const PathRecordView* path_records_{nullptr};
+    const PathNameEntryView* path_names_{nullptr};
+    const PathNameEntryView* namespace_names_{nullptr};
+    const NodeRecordView* node_records_{nullptr};
+    const StepBlockView* step_blocks_{nullptr};
+    const StepPhraseView* step_phrases_{nullptr};
+    const unsigned char* step_data_{nullptr};
+    std::uint64_t step_block_count_{};
+    std::uint64_t step_phrase_count_{};
+    std::uint64_t literal_step_count_{};
+    std::uint64_t step_data_size_{};
+    const unsigned char* postings_{nullptr};
+    const char* strings_{nullptr};
+    std::uint64_t strings_size_{};
     std::uint64_t posting_table_bytes_{};
     std::uint64_t total_step_count_{};
+    std::uint64_t path_layout_hash_{};
+    std::uint32_t path_count_{};
     std::uint32_t node_count_{};
-    std::vector<PathMeta> paths_;
-    std::unordered_map<std::string, std::uint32_t> path_name_to_id_;
-    mutable std::unordered_map<std::uint32_t, NodeMeta> node_meta_cache_;
-    mutable std::unordered_map<std::uint32_t, std::string> node_name_cache_;
-    // Large scans promote the sparse hash cache into a rank-to-dense-name
-    // lookup. The deque keeps returned string views stable as more names are
-    // loaded, while the uint32 rank table avoids one string object per graph
-    // node and is not allocated for ordinary small queries.
-    mutable std::vector<std::uint32_t> node_name_rank_to_dense_;
-    mutable std::deque<std::string> dense_node_names_;
 };
 
+template <typename Visitor>
+void PathIndexReader::for_each_step_block(std::uint32_t path_id,
+                                          std::uint64_t start_step,
+                                          std::uint64_t max_steps,
+                                          Visitor&& visitor) const {
+    const auto& rec = path_record(path_id);
+    if (start_step > rec.step_count) {
+        throw std::runtime_error("Requested start step beyond path length");
+    }
+    const std::uint64_t end_step = start_step + std::min(rec.step_count - start_step, max_steps);
+    if (start_step == end_step) return;
+
+    // Find the first phrase that ends after start_step, then walk phrases and
+    // their literal blocks in order. Consecutive phrases often reuse the same
+    // literal block, so the last decoded block is kept.
+    const StepPhraseView* phrase_begin = step_phrases_ + rec.step_phrase_begin;
+    const StepPhraseView* phrase_end = phrase_begin + rec.step_phrase_count;
+    const StepPhraseView* phrase = std::upper_bound(
+        phrase_begin, phrase_end, start_step,
+        [](std::uint64_t step, const StepPhraseView& entry) { return step < entry.step_end; });
+    std::uint64_t phrase_first = (phrase == phrase_begin) ? 0 : (phrase - 1)->step_end;
+
+    std::array<StepRecordDisk, kStepBlockSize> decoded;
+    std::uint64_t decoded_block = std::numeric_limits<std::uint64_t>::max();
+    std::size_t decoded_count = 0;
+    std::uint64_t step = start_step;
+    while (step < end_step) {
+        if (phrase == phrase_end || phrase->step_end <= phrase_first ||
+            phrase->literal_begin > literal_step_count_ ||
+            phrase->step_end - phrase_first > literal_step_count_ - phrase->literal_begin) {
+            throw std::runtime_error("Path step phrase is out of range: " + index_path_);
+        }
+
+        const std::uint64_t run_end = std::min(phrase->step_end, end_step);
+        std::uint64_t literal = phrase->literal_begin + (step - phrase_first);
+        while (step < run_end) {
+            const std::uint64_t block = literal / kStepBlockSize;
+            if (block != decoded_block) {
+                decoded_count = decode_literal_block(block, decoded.data());
+                decoded_block = block;
+            }
+            const auto offset = static_cast<std::size_t>(literal % kStepBlockSize);
+            const auto take = static_cast<std::size_t>(
+                std::min<std::uint64_t>(decoded_count - offset, run_end - step));
+            visitor(StepSpan(decoded.data() + offset, take), step);
+            step += take;
+            literal += take;
+        }
+
+        phrase_first = phrase->step_end;
+        ++phrase;
+    }
+}
+
+template <typename Visitor>
+void PathIndexReader::for_each_node_posting(std::uint32_t node_id, Visitor&& visitor) const {
+    const auto block = posting_block(node_id);
+    if (block.posting_count == 0) return;
+
+    std::array<std::uint32_t, kPostingChunkSize> path_ids;
+    std::array<std::uint32_t, kPostingChunkSize> step_ranks;
+    std::size_t cursor = 0;
+    for (std::uint64_t emitted = 0; emitted < block.posting_count;) {
+        const auto count = static_cast<std::size_t>(
+            std::min<std::uint64_t>(kPostingChunkSize, block.posting_count - emitted));
+        detail::decode_posting_chunk(block.data, block.size, cursor, count,
+                                     path_ids.data(), step_ranks.data());
+        for (std::size_t i = 0; i < count; ++i) {
+            visitor(path_ids[i], step_ranks[i]);
+        }
+        emitted += count;
+    }
+
+    if (cursor != block.size) {
+        throw std::runtime_error("Compressed posting block has trailing bytes");
+    }
+}
+
+template <typename Visitor>
+void PathIndexReader::for_each_node_posting_in_paths(std::uint32_t node_id,
+                                                     std::uint32_t path_begin,
+                                                     std::uint32_t path_end,
+                                                     Visitor&& visitor) const {
+    const auto block = posting_block(node_id);
+    if (block.posting_count == 0 || path_begin >= path_end) return;
+
+    std::size_t cursor = 0;
+    std::uint64_t emitted = 0;
+    seek_posting_chunk(block, path_begin, cursor, emitted);
+
+    // Chunks are sorted by path id, so each chunk contributes one contiguous
+    // range, and the scan ends at the first chunk that reaches path_end.
+    std::array<std::uint32_t, kPostingChunkSize> path_ids;
+    std::array<std::uint32_t, kPostingChunkSize> step_ranks;
+    while (emitted < block.posting_count) {
+        const auto count = static_cast<std::size_t>(
+            std::min<std::uint64_t>(kPostingChunkSize, block.posting_count - emitted));
+        detail::decode_posting_chunk(block.data, block.size, cursor, count,
+                                     path_ids.data(), step_ranks.data());
+        emitted += count;
+
+        const std::uint32_t* chunk_begin = path_ids.data();
+        const std::uint32_t* chunk_end = chunk_begin + count;
+        const std::uint32_t* first = std::lower_bound(chunk_begin, chunk_end, path_begin);
+        const std::uint32_t* last = std::lower_bound(first, chunk_end, path_end);
+        for (const std::uint32_t* it = first; it != last; ++it) {
+            visitor(*it, step_ranks[static_cast<std::size_t>(it - chunk_begin)]);
+        }
+        if (last != chunk_end) return;
+    }
+}
+
 // Immutable rank-to-name lookup over names already owned by extraction. Small
 // selections use a sparse map; large selections use one direct rank table.
 // Keeping only name indexes here avoids rereading or duplicating node strings,
@@ -243,11 +650,14 @@ private:
     std::vector<std::uint32_t> rank_to_name_;
 };
 
-// Resolve a node set into all path runs that remain contiguous inside that set.
-// Runs shorter than two consecutive steps are suppressed to avoid emitting
-// single-node path fragments that tend to confuse downstream users and tools.
+// Resolve a node set into all path runs that remain contiguous inside that set,
+// ordered by path id and then start step. Runs shorter than two consecutive
+// steps are suppressed to avoid emitting single-node path fragments that tend
+// to confuse downstream users and tools. Node postings are decoded on up to
+// threads workers; the result does not depend on the thread count.
 std::vector<SubpathRun> find_subpaths_for_node_ids(const PathIndexReader& index,
-                                                   const std::vector<std::uint32_t>& node_ids);
+                                                   const std::vector<std::uint32_t>& node_ids,
+                                                   unsigned threads = 1);
 
 void write_path_as_gfa_line(std::ostream& out,
                             const PathIndexReader& index,
@@ -261,7 +671,8 @@ void write_subpath_as_gfa_line(std::ostream& out,
                                std::string_view output_name);
 
 // Format one subpath into an owned buffer. Step reads and node-name lookup are
-// explicit so callers can use either a reader cache or the selected-name table.
+// explicit so callers can use either mapped reader names or the selected-name
+// table.
 std::string format_subpath_as_gfa_line(
     const PathIndexReader& step_index,
     const PathIndexReader& node_name_index,
@@ -271,7 +682,7 @@ std::string format_subpath_as_gfa_line(
     std::string_view output_name);
 
 // Parallel and optimized serial extraction use names already owned by the
-// selected-node vector instead of building a second PathIndexReader cache.
+// selected-node vector so output does not fault in scattered .pdx name pages.
 std::string format_subpath_as_gfa_line(
     const PathIndexReader& step_index,
     const SelectedNodeNameLookup& node_name_index,
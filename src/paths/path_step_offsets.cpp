@@ -0,0 +1,163 @@
+#include "paths/path_step_offsets.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace gfaidx::paths {
+
+PathStepOffsets::PathStepOffsets(const PathIndexReader& path_index,
+                                 const indexer::NodeLengthIndexReader& lengths,
+                                 const PathCoordinateCheckpointIndexReader* checkpoints)
+    : path_index_(path_index), lengths_(lengths), checkpoints_(checkpoints) {
+    if (lengths_.node_count() != path_index_.node_count()) {
+        throw std::runtime_error(".lnx and .pdx node counts differ; rebuild them against the same .ndx");
+    }
+}
+
+std::uint64_t PathStepOffsets::block_step_count(
+    const PathCoordinateCheckpointIndexReader* checkpoints) {
+    return checkpoints != nullptr ? checkpoints->checkpoint_stride() : kDefaultPathCheckpointStride;
+}
+
+void PathStepOffsets::select_path(std::uint32_t path_id) {
+    if (path_id == path_id_) return;
+    if (path_id >= path_index_.path_count()) {
+        throw std::runtime_error("Path id is outside the .pdx path table");
+    }
+    path_id_ = path_id;
+    step_count_ = path_index_.get_path_info(path_id).step_count;
+    block_steps_ = block_step_count(checkpoints_);
+    // Every block holds at least one step; an empty path has one empty block.
+    block_count_ = std::max<std::uint64_t>(1, (step_count_ + block_steps_ - 1) / block_steps_);
+    block_loaded_ = false;
+    scanned_starts_.assign(1, 0);
+}
+
+std::uint64_t PathStepOffsets::block_start_offset(std::uint64_t block) {
+    if (block == 0) return 0;
+    if (checkpoints_ == nullptr) {
+        scan_block_starts(block);
+        return scanned_starts_[block];
+    }
+    std::uint64_t checkpoint_step = 0;
+    return checkpoints_->prefix_before_step(path_id_, block * block_steps_, checkpoint_step);
+}
+
+void PathStepOffsets::scan_block_starts(std::uint64_t block) {
+    while (scanned_starts_.size() <= block) {
+        const auto first_step = (scanned_starts_.size() - 1) * block_steps_;
+        auto offset = scanned_starts_.back();
+        path_index_.for_each_step_block(path_id_, first_step, block_steps_,
+            [&](const StepSpan& steps, std::uint64_t) {
+                for (std::size_t i = 0; i < steps.size(); ++i) {
+                    const auto node_id = steps[i].unpack().node_id;
+                    if (node_id >= lengths_.node_count()) {
+                        throw std::runtime_error(
+                            "Path references a node outside the .lnx length table");
+                    }
+                    offset += lengths_.length(node_id);
+                }
+            });
+        scanned_starts_.push_back(offset);
+    }
+}
+
+void PathStepOffsets::load_block(std::uint64_t block) {
+    if (block_loaded_ && block == block_) return;
+    block_first_step_ = block * block_steps_;
+    const auto step_count = std::min(block_steps_, step_count_ - block_first_step_);
+    node_ids_.clear();
+    reverse_.clear();
+    starts_.clear();
+    node_ids_.reserve(step_count);
+    reverse_.reserve(step_count);
+    starts_.reserve(step_count + 1);
+
+    auto offset = block_start_offset(block);
+    path_index_.for_each_step(path_id_, block_first_step_, step_count,
+        [&](const StepRecord& step, std::uint64_t) {
+            if (step.node_id >= lengths_.node_count()) {
+                throw std::runtime_error("Path references a node outside the .lnx length table");
+            }
+            node_ids_.push_back(step.node_id);
+            reverse_.push_back(step.is_reverse ? 1 : 0);
+            starts_.push_back(offset);
+            offset += lengths_.length(step.node_id);
+        });
+    if (node_ids_.size() != step_count) {
+        throw std::runtime_error("Path step block is shorter than its .pdx step count");
+    }
+    starts_.push_back(offset);
+    if (checkpoints_ == nullptr && scanned_starts_.size() == block + 1) {
+        scanned_starts_.push_back(offset);
+    }
+    block_ = block;
+    block_loaded_ = true;
+    ++decoded_block_count_;
+}
+
+std::uint64_t PathStepOffsets::step_offset(std::uint32_t path_id, std::uint64_t step_rank) {
+    select_path(path_id);
+    if (step_rank > step_count_) {
+        throw std::runtime_error("Step rank is outside the path");
+    }
+    // The path end is the end of the last block.
+    const auto block = std::min(step_rank / block_steps_, block_count_ - 1);
+    load_block(block);
+    return starts_[step_rank - block_first_step_];
+}
+
+PathStepPosition PathStepOffsets::step_position(std::uint32_t path_id,
+                                                std::uint64_t step_rank) {
+    select_path(path_id);
+    if (step_rank >= step_count_) {
+        throw std::runtime_error("Step rank is outside the path");
+    }
+    load_block(step_rank / block_steps_);
+    const auto index = static_cast<std::size_t>(step_rank - block_first_step_);
+    PathStepPosition out;
+    out.step_rank = step_rank;
+    out.offset = starts_[index];
+    out.node_id = node_ids_[index];
+    out.length = lengths_.length(out.node_id);
+    out.is_reverse = reverse_[index] != 0;
+    return out;
+}
+
+bool PathStepOffsets::find_step(std::uint32_t path_id,
+                                std::uint64_t offset,
+                                PathStepPosition& out) {
+    select_path(path_id);
+    if (step_count_ == 0) return false;
+
+    // Last block starting at or before offset. Blocks after zero-length steps
+    // can share a start; the last of them holds the covering step. Scanned
+    // starts are only extended until one lies past offset.
+    std::uint64_t low = 1;
+    std::uint64_t high = block_count_;
+    if (checkpoints_ == nullptr) {
+        while (scanned_starts_.size() < block_count_ && scanned_starts_.back() <= offset) {
+            scan_block_starts(scanned_starts_.size());
+        }
+        high = std::min<std::uint64_t>(high, scanned_starts_.size());
+    }
+    while (low < high) {
+        const auto mid = low + (high - low) / 2;
+        if (block_start_offset(mid) <= offset) low = mid + 1;
+        else high = mid;
+    }
+    load_block(low - 1);
+    if (offset >= starts_.back()) return false;
+
+    const auto block_steps = node_ids_.size();
+    const auto it = std::upper_bound(starts_.begin(), starts_.begin() + block_steps, offset);
+    const auto index = static_cast<std::size_t>(it - starts_.begin()) - 1;
+    out.step_rank = block_first_step_ + index;
+    out.offset = starts_[index];
+    out.node_id = node_ids_[index];
+    out.length = lengths_.length(out.node_id);
+    out.is_reverse = reverse_[index] != 0;
+    return true;
+}
+
+}  // namespace gfaidx::paths
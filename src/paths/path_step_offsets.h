@@ -0,0 +1,94 @@
+#ifndef GFAIDX_PATH_STEP_OFFSETS_H
+#define GFAIDX_PATH_STEP_OFFSETS_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "indexer/node_length_index.h"
+#include "paths/path_coordinate_checkpoints.h"
+#include "paths/path_index.h"
+
+namespace gfaidx::paths {
+
+// One path step together with the path-local base offset at which it starts.
+struct PathStepPosition {
+    std::uint64_t step_rank{};
+    std::uint64_t offset{};
+    std::uint32_t node_id{};
+    std::uint32_t length{};
+    bool is_reverse{};
+};
+
+// Translate between path steps and path-local base offsets. A .pcx splits
+// every path into blocks of checkpoint_stride steps whose first offset is
+// stored, so one lookup decodes at most one block. The last decoded block is
+// kept: callers that visit steps in path-id then step order decode each block
+// once. Without checkpoints the blocks have the default stride, and their
+// first offsets are summed from the lengths as the current path is scanned,
+// so a long path is never held in memory at once.
+class PathStepOffsets {
+public:
+    // lengths must be rank-aligned with path_index, and checkpoints, when
+    // given, must already be validated against it.
+    PathStepOffsets(const PathIndexReader& path_index,
+                    const indexer::NodeLengthIndexReader& lengths,
+                    const PathCoordinateCheckpointIndexReader* checkpoints);
+
+    // Offset at which step step_rank starts; step_rank may equal the step
+    // count, which gives the path length.
+    [[nodiscard]] std::uint64_t step_offset(std::uint32_t path_id, std::uint64_t step_rank);
+
+    // Step step_rank, which must be below the step count, and its offset.
+    [[nodiscard]] PathStepPosition step_position(std::uint32_t path_id, std::uint64_t step_rank);
+
+    // The step covering path-local offset. Return false when offset is at or
+    // past the end of the path.
+    [[nodiscard]] bool find_step(std::uint32_t path_id,
+                                 std::uint64_t offset,
+                                 PathStepPosition& out);
+
+    // Number of blocks decoded so far.
+    [[nodiscard]] std::uint64_t decoded_block_count() const { return decoded_block_count_; }
+
+    // Steps per block: the .pcx checkpoint stride, or the default stride
+    // without checkpoints. Callers can split work on block boundaries so that
+    // no two translators decode the same block.
+    [[nodiscard]] static std::uint64_t block_step_count(
+        const PathCoordinateCheckpointIndexReader* checkpoints);
+
+private:
+    static constexpr std::uint32_t kNoPath = std::numeric_limits<std::uint32_t>::max();
+
+    void select_path(std::uint32_t path_id);
+    void load_block(std::uint64_t block);
+    [[nodiscard]] std::uint64_t block_start_offset(std::uint64_t block);
+    // Without checkpoints, sum step lengths until the first offset of block
+    // is known.
+    void scan_block_starts(std::uint64_t block);
+
+    const PathIndexReader& path_index_;
+    const indexer::NodeLengthIndexReader& lengths_;
+    const PathCoordinateCheckpointIndexReader* checkpoints_;
+
+    std::uint32_t path_id_{kNoPath};
+    std::uint64_t step_count_{};
+    std::uint64_t block_steps_{};
+    std::uint64_t block_count_{};
+    // First offsets of the current path's leading blocks, when there is no
+    // .pcx to read them from.
+    std::vector<std::uint64_t> scanned_starts_;
+
+    // Decoded block: starts holds one offset per step plus the block end.
+    std::uint64_t block_{};
+    bool block_loaded_{false};
+    std::uint64_t block_first_step_{};
+    std::vector<std::uint32_t> node_ids_;
+    std::vector<std::uint8_t> reverse_;
+    std::vector<std::uint64_t> starts_;
+    std::uint64_t decoded_block_count_{};
+};
+
+}  // namespace gfaidx::paths
+
+#endif  // GFAIDX_PATH_STEP_OFFSETS_H
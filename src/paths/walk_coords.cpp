@@ -649,8 +649,8 @@ void write_p_subpath_with_coords(std::ostream& out,
     out << '\n';
 }
 
-// Keep coordinate validation and exact output bytes shared between the legacy
-// reader cache and extraction's non-owning selected-name lookup.
+// Keep coordinate validation and exact output bytes shared between mapped
+// reader names and extraction's non-owning selected-name lookup.
 template <typename NodeNameLookup>
 bool format_w_subpath_with_coords_bounded_impl(
     std::string& output,
@@ -95,8 +95,8 @@ bool write_p_subpath_with_coords_bounded(std::ostream& out,
                                          const WalkCoordWarning& warn = WalkCoordWarning{});
 
 // Parallel extraction formats records in workers but writes them in original
-// run order. The step index is worker-local; either node-name source below is
-// immutable for the duration of formatting.
+// run order. The step index is shared by all workers; either node-name source
+// below is immutable for the duration of formatting.
 bool format_w_subpath_with_coords_bounded(
     std::string& output,
     const PathIndexReader& step_index,
@@ -1,6 +1,7 @@
 #include "utils/cli_helpers.h"
 
 #include <algorithm>
+#include <limits>
 #include <stdexcept>
 #include <string>
 
@@ -81,4 +82,27 @@ std::uint32_t parse_u32_strict(std::string_view value,
     return static_cast<std::uint32_t>(parsed);
 }
 
+std::uint64_t parse_byte_size_strict(std::string_view value,
+                                     std::string_view field_name) {
+    unsigned shift = 0;
+    std::string_view digits = value;
+    if (!digits.empty()) {
+        switch (digits.back()) {
+            case 'K': case 'k': shift = 10; break;
+            case 'M': case 'm': shift = 20; break;
+            case 'G': case 'g': shift = 30; break;
+            case 'T': case 't': shift = 40; break;
+            default: break;
+        }
+        if (shift != 0) digits.remove_suffix(1);
+    }
+
+    const auto parsed = parse_u64_strict(digits, field_name);
+    if (parsed > (std::numeric_limits<std::uint64_t>::max() >> shift)) {
+        throw std::runtime_error("Invalid " + std::string(field_name) +
+                                 " value '" + std::string(value) + "': out of range");
+    }
+    return parsed << shift;
+}
+
 }  // namespace gfaidx::utils
@@ -38,6 +38,11 @@ std::uint32_t parse_u32_strict(std::string_view value,
                                std::uint32_t max_value = std::numeric_limits<std::uint32_t>::max(),
                                bool allow_commas = false);
 
+// Parse a byte count such as --max_memory with an optional binary K, M, G or
+// T suffix (case-insensitive), e.g. "512M" or "4G".
+std::uint64_t parse_byte_size_strict(std::string_view value,
+                                     std::string_view field_name);
+
 }  // namespace gfaidx::utils
 
 #endif  // GFAIDX_CLI_HELPERS_H
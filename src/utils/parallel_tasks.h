@@ -0,0 +1,63 @@
+#ifndef GFAIDX_PARALLEL_TASKS_H
+#define GFAIDX_PARALLEL_TASKS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gfaidx::utils {
+
+// Run task(i) for every i in [0, task_count) on up to worker_count threads,
+// the calling thread included. Tasks are claimed in index order, so a task
+// may wait for an earlier one to finish. The first exception stops further
+// claims and is rethrown once every worker has stopped.
+template <typename Task>
+void run_parallel_tasks(std::size_t task_count, std::size_t worker_count, Task&& task) {
+    worker_count = std::min(worker_count, task_count);
+    if (worker_count <= 1) {
+        for (std::size_t i = 0; i < task_count; ++i) task(i);
+        return;
+    }
+
+    std::atomic<std::size_t> next_task{0};
+    std::atomic<bool> failed{false};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    const auto run_worker = [&]() {
+        try {
+            while (!failed.load(std::memory_order_relaxed)) {
+                const std::size_t i = next_task.fetch_add(1);
+                if (i >= task_count) return;
+                task(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+            failed = true;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(worker_count - 1);
+    try {
+        for (std::size_t w = 1; w < worker_count; ++w) {
+            threads.emplace_back(run_worker);
+        }
+    } catch (...) {
+        // Workers already started stop at their next claim.
+        failed = true;
+        for (auto& thread : threads) thread.join();
+        throw;
+    }
+    run_worker();
+    for (auto& thread : threads) thread.join();
+    if (error) std::rethrow_exception(error);
+}
+
+}  // namespace gfaidx::utils
+
+#endif  // GFAIDX_PARALLEL_TASKS_H
@@ -0,0 +1,63 @@
+#include "utils/sparse_bitmap.h"
+
+namespace gfaidx::utils {
+
+std::uint32_t SparseBitmap::find_container(std::uint64_t key) const {
+    if (last_container_ != kNoContainer && last_key_ == key) return last_container_;
+    const auto it = container_by_key_.find(key);
+    if (it == container_by_key_.end()) return kNoContainer;
+    last_key_ = key;
+    last_container_ = it->second;
+    return it->second;
+}
+
+bool SparseBitmap::insert(std::uint64_t value) {
+    const std::uint64_t key = value >> 16;
+    const auto low = static_cast<std::uint16_t>(value & 0xffffU);
+
+    std::uint32_t index = find_container(key);
+    if (index == kNoContainer) {
+        index = static_cast<std::uint32_t>(containers_.size());
+        containers_.push_back(Container{key, {}, {}});
+        container_by_key_.emplace(key, index);
+        last_key_ = key;
+        last_container_ = index;
+    }
+    auto& container = containers_[index];
+
+    if (!container.bits.empty()) {
+        auto& word = container.bits[low / 64];
+        const std::uint64_t mask = 1ULL << (low % 64);
+        if ((word & mask) != 0) return false;
+        word |= mask;
+        ++size_;
+        return true;
+    }
+
+    auto& values = container.values;
+    const auto it = std::lower_bound(values.begin(), values.end(), low);
+    if (it != values.end() && *it == low) return false;
+    values.insert(it, low);
+    ++size_;
+
+    // Past this size a bitmap is no larger than the array and has O(1) inserts.
+    if (values.size() >= kArrayMaxSize) {
+        container.bits.assign(kBitmapWords, 0);
+        for (const auto v : values) container.bits[v / 64] |= 1ULL << (v % 64);
+        std::vector<std::uint16_t>().swap(values);
+    }
+    return true;
+}
+
+bool SparseBitmap::contains(std::uint64_t value) const {
+    const std::uint32_t index = find_container(value >> 16);
+    if (index == kNoContainer) return false;
+    const auto& container = containers_[index];
+    const auto low = static_cast<std::uint16_t>(value & 0xffffU);
+    if (!container.bits.empty()) {
+        return (container.bits[low / 64] & (1ULL << (low % 64))) != 0;
+    }
+    return std::binary_search(container.values.begin(), container.values.end(), low);
+}
+
+}  // namespace gfaidx::utils
@@ -0,0 +1,80 @@
+#ifndef GFAIDX_SPARSE_BITMAP_H
+#define GFAIDX_SPARSE_BITMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace gfaidx::utils {
+
+// Roaring-style set of uint64 values for sets that are small compared to the
+// range their values come from, such as the node ranks or path steps touched
+// by one query. Each value is split into a container key (the high 48 bits)
+// and a 16-bit low part. A container keeps its low parts as a sorted array
+// until it holds kArrayMaxSize of them, then switches to a 65536-bit bitmap.
+// Memory and clearing cost follow the number of values set, not the largest
+// possible value.
+class SparseBitmap {
+public:
+    // Add value and return true if it was not in the set yet.
+    bool insert(std::uint64_t value);
+    [[nodiscard]] bool contains(std::uint64_t value) const;
+    [[nodiscard]] std::uint64_t size() const { return size_; }
+
+    // Visit every value in ascending order.
+    template <typename Visitor>
+    void for_each(Visitor&& visitor) const;
+
+private:
+    static constexpr std::size_t kArrayMaxSize = 4096;
+    static constexpr std::size_t kBitmapWords = 65536 / 64;
+    static constexpr std::uint32_t kNoContainer = 0xffffffffU;
+
+    struct Container {
+        std::uint64_t key{};
+        std::vector<std::uint16_t> values;
+        std::vector<std::uint64_t> bits;
+    };
+
+    [[nodiscard]] std::uint32_t find_container(std::uint64_t key) const;
+
+    std::vector<Container> containers_;
+    std::unordered_map<std::uint64_t, std::uint32_t> container_by_key_;
+    // Queries touch values in clustered order, so most lookups hit the same
+    // container as the one before.
+    mutable std::uint64_t last_key_{};
+    mutable std::uint32_t last_container_{kNoContainer};
+    std::uint64_t size_{0};
+};
+
+template <typename Visitor>
+void SparseBitmap::for_each(Visitor&& visitor) const {
+    std::vector<std::uint32_t> order(containers_.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = static_cast<std::uint32_t>(i);
+    std::sort(order.begin(), order.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+        return containers_[lhs].key < containers_[rhs].key;
+    });
+
+    for (const auto index : order) {
+        const auto& container = containers_[index];
+        const std::uint64_t high = container.key << 16;
+        if (container.bits.empty()) {
+            for (const auto low : container.values) visitor(high | low);
+            continue;
+        }
+        for (std::size_t word = 0; word < kBitmapWords; ++word) {
+            std::uint64_t bits = container.bits[word];
+            while (bits != 0) {
+                const auto bit = static_cast<std::uint64_t>(__builtin_ctzll(bits));
+                visitor(high | (word * 64 + bit));
+                bits &= bits - 1;
+            }
+        }
+    }
+}
+
+}  // namespace gfaidx::utils
+
+#endif  // GFAIDX_SPARSE_BITMAP_H
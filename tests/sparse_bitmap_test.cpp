@@ -0,0 +1,105 @@
+// Compare utils::SparseBitmap against std::set on random inputs.
+//
+// The inputs cover sparse values spread over the whole uint64 range, dense
+// values that push containers past the 4096-value array limit into bitmaps,
+// and clustered values whose containers are created out of key order, so
+// for_each() has to sort them.
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "utils/sparse_bitmap.h"
+
+namespace {
+
+using gfaidx::utils::SparseBitmap;
+
+void check(bool condition, const std::string& message) {
+    if (!condition) throw std::runtime_error(message);
+}
+
+// Insert values into both sets, then check sizes, membership of inserted and
+// random probe values, and the ascending for_each() order.
+void compare(const std::string& label, const std::vector<std::uint64_t>& values,
+             std::mt19937_64& rng) {
+    SparseBitmap bitmap;
+    std::set<std::uint64_t> reference;
+    for (const auto value : values) {
+        const bool inserted = reference.insert(value).second;
+        check(bitmap.insert(value) == inserted, label + ": insert result differs");
+        check(bitmap.contains(value), label + ": inserted value missing");
+    }
+    check(bitmap.size() == reference.size(), label + ": size differs");
+
+    for (const auto value : values) {
+        const std::uint64_t probes[] = {value - 1, value, value + 1, value ^ 0x10000ULL};
+        for (const auto probe : probes) {
+            check(bitmap.contains(probe) == (reference.count(probe) != 0),
+                  label + ": contains differs near an inserted value");
+        }
+    }
+    for (int i = 0; i < 10000; ++i) {
+        const auto probe = rng();
+        check(bitmap.contains(probe) == (reference.count(probe) != 0),
+              label + ": contains differs for a random value");
+    }
+
+    std::vector<std::uint64_t> visited;
+    bitmap.for_each([&](std::uint64_t value) { visited.push_back(value); });
+    check(std::vector<std::uint64_t>(reference.begin(), reference.end()) == visited,
+          label + ": for_each differs from the sorted reference");
+}
+
+}  // namespace
+
+int main() {
+    try {
+        std::mt19937_64 rng(40);
+
+        std::vector<std::uint64_t> sparse;
+        for (int i = 0; i < 20000; ++i) sparse.push_back(rng());
+        compare("sparse", sparse, rng);
+
+        // One container filled up to the array limit and one value past it,
+        // with a duplicate of each, checked on both sides of the switch.
+        for (const std::uint64_t count : {4095ULL, 4096ULL, 4097ULL}) {
+            std::vector<std::uint64_t> boundary;
+            const std::uint64_t high = 7ULL << 16;
+            for (std::uint64_t i = 0; i < count; ++i) boundary.push_back(high | (i * 13 % 65536));
+            boundary.push_back(high | 13);
+            compare("array limit " + std::to_string(count), boundary, rng);
+        }
+
+        // Dense containers reach bitmaps at different points, interleaved with
+        // containers that stay arrays, created in random key order.
+        std::vector<std::uint64_t> dense;
+        std::uniform_int_distribution<std::uint64_t> key(0, 40);
+        std::uniform_int_distribution<std::uint64_t> low(0, 65535);
+        for (int i = 0; i < 200000; ++i) {
+            const auto k = key(rng);
+            const auto spread = k % 3 == 0 ? 65536 : 6000;
+            dense.push_back(((k * 1000003ULL) << 16) | (low(rng) % spread));
+        }
+        compare("dense", dense, rng);
+
+        // Runs of consecutive values crossing container boundaries, as path
+        // steps do, starting from descending keys.
+        std::vector<std::uint64_t> clustered;
+        for (std::uint64_t start = 900000; start >= 100000; start -= 100000) {
+            for (std::uint64_t v = start; v < start + 70000; v += 1 + rng() % 3) {
+                clustered.push_back(v);
+            }
+        }
+        compare("clustered", clustered, rng);
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+    std::cout << "sparse bitmap matches std::set" << std::endl;
+    return 0;
+}
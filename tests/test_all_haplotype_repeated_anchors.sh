@@ -202,6 +202,28 @@ check_gap_one_output "$work_dir/gap_one.gfa"
     --with_coords >/dev/null
 cmp "$work_dir/from_cdx.gfa" "$work_dir/gap_one_kb.gfa"
 
+# One-base projection windows make every interior reference node a whole
+# window, so the .hpx bounds replace most postings and must select the same
+# path spans. Local gap clustering ignores the projection.
+"$gfaidx" index_haplotype_projection "$indexed_gfa" --window 1bp >/dev/null
+"$gfaidx" get_region \
+    "$indexed_gfa" \
+    ref:1-4 \
+    "$work_dir/from_hpx.gfa" \
+    --all_haplotypes \
+    --with_coords >"$work_dir/from_hpx.stdout"
+grep -F "Haplotype projection supplied" "$work_dir/from_hpx.stdout" >/dev/null
+cmp "$work_dir/from_cdx.gfa" "$work_dir/from_hpx.gfa"
+"$gfaidx" get_region \
+    "$indexed_gfa" \
+    ref:1-4 \
+    "$work_dir/gap_one_hpx.gfa" \
+    --all_haplotypes \
+    --haplotype_gap 1bp \
+    --with_coords >/dev/null
+cmp "$work_dir/gap_one.gfa" "$work_dir/gap_one_hpx.gfa"
+rm "$indexed_gfa.hpx"
+
 # Reject gap clustering outside all-haplotype extraction and reject malformed
 # units before opening the graph or creating an output file.
 if "$gfaidx" get_region "$indexed_gfa" ref:1-4 \
@@ -236,3 +258,41 @@ mv "$indexed_gfa.pcx" "$work_dir/checkpoint_stride_2.pcx"
     --all_haplotypes \
     --with_coords >/dev/null
 check_output "$work_dir/from_fallback.gfa"
+
+# Enough anchor hits to turn the anchor-step bitmap containers into bitmaps:
+# the reference and a haplotype with a 2000-base insertion share 5000 nodes,
+# and a 60000-step filler path in front makes the haplotype's packed step
+# ranks cross a container boundary. The insertion splits the haplotype only
+# when the allowance is below its length.
+python3 - "$work_dir/many_anchors.gfa" <<'PY'
+import sys
+
+with open(sys.argv[1], "w") as out:
+    out.write("H\tVN:Z:1.0\nS\tf\tA\n")
+    for i in range(5000):
+        out.write(f"S\ta{i}\tA\n")
+    for i in range(2000):
+        out.write(f"S\ti{i}\tC\n")
+    ref = [f"a{i}" for i in range(5000)]
+    hap = ref[:2500] + [f"i{i}" for i in range(2000)] + ref[2500:]
+    links = set(zip(ref, ref[1:])) | set(zip(hap, hap[1:]))
+    for a, b in sorted(links):
+        out.write(f"L\t{a}\t+\t{b}\t+\t0M\n")
+    out.write("P\tfiller\t" + ",".join(["f+"] * 60000) + "\t*\n")
+    out.write("P\tref\t" + ",".join(s + "+" for s in ref) + "\t*\n")
+    out.write("P\thap\t" + ",".join(s + "+" for s in hap) + "\t*\n")
+PY
+many_anchors_gfa="$work_dir/many_anchors.gfa.gz"
+"$gfaidx" index_gfa "$work_dir/many_anchors.gfa" "$many_anchors_gfa" \
+    --progress_every 0 >/dev/null
+for gap in 1999bp 2000bp; do
+    "$gfaidx" get_region "$many_anchors_gfa" ref:0-5000 "$work_dir/many_$gap.gfa" \
+        --all_haplotypes --haplotype_gap "$gap" --with_coords >/dev/null
+    awk -F '\t' '$1 == "P" {print $2}' "$work_dir/many_$gap.gfa" \
+        >"$work_dir/many_${gap}_paths.txt"
+done
+printf '%s\n' ref:0-5000 hap:0-2500 hap:4500-7000 >"$work_dir/expected_many_split.txt"
+diff -u "$work_dir/expected_many_split.txt" "$work_dir/many_1999bp_paths.txt"
+printf '%s\n' ref:0-5000 hap:0-7000 >"$work_dir/expected_many_joined.txt"
+diff -u "$work_dir/expected_many_joined.txt" "$work_dir/many_2000bp_paths.txt"
+test "$(grep -c '^S' "$work_dir/many_1999bp.gfa")" -eq 5000
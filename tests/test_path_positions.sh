@@ -0,0 +1,175 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+gfaidx=$1
+input_gfa=$2
+work_dir=$(mktemp -d "${TMPDIR:-/tmp}/gfaidx-path-positions.XXXXXX")
+trap 'rm -rf "$work_dir"' EXIT
+
+indexed_gfa="$work_dir/graph.gfa.gz"
+"$gfaidx" index_gfa "$input_gfa" "$indexed_gfa" --progress_every 0 >/dev/null
+
+# The fixture's reference fragment starts at 1000, hap#1#chr1 is its reverse
+# complement, dup visits A twice, and the W walk starts at 50. A base lifts to
+# every other visit of its node, with the strand of the target step relative
+# to the source step; the past-the-end position is skipped with a warning.
+printf 'ref#0#chr1\t1001\ndup\t6\nhap#1#chr1\t4\nsmp#2#chr1\t59\nref#0#chr1\t1010\n' \
+    >"$work_dir/positions.tsv"
+cat >"$work_dir/expected_liftover.tsv" <<'EOT'
+query_path	query_position	target_path	target_position	strand	node
+ref#0#chr1	1001	hap#1#chr1	8	-	A
+ref#0#chr1	1001	dup	1	+	A
+ref#0#chr1	1001	dup	6	+	A
+ref#0#chr1	1001	smp#2#chr1	51	+	A
+dup	6	ref#0#chr1	1001	+	A
+dup	6	hap#1#chr1	8	-	A
+dup	6	dup	1	+	A
+dup	6	smp#2#chr1	51	+	A
+hap#1#chr1	4	ref#0#chr1	1005	-	C
+hap#1#chr1	4	smp#2#chr1	55	-	C
+smp#2#chr1	59	ref#0#chr1	1009	+	D
+smp#2#chr1	59	hap#1#chr1	0	-	D
+EOT
+"$gfaidx" liftover "$indexed_gfa" --positions "$work_dir/positions.tsv" \
+    >"$work_dir/liftover.tsv" 2>"$work_dir/liftover.stderr"
+diff -u "$work_dir/expected_liftover.tsv" "$work_dir/liftover.tsv"
+grep -F "skipped position ref#0#chr1:1010" "$work_dir/liftover.stderr" >/dev/null
+
+# Without .pcx the step offsets are summed while the paths are scanned, with
+# the same answer.
+mv "$indexed_gfa.pcx" "$work_dir/saved.pcx"
+"$gfaidx" liftover "$indexed_gfa" --positions "$work_dir/positions.tsv" \
+    >"$work_dir/liftover_without_pcx.tsv" 2>/dev/null
+diff -u "$work_dir/expected_liftover.tsv" "$work_dir/liftover_without_pcx.tsv"
+mv "$work_dir/saved.pcx" "$indexed_gfa.pcx"
+
+# A 10000-step path spans three 4096-step blocks. Its positions lift to the
+# reverse path with and without .pcx, including the bases around each block
+# boundary, and without .pcx the blocks are still decoded one at a time.
+python3 - "$work_dir/long.gfa" "$work_dir/long_positions.tsv" \
+    "$work_dir/expected_long.tsv" <<'PY'
+import sys
+
+lengths = [1 + i % 5 for i in range(10000)]
+starts = [0]
+for length in lengths:
+    starts.append(starts[-1] + length)
+with open(sys.argv[1], "w") as out:
+    out.write("H\tVN:Z:1.0\n")
+    for i, length in enumerate(lengths):
+        out.write(f"S\tn{i}\t{'A' * length}\n")
+    for i in range(len(lengths) - 1):
+        out.write(f"L\tn{i}\t+\tn{i + 1}\t+\t0M\n")
+    out.write("P\tref\t" + ",".join(f"n{i}+" for i in range(len(lengths))) + "\t*\n")
+    out.write("P\talt\t" + ",".join(f"n{i}-" for i in reversed(range(len(lengths)))) + "\t*\n")
+steps = [0, 4095, 4096, 8191, 8192, 9999]
+queries = sorted({starts[k] + d for k in steps for d in (0, lengths[k] - 1)} |
+                 {starts[k] - 1 for k in steps if k})
+with open(sys.argv[2], "w") as positions, open(sys.argv[3], "w") as expected:
+    for position in queries:
+        k = max(i for i in range(len(lengths)) if starts[i] <= position)
+        target = starts[-1] - position - 1
+        positions.write(f"ref\t{position}\n")
+        expected.write(f"ref\t{position}\talt\t{target}\t-\tn{k}\n")
+PY
+long_gfa="$work_dir/long.gfa.gz"
+"$gfaidx" index_gfa "$work_dir/long.gfa" "$long_gfa" --progress_every 0 >/dev/null
+"$gfaidx" liftover "$long_gfa" --positions "$work_dir/long_positions.tsv" \
+    --target alt --no_header >"$work_dir/long_liftover.tsv" 2>/dev/null
+diff -u "$work_dir/expected_long.tsv" "$work_dir/long_liftover.tsv"
+
+# A .pcx of a graph with the same counts but another path name is rejected by
+# the .pdx layout hash, and the lookups fall back to scanning.
+sed 's/^P\talt\t/P\talu\t/' "$work_dir/long.gfa" >"$work_dir/renamed.gfa"
+"$gfaidx" index_gfa "$work_dir/renamed.gfa" "$work_dir/renamed.gfa.gz" \
+    --progress_every 0 >/dev/null
+mv "$work_dir/renamed.gfa.gz.pcx" "$long_gfa.pcx"
+"$gfaidx" liftover "$long_gfa" --positions "$work_dir/long_positions.tsv" \
+    --target alt --no_header >"$work_dir/long_stale_pcx.tsv" \
+    2>"$work_dir/long_stale_pcx.stderr"
+diff -u "$work_dir/expected_long.tsv" "$work_dir/long_stale_pcx.tsv"
+grep -F ".pcx path metadata does not match" "$work_dir/long_stale_pcx.stderr" >/dev/null
+rm "$long_gfa.pcx"
+"$gfaidx" liftover "$long_gfa" --positions "$work_dir/long_positions.tsv" \
+    --target alt --no_header >"$work_dir/long_without_pcx.tsv" \
+    2>"$work_dir/long_without_pcx.stderr"
+diff -u "$work_dir/expected_long.tsv" "$work_dir/long_without_pcx.tsv"
+long_blocks=$(sed -n 's/.*(\([0-9]*\) step blocks decoded).*/\1/p' \
+    "$work_dir/long_without_pcx.stderr")
+test "$long_blocks" -ge 3
+
+# A single position may name an exact record, and --target restricts the
+# output; a base with no other visit on the targets gets '*' columns.
+"$gfaidx" liftover "$indexed_gfa" 'ref#0#chr1:1000-1010:1,001' \
+    --target 'hap#1#chr1' --no_header >"$work_dir/single.tsv" 2>/dev/null
+printf 'ref#0#chr1:1000-1010\t1001\thap#1#chr1\t8\t-\tA\n' >"$work_dir/expected_single.tsv"
+diff -u "$work_dir/expected_single.tsv" "$work_dir/single.tsv"
+
+"$gfaidx" liftover "$indexed_gfa" 'hap#1#chr1:4' --target dup --no_header \
+    >"$work_dir/unmapped.tsv" 2>/dev/null
+printf 'hap#1#chr1\t4\t*\t*\t*\tC\n' >"$work_dir/expected_unmapped.tsv"
+diff -u "$work_dir/expected_unmapped.tsv" "$work_dir/unmapped.tsv"
+
+if "$gfaidx" liftover "$indexed_gfa" 'ref#0#chr1:1001' --target missing \
+    >"$work_dir/bad_target.stdout" 2>"$work_dir/bad_target.stderr"; then
+    echo "liftover unexpectedly accepted an unknown target" >&2
+    exit 1
+fi
+grep -F "No indexed P path or W walk is named 'missing'" \
+    "$work_dir/bad_target.stderr" >/dev/null
+
+# get_position lists every visit of each node in query order, with the
+# node's interval in the visiting record's coordinate namespace.
+cat >"$work_dir/expected_positions.tsv" <<'EOT'
+node	path	start	end	strand
+C	ref#0#chr1	1005	1006	+
+C	hap#1#chr1	4	5	-
+C	smp#2#chr1	55	56	+
+A	ref#0#chr1	1000	1003	+
+A	hap#1#chr1	7	10	-
+A	dup	0	3	+
+A	dup	5	8	+
+A	smp#2#chr1	50	53	+
+EOT
+printf 'C\nA,missing\n' >"$work_dir/nodes.txt"
+"$gfaidx" get_position "$indexed_gfa" --nodes_file "$work_dir/nodes.txt" \
+    >"$work_dir/positions_out.tsv" 2>"$work_dir/positions.stderr"
+diff -u "$work_dir/expected_positions.tsv" "$work_dir/positions_out.tsv"
+grep -F "skipped node missing" "$work_dir/positions.stderr" >/dev/null
+"$gfaidx" get_position "$indexed_gfa" --nodes_file "$work_dir/nodes.txt" --threads 3 \
+    >"$work_dir/positions_threads.tsv" 2>/dev/null
+cmp "$work_dir/positions_out.tsv" "$work_dir/positions_threads.tsv"
+
+"$gfaidx" get_position "$indexed_gfa" --nodes A,B --target dup --no_header \
+    >"$work_dir/positions_dup.tsv" 2>/dev/null
+printf 'A\tdup\t0\t3\t+\nA\tdup\t5\t8\t+\nB\tdup\t3\t5\t+\n' >"$work_dir/expected_dup.tsv"
+diff -u "$work_dir/expected_dup.tsv" "$work_dir/positions_dup.tsv"
+
+# get_depth counts the visits of each reference node, or with
+# --distinct_paths the records visiting it, and bins weight each base by the
+# depth of its node; bins are aligned to multiples of the bin size.
+cat >"$work_dir/expected_depth.tsv" <<'EOT'
+path	start	end	node	depth
+ref#0#chr1	1000	1003	A	5
+ref#0#chr1	1003	1005	B	4
+ref#0#chr1	1005	1006	C	3
+ref#0#chr1	1006	1010	D	3
+EOT
+"$gfaidx" get_depth "$indexed_gfa" 'ref#0#chr1:1001-1009' \
+    >"$work_dir/depth.tsv" 2>/dev/null
+diff -u "$work_dir/expected_depth.tsv" "$work_dir/depth.tsv"
+
+cat >"$work_dir/expected_depth_bins.tsv" <<'EOT'
+ref#0#chr1	1001	1002	1	4.000	4	4
+ref#0#chr1	1002	1005	3	4.000	4	4
+ref#0#chr1	1005	1008	3	3.000	3	3
+ref#0#chr1	1008	1009	1	3.000	3	3
+EOT
+"$gfaidx" get_depth "$indexed_gfa" 'ref#0#chr1:1001-1009' --bin_size 3bp \
+    --distinct_paths --threads 2 --no_header >"$work_dir/depth_bins.tsv" 2>/dev/null
+diff -u "$work_dir/expected_depth_bins.tsv" "$work_dir/depth_bins.tsv"
+
+"$gfaidx" get_depth "$indexed_gfa" chr1:52-56 --reference smp --bin_size 4 --no_header \
+    >"$work_dir/depth_walk.tsv" 2>/dev/null
+printf 'smp#2#chr1\t52\t56\t4\t4.000\t3\t5\n' >"$work_dir/expected_depth_walk.tsv"
+diff -u "$work_dir/expected_depth_walk.tsv" "$work_dir/depth_walk.tsv"
@@ -0,0 +1,209 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+gfaidx=$1
+loop_checker=$2
+work_dir=$(mktemp -d "${TMPDIR:-/tmp}/gfaidx-step-storage-test.XXXXXX")
+trap 'rm -rf "$work_dir"' EXIT
+
+# Paths with lengths around the 128-step block size, wide node-id spreads, both
+# orientations, one single-node repeat, a two-node loop long enough to give
+# its nodes a posting skip table, a P line longer than both the reader's buffer
+# and one shared parse block, and a W line spanning several blocks.
+python3 - "$work_dir/graph.gfa" <<'PY'
+import random
+import sys
+
+rng = random.Random(29)
+node_count = 700
+paths = {
+    "wide": [rng.randrange(node_count) for _ in range(300)],
+    "one_block": [rng.randrange(40) for _ in range(128)],
+    "block_plus_one": [rng.randrange(node_count) for _ in range(129)],
+    "single": [5],
+    "same_node": [7] * 200,
+    "two_node_loop": [7, 8] * 2100,
+}
+# Repeat an earlier path so sharing still stores it cheaply.
+paths["longer_than_read_buffer"] = paths["wide"] * 300
+walk = [rng.randrange(node_count) for _ in range(257)]
+orient = {name: [rng.random() < 0.5 for _ in steps] for name, steps in paths.items()}
+orient["same_node"] = [False] * 200
+orient["longer_than_read_buffer"] = orient["wide"] * 300
+walk_orient = [rng.random() < 0.5 for _ in walk]
+
+with open(sys.argv[1], "w") as out:
+    out.write("H\tVN:Z:1.1\n")
+    for node in range(node_count):
+        out.write(f"S\tn{node}\tACGT\n")
+    links = set()
+    for steps in list(paths.values()) + [walk]:
+        for a, b in zip(steps, steps[1:]):
+            links.add((a, b))
+    for a, b in sorted(links):
+        out.write(f"L\tn{a}\t+\tn{b}\t+\t0M\n")
+    for name, steps in paths.items():
+        tokens = ",".join(f"n{s}{'-' if r else '+'}" for s, r in zip(steps, orient[name]))
+        out.write(f"P\t{name}\t{tokens}\t*\n")
+    tokens = "".join(f"{'<' if r else '>'}n{s}" for s, r in zip(walk, walk_orient))
+    out.write(f"W\tsample\t1\tchr1\t0\t{4 * len(walk)}\t{tokens}\n")
+
+    # Haplotypes through a chain of SNP bubbles. They copy a few founders with
+    # recombination and private variants, so most of each path repeats an
+    # earlier one and should be stored as shared runs.
+    sites, founders = 400, 4
+    alleles = [[rng.random() < 0.3 for _ in range(sites)] for _ in range(founders)]
+    for i in range(sites):
+        out.write(f"S\tb{i}\tACGT\nS\tref{i}\tA\nS\talt{i}\tC\n")
+        for allele in ("ref", "alt"):
+            out.write(f"L\tb{i}\t+\t{allele}{i}\t+\t0M\n")
+            out.write(f"L\t{allele}{i}\t+\tb{i + 1}\t+\t0M\n")
+    out.write(f"S\tb{sites}\tACGT\n")
+    for hap in range(100):
+        founder = rng.randrange(founders)
+        tokens = []
+        for i in range(sites):
+            if rng.random() < 0.01:
+                founder = rng.randrange(founders)
+            alt = alleles[founder][i] != (rng.random() < 0.005)
+            tokens.append(f"b{i}+")
+            tokens.append(f"{'alt' if alt else 'ref'}{i}+")
+        tokens.append(f"b{sites}+")
+        out.write(f"P\thap{hap}\t{','.join(tokens)}\t*\n")
+PY
+
+indexed_gfa="$work_dir/graph.gfa.gz"
+"$gfaidx" index_gfa "$work_dir/graph.gfa" "$indexed_gfa" \
+    --progress_every 0 >/dev/null
+
+# index_gfa accumulates .pcx while writing the steps; it must match a rescan of
+# the finished .pdx byte for byte, with paths spanning several checkpoints.
+"$gfaidx" index_path_checkpoints "$indexed_gfa" "$work_dir/rescanned.pcx" \
+    --progress_every_paths 0 >/dev/null
+cmp "$indexed_gfa.pcx" "$work_dir/rescanned.pcx"
+"$gfaidx" index_path_checkpoints "$indexed_gfa" "$work_dir/stride_3.pcx" \
+    --checkpoint_steps 3 \
+    --threads 4 \
+    --progress_every_paths 0 >/dev/null
+"$gfaidx" index_gfa "$work_dir/graph.gfa" "$work_dir/stride_3.gfa.gz" \
+    --checkpoint_steps 3 \
+    --progress_every 0 >/dev/null
+cmp "$work_dir/stride_3.gfa.gz.pcx" "$work_dir/stride_3.pcx"
+
+# Without a .cdx, get_region resolves coordinates from the path steps. A stride-3
+# .pcx bounds that scan to a few steps around the interval; the selection must
+# match the one-checkpoint scan of the default stride.
+for region in longer_than_read_buffer:0-1 longer_than_read_buffer:1001-1013 \
+    longer_than_read_buffer:239990-240000 longer_than_read_buffer:359990-360000 two_node_loop:4000-9000 wide:37-38; do
+    "$gfaidx" get_region "$indexed_gfa" "$region" "$work_dir/region_full.gfa" \
+        --all_haplotypes --with_coords >/dev/null 2>&1
+    "$gfaidx" get_region "$indexed_gfa" "$region" "$work_dir/region_stride_3.gfa" \
+        --pcx "$work_dir/stride_3.pcx" \
+        --all_haplotypes --with_coords >/dev/null 2>&1
+    cmp "$work_dir/region_full.gfa" "$work_dir/region_stride_3.gfa"
+done
+
+"$gfaidx" index_paths "$work_dir/graph.gfa" "$work_dir/flat.pdx" \
+    --ndx "$indexed_gfa.ndx" \
+    --flat_steps \
+    --progress_every 0 >/dev/null
+
+# Parsing P/W lines on several workers must not change a single byte, nor
+# must a tiny posting budget that forces merge passes and many node ranges.
+"$gfaidx" index_paths "$work_dir/graph.gfa" "$work_dir/flat_threaded.pdx" \
+    --ndx "$indexed_gfa.ndx" \
+    --flat_steps \
+    --threads 3 \
+    --max_memory 64K \
+    --progress_every 0 >/dev/null
+cmp "$work_dir/flat.pdx" "$work_dir/flat_threaded.pdx"
+
+# The shared layout parses runs in input order on the writer, so it must not
+# depend on the worker count either, whether built by index_paths or index_gfa.
+"$gfaidx" index_paths "$work_dir/graph.gfa" "$work_dir/shared.pdx" \
+    --ndx "$indexed_gfa.ndx" \
+    --threads 1 \
+    --progress_every 0 >/dev/null
+"$gfaidx" index_paths "$work_dir/graph.gfa" "$work_dir/shared_threaded.pdx" \
+    --ndx "$indexed_gfa.ndx" \
+    --threads 3 \
+    --max_memory 64K \
+    --progress_every 0 >/dev/null
+cmp "$work_dir/shared.pdx" "$work_dir/shared_threaded.pdx"
+cmp "$indexed_gfa.pdx" "$work_dir/shared.pdx"
+"$gfaidx" index_gfa "$work_dir/graph.gfa" "$work_dir/threaded.gfa.gz" \
+    --threads 3 \
+    --max_memory 64K \
+    --progress_every 0 >/dev/null
+cmp "$indexed_gfa.pdx" "$work_dir/threaded.gfa.gz.pdx"
+cmp "$indexed_gfa.pcx" "$work_dir/threaded.gfa.gz.pcx"
+
+if "$gfaidx" index_gfa "$work_dir/graph.gfa" "$work_dir/tiny_budget.gfa.gz" \
+    --max_memory 1K --progress_every 0 >/dev/null 2>&1; then
+    echo "index_gfa accepted a --max_memory below 64K" >&2
+    exit 1
+fi
+
+# index_gfa --flat_steps must write the same flat layout as index_paths.
+"$gfaidx" index_gfa "$work_dir/graph.gfa" "$work_dir/flat.gfa.gz" \
+    --flat_steps \
+    --progress_every 0 >/dev/null
+cmp "$work_dir/flat.pdx" "$work_dir/flat.gfa.gz.pdx"
+
+# A 64K step history holds under 2000 steps, far fewer than the longest path,
+# so older runs fall out of it while paths are still being parsed.
+"$gfaidx" index_paths "$work_dir/graph.gfa" "$work_dir/small_history.pdx" \
+    --ndx "$indexed_gfa.ndx" \
+    --step_memory 64K \
+    --progress_every 0 >/dev/null
+
+# Every P record must decode back to the exact input step list from both the
+# shared-run and the flat step layout, and with a bounded step history.
+grep '^P' "$work_dir/graph.gfa" | cut -f1-3 > "$work_dir/expected_p.tsv"
+for layout in shared flat small_history; do
+    pdx="$indexed_gfa.pdx"
+    [[ "$layout" != shared ]] && pdx="$work_dir/$layout.pdx"
+    : > "$work_dir/actual_$layout.tsv"
+    for name in $(cut -f2 "$work_dir/expected_p.tsv"); do
+        "$gfaidx" get_path "$indexed_gfa" --pdx "$pdx" --path_id "$name" 2>/dev/null \
+            | grep '^P' | cut -f1-3 >> "$work_dir/actual_$layout.tsv"
+    done
+    diff -u "$work_dir/expected_p.tsv" "$work_dir/actual_$layout.tsv"
+done
+
+# The haplotypes repeat each other, so sharing runs must shrink the step table.
+python3 - "$indexed_gfa.pdx" "$work_dir/flat.pdx" <<'PY'
+import struct
+import sys
+
+def step_table_bytes(path):
+    with open(path, "rb") as handle:
+        values = struct.unpack("<8sIIQQQQQQQQQQQQQQ", handle.read(128))
+    assert values[1] == 11, values[1]
+    return values[10] - values[9]
+
+shared, flat = (step_table_bytes(path) for path in sys.argv[1:])
+assert shared * 4 < flat, (shared, flat)
+PY
+
+grep '^W' "$work_dir/graph.gfa" | cut -f7 > "$work_dir/expected_w.txt"
+"$gfaidx" get_path "$indexed_gfa" --sample sample --hap_index 1 --seq_id chr1 2>/dev/null \
+    | grep '^W' | cut -f7 > "$work_dir/actual_w.txt"
+diff -u "$work_dir/expected_w.txt" "$work_dir/actual_w.txt"
+
+# n7 and n8 occur often enough to carry posting skip tables; a node-set
+# lookup must still see every occurrence.
+"$gfaidx" get_path "$indexed_gfa" --nodes n7,n8 2>/dev/null \
+    | awk -F '\t' '$1 == "P" { print $2, split($3, steps, ",") }' > "$work_dir/node_runs.txt"
+grep -qx 'two_node_loop#subpath_0_4199 4200' "$work_dir/node_runs.txt"
+grep -qx 'same_node#subpath_0_199 200' "$work_dir/node_runs.txt"
+
+# The standalone checker decodes the same blocks without the C++ reader.
+python3 "$loop_checker" "$indexed_gfa.pdx" same_node > "$work_dir/loops.txt"
+grep -q '^Steps: 200$' "$work_dir/loops.txt"
+grep -q '^Unique node ranks: 1$' "$work_dir/loops.txt"
+python3 "$loop_checker" "$indexed_gfa.pdx" single > "$work_dir/single.txt"
+grep -q 'node-simple' "$work_dir/single.txt"
+python3 "$loop_checker" "$indexed_gfa.pdx" hap99 > "$work_dir/hap.txt"
+grep -q '^Steps: 801$' "$work_dir/hap.txt"
+grep -q 'node-simple' "$work_dir/hap.txt"
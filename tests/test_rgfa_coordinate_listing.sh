@@ -52,3 +52,173 @@ cdx_only_gfa="$work_dir/graph.no_paths.gfa.gz"
 "$gfaidx" get_region "$cdx_only_gfa" --list_coordinates \
     >"$work_dir/cdx_only.tsv"
 diff -u "$work_dir/list_coordinates.tsv" "$work_dir/cdx_only.tsv"
+
+# A reference chain long enough to span several 256-entry lookup fences. Each
+# interval, including ones that start or end on a fence entry, must select
+# exactly the segments it overlaps.
+python3 - "$work_dir/chain.gfa" "$work_dir/chain_queries.tsv" <<'PY'
+import random
+import sys
+
+rng = random.Random(41)
+lengths = [rng.randint(1, 9) for _ in range(1500)]
+starts = []
+offset = 0
+with open(sys.argv[1], "w") as out:
+    out.write("H\tVN:Z:1.0\n")
+    for node, length in enumerate(lengths):
+        starts.append(offset)
+        out.write(f"S\tc{node}\t{'A' * length}\tSN:Z:chrC\tSO:i:{offset}\tSR:i:0\n")
+        offset += length
+    for node in range(len(lengths) - 1):
+        out.write(f"L\tc{node}\t+\tc{node + 1}\t+\t0M\n")
+
+intervals = [(0, 1), (offset - 1, offset), (0, offset)]
+for entry in (255, 256, 511, 512, 1023, 1024, 1279, 1280):
+    intervals.append((starts[entry], starts[entry] + 1))
+    intervals.append((starts[entry] - 1, starts[entry]))
+    intervals.append((starts[entry] - 20, starts[entry] + 20))
+intervals += [(b, b + rng.randint(1, 300)) for b in (rng.randrange(offset) for _ in range(20))]
+with open(sys.argv[2], "w") as out:
+    for begin, end in intervals:
+        end = min(end, offset)
+        nodes = [f"c{n}" for n, s in enumerate(starts) if s < end and s + lengths[n] > begin]
+        out.write(f"{begin}\t{end}\t{','.join(sorted(nodes))}\n")
+PY
+chain_gfa="$work_dir/chain.gfa.gz"
+"$gfaidx" index_gfa "$work_dir/chain.gfa" "$chain_gfa" \
+    --progress_every 0 >/dev/null
+"$gfaidx" index_coordinates "$chain_gfa" "$chain_gfa.cdx" \
+    --progress_every 0 >/dev/null
+while IFS=$'\t' read -r begin end expected; do
+    "$gfaidx" get_region "$chain_gfa" "chrC:$begin-$end" "$work_dir/chain_region.gfa" \
+        --all_haplotypes >/dev/null 2>&1
+    actual=$(awk -F '\t' '$1 == "S" { print $2 }' "$work_dir/chain_region.gfa" \
+        | LC_ALL=C sort | paste -sd, -)
+    if [[ "$actual" != "$expected" ]]; then
+        echo "chrC:$begin-$end selected '$actual', expected '$expected'" >&2
+        exit 1
+    fi
+done < "$work_dir/chain_queries.tsv"
+
+# The same intervals as one --regions_bed batch, in shuffled order and with a
+# sequence .cdx does not know. Every known region must appear under its own
+# #region tag with the same segments; the unknown one is skipped.
+awk -F '\t' '{ print "chrC\t" $1 "\t" $2 "\tq" NR }' "$work_dir/chain_queries.tsv" \
+    | sort -t $'\t' -k2,2nr > "$work_dir/chain_regions.bed"
+printf 'chrMissing\t0\t10\tmissing\n' >> "$work_dir/chain_regions.bed"
+"$gfaidx" get_region "$chain_gfa" --regions_bed "$work_dir/chain_regions.bed" \
+    "$work_dir/chain_batch.gfa" --all_haplotypes \
+    >/dev/null 2>"$work_dir/chain_batch.stderr"
+grep -F "skipped region missing" "$work_dir/chain_batch.stderr" >/dev/null
+python3 - "$work_dir/chain_queries.tsv" "$work_dir/chain_batch.gfa" <<'PY'
+import sys
+
+expected = {}
+with open(sys.argv[1]) as queries:
+    for number, line in enumerate(queries, 1):
+        expected[f"q{number}"] = line.rstrip("\n").split("\t")[2]
+selected = {}
+with open(sys.argv[2]) as batch:
+    for line in batch:
+        fields = line.rstrip("\n").split("\t")
+        if fields[0] == "#region":
+            name = fields[1]
+            selected[name] = []
+        elif fields[0] == "S":
+            selected[name].append(fields[1])
+for name, nodes in expected.items():
+    actual = ",".join(sorted(selected.get(name, ["<missing>"])))
+    if actual != nodes:
+        sys.exit(f"batch region {name} selected '{actual}', expected '{nodes}'")
+if set(selected) != set(expected):
+    sys.exit(f"unexpected batch regions: {sorted(set(selected) - set(expected))}")
+PY
+
+# --split_regions writes the same records to one file per BED record.
+"$gfaidx" get_region "$chain_gfa" --regions_bed "$work_dir/chain_regions.bed" \
+    "$work_dir/chain_split" --split_regions --all_haplotypes >/dev/null 2>&1
+first_region=$(head -n 1 "$work_dir/chain_regions.bed" | cut -f4)
+awk -v name="$first_region" -F '\t' '
+    $1 == "#region" { keep = ($2 == name); next }
+    keep
+' "$work_dir/chain_batch.gfa" > "$work_dir/chain_first.gfa"
+cmp "$work_dir/chain_first.gfa" "$work_dir/chain_split/1.$first_region.gfa"
+test ! -e "$work_dir/chain_split/$(wc -l < "$work_dir/chain_regions.bed").missing.gfa"
+
+# SR:i:0 segments beyond the --max_memory budget spill to sorted runs. A
+# shuffled rGFA with gaps must give the same .cdx whether the segments fit in
+# memory or not, and whether lengths come from the .lnx or the S lines.
+python3 - "$work_dir/shuffled.gfa" <<'PY'
+import random
+import sys
+
+rng = random.Random(45)
+segments = []
+offsets = [0, 0, 0]
+for node in range(9000):
+    sequence = node % 3
+    if rng.random() < 0.02:
+        offsets[sequence] += rng.randint(1, 20)
+    length = rng.randint(1, 9)
+    segments.append((node, sequence, offsets[sequence], length))
+    offsets[sequence] += length
+rng.shuffle(segments)
+with open(sys.argv[1], "w") as out:
+    out.write("H\tVN:Z:1.0\n")
+    for node, sequence, offset, length in segments:
+        out.write(f"S\tr{node}\t{'A' * length}\tSN:Z:chr{sequence}\tSO:i:{offset}\tSR:i:0\n")
+    for node in range(len(segments) - 3):
+        out.write(f"L\tr{node}\t+\tr{node + 3}\t+\t0M\n")
+PY
+shuffled_gfa="$work_dir/shuffled.gfa.gz"
+"$gfaidx" index_gfa "$work_dir/shuffled.gfa" "$shuffled_gfa" \
+    --progress_every 0 >/dev/null
+"$gfaidx" index_coordinates "$shuffled_gfa" "$shuffled_gfa.cdx" \
+    --progress_every 0 >/dev/null
+"$gfaidx" index_coordinates "$shuffled_gfa" "$work_dir/spilled.cdx" \
+    --max_memory 64K --tmp_dir "$work_dir/spill_tmp" --progress_every 0 \
+    >"$work_dir/spilled.stdout"
+grep -F "Merging" "$work_dir/spilled.stdout" >/dev/null
+cmp "$shuffled_gfa.cdx" "$work_dir/spilled.cdx"
+test -z "$(ls -A "$work_dir/spill_tmp")"
+"$gfaidx" index_coordinates "$work_dir/shuffled.gfa" "$work_dir/from_s_lines.cdx" \
+    --ndx "$shuffled_gfa.ndx" --max_memory 64K --progress_every 0 >/dev/null
+cmp "$shuffled_gfa.cdx" "$work_dir/from_s_lines.cdx"
+
+# --communities_only reads the region's communities from the .cdx community
+# runs and writes their gzip members unchanged: the output is exactly the
+# get_chunk members of the communities holding the overlapping segments.
+"$gfaidx" get_region "$shuffled_gfa" chr1:2000-6000 "$work_dir/communities.gfa" \
+    --communities_only >/dev/null
+community_count=$(($(wc -l < "$shuffled_gfa.idx") - 2))
+for community in $(seq 0 $((community_count - 1))); do
+    "$gfaidx" get_chunk "$shuffled_gfa" --community_id "$community" 2>/dev/null |
+        grep -v '^gfaidx version' > "$work_dir/member_$community.gfa" || true
+done
+python3 - "$work_dir/shuffled.gfa" "$work_dir/communities.gfa" "$work_dir" \
+    "$community_count" <<'PY'
+import sys
+
+gfa, output, work_dir, community_count = sys.argv[1], sys.argv[2], sys.argv[3], int(sys.argv[4])
+members = [open(f"{work_dir}/member_{c}.gfa").read() for c in range(community_count)]
+community_of = {}
+for community, text in enumerate(members):
+    for line in text.splitlines():
+        if line.startswith("S\t"):
+            community_of[line.split("\t")[1]] = community
+wanted = set()
+for line in open(gfa):
+    fields = line.rstrip("\n").split("\t")
+    if fields[0] != "S" or fields[3] != "SN:Z:chr1":
+        continue
+    start = int(fields[4][5:])
+    if start < 6000 and start + len(fields[2]) > 2000:
+        wanted.add(community_of[fields[1]])
+expected = "".join(members[c] for c in sorted(wanted))
+if open(output).read() != expected:
+    sys.exit(f"--communities_only output differs from get_chunk members {sorted(wanted)}")
+PY
+"$gfaidx" get_region "$shuffled_gfa" chr1:2000-6000 "$work_dir/whole_communities.gfa" \
+    --whole_communities >/dev/null
+cmp "$work_dir/communities.gfa" "$work_dir/whole_communities.gfa"